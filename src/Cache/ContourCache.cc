@@ -0,0 +1,83 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "ContourCache.h"
+
+#include <spdlog/fmt/fmt.h>
+
+using namespace carta;
+
+void ContourCacheEntry::Add(double set_progress, const CARTA::ContourSet& contour_set) {
+    progress.push_back(set_progress);
+    contour_sets.push_back(contour_set);
+    size += sizeof(CARTA::ContourSet) + contour_set.ByteSizeLong();
+}
+
+ContourCache::ContourCache(size_t capacity) : _capacity(capacity), _size(0) {}
+
+std::string ContourCache::Key(const std::string& image_id, int z, int stokes, const std::vector<double>& levels, int smoothing_mode,
+    int smoothing_factor, int decimation, int compression_level) {
+    auto key = fmt::format("{}:{}:{}:{}:{}:{}:{}", image_id, z, stokes, smoothing_mode, smoothing_factor, decimation, compression_level);
+    for (auto level : levels) {
+        // Shortest representation which round-trips, so that different levels give different keys
+        key += fmt::format(":{}", level);
+    }
+    return key;
+}
+
+ContourCacheEntryPtr ContourCache::Get(const std::string& key) {
+    std::unique_lock<std::mutex> guard(_contour_cache_mutex);
+    auto it = _map.find(key);
+    if (it == _map.end()) {
+        return nullptr;
+    }
+
+    // Touch the cache entry
+    _queue.splice(_queue.begin(), _queue, it->second);
+    return it->second->second;
+}
+
+void ContourCache::Put(const std::string& key, ContourCacheEntryPtr entry) {
+    if (!entry || entry->size > _capacity) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> guard(_contour_cache_mutex);
+    auto it = _map.find(key);
+    if (it != _map.end()) {
+        _size -= it->second->second->size;
+        _queue.erase(it->second);
+        _map.erase(it);
+    }
+
+    // Evict least recently used entries
+    while (!_queue.empty() && _size + entry->size > _capacity) {
+        _size -= _queue.back().second->size;
+        _map.erase(_queue.back().first);
+        _queue.pop_back();
+    }
+
+    _queue.emplace_front(key, entry);
+    _map[key] = _queue.begin();
+    _size += entry->size;
+}
+
+void ContourCache::Clear() {
+    std::unique_lock<std::mutex> guard(_contour_cache_mutex);
+    _queue.clear();
+    _map.clear();
+    _size = 0;
+}
+
+size_t ContourCache::Size() {
+    std::unique_lock<std::mutex> guard(_contour_cache_mutex);
+    return _size;
+}
+
+size_t ContourCache::Count() {
+    std::unique_lock<std::mutex> guard(_contour_cache_mutex);
+    return _map.size();
+}
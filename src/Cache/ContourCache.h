@@ -0,0 +1,70 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef CARTA_SRC_CACHE_CONTOURCACHE_H_
+#define CARTA_SRC_CACHE_CONTOURCACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <carta-protobuf/contour_image.pb.h>
+
+#define CONTOUR_CACHE_SIZE_MB 256
+
+namespace carta {
+
+// Encoded contours for one image plane and set of contour parameters. Contour sets are stored in the order in which they were sent,
+// with the progress of each message, so that they can be replayed to another client or after a channel change.
+struct ContourCacheEntry {
+    std::vector<double> progress;
+    std::vector<CARTA::ContourSet> contour_sets;
+    size_t size = 0;
+
+    // Append a copy of a sent contour set (with encoded coordinates) and the progress of its message
+    void Add(double set_progress, const CARTA::ContourSet& contour_set);
+};
+
+using ContourCacheEntryPtr = std::shared_ptr<const ContourCacheEntry>;
+
+// Cache of encoded contours shared by all sessions, keyed on the image, plane and all contour parameters which affect the encoded
+// data. LRU cache: when the memory budget is reached, the least recently used entries are discarded first.
+class ContourCache {
+public:
+    // Capacity is the memory budget in bytes
+    ContourCache(size_t capacity = CONTOUR_CACHE_SIZE_MB * 1024 * 1024);
+
+    // Key for the contours of an image plane; image_id identifies the image data, independent of session and file id. The contour
+    // chunk size is not part of the key, as it only changes how the contours are split into messages.
+    static std::string Key(const std::string& image_id, int z, int stokes, const std::vector<double>& levels, int smoothing_mode,
+        int smoothing_factor, int decimation, int compression_level);
+
+    // Entry for the key, or nullptr if it is not in the cache
+    ContourCacheEntryPtr Get(const std::string& key);
+    // Add or replace an entry, evicting the least recently used entries to stay within the memory budget. Entries larger than the
+    // memory budget are not added.
+    void Put(const std::string& key, ContourCacheEntryPtr entry);
+    void Clear();
+
+    size_t Size();
+    size_t Count();
+
+private:
+    using EntryPair = std::pair<std::string, ContourCacheEntryPtr>;
+
+    size_t _capacity;
+    size_t _size;
+    std::list<EntryPair> _queue;
+    std::unordered_map<std::string, std::list<EntryPair>::iterator> _map;
+    std::mutex _contour_cache_mutex;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_CACHE_CONTOURCACHE_H_
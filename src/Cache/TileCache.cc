@@ -46,6 +46,24 @@ TilePtr TileCache::Get(Key key, std::shared_ptr<FileLoader> loader, std::mutex&
     return nullptr;
 }
 
+TilePtr TileCache::Get(Key key, int32_t z, int32_t stokes, std::shared_ptr<FileLoader> loader, std::mutex& image_mutex) {
+    std::unique_lock<std::mutex> guard(_tile_cache_mutex);
+
+    if (z != _z || stokes != _stokes) {
+        return nullptr;
+    }
+
+    if (_map.find(key) == _map.end()) { // Not in cache
+        if (!LoadChunk(ChunkKey(key), loader, image_mutex)) {
+            return nullptr;
+        }
+    } else {
+        Touch(key);
+    }
+
+    return UnsafePeek(key);
+}
+
 void TileCache::Reset(int32_t z, int32_t stokes, int capacity) {
     std::unique_lock<std::mutex> guard(_tile_cache_mutex);
     if (capacity > 0) {
@@ -53,6 +53,15 @@ public:
      *  @details This function locks the cache because it modifies the cache state.
      */
     TilePtr Get(Key key, std::shared_ptr<FileLoader> loader, std::mutex& image_mutex);
+    /** @brief Retrieve a tile from the cache if the cache is for the given Z and Stokes coordinates
+     *  @param key The tile key
+     *  @param z The Z coordinate of the tile
+     *  @param stokes The Stokes coordinate of the tile
+     *  @return The tile, or nullptr if the cache has been reset for other coordinates or the tile could not be loaded
+     *  @details This function locks the cache because it modifies the cache state. It is used by readers of many tiles, such as
+     * contour tracing, which must not mix tiles from different planes.
+     */
+    TilePtr Get(Key key, int32_t z, int32_t stokes, std::shared_ptr<FileLoader> loader, std::mutex& image_mutex);
     /** @brief Reset the cache for a new Z coordinate and/or Stokes coordinate, clearing all tiles.
      *  @param z The new Z coordinate
      *  @param stokes The new Stokes coordinate
@@ -8,14 +8,13 @@
 
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <memory>
 
 #include <zfp.h>
+#include <zstd.h>
 
-#ifdef _ARM_ARCH_
-#include <sse2neon/sse2neon.h>
-#else
-#include <x86intrin.h>
-#endif
+#include "Util/Simd.h"
 
 namespace carta {
 
@@ -86,89 +85,192 @@ int Decompress(std::vector<float>& array, std::vector<char>& compression_buffer,
     return status;
 }
 
-// Removes NaNs from an array and returns run-length encoded list of NaNs
-std::vector<int32_t> GetNanEncodingsSimple(std::vector<float>& array, int offset, int length) {
-    int32_t prev_index = offset;
-    bool prev = false;
-    std::vector<int32_t> encoded_array;
-    // Find first non-NaN number in the array
-    float prev_valid_num = 0;
-    for (auto i = offset; i < offset + length; i++) {
-        if (!std::isnan(array[i])) {
-            prev_valid_num = array[i];
-            break;
+// NaN masks of 64 values per word, with bit i of word k set if value 64 * k + i is NaN. The bits past the end of the data are zero.
+static void GetNanMasksSSE(const float* data, int64_t length, uint64_t* masks) {
+    const int64_t num_full_words = length / 64;
+    for (int64_t word = 0; word < num_full_words; word++) {
+        const float* ptr = data + word * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; i++) {
+            __m128 vals = _mm_loadu_ps(ptr + 4 * i);
+            bits |= (uint64_t)_mm_movemask_ps(_mm_cmpunord_ps(vals, vals)) << (4 * i);
         }
+        masks[word] = bits;
+    }
+    if (length % 64) {
+        uint64_t bits = 0;
+        for (int64_t i = num_full_words * 64; i < length; i++) {
+            bits |= (uint64_t)std::isnan(data[i]) << (i % 64);
+        }
+        masks[num_full_words] = bits;
+    }
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX static void GetNanMasksAVX(const float* data, int64_t length, uint64_t* masks) {
+    const int64_t num_full_words = length / 64;
+    for (int64_t word = 0; word < num_full_words; word++) {
+        const float* ptr = data + word * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++) {
+            __m256 vals = _mm256_loadu_ps(ptr + 8 * i);
+            bits |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(vals, vals, _CMP_UNORD_Q)) << (8 * i);
+        }
+        masks[word] = bits;
+    }
+    if (length % 64) {
+        GetNanMasksSSE(data + num_full_words * 64, length % 64, masks + num_full_words);
+    }
+}
+
+SIMD_TARGET_AVX512 static void GetNanMasksAVX512(const float* data, int64_t length, uint64_t* masks) {
+    const int64_t num_full_words = length / 64;
+    for (int64_t word = 0; word < num_full_words; word++) {
+        const float* ptr = data + word * 64;
+        uint64_t bits = 0;
+        for (int i = 0; i < 4; i++) {
+            __m512 vals = _mm512_loadu_ps(ptr + 16 * i);
+            bits |= (uint64_t)_mm512_cmp_ps_mask(vals, vals, _CMP_UNORD_Q) << (16 * i);
+        }
+        masks[word] = bits;
+    }
+    if (length % 64) {
+        GetNanMasksSSE(data + num_full_words * 64, length % 64, masks + num_full_words);
     }
+}
+#endif
 
-    // Generate RLE list and replace NaNs with neighbouring valid values. Ideally, this should take into account
-    // the width and height of the image, and look for neighbouring values in vertical and horizontal directions,
-    // but this is only an issue with NaNs right at the edge of images.
-    for (auto i = offset; i < offset + length; i++) {
-        bool current = std::isnan(array[i]);
-        if (current != prev) {
+static std::vector<uint64_t> GetNanMasks(const float* data, int64_t length) {
+    std::vector<uint64_t> masks((length + 63) / 64);
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        GetNanMasksAVX512(data, length, masks.data());
+        return masks;
+    } else if (simd_level >= SimdLevel::AVX) {
+        GetNanMasksAVX(data, length, masks.data());
+        return masks;
+    }
+#endif
+    GetNanMasksSSE(data, length, masks.data());
+    return masks;
+}
+
+// Run-length encoding of the NaN masks, starting with a (possibly empty) run of valid values. Only the positions where the NaN state
+// changes are visited, so long runs of NaNs or valid values are skipped a word at a time.
+static std::vector<int32_t> EncodeNanRuns(const std::vector<uint64_t>& masks, int64_t length) {
+    std::vector<int32_t> encoded_array;
+    int64_t prev_index = 0;
+    bool prev = false;
+    const int64_t num_words = masks.size();
+    for (int64_t word = 0; word < num_words; word++) {
+        const uint64_t bits = masks[word];
+        const uint64_t valid_bits = (word + 1) * 64 <= length ? ~0ULL : (1ULL << (length % 64)) - 1;
+        uint64_t changes = (prev ? ~bits : bits) & valid_bits;
+        while (changes) {
+            int bit = __builtin_ctzll(changes);
+            int64_t i = word * 64 + bit;
             encoded_array.push_back(i - prev_index);
             prev_index = i;
-            prev = current;
+            prev = !prev;
+            changes = (prev ? ~bits : bits) & valid_bits & (~0ULL << bit);
         }
-        if (current) {
-            array[i] = prev_valid_num;
-        } else {
-            prev_valid_num = array[i];
+    }
+    encoded_array.push_back(length - prev_index);
+    return encoded_array;
+}
+
+// Removes NaNs from an array and returns run-length encoded list of NaNs
+std::vector<int32_t> GetNanEncodingsSimple(std::vector<float>& array, int offset, int length) {
+    auto encoded_array = EncodeNanRuns(GetNanMasks(array.data() + offset, length), length);
+
+    // Replace NaNs with neighbouring valid values: the last valid value before each run of NaNs, or the first valid value for a leading
+    // run. Ideally, this should take into account the width and height of the image, and look for neighbouring values in vertical and
+    // horizontal directions, but this is only an issue with NaNs right at the edge of images.
+    float* data = array.data() + offset;
+    int64_t run_start = 0;
+    for (size_t run = 0; run < encoded_array.size(); run++) {
+        int64_t run_end = run_start + encoded_array[run];
+        // Odd runs are NaNs
+        if (run % 2 && run_end > run_start) {
+            float fill_value = run_start > 0 ? data[run_start - 1] : (run_end < length ? data[run_end] : 0);
+            std::fill(data + run_start, data + run_end, fill_value);
         }
+        run_start = run_end;
     }
-    encoded_array.push_back(offset + length - prev_index);
     return encoded_array;
 }
 
-std::vector<int32_t> GetNanEncodingsBlock(std::vector<float>& array, int offset, int w, int h) {
-    // Generate RLE NaN list
-    int length = w * h;
-    int32_t prev_index = offset;
-    bool prev = false;
-    std::vector<int32_t> encoded_array;
+// Number of NaNs in bits [start, end) of the NaN masks
+static int64_t CountNans(const std::vector<uint64_t>& masks, int64_t start, int64_t end) {
+    int64_t count = 0;
+    for (int64_t word = start / 64; word * 64 < end; word++) {
+        uint64_t bits = masks[word];
+        if (word * 64 < start) {
+            bits &= ~0ULL << (start % 64);
+        }
+        if ((word + 1) * 64 > end) {
+            bits &= (1ULL << (end % 64)) - 1;
+        }
+        count += __builtin_popcountll(bits);
+    }
+    return count;
+}
 
-    for (auto i = offset; i < offset + length; i++) {
-        bool current = std::isnan(array[i]);
-        if (current != prev) {
-            encoded_array.push_back(i - prev_index);
-            prev_index = i;
-            prev = current;
+// Replaces NaNs in a 4x4 block with the block average
+static void FillNanBlock(float* block_start, int w, int block_width, int block_height) {
+    int valid_count = 0;
+    float sum = 0;
+    for (int x = 0; x < block_width; x++) {
+        for (int y = 0; y < block_height; y++) {
+            float v = block_start[(y * w) + x];
+            if (!std::isnan(v)) {
+                valid_count++;
+                sum += v;
+            }
         }
     }
-    encoded_array.push_back(offset + length - prev_index);
+
+    float average = sum / valid_count;
+    for (int x = 0; x < block_width; x++) {
+        for (int y = 0; y < block_height; y++) {
+            float& v = block_start[(y * w) + x];
+            if (std::isnan(v)) {
+                v = average;
+            }
+        }
+    }
+}
+
+std::vector<int32_t> GetNanEncodingsBlock(std::vector<float>& array, int offset, int w, int h) {
+    // Generate RLE NaN list
+    int length = w * h;
+    auto masks = GetNanMasks(array.data() + offset, length);
+    auto encoded_array = EncodeNanRuns(masks, length);
 
     // Skip all-NaN images and NaN-free images
     if (encoded_array.size() > 1) {
-        // Calculate average of 4x4 blocks (matching blocks used in ZFP), and replace NaNs with block average
-        for (auto i = 0; i < w; i += 4) {
-            for (auto j = 0; j < h; j += 4) {
-                int block_start = offset + j * w + i;
-                int valid_count = 0;
-                float sum = 0;
-                // Limit the block size when at the edges of the image
+        // Calculate average of 4x4 blocks (matching blocks used in ZFP), and replace NaNs with block average. The NaN masks are used to
+        // find the blocks to fill, so that only blocks on the edges of NaN regions are read again.
+        float* data = array.data() + offset;
+        for (auto j = 0; j < h; j += 4) {
+            // Limit the block size when at the edges of the image
+            int block_height = std::min(4, h - j);
+            int64_t row_nans = CountNans(masks, (int64_t)j * w, (int64_t)(j + block_height) * w);
+            if (row_nans == 0 || row_nans == (int64_t)block_height * w) {
+                continue;
+            }
+            for (auto i = 0; i < w; i += 4) {
                 int block_width = std::min(4, w - i);
-                int block_height = std::min(4, h - j);
-                for (int x = 0; x < block_width; x++) {
-                    for (int y = 0; y < block_height; y++) {
-                        float v = array[block_start + (y * w) + x];
-                        if (!std::isnan(v)) {
-                            valid_count++;
-                            sum += v;
-                        }
-                    }
+                int64_t nan_count = 0;
+                for (int y = 0; y < block_height; y++) {
+                    int64_t block_row_start = (int64_t)(j + y) * w + i;
+                    nan_count += CountNans(masks, block_row_start, block_row_start + block_width);
                 }
 
                 // Only process blocks which have at least one valid value AND at least one NaN. All-NaN blocks won't affect ZFP compression
-                if (valid_count && valid_count != block_width * block_height) {
-                    float average = sum / valid_count;
-                    for (int x = 0; x < block_width; x++) {
-                        for (int y = 0; y < block_height; y++) {
-                            float v = array[block_start + (y * w) + x];
-                            if (std::isnan(v)) {
-                                array[block_start + (y * w) + x] = average;
-                            }
-                        }
-                    }
+                if (nan_count && nan_count != block_width * block_height) {
+                    FillNanBlock(data + j * w + i, w, block_width, block_height);
                 }
             }
         }
@@ -234,4 +336,47 @@ void EncodeIntegers(std::vector<int32_t>& array, bool strided) {
     }
 }
 
+bool ZstdCompressPayload(std::vector<char>& buffer, size_t offset, int level) {
+    if (buffer.size() <= offset) {
+        return false;
+    }
+
+    // Compression contexts and buffers are reused by each worker thread
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    thread_local std::vector<char> compression_buffer;
+
+    const size_t src_size = buffer.size() - offset;
+    compression_buffer.resize(ZSTD_compressBound(src_size));
+    size_t compressed_size = ZSTD_compressCCtx(
+        context.get(), compression_buffer.data(), compression_buffer.size(), buffer.data() + offset, src_size, level);
+    if (ZSTD_isError(compressed_size) || compressed_size >= src_size) {
+        return false;
+    }
+
+    std::memcpy(buffer.data() + offset, compression_buffer.data(), compressed_size);
+    buffer.resize(offset + compressed_size);
+    return true;
+}
+
+bool ZstdDecompressPayload(std::vector<char>& buffer, size_t offset) {
+    if (buffer.size() <= offset) {
+        return false;
+    }
+
+    const size_t src_size = buffer.size() - offset;
+    auto decompressed_size = ZSTD_getFrameContentSize(buffer.data() + offset, src_size);
+    if (decompressed_size == ZSTD_CONTENTSIZE_ERROR || decompressed_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+        return false;
+    }
+
+    std::vector<char> decompressed(offset + decompressed_size);
+    std::memcpy(decompressed.data(), buffer.data(), offset);
+    size_t result = ZSTD_decompress(decompressed.data() + offset, decompressed_size, buffer.data() + offset, src_size);
+    if (ZSTD_isError(result)) {
+        return false;
+    }
+    buffer.swap(decompressed);
+    return true;
+}
+
 } // namespace carta
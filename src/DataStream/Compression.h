@@ -22,6 +22,11 @@ std::vector<int32_t> GetNanEncodingsBlock(std::vector<float>& array, int offset,
 void RoundAndEncodeVertices(const std::vector<float>& array, std::vector<int32_t>& dest, float rounding_factor);
 void EncodeIntegers(std::vector<int32_t>& array, bool strided = false);
 
+// Compress the bytes of a buffer following the given offset with zstd, in place. Returns false (leaving the buffer unchanged)
+// if compression fails or does not reduce the size.
+bool ZstdCompressPayload(std::vector<char>& buffer, size_t offset, int level);
+bool ZstdDecompressPayload(std::vector<char>& buffer, size_t offset);
+
 } // namespace carta
 
 #endif // CARTA_SRC_DATASTREAM_COMPRESSION_H_
@@ -6,9 +6,14 @@
 
 #include "Contouring.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 
 #include "../Logger/Logger.h"
@@ -17,22 +22,50 @@
 
 namespace carta {
 
+// Part of a contour which enters or leaves a band through a seam. Edge ids are row * width + column of the seam edge,
+// or -1 for the image boundary.
+struct ContourPiece {
+    std::vector<float> vertices;
+    int64_t start_edge;
+    int64_t end_edge;
+};
+
+// Contours traced for one level in one band: complete segments (which may already have been partially sent) and pieces to stitch
+struct ContourBand {
+    std::vector<float> vertices;
+    std::vector<int32_t> indices;
+    std::vector<ContourPiece> pieces;
+};
+
+// Image rows [j_start, j_end] of a band, with the value range of each row (NaN is below any level)
+struct BandRows {
+    std::once_flag loaded;
+    const float* data = nullptr;
+    std::vector<float> buffer;
+    std::vector<float> row_min;
+    std::vector<float> row_max;
+    std::atomic<int64_t> remaining_levels;
+};
+
 // Contour tracing code adapted from SAOImage DS9: https://github.com/SAOImageDS9/SAOImageDS9
-void TraceSegment(const float* image, std::vector<bool>& visited, int64_t width, int64_t height, double scale, double offset, double level,
-    int x_cell, int y_cell, int side, vector<float>& vertices) {
+// The segment is traced within the band of cell rows [j_start, j_end), where image points to row j_start. Returns the id of the
+// seam edge through which it leaves the band, or -1 if it closes or ends on the image boundary.
+int64_t TraceSegment(const float* image, std::vector<bool>& visited, int64_t width, int64_t height, int64_t j_start, int64_t j_end,
+    double scale, double offset, double level, int64_t x_cell, int64_t y_cell, int side, std::vector<float>& vertices) {
     int64_t i = x_cell;
     int64_t j = y_cell;
     int orig_side = side;
+    int64_t exit_edge = -1;
 
     bool first_iteration = true;
-    bool done = (i < 0 || i >= width - 1 || (j < 0 && j >= height - 1));
+    bool done = (i < 0 || i >= width - 1 || j < j_start || j >= j_end);
 
     while (!done) {
         bool flag = false;
-        double a = image[(j)*width + i];
-        double b = image[(j)*width + i + 1];
-        double c = image[(j + 1) * width + i + 1];
-        double d = image[(j + 1) * width + i];
+        double a = image[(j - j_start) * width + i];
+        double b = image[(j - j_start) * width + i + 1];
+        double c = image[(j - j_start + 1) * width + i + 1];
+        double d = image[(j - j_start + 1) * width + i];
         a = isnan(a) ? -std::numeric_limits<float>::max() : a;
         b = isnan(b) ? -std::numeric_limits<float>::max() : b;
         c = isnan(c) ? -std::numeric_limits<float>::max() : c;
@@ -52,7 +85,8 @@ void TraceSegment(const float* image, std::vector<bool>& visited, int64_t width,
                     y = (level - b) / (c - b) + j;
                     break;
                 case Edge::BottomEdge:
-                    x = (level - c) / (d - c) + i;
+                    // Same vertex as a segment leaving the cell below through its top edge
+                    x = (level - d) / (c - d) + i;
                     y = j + 1;
                     break;
                 case Edge::LeftEdge:
@@ -65,7 +99,7 @@ void TraceSegment(const float* image, std::vector<bool>& visited, int64_t width,
 
         } else {
             if (side == Edge::TopEdge) {
-                visited[j * width + i] = true;
+                visited[(j - j_start) * width + i] = true;
             }
 
             do {
@@ -120,8 +154,13 @@ void TraceSegment(const float* image, std::vector<bool>& visited, int64_t width,
             if (i == x_cell && j == y_cell && side == orig_side) {
                 done = true;
             }
-            if (i < 0 || i >= width - 1 || j < 0 || j >= height - 1) {
+            if (i < 0 || i >= width - 1 || j < j_start || j >= j_end) {
                 done = true;
+                if (j < j_start && j_start > 0) {
+                    exit_edge = j_start * width + i;
+                } else if (j >= j_end && j_end < height - 1) {
+                    exit_edge = j_end * width + i;
+                }
             }
         }
 
@@ -131,124 +170,280 @@ void TraceSegment(const float* image, std::vector<bool>& visited, int64_t width,
         vertices.push_back(scale * x_val + offset);
         vertices.push_back(scale * y_val + offset);
     }
+
+    return exit_edge;
 }
 
-void TraceLevel(const float* image, int64_t width, int64_t height, double scale, double offset, double level, vector<float>& vertices,
-    vector<int32_t>& indices, int chunk_size, ContourCallback& partial_callback) {
-    const int64_t num_pixels = width * height;
-    const size_t vertex_cutoff = 2 * chunk_size;
-    int64_t checked_pixels = 0;
-    vector<bool> visited(num_pixels);
-    int64_t i, j;
+// Traces a level within the band of cell rows [j_start, j_end). Segments contained in the band are added to the band vertices
+// (and sent in chunks), segments crossing a seam are kept as pieces for stitching.
+void TraceBand(const BandRows& rows, int64_t width, int64_t height, int64_t j_start, int64_t j_end, double scale, double offset,
+    double level, ContourBand& band, const std::function<void()>& flush) {
+    const float* image = rows.data;
+    std::vector<bool> visited(width * (j_end - j_start));
+    auto& vertices = band.vertices;
+    auto& indices = band.indices;
 
-    auto test_for_chunk_overflow = [&]() {
-        if (vertex_cutoff && vertices.size() > vertex_cutoff) {
-            double progress = std::min(0.99, checked_pixels / double(num_pixels));
-            partial_callback(level, progress, vertices, indices);
-            vertices.clear();
-            indices.clear();
+    auto trace = [&](int64_t x_cell, int64_t y_cell, int side, int64_t start_edge) {
+        if (start_edge < 0) {
+            indices.push_back(vertices.size());
+            auto end_edge =
+                TraceSegment(image, visited, width, height, j_start, j_end, scale, offset, level, x_cell, y_cell, side, vertices);
+            if (end_edge < 0) {
+                flush();
+                return;
+            }
+            // Ends on a seam: move the segment to a piece
+            ContourPiece piece{std::vector<float>(vertices.begin() + indices.back(), vertices.end()), start_edge, end_edge};
+            vertices.resize(indices.back());
+            indices.pop_back();
+            band.pieces.push_back(std::move(piece));
+        } else {
+            ContourPiece piece{{}, start_edge, -1};
+            piece.end_edge =
+                TraceSegment(image, visited, width, height, j_start, j_end, scale, offset, level, x_cell, y_cell, side, piece.vertices);
+            band.pieces.push_back(std::move(piece));
         }
     };
 
-    // Search TopEdge
-    for (j = 0, i = 0; i < width - 1; i++) {
-        float pt_a = image[(j)*width + i];
-        float pt_b = image[(j)*width + i + 1];
+    // Crossings of a horizontal edge from below to above the level, from left to right
+    auto enters_downwards = [&](float pt_a, float pt_b) { return (isnan(pt_a) || pt_a < level) && level <= pt_b; };
+    // Value at column i of image row j
+    auto value = [&](int64_t i, int64_t j) { return image[(j - j_start) * width + i]; };
+    int64_t i, j;
 
-        if ((isnan(pt_a) || pt_a < level) && level <= pt_b) {
-            indices.push_back(vertices.size());
-            TraceSegment(image, visited, width, height, scale, offset, level, i, j, Edge::TopEdge, vertices);
-            test_for_chunk_overflow();
+    // Search top edge of the band: the image top edge, or the seam with the band above
+    j = j_start;
+    for (i = 0; i < width - 1; i++) {
+        if (enters_downwards(value(i, j), value(i + 1, j))) {
+            trace(i, j, Edge::TopEdge, j_start == 0 ? -1 : j * width + i);
         }
-        checked_pixels++;
     }
 
-    // Search RightEdge
-    for (j = 0; j < height - 1; j++) {
-        float pt_a = image[(j)*width + i];
-        float pt_b = image[(j + 1) * width + i];
-
-        if ((isnan(pt_a) || pt_a < level) && level <= pt_b) {
-            indices.push_back(vertices.size());
-            TraceSegment(image, visited, width, height, scale, offset, level, i - 1, j, Edge::RightEdge, vertices);
-            test_for_chunk_overflow();
+    // Search right edge of the image
+    i = width - 1;
+    for (j = j_start; j < j_end; j++) {
+        if (enters_downwards(value(i, j), value(i, j + 1))) {
+            trace(i - 1, j, Edge::RightEdge, -1);
         }
-        checked_pixels++;
     }
 
-    // Search Bottom
-    for (i--; i >= 0; i--) {
-        float pt_a = image[(j)*width + i + 1];
-        float pt_b = image[(j)*width + i];
-
-        if ((isnan(pt_a) || pt_a < level) && level <= pt_b) {
-            indices.push_back(vertices.size());
-            TraceSegment(image, visited, width, height, scale, offset, level, i, j - 1, Edge::BottomEdge, vertices);
-            test_for_chunk_overflow();
+    // Search bottom edge of the band: the image bottom edge, or the seam with the band below
+    j = j_end;
+    for (i = width - 2; i >= 0; i--) {
+        if (enters_downwards(value(i + 1, j), value(i, j))) {
+            trace(i, j - 1, Edge::BottomEdge, j_end == height - 1 ? -1 : j * width + i);
         }
-        checked_pixels++;
     }
 
-    // Search Left
-    for (i = 0, j--; j >= 0; j--) {
-        float pt_a = image[(j + 1) * width + i];
-        float pt_b = image[(j)*width + i];
-
-        if ((isnan(pt_a) || pt_a < level) && level <= pt_b) {
-            indices.push_back(vertices.size());
-            TraceSegment(image, visited, width, height, scale, offset, level, i, j, Edge::LeftEdge, vertices);
-            test_for_chunk_overflow();
+    // Search left edge of the image
+    i = 0;
+    for (j = j_end - 1; j >= j_start; j--) {
+        if (enters_downwards(value(i, j + 1), value(i, j))) {
+            trace(i, j, Edge::LeftEdge, -1);
         }
-        checked_pixels++;
     }
 
-    // Search each row of the image
-    for (j = 1; j < height - 1; j++) {
+    // Search each row of the band for closed contours, skipping rows which the level does not cross
+    for (j = j_start + 1; j < j_end; j++) {
+        if (!(rows.row_min[j - j_start] < level && level <= rows.row_max[j - j_start])) {
+            continue;
+        }
         for (i = 0; i < width - 1; i++) {
-            float pt_a = image[(j)*width + i];
-            float pt_b = image[(j)*width + i + 1];
-
-            if (!visited[j * width + i] && (isnan(pt_a) || pt_a < level) && level <= pt_b) {
-                indices.push_back(vertices.size());
-                TraceSegment(image, visited, width, height, scale, offset, level, i, j, TopEdge, vertices);
-                test_for_chunk_overflow();
+            if (!visited[(j - j_start) * width + i] && enters_downwards(value(i, j), value(i + 1, j))) {
+                trace(i, j, Edge::TopEdge, -1);
             }
-            checked_pixels++;
         }
     }
-    partial_callback(level, 1.0, vertices, indices);
 }
 
-void TraceContours(float* image, int64_t width, int64_t height, double scale, double offset, const std::vector<double>& levels,
+bool TraceContours(float* image, int64_t width, int64_t height, double scale, double offset, const std::vector<double>& levels,
     std::vector<std::vector<float>>& vertex_data, std::vector<std::vector<int32_t>>& index_data, int chunk_size,
-    ContourCallback& partial_callback) {
+    ContourCallback& partial_callback, int64_t band_rows, int64_t priority_row_start, int64_t priority_row_end) {
+    auto get_rows = [&](int64_t row_start, int64_t num_rows, std::vector<float>& buffer) -> const float* {
+        return image + row_start * width;
+    };
+    return TraceContours(get_rows, width, height, scale, offset, levels, vertex_data, index_data, chunk_size, partial_callback, band_rows,
+        priority_row_start, priority_row_end);
+}
+
+bool TraceContours(ContourRowsCallback& get_rows, int64_t width, int64_t height, double scale, double offset,
+    const std::vector<double>& levels, std::vector<std::vector<float>>& vertex_data, std::vector<std::vector<int32_t>>& index_data,
+    int chunk_size, ContourCallback& partial_callback, int64_t band_rows, int64_t priority_row_start, int64_t priority_row_end) {
     Timer t;
-    vertex_data.resize(levels.size());
-    index_data.resize(levels.size());
+    const int64_t num_levels = levels.size();
+    const size_t vertex_cutoff = 2 * chunk_size;
+    vertex_data.assign(num_levels, {});
+    index_data.assign(num_levels, {});
+
+    if (width < 2 || height < 2) {
+        for (int64_t l = 0; l < num_levels; l++) {
+            partial_callback(levels[l], 1.0, vertex_data[l], index_data[l]);
+        }
+        return true;
+    }
+
+    // Cell rows [0, height - 1) are split into bands, and each (band, level) pair is traced independently. Bands closest to the
+    // priority rows are traced first.
+    band_rows = std::max<int64_t>(1, band_rows);
+    const int64_t num_bands = (height - 1 + band_rows - 1) / band_rows;
+    std::vector<int64_t> band_order(num_bands);
+    std::iota(band_order.begin(), band_order.end(), 0);
+    if (priority_row_end > priority_row_start) {
+        auto distance = [&](int64_t b) {
+            int64_t j_start = b * band_rows;
+            int64_t j_end = j_start + band_rows;
+            return std::max<int64_t>({0, j_start - priority_row_end, priority_row_start - j_end});
+        };
+        std::stable_sort(band_order.begin(), band_order.end(), [&](int64_t b1, int64_t b2) { return distance(b1) < distance(b2); });
+    }
+
+    const int64_t num_tasks = num_bands * num_levels;
+    std::vector<ContourBand> bands(num_tasks);
+    std::vector<BandRows> rows(num_bands);
+    for (auto& band_rows_data : rows) {
+        band_rows_data.remaining_levels = num_levels;
+    }
+    std::vector<std::mutex> level_mutexes(num_levels);
+    std::atomic<int64_t> completed_tasks(0);
+    std::atomic<bool> rows_ok(true);
 
     ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t task = 0; task < num_tasks; task++) {
+        int64_t b = band_order[task / num_levels];
+        int64_t l = task % num_levels;
+        int64_t j_start = b * band_rows;
+        int64_t j_end = std::min(j_start + band_rows, height - 1);
+        double level = levels[l];
+        auto& band = bands[b * num_levels + l];
+        auto& band_rows_data = rows[b];
+
+        // Image rows are read once for all levels of the band
+        std::call_once(band_rows_data.loaded, [&]() {
+            int64_t num_rows = j_end - j_start + 1;
+            band_rows_data.data = get_rows(j_start, num_rows, band_rows_data.buffer);
+            if (!band_rows_data.data) {
+                rows_ok = false;
+                return;
+            }
+            band_rows_data.row_min.resize(num_rows);
+            band_rows_data.row_max.resize(num_rows);
+            for (int64_t j = 0; j < num_rows; j++) {
+                float min_val = std::numeric_limits<float>::max();
+                float max_val = -std::numeric_limits<float>::max();
+                for (int64_t i = 0; i < width; i++) {
+                    float val = band_rows_data.data[j * width + i];
+                    val = std::isnan(val) ? -std::numeric_limits<float>::max() : val;
+                    min_val = std::min(min_val, val);
+                    max_val = std::max(max_val, val);
+                }
+                band_rows_data.row_min[j] = min_val;
+                band_rows_data.row_max[j] = max_val;
+            }
+        });
+
+        // Skip bands which the level does not cross
+        if (band_rows_data.data) {
+            float band_min = *std::min_element(band_rows_data.row_min.begin(), band_rows_data.row_min.end());
+            float band_max = *std::max_element(band_rows_data.row_max.begin(), band_rows_data.row_max.end());
+            if (band_min < level && level <= band_max) {
+                auto flush = [&](size_t cutoff) {
+                    if (vertex_cutoff && band.vertices.size() > cutoff) {
+                        double progress = std::min(0.99, completed_tasks / double(num_tasks));
+                        std::unique_lock<std::mutex> ulock(level_mutexes[l]);
+                        partial_callback(level, progress, band.vertices, band.indices);
+                        band.vertices.clear();
+                        band.indices.clear();
+                    }
+                };
+                TraceBand(band_rows_data, width, height, j_start, j_end, scale, offset, level, band, [&]() { flush(vertex_cutoff); });
+                // Stream the complete segments of the band rather than waiting for the other bands
+                flush(0);
+            }
+        }
+
+        if (--band_rows_data.remaining_levels == 0) {
+            std::vector<float>().swap(band_rows_data.buffer);
+        }
+        ++completed_tasks;
+    }
+
+    // Stitch pieces across seams and send the remaining vertices of each level
 #pragma omp parallel for
-    for (int64_t l = 0; l < levels.size(); l++) {
-        vertex_data[l].clear();
-        index_data[l].clear();
-        TraceLevel(image, width, height, scale, offset, levels[l], vertex_data[l], index_data[l], chunk_size, partial_callback);
+    for (int64_t l = 0; l < num_levels; l++) {
+        double level = levels[l];
+        auto& vertices = vertex_data[l];
+        auto& indices = index_data[l];
+
+        auto flush = [&]() {
+            if (vertex_cutoff && vertices.size() > vertex_cutoff) {
+                partial_callback(level, 0.99, vertices, indices);
+                vertices.clear();
+                indices.clear();
+            }
+        };
+
+        std::vector<ContourPiece*> pieces;
+        std::unordered_map<int64_t, ContourPiece*> pieces_by_start;
+        for (int64_t b = 0; b < num_bands; b++) {
+            auto& band = bands[b * num_levels + l];
+            for (auto index : band.indices) {
+                indices.push_back(vertices.size() + index);
+            }
+            vertices.insert(vertices.end(), band.vertices.begin(), band.vertices.end());
+            flush();
+
+            for (auto& piece : band.pieces) {
+                pieces.push_back(&piece);
+                if (piece.start_edge >= 0) {
+                    pieces_by_start[piece.start_edge] = &piece;
+                }
+            }
+        }
+
+        // Follow a chain of pieces from the given one, until it leaves the image or returns to its start
+        auto stitch = [&](ContourPiece* piece) {
+            indices.push_back(vertices.size());
+            vertices.insert(vertices.end(), piece->vertices.begin(), piece->vertices.end());
+            auto start = piece;
+            piece->vertices.clear();
+            while (piece->end_edge >= 0) {
+                auto next = pieces_by_start.find(piece->end_edge);
+                if (next == pieces_by_start.end() || next->second == start) {
+                    break;
+                }
+                piece = next->second;
+                pieces_by_start.erase(next);
+                // The first vertex is on the seam, where the previous piece ended
+                vertices.insert(vertices.end(), piece->vertices.begin() + 2, piece->vertices.end());
+                piece->vertices.clear();
+            }
+            flush();
+        };
+
+        // Open contours start on the image boundary; the remaining pieces form closed contours crossing seams
+        for (auto piece : pieces) {
+            if (piece->start_edge < 0) {
+                stitch(piece);
+            }
+        }
+        for (auto piece : pieces) {
+            if (piece->start_edge >= 0 && pieces_by_start.erase(piece->start_edge)) {
+                stitch(piece);
+            }
+        }
+
+        partial_callback(level, 1.0, vertices, indices);
     }
 
     if (spdlog::get(PERF_TAG)) {
         auto dt = t.Elapsed();
         auto rate_contours = width * height / dt.us();
-        int vertex_count = 0;
-        int segment_count = 0;
-        for (auto& vertices : vertex_data) {
-            vertex_count += vertices.size();
-        }
-        for (auto& indices : index_data) {
-            segment_count += indices.size();
-        }
-
-        spdlog::performance("Contoured {}x{} image in {:.3f} ms at {:.3f} MPix/s. Found {} vertices in {} segments across {} levels", width,
-            height, dt.ms(), rate_contours, vertex_count, segment_count, levels.size());
+        spdlog::performance("Contoured {}x{} image in {:.3f} ms at {:.3f} MPix/s. Traced {} levels in {} bands", width, height, dt.ms(),
+            rate_contours, num_levels, num_bands);
     }
+
+    return rows_ok;
 }
 
 } // namespace carta
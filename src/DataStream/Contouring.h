@@ -11,17 +11,28 @@
 #include <functional>
 #include <vector>
 
+// Cell rows are split into bands of this many rows, which are traced in parallel and stitched together at the seams
+#define CONTOUR_BAND_ROWS 128
+
 namespace carta {
 
 typedef const std::function<void(double, double, const std::vector<float>&, const std::vector<int32_t>&)> ContourCallback;
+// Provides image rows [row_start, row_start + num_rows), either pointing to existing data or filling the buffer. Returns nullptr if
+// the rows cannot be read.
+typedef const std::function<const float*(int64_t row_start, int64_t num_rows, std::vector<float>& buffer)> ContourRowsCallback;
 
 enum Edge { TopEdge, RightEdge, BottomEdge, LeftEdge, None };
 
 void TraceContourLevel(float* image, int64_t width, int64_t height, double scale, double offset, double level,
     std::vector<double>& vertex_data, std::vector<int32_t>& indices);
-void TraceContours(float* image, int64_t width, int64_t height, double scale, double offset, const std::vector<double>& levels,
+// Bands overlapping rows [priority_row_start, priority_row_end) (e.g. the viewport) are traced and sent first
+bool TraceContours(float* image, int64_t width, int64_t height, double scale, double offset, const std::vector<double>& levels,
     std::vector<std::vector<float>>& vertex_data, std::vector<std::vector<int32_t>>& index_data, int chunk_size,
-    ContourCallback& partial_callback);
+    ContourCallback& partial_callback, int64_t band_rows = CONTOUR_BAND_ROWS, int64_t priority_row_start = 0, int64_t priority_row_end = 0);
+bool TraceContours(ContourRowsCallback& get_rows, int64_t width, int64_t height, double scale, double offset,
+    const std::vector<double>& levels, std::vector<std::vector<float>>& vertex_data, std::vector<std::vector<int32_t>>& index_data,
+    int chunk_size, ContourCallback& partial_callback, int64_t band_rows = CONTOUR_BAND_ROWS, int64_t priority_row_start = 0,
+    int64_t priority_row_end = 0);
 
 } // namespace carta
 
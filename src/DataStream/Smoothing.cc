@@ -6,9 +6,12 @@
 
 #include "Smoothing.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "../Logger/Logger.h"
@@ -113,62 +116,203 @@ bool RunKernel(const vector<float>& kernel, const float* src_data, float* dest_d
     return true;
 }
 
-bool GaussianSmooth(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
-    int smoothing_factor) {
-    float sigma = (smoothing_factor - 1) / 2.0f;
-    int mask_size = (smoothing_factor - 1) * 2 + 1;
-    const int apron_height = smoothing_factor - 1;
-    int64_t calculated_dest_width = src_width - 2 * (smoothing_factor - 1);
-    int64_t calculated_dest_height = src_height - 2 * (smoothing_factor - 1);
+// Grow-only buffer aligned for SIMD loads, reused by a thread between smoothing calls
+class ScratchBuffer {
+public:
+    float* Get(size_t size) {
+        if (size > _capacity) {
+            size_t num_bytes = ((size * sizeof(float) + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT) * SCRATCH_ALIGNMENT;
+            _data.reset(static_cast<float*>(std::aligned_alloc(SCRATCH_ALIGNMENT, num_bytes)));
+            _capacity = _data ? size : 0;
+        }
+        return _data.get();
+    }
 
-    if (dest_width * dest_height < calculated_dest_width * calculated_dest_height) {
-        spdlog::error("Incorrectly sized destination array. Should be at least{}x{} (got {}x{})", calculated_dest_width,
-            calculated_dest_height, dest_width, dest_height);
-        return false;
+    // Release the buffer if it is too large to keep between calls
+    void Trim() {
+        if (_capacity * sizeof(float) > SMOOTHING_SCRATCH_SIZE_MB * 1024 * 1024) {
+            _data.reset();
+            _capacity = 0;
+        }
+    }
+
+private:
+    static constexpr size_t SCRATCH_ALIGNMENT = 64;
+    struct Free {
+        void operator()(float* ptr) {
+            std::free(ptr);
+        }
+    };
+    std::unique_ptr<float, Free> _data;
+    size_t _capacity = 0;
+};
+
+static inline void AccumulateFinite(__m128& sum, __m128& weight, __m128 val, __m128 w) {
+    __m128 mask = _mm_andnot_ps(IsInfinity(val), _mm_cmpeq_ps(val, val));
+    w = _mm_and_ps(w, mask);
+    val = _mm_and_ps(val, mask);
+    sum += val * w;
+    weight += w;
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX static inline void AccumulateFinite(__m256& sum, __m256& weight, __m256 val, __m256 w) {
+    __m256 mask = _mm256_andnot_ps(IsInfinity(val), _mm256_cmp_ps(val, val, _CMP_EQ_OQ));
+    w = _mm256_and_ps(w, mask);
+    val = _mm256_and_ps(val, mask);
+    sum += val * w;
+    weight += w;
+}
+#endif
+
+// The separable passes share one kernel: dest[x] is the weighted mean of the finite values of src[x + i * stride] for i in
+// [0, kernel size), or NaN if there are none. The horizontal pass uses a stride of 1, and the vertical pass the row width.
+static void ConvolveScalar(
+    const std::vector<float>& kernel, const float* src, float* dest, int64_t x_start, int64_t width, int64_t stride) {
+    const int64_t kernel_size = kernel.size();
+    for (int64_t x = x_start; x < width; x++) {
+        float sum = 0.0;
+        float weight = 0.0;
+        for (int64_t i = 0; i < kernel_size; i++) {
+            float val = src[x + i * stride];
+            if (std::isfinite(val)) {
+                sum += val * kernel[i];
+                weight += kernel[i];
+            }
+        }
+        dest[x] = weight > 0.0 ? sum / weight : NAN;
     }
+}
 
-    std::vector<float> kernel(mask_size);
-    MakeKernel(kernel, sigma);
+static void ConvolveSSE(const std::vector<float>& kernel, const float* src, float* dest, int64_t width, int64_t stride) {
+    const int64_t kernel_size = kernel.size();
+    const int64_t block_limit = 4 * (width / 4);
+    for (int64_t x = 0; x < block_limit; x += 4) {
+        __m128 sum = _mm_setzero_ps();
+        __m128 weight = _mm_setzero_ps();
+        for (int64_t i = 0; i < kernel_size; i++) {
+            AccumulateFinite(sum, weight, _mm_loadu_ps(src + x + i * stride), _mm_set_ps1(kernel[i]));
+        }
+        _mm_storeu_ps(dest + x, sum / weight);
+    }
+    ConvolveScalar(kernel, src, dest, block_limit, width, stride);
+}
 
-    double target_pixels = (SMOOTHING_TEMP_BUFFER_SIZE_MB * 1e6) / sizeof(float);
-    int64_t target_buffer_height = target_pixels / dest_width;
-    if (target_buffer_height < 4 * apron_height) {
-        target_buffer_height = 4 * apron_height;
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX static void ConvolveAVX(const std::vector<float>& kernel, const float* src, float* dest, int64_t width, int64_t stride) {
+    const int64_t kernel_size = kernel.size();
+    const int64_t block_limit = 8 * (width / 8);
+    for (int64_t x = 0; x < block_limit; x += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        __m256 weight = _mm256_setzero_ps();
+        for (int64_t i = 0; i < kernel_size; i++) {
+            AccumulateFinite(sum, weight, _mm256_loadu_ps(src + x + i * stride), _mm256_set1_ps(kernel[i]));
+        }
+        _mm256_storeu_ps(dest + x, sum / weight);
     }
-    int64_t buffer_height = min(target_buffer_height, src_height);
+    ConvolveScalar(kernel, src, dest, block_limit, width, stride);
+}
 
-    int64_t line_offset = 0;
-    Timer t;
-    std::unique_ptr<float[]> temp_array(new float[dest_width * buffer_height]);
-    auto source_ptr = src_data;
-    auto dest_ptr = dest_data;
-    const auto temp_ptr = temp_array.get();
-
-    while (line_offset < dest_height) {
-        int64_t num_lines = buffer_height - 2 * apron_height;
-        // clamp last iteration
-        if (line_offset + num_lines > dest_height) {
-            num_lines = dest_height - line_offset;
+SIMD_TARGET_AVX512 static void ConvolveAVX512(const std::vector<float>& kernel, const float* src, float* dest, int64_t width,
+    int64_t stride) {
+    const int64_t kernel_size = kernel.size();
+    const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+    // The right edge is handled with masked loads and stores
+    for (int64_t x = 0; x < width; x += 16) {
+        __mmask16 edge_mask = width - x >= 16 ? 0xFFFF : (1 << (width - x)) - 1;
+        __m512 sum = _mm512_setzero_ps();
+        __m512 weight = _mm512_setzero_ps();
+        for (int64_t i = 0; i < kernel_size; i++) {
+            __m512 val = _mm512_maskz_loadu_ps(edge_mask, src + x + i * stride);
+            // Comparisons with NaN are false, so only finite values are accumulated
+            __mmask16 finite = _mm512_cmp_ps_mask(_mm512_abs_ps(val), inf, _CMP_LT_OQ);
+            __m512 w = _mm512_set1_ps(kernel[i]);
+            sum = _mm512_mask_add_ps(sum, finite, sum, _mm512_mul_ps(val, w));
+            weight = _mm512_mask_add_ps(weight, finite, weight, w);
+        }
+        _mm512_mask_storeu_ps(dest + x, edge_mask, _mm512_div_ps(sum, weight));
+    }
+}
+#endif
+
+// Pixels which are NaN in the source are NaN in the smoothed image
+static inline void RestoreNaNs(const float* src, float* dest, int64_t width) {
+    for (int64_t x = 0; x < width; x++) {
+        if (isnan(src[x])) {
+            dest[x] = NAN;
         }
-        RunKernel(kernel, source_ptr, temp_ptr, src_width, src_height, dest_width, num_lines + 2 * apron_height, false);
-        RunKernel(kernel, temp_array.get(), dest_ptr, dest_width, num_lines + 2 * apron_height, dest_width, num_lines, true);
+    }
+}
 
-        line_offset += num_lines;
-        source_ptr += num_lines * src_width;
-        dest_ptr += num_lines * dest_width;
+bool GaussianSmoothSeparable(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
+    int64_t dest_height, int smoothing_factor) {
+    const int64_t apron = smoothing_factor - 1;
+    if (dest_width > src_width - 2 * apron || dest_height > src_height - 2 * apron) {
+        return false;
     }
 
-    // Fill in original NaNs
+    std::vector<float> kernel(2 * apron + 1);
+    MakeKernel(kernel, apron / 2.0);
+
+    // Each block of rows is smoothed by one thread: the horizontal pass over the block and its aprons is kept in the thread's scratch
+    // buffer for the vertical pass. Blocks are sized so that the buffer can be kept between calls, unless the rows are very long.
+    const int64_t scratch_rows = SMOOTHING_SCRATCH_SIZE_MB * 1024 * 1024 / (sizeof(float) * std::max<int64_t>(dest_width, 1));
+    const int64_t block_rows = std::max<int64_t>(SMOOTHING_BLOCK_ROWS, std::min(16 * apron, scratch_rows - 2 * apron));
+    const int64_t num_blocks = (dest_height + block_rows - 1) / block_rows;
+
+    auto convolve = ConvolveSSE;
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        convolve = ConvolveAVX512;
+    } else if (simd_level >= SimdLevel::AVX) {
+        convolve = ConvolveAVX;
+    }
+#endif
+
     ThreadManager::ApplyThreadLimit();
-#pragma omp parallel for
-    for (int64_t j = 0; j < dest_height; j++) {
-        for (int64_t i = 0; i < dest_width; i++) {
-            auto src_index = (j + apron_height) * src_width + (i + apron_height);
-            auto origVal = src_data[src_index];
-            if (isnan(origVal)) {
-                dest_data[j * dest_width + i] = NAN;
+#pragma omp parallel
+    {
+        thread_local ScratchBuffer scratch;
+
+#pragma omp for schedule(dynamic)
+        for (int64_t block = 0; block < num_blocks; block++) {
+            const int64_t row_start = block * block_rows;
+            const int64_t num_rows = std::min(block_rows, dest_height - row_start);
+            const int64_t num_src_rows = num_rows + 2 * apron;
+            float* rows = scratch.Get(num_src_rows * dest_width);
+
+            for (int64_t j = 0; j < num_src_rows; j++) {
+                convolve(kernel, src_data + (row_start + j) * src_width, rows + j * dest_width, dest_width, 1);
+            }
+
+            for (int64_t j = 0; j < num_rows; j++) {
+                float* dest_row = dest_data + (row_start + j) * dest_width;
+                convolve(kernel, rows + j * dest_width, dest_row, dest_width, dest_width);
+                RestoreNaNs(src_data + (row_start + j + apron) * src_width + apron, dest_row, dest_width);
             }
         }
+        scratch.Trim();
+    }
+
+    return true;
+}
+
+bool GaussianSmooth(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
+    int smoothing_factor) {
+    int mask_size = (smoothing_factor - 1) * 2 + 1;
+    int64_t calculated_dest_width = src_width - 2 * (smoothing_factor - 1);
+    int64_t calculated_dest_height = src_height - 2 * (smoothing_factor - 1);
+
+    if (dest_width * dest_height < calculated_dest_width * calculated_dest_height) {
+        spdlog::error("Incorrectly sized destination array. Should be at least{}x{} (got {}x{})", calculated_dest_width,
+            calculated_dest_height, dest_width, dest_height);
+        return false;
+    }
+
+    Timer t;
+    if (!GaussianSmoothSeparable(src_data, dest_data, src_width, src_height, dest_width, dest_height, smoothing_factor)) {
+        return false;
     }
 
     auto dt = t.Elapsed();
@@ -181,9 +325,13 @@ bool GaussianSmooth(const float* src_data, float* dest_data, int64_t src_width,
 
 bool BlockSmooth(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
     int64_t x_offset, int64_t y_offset, int smoothing_factor) {
-#ifdef __AVX__
-    // AVX version, only for 8x down-sampling and above
-    if (smoothing_factor % 8 == 0) {
+#ifndef _ARM_ARCH_
+    // AVX-512 and AVX versions, only for 16x and 8x down-sampling and above
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512 && smoothing_factor % 16 == 0) {
+        return BlockSmoothAVX512(src_data, dest_data, src_width, src_height, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
+    }
+    if (simd_level >= SimdLevel::AVX && smoothing_factor % 8 == 0) {
         return BlockSmoothAVX(src_data, dest_data, src_width, src_height, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
     }
 #endif
@@ -253,9 +401,9 @@ bool BlockSmoothSSE(const float* src_data, float* dest_data, int64_t src_width,
     return true;
 }
 
-#ifdef __AVX__
-bool BlockSmoothAVX(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
-    int64_t x_offset, int64_t y_offset, int smoothing_factor) {
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX bool BlockSmoothAVX(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
+    int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor) {
     ThreadManager::ApplyThreadLimit();
 #pragma omp parallel for
     for (int64_t j = 0; j < dest_height; ++j) {
@@ -307,6 +455,51 @@ bool BlockSmoothAVX(const float* src_data, float* dest_data, int64_t src_width,
     }
     return true;
 }
+
+SIMD_TARGET_AVX512 bool BlockSmoothAVX512(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height,
+    int64_t dest_width, int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor) {
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for
+    for (int64_t j = 0; j < dest_height; ++j) {
+        for (auto i = 0; i < dest_width; i++) {
+            int64_t image_row = y_offset + (j * smoothing_factor);
+            int64_t image_col = x_offset + (i * smoothing_factor);
+
+            const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+            const __m512 v1 = _mm512_set1_ps(1.0f);
+            __m512 count = _mm512_setzero_ps(), total = _mm512_setzero_ps();
+
+            int rows_left = min(smoothing_factor, (int)(src_height - image_row));
+            int columns_left = min(smoothing_factor, (int)(src_width - image_col));
+            int blocks_left = columns_left / 16;
+            // The right edge of the block is handled with a masked load
+            __mmask16 edge_mask = (1 << (columns_left % 16)) - 1;
+
+            for (auto row_index = 0; row_index < rows_left; row_index++) {
+                const float* ptr = src_data + ((image_row + row_index) * src_width) + image_col;
+                for (auto col_index = 0; col_index < blocks_left; col_index++) {
+                    __m512 row = _mm512_loadu_ps(ptr);
+                    // Ordered comparison, so that NaNs are also excluded
+                    __mmask16 mask = _mm512_cmp_ps_mask(_mm512_abs_ps(row), inf, _CMP_LT_OQ);
+                    total = _mm512_mask_add_ps(total, mask, total, row);
+                    count = _mm512_mask_add_ps(count, mask, count, v1);
+                    ptr += 16;
+                }
+                if (edge_mask) {
+                    __m512 row = _mm512_maskz_loadu_ps(edge_mask, ptr);
+                    __mmask16 mask = _mm512_mask_cmp_ps_mask(edge_mask, _mm512_abs_ps(row), inf, _CMP_LT_OQ);
+                    total = _mm512_mask_add_ps(total, mask, total, row);
+                    count = _mm512_mask_add_ps(count, mask, count, v1);
+                }
+            }
+
+            float pixel_sum = _mm512_reduce_add_ps(total);
+            float pixel_count = _mm512_reduce_add_ps(count);
+            dest_data[j * dest_width + i] = pixel_count ? pixel_sum / pixel_count : NAN;
+        }
+    }
+    return true;
+}
 #endif
 
 bool BlockSmoothScalar(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
@@ -339,8 +532,8 @@ bool BlockSmoothScalar(const float* src_data, float* dest_data, int64_t src_widt
     return true;
 }
 
-void NearestNeighbor(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width, int64_t dest_height, int64_t x_offset,
-    int64_t y_offset, int smoothing_factor) {
+static void NearestNeighborScalar(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width, int64_t dest_height,
+    int64_t x_offset, int64_t y_offset, int smoothing_factor) {
     ThreadManager::ApplyThreadLimit();
 #pragma omp parallel for
     for (size_t j = 0; j < dest_height; ++j) {
@@ -352,4 +545,62 @@ void NearestNeighbor(const float* src_data, float* dest_data, int64_t src_width,
     }
 }
 
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX2 static void NearestNeighborAVX2(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width,
+    int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor) {
+    ThreadManager::ApplyThreadLimit();
+    const int64_t blocked_width = 8 * (dest_width / 8);
+#pragma omp parallel for
+    for (int64_t j = 0; j < dest_height; ++j) {
+        const float* src_row = src_data + (y_offset + j * smoothing_factor) * src_width + x_offset;
+        float* dest_row = dest_data + j * dest_width;
+        // Column offsets within the source row, which always fit in 32 bits
+        __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(smoothing_factor));
+        const __m256i step = _mm256_set1_epi32(8 * smoothing_factor);
+        int64_t i = 0;
+        for (; i < blocked_width; i += 8) {
+            _mm256_storeu_ps(dest_row + i, _mm256_i32gather_ps(src_row, index, 4));
+            index = _mm256_add_epi32(index, step);
+        }
+        for (; i < dest_width; i++) {
+            dest_row[i] = src_row[i * smoothing_factor];
+        }
+    }
+}
+
+SIMD_TARGET_AVX512 static void NearestNeighborAVX512(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width,
+    int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor) {
+    ThreadManager::ApplyThreadLimit();
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+#pragma omp parallel for
+    for (int64_t j = 0; j < dest_height; ++j) {
+        const float* src_row = src_data + (y_offset + j * smoothing_factor) * src_width + x_offset;
+        float* dest_row = dest_data + j * dest_width;
+        __m512i index = _mm512_mullo_epi32(lanes, _mm512_set1_epi32(smoothing_factor));
+        const __m512i step = _mm512_set1_epi32(16 * smoothing_factor);
+        for (int64_t i = 0; i < dest_width; i += 16) {
+            // Masked gather and store for the right edge of the row
+            __mmask16 mask = dest_width - i >= 16 ? 0xFFFF : (1 << (dest_width - i)) - 1;
+            __m512 vals = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, index, src_row, 4);
+            _mm512_mask_storeu_ps(dest_row + i, mask, vals);
+            index = _mm512_add_epi32(index, step);
+        }
+    }
+}
+#endif
+
+void NearestNeighbor(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width, int64_t dest_height, int64_t x_offset,
+    int64_t y_offset, int smoothing_factor) {
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        return NearestNeighborAVX512(src_data, dest_data, src_width, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
+    }
+    if (simd_level >= SimdLevel::AVX2) {
+        return NearestNeighborAVX2(src_data, dest_data, src_width, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
+    }
+#endif
+    NearestNeighborScalar(src_data, dest_data, src_width, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
+}
+
 } // namespace carta
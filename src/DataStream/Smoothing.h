@@ -15,20 +15,23 @@
 #include <limits>
 #include <vector>
 
-#ifdef _ARM_ARCH_
-#include <sse2neon/sse2neon.h>
-#else
-#include <x86intrin.h>
-#endif
+#include "Util/Simd.h"
 
-#define SMOOTHING_TEMP_BUFFER_SIZE_MB 200
+// Largest scratch buffer kept by a thread between smoothing calls
+#define SMOOTHING_SCRATCH_SIZE_MB 16
+// Minimum number of output rows smoothed by each thread in a separable pass
+#define SMOOTHING_BLOCK_ROWS 128
 
 namespace carta {
 
 #ifdef __AVX__
 #define SIMD_WIDTH 8
+#else
+#define SIMD_WIDTH 4
+#endif
 
-static inline __m256 IsInfinity(__m256 x) {
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX static inline __m256 IsInfinity(__m256 x) {
     const __m256 sign_mask = _mm256_set1_ps(-0.0);
     const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
     x = _mm256_andnot_ps(sign_mask, x);
@@ -36,15 +39,13 @@ static inline __m256 IsInfinity(__m256 x) {
     return x;
 }
 
-static inline float _mm256_reduce_add_ps(__m256 x) {
+SIMD_TARGET_AVX static inline float _mm256_reduce_add_ps(__m256 x) {
     __m256 t1 = _mm256_hadd_ps(x, x);
     __m256 t2 = _mm256_hadd_ps(t1, t1);
     __m128 t3 = _mm256_extractf128_ps(t2, 1);
     __m128 t4 = _mm_add_ss(_mm256_castps256_ps128(t2), t3);
     return _mm_cvtss_f32(t4);
 }
-#else
-#define SIMD_WIDTH 4
 #endif
 
 static inline __m128 IsInfinity(__m128 x) {
@@ -59,17 +60,25 @@ static inline __m128 IsInfinity(__m128 x) {
 void MakeKernel(std::vector<float>& kernel, double sigma);
 bool RunKernel(const std::vector<float>& kernel, const float* src_data, float* dest_data, int64_t src_width, int64_t src_height,
     int64_t dest_width, int64_t dest_height, bool vertical);
+// Gaussian smoothing with sigma (smoothing_factor - 1) / 2, without the apron of smoothing_factor - 1 pixels on each side
 bool GaussianSmooth(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
     int smoothing_factor);
+// Separable convolution with the kernel truncated at the apron, in blocks of rows using per-thread scratch buffers. Pixels with NaN or
+// infinite values are excluded from the weights, and pixels which are NaN in the source are NaN in the result.
+bool GaussianSmoothSeparable(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
+    int64_t dest_height, int smoothing_factor);
 bool BlockSmooth(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
     int64_t x_offset, int64_t y_offset, int smoothing_factor);
 bool BlockSmoothScalar(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
     int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor);
 bool BlockSmoothSSE(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
     int64_t x_offset, int64_t y_offset, int smoothing_factor);
-#ifdef __AVX__
+#ifndef _ARM_ARCH_
+// Only called by BlockSmooth if supported by the host, see Simd::Level()
 bool BlockSmoothAVX(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width, int64_t dest_height,
     int64_t x_offset, int64_t y_offset, int smoothing_factor);
+bool BlockSmoothAVX512(const float* src_data, float* dest_data, int64_t src_width, int64_t src_height, int64_t dest_width,
+    int64_t dest_height, int64_t x_offset, int64_t y_offset, int smoothing_factor);
 #endif
 
 void NearestNeighbor(const float* src_data, float* dest_data, int64_t src_width, int64_t dest_width, int64_t dest_height, int64_t x_offset,
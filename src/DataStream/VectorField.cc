@@ -6,10 +6,18 @@
 
 #include "VectorField.h"
 #include "Util/Message.h"
+#include "Util/Simd.h"
 
 namespace carta {
 
-VectorField::VectorField() : _calculate_pi(false), _calculate_pa(false), _current_stokes_as_pi(false), _current_stokes_as_pa(false) {
+VectorField::VectorField()
+    : _calculate_pi(false),
+      _calculate_pa(false),
+      _current_stokes_as_pi(false),
+      _current_stokes_as_pa(false),
+      _tile_data_z(-1),
+      _tile_data_mip(0),
+      _keep_tile_data(false) {
     ClearSettings();
 }
 
@@ -28,6 +36,7 @@ bool VectorField::ClearParameters(const std::function<void(CARTA::VectorOverlayT
 
     if (_stokes_intensity < 0 && _stokes_angle < 0) {
         ClearSettings();
+        ClearTileData();
         auto empty_response =
             Message::VectorOverlayTileData(_file_id, z_index, _stokes_intensity, _stokes_angle, _compression_type, _compression_quality);
         empty_response.set_progress(1.0);
@@ -37,9 +46,8 @@ bool VectorField::ClearParameters(const std::function<void(CARTA::VectorOverlayT
     return false;
 }
 
-void VectorField::CalculatePiPa(std::unordered_map<std::string, std::vector<float>>& stokes_data,
-    std::unordered_map<std::string, bool>& stokes_flag, const Tile& tile, int width, int height, int z_index, double progress,
-    const std::function<void(CARTA::VectorOverlayTileData&)>& callback) {
+CARTA::VectorOverlayTileData VectorField::CalculatePiPa(const std::unordered_map<std::string, std::vector<float>>& stokes_data,
+    const std::unordered_map<std::string, bool>& stokes_flag, const Tile& tile, int width, int height, int z_index) {
     // Set response messages
     auto response =
         Message::VectorOverlayTileData(_file_id, z_index, _stokes_intensity, _stokes_angle, _compression_type, _compression_quality);
@@ -51,15 +59,16 @@ void VectorField::CalculatePiPa(std::unordered_map<std::string, std::vector<floa
 
     // Current stokes data as PI or PA
     if (_current_stokes_as_pi || _current_stokes_as_pa) {
-        // Apply a threshold cut
-        std::for_each(stokes_data["CUR"].begin(), stokes_data["CUR"].end(), threshold_cut);
+        // Apply a threshold cut to a copy, so that the cached data is kept
+        auto current_data = stokes_data.at("CUR");
+        std::for_each(current_data.begin(), current_data.end(), threshold_cut);
 
         if (_current_stokes_as_pi) {
-            FillTileData(tile_pi, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, stokes_data["CUR"], _compression_type,
+            FillTileData(tile_pi, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, current_data, _compression_type,
                 _compression_quality);
         }
         if (_current_stokes_as_pa) {
-            FillTileData(tile_pa, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, stokes_data["CUR"], _compression_type,
+            FillTileData(tile_pa, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, current_data, _compression_type,
                 _compression_quality);
         }
     }
@@ -69,17 +78,15 @@ void VectorField::CalculatePiPa(std::unordered_map<std::string, std::vector<floa
         std::vector<float> pi;
         pi.resize(width * height);
 
-        // Lambda function to calculate PI, errors are applied
-        CalcPi calc_pi(_q_error, _u_error);
-
-        std::transform(stokes_data["Q"].begin(), stokes_data["Q"].end(), stokes_data["U"].begin(), pi.begin(), calc_pi);
+        // Calculate PI, errors are applied
+        CalculatePolarizedIntensity(stokes_data.at("Q").data(), stokes_data.at("U").data(), pi.data(), pi.size(), _q_error, _u_error);
         if (_fractional) { // Calculate fractional PI
             CalcFpi calc_fpi;
-            std::transform(stokes_data["I"].begin(), stokes_data["I"].end(), pi.begin(), pi.begin(), calc_fpi);
+            std::transform(stokes_data.at("I").begin(), stokes_data.at("I").end(), pi.begin(), pi.begin(), calc_fpi);
         }
 
-        if (stokes_flag["I"]) { // Set NAN for PI/FPI if stokes I is NAN or below the threshold
-            std::transform(stokes_data["I"].begin(), stokes_data["I"].end(), pi.begin(), pi.begin(), threshold_cut);
+        if (stokes_flag.at("I")) { // Set NAN for PI/FPI if stokes I is NAN or below the threshold
+            std::transform(stokes_data.at("I").begin(), stokes_data.at("I").end(), pi.begin(), pi.begin(), threshold_cut);
         }
         FillTileData(tile_pi, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, pi, _compression_type, _compression_quality);
     }
@@ -87,18 +94,63 @@ void VectorField::CalculatePiPa(std::unordered_map<std::string, std::vector<floa
     if (_calculate_pa) {
         std::vector<float> pa;
         pa.resize(width * height);
-        CalcPa calc_pa;
-        std::transform(stokes_data["Q"].begin(), stokes_data["Q"].end(), stokes_data["U"].begin(), pa.begin(), calc_pa);
+        CalculatePolarizationAngle(stokes_data.at("Q").data(), stokes_data.at("U").data(), pa.data(), pa.size());
 
-        if (stokes_flag["I"]) { // Set NAN for PA if stokes I is NAN or below the threshold
-            std::transform(stokes_data["I"].begin(), stokes_data["I"].end(), pa.begin(), pa.begin(), threshold_cut);
+        if (stokes_flag.at("I")) { // Set NAN for PA if stokes I is NAN or below the threshold
+            std::transform(stokes_data.at("I").begin(), stokes_data.at("I").end(), pa.begin(), pa.begin(), threshold_cut);
         }
         FillTileData(tile_pa, tile.x, tile.y, tile.layer, _smoothing_factor, width, height, pa, _compression_type, _compression_quality);
     }
 
-    // Send response message
-    response.set_progress(progress);
-    callback(response);
+    return response;
+}
+
+std::vector<std::string> VectorField::MissingTileData(
+    int z, int mip, int num_tiles, size_t num_pixels, const std::unordered_map<std::string, int>& stokes_indices) {
+    if (z != _tile_data_z || mip != _tile_data_mip || num_tiles != (int)_tile_data.size()) {
+        ClearTileData();
+        _tile_data_z = z;
+        _tile_data_mip = mip;
+        _tile_data.resize(num_tiles);
+    }
+
+    _keep_tile_data = num_pixels * stokes_indices.size() * sizeof(float) <= VECTOR_FIELD_TILE_DATA_SIZE_MB * 1024 * 1024;
+    if (!_keep_tile_data) {
+        // Too large to cache: every stokes is read for each tile, and released once the tile is sent
+        _tile_data_stokes.clear();
+        std::vector<std::string> all_stokes;
+        for (const auto& [stokes, stokes_index] : stokes_indices) {
+            all_stokes.push_back(stokes);
+        }
+        return all_stokes;
+    }
+
+    std::vector<std::string> missing_stokes;
+    for (const auto& [stokes, stokes_index] : stokes_indices) {
+        if (!_tile_data_stokes.count(stokes) || _tile_data_stokes[stokes] != stokes_index) {
+            // Data for another stokes index (e.g. the current stokes has changed) is replaced
+            _tile_data_stokes[stokes] = stokes_index;
+            missing_stokes.push_back(stokes);
+        }
+    }
+    return missing_stokes;
+}
+
+std::unordered_map<std::string, std::vector<float>>& VectorField::TileData(int tile_index) {
+    return _tile_data[tile_index];
+}
+
+void VectorField::ReleaseTileData(int tile_index) {
+    if (!_keep_tile_data) {
+        std::unordered_map<std::string, std::vector<float>>().swap(_tile_data[tile_index]);
+    }
+}
+
+void VectorField::ClearTileData() {
+    _tile_data_z = -1;
+    _tile_data_mip = 0;
+    _tile_data_stokes.clear();
+    _tile_data.clear();
 }
 
 void VectorField::ClearSettings() {
@@ -203,4 +255,212 @@ CARTA::ImageBounds GetImageBounds(const Tile& tile, int image_width, int image_h
     return bounds;
 }
 
+// Polynomial approximation of atan on [0, 1] from the Cephes library, with the range reduced to [0, tan(pi/8)]
+#define ATAN_TAN_PI_8 0.414213562373095f
+#define ATAN_P0 8.05374449538e-2f
+#define ATAN_P1 -1.38776856032e-1f
+#define ATAN_P2 1.99777106478e-1f
+#define ATAN_P3 -3.33329491539e-1f
+
+static void PolarizedIntensitySSE(const float* q, const float* u, float* pi, size_t size, double q_error, double u_error) {
+    const __m128d debias = _mm_set1_pd((std::pow(q_error, 2) + std::pow(u_error, 2)) / 2.0);
+    const __m128 nan = _mm_set1_ps(FLOAT_NAN);
+    const size_t blocked_size = 4 * (size / 4);
+    for (size_t i = 0; i < blocked_size; i += 4) {
+        __m128 q_vec = _mm_loadu_ps(q + i);
+        __m128 u_vec = _mm_loadu_ps(u + i);
+        // Double precision, matching the scalar calculation
+        __m128d q_low = _mm_cvtps_pd(q_vec), q_high = _mm_cvtps_pd(_mm_movehl_ps(q_vec, q_vec));
+        __m128d u_low = _mm_cvtps_pd(u_vec), u_high = _mm_cvtps_pd(_mm_movehl_ps(u_vec, u_vec));
+        __m128d low = _mm_sqrt_pd(_mm_sub_pd(_mm_add_pd(_mm_mul_pd(q_low, q_low), _mm_mul_pd(u_low, u_low)), debias));
+        __m128d high = _mm_sqrt_pd(_mm_sub_pd(_mm_add_pd(_mm_mul_pd(q_high, q_high), _mm_mul_pd(u_high, u_high)), debias));
+        __m128 result = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+        _mm_storeu_ps(pi + i, _mm_blendv_ps(nan, result, _mm_cmpord_ps(q_vec, u_vec)));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pi + blocked_size, VectorField::CalcPi(q_error, u_error));
+}
+
+static void PolarizationAngleSSE(const float* q, const float* u, float* pa, size_t size) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 pi_4 = _mm_set1_ps(casacore::C::pi / 4);
+    const __m128 pi_2 = _mm_set1_ps(casacore::C::pi / 2);
+    const __m128 pi = _mm_set1_ps(casacore::C::pi);
+    const __m128 degrees = _mm_set1_ps((float)(180.0 / casacore::C::pi));
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 nan = _mm_set1_ps(FLOAT_NAN);
+    const size_t blocked_size = 4 * (size / 4);
+    for (size_t i = 0; i < blocked_size; i += 4) {
+        __m128 q_vec = _mm_loadu_ps(q + i);
+        __m128 u_vec = _mm_loadu_ps(u + i);
+        __m128 q_abs = _mm_andnot_ps(sign_mask, q_vec);
+        __m128 u_abs = _mm_andnot_ps(sign_mask, u_vec);
+        __m128 max_abs = _mm_max_ps(q_abs, u_abs);
+        __m128 a = _mm_div_ps(_mm_min_ps(q_abs, u_abs), max_abs);
+        a = _mm_blendv_ps(a, zero, _mm_cmpeq_ps(max_abs, zero));
+
+        __m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(ATAN_TAN_PI_8));
+        __m128 x = _mm_blendv_ps(a, _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one)), reduce);
+        __m128 z = _mm_mul_ps(x, x);
+        __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ATAN_P0), z), _mm_set1_ps(ATAN_P1));
+        r = _mm_add_ps(_mm_mul_ps(r, z), _mm_set1_ps(ATAN_P2));
+        r = _mm_add_ps(_mm_mul_ps(r, z), _mm_set1_ps(ATAN_P3));
+        r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, z), x), x);
+        r = _mm_add_ps(r, _mm_and_ps(reduce, pi_4));
+
+        // Octant corrections, and the sign of u
+        r = _mm_blendv_ps(r, _mm_sub_ps(pi_2, r), _mm_cmpgt_ps(u_abs, q_abs));
+        r = _mm_blendv_ps(r, _mm_sub_ps(pi, r), q_vec);
+        r = _mm_or_ps(r, _mm_and_ps(sign_mask, u_vec));
+
+        __m128 result = _mm_div_ps(_mm_mul_ps(degrees, r), two);
+        _mm_storeu_ps(pa + i, _mm_blendv_ps(nan, result, _mm_cmpord_ps(q_vec, u_vec)));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pa + blocked_size, VectorField::CalcPa());
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX2 static void PolarizedIntensityAVX2(
+    const float* q, const float* u, float* pi, size_t size, double q_error, double u_error) {
+    const __m256d debias = _mm256_set1_pd((std::pow(q_error, 2) + std::pow(u_error, 2)) / 2.0);
+    const __m256 nan = _mm256_set1_ps(FLOAT_NAN);
+    const size_t blocked_size = 8 * (size / 8);
+    for (size_t i = 0; i < blocked_size; i += 8) {
+        __m256 q_vec = _mm256_loadu_ps(q + i);
+        __m256 u_vec = _mm256_loadu_ps(u + i);
+        __m256d q_low = _mm256_cvtps_pd(_mm256_castps256_ps128(q_vec)), q_high = _mm256_cvtps_pd(_mm256_extractf128_ps(q_vec, 1));
+        __m256d u_low = _mm256_cvtps_pd(_mm256_castps256_ps128(u_vec)), u_high = _mm256_cvtps_pd(_mm256_extractf128_ps(u_vec, 1));
+        __m256d low = _mm256_sqrt_pd(_mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(q_low, q_low), _mm256_mul_pd(u_low, u_low)), debias));
+        __m256d high = _mm256_sqrt_pd(_mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(q_high, q_high), _mm256_mul_pd(u_high, u_high)), debias));
+        __m256 result = _mm256_set_m128(_mm256_cvtpd_ps(high), _mm256_cvtpd_ps(low));
+        _mm256_storeu_ps(pi + i, _mm256_blendv_ps(nan, result, _mm256_cmp_ps(q_vec, u_vec, _CMP_ORD_Q)));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pi + blocked_size, VectorField::CalcPi(q_error, u_error));
+}
+
+SIMD_TARGET_AVX2 static void PolarizationAngleAVX2(const float* q, const float* u, float* pa, size_t size) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 pi_4 = _mm256_set1_ps(casacore::C::pi / 4);
+    const __m256 pi_2 = _mm256_set1_ps(casacore::C::pi / 2);
+    const __m256 pi = _mm256_set1_ps(casacore::C::pi);
+    const __m256 degrees = _mm256_set1_ps((float)(180.0 / casacore::C::pi));
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 nan = _mm256_set1_ps(FLOAT_NAN);
+    const size_t blocked_size = 8 * (size / 8);
+    for (size_t i = 0; i < blocked_size; i += 8) {
+        __m256 q_vec = _mm256_loadu_ps(q + i);
+        __m256 u_vec = _mm256_loadu_ps(u + i);
+        __m256 q_abs = _mm256_andnot_ps(sign_mask, q_vec);
+        __m256 u_abs = _mm256_andnot_ps(sign_mask, u_vec);
+        __m256 max_abs = _mm256_max_ps(q_abs, u_abs);
+        __m256 a = _mm256_div_ps(_mm256_min_ps(q_abs, u_abs), max_abs);
+        a = _mm256_blendv_ps(a, zero, _mm256_cmp_ps(max_abs, zero, _CMP_EQ_OQ));
+
+        __m256 reduce = _mm256_cmp_ps(a, _mm256_set1_ps(ATAN_TAN_PI_8), _CMP_GT_OQ);
+        __m256 x = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), reduce);
+        __m256 z = _mm256_mul_ps(x, x);
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ATAN_P0), z), _mm256_set1_ps(ATAN_P1));
+        r = _mm256_add_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(ATAN_P2));
+        r = _mm256_add_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(ATAN_P3));
+        r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(r, z), x), x);
+        r = _mm256_add_ps(r, _mm256_and_ps(reduce, pi_4));
+
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(pi_2, r), _mm256_cmp_ps(u_abs, q_abs, _CMP_GT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(pi, r), q_vec);
+        r = _mm256_or_ps(r, _mm256_and_ps(sign_mask, u_vec));
+
+        __m256 result = _mm256_div_ps(_mm256_mul_ps(degrees, r), two);
+        _mm256_storeu_ps(pa + i, _mm256_blendv_ps(nan, result, _mm256_cmp_ps(q_vec, u_vec, _CMP_ORD_Q)));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pa + blocked_size, VectorField::CalcPa());
+}
+
+SIMD_TARGET_AVX512 static void PolarizedIntensityAVX512(
+    const float* q, const float* u, float* pi, size_t size, double q_error, double u_error) {
+    const __m512d debias = _mm512_set1_pd((std::pow(q_error, 2) + std::pow(u_error, 2)) / 2.0);
+    const __m512 nan = _mm512_set1_ps(FLOAT_NAN);
+    const size_t blocked_size = 16 * (size / 16);
+    for (size_t i = 0; i < blocked_size; i += 16) {
+        __m512 q_vec = _mm512_loadu_ps(q + i);
+        __m512 u_vec = _mm512_loadu_ps(u + i);
+        __m512d q_low = _mm512_cvtps_pd(_mm512_castps512_ps256(q_vec));
+        __m512d q_high = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(q_vec), 1)));
+        __m512d u_low = _mm512_cvtps_pd(_mm512_castps512_ps256(u_vec));
+        __m512d u_high = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(u_vec), 1)));
+        __m512d low = _mm512_sqrt_pd(_mm512_sub_pd(_mm512_add_pd(_mm512_mul_pd(q_low, q_low), _mm512_mul_pd(u_low, u_low)), debias));
+        __m512d high = _mm512_sqrt_pd(_mm512_sub_pd(_mm512_add_pd(_mm512_mul_pd(q_high, q_high), _mm512_mul_pd(u_high, u_high)), debias));
+        __m512 result = _mm512_castpd_ps(
+            _mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(low))), _mm256_castps_pd(_mm512_cvtpd_ps(high)), 1));
+        _mm512_storeu_ps(pi + i, _mm512_mask_blend_ps(_mm512_cmp_ps_mask(q_vec, u_vec, _CMP_ORD_Q), nan, result));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pi + blocked_size, VectorField::CalcPi(q_error, u_error));
+}
+
+SIMD_TARGET_AVX512 static void PolarizationAngleAVX512(const float* q, const float* u, float* pa, size_t size) {
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 pi_4 = _mm512_set1_ps(casacore::C::pi / 4);
+    const __m512 pi_2 = _mm512_set1_ps(casacore::C::pi / 2);
+    const __m512 pi = _mm512_set1_ps(casacore::C::pi);
+    const __m512 degrees = _mm512_set1_ps((float)(180.0 / casacore::C::pi));
+    const __m512 two = _mm512_set1_ps(2.0f);
+    const __m512 nan = _mm512_set1_ps(FLOAT_NAN);
+    const __m512i sign_mask = _mm512_set1_epi32(0x80000000);
+    const size_t blocked_size = 16 * (size / 16);
+    for (size_t i = 0; i < blocked_size; i += 16) {
+        __m512 q_vec = _mm512_loadu_ps(q + i);
+        __m512 u_vec = _mm512_loadu_ps(u + i);
+        __m512 q_abs = _mm512_abs_ps(q_vec);
+        __m512 u_abs = _mm512_abs_ps(u_vec);
+        __m512 max_abs = _mm512_max_ps(q_abs, u_abs);
+        __m512 a = _mm512_div_ps(_mm512_min_ps(q_abs, u_abs), max_abs);
+        a = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(max_abs, zero, _CMP_EQ_OQ), a, zero);
+
+        __mmask16 reduce = _mm512_cmp_ps_mask(a, _mm512_set1_ps(ATAN_TAN_PI_8), _CMP_GT_OQ);
+        __m512 x = _mm512_mask_div_ps(a, reduce, _mm512_sub_ps(a, one), _mm512_add_ps(a, one));
+        __m512 z = _mm512_mul_ps(x, x);
+        __m512 r = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(ATAN_P0), z), _mm512_set1_ps(ATAN_P1));
+        r = _mm512_add_ps(_mm512_mul_ps(r, z), _mm512_set1_ps(ATAN_P2));
+        r = _mm512_add_ps(_mm512_mul_ps(r, z), _mm512_set1_ps(ATAN_P3));
+        r = _mm512_add_ps(_mm512_mul_ps(_mm512_mul_ps(r, z), x), x);
+        r = _mm512_mask_add_ps(r, reduce, r, pi_4);
+
+        r = _mm512_mask_sub_ps(r, _mm512_cmp_ps_mask(u_abs, q_abs, _CMP_GT_OQ), pi_2, r);
+        r = _mm512_mask_sub_ps(r, _mm512_test_epi32_mask(_mm512_castps_si512(q_vec), sign_mask), pi, r);
+        r = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(r), _mm512_and_si512(sign_mask, _mm512_castps_si512(u_vec))));
+
+        __m512 result = _mm512_div_ps(_mm512_mul_ps(degrees, r), two);
+        _mm512_storeu_ps(pa + i, _mm512_mask_blend_ps(_mm512_cmp_ps_mask(q_vec, u_vec, _CMP_ORD_Q), nan, result));
+    }
+    std::transform(q + blocked_size, q + size, u + blocked_size, pa + blocked_size, VectorField::CalcPa());
+}
+#endif
+
+void CalculatePolarizedIntensity(const float* q, const float* u, float* pi, size_t size, double q_error, double u_error) {
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        return PolarizedIntensityAVX512(q, u, pi, size, q_error, u_error);
+    } else if (simd_level >= SimdLevel::AVX2) {
+        return PolarizedIntensityAVX2(q, u, pi, size, q_error, u_error);
+    }
+#endif
+    PolarizedIntensitySSE(q, u, pi, size, q_error, u_error);
+}
+
+void CalculatePolarizationAngle(const float* q, const float* u, float* pa, size_t size) {
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        return PolarizationAngleAVX512(q, u, pa, size);
+    } else if (simd_level >= SimdLevel::AVX2) {
+        return PolarizationAngleAVX2(q, u, pa, size);
+    }
+#endif
+    PolarizationAngleSSE(q, u, pa, size);
+}
+
 } // namespace carta
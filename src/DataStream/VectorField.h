@@ -16,6 +16,8 @@
 #include "Util/Image.h"
 
 #define FLOAT_NAN std::numeric_limits<float>::quiet_NaN()
+// Largest downsampled tile data kept between vector field calculations
+#define VECTOR_FIELD_TILE_DATA_SIZE_MB 256
 
 namespace carta {
 
@@ -26,9 +28,19 @@ public:
     bool SetParameters(const CARTA::SetVectorOverlayParameters& message, int stokes_axis);
     bool ClearParameters(const std::function<void(CARTA::VectorOverlayTileData&)>& callback, int z_index);
 
-    void CalculatePiPa(std::unordered_map<std::string, std::vector<float>>& stokes_data, std::unordered_map<std::string, bool>& stokes_flag,
-        const Tile& tile, int width, int height, int z_index, double progress,
-        const std::function<void(CARTA::VectorOverlayTileData&)>& callback);
+    // Response for one tile, without the progress
+    CARTA::VectorOverlayTileData CalculatePiPa(const std::unordered_map<std::string, std::vector<float>>& stokes_data,
+        const std::unordered_map<std::string, bool>& stokes_flag, const Tile& tile, int width, int height, int z_index);
+
+    // Cache of downsampled tile data for each stokes name ("I", "Q", "U", or "CUR" for the current stokes). Resets the cache if the
+    // channel, mip or number of tiles changed, and returns the stokes names which are not cached for the given stokes indices. Data is
+    // only kept if num_pixels (of each stokes) for all the stokes fits in VECTOR_FIELD_TILE_DATA_SIZE_MB.
+    std::vector<std::string> MissingTileData(
+        int z, int mip, int num_tiles, size_t num_pixels, const std::unordered_map<std::string, int>& stokes_indices);
+    std::unordered_map<std::string, std::vector<float>>& TileData(int tile_index);
+    // Frees the data of a tile once it has been used, if it is not cached
+    void ReleaseTileData(int tile_index);
+    void ClearTileData();
 
     int Mip() const {
         return _smoothing_factor;
@@ -130,12 +142,24 @@ protected:
     bool _calculate_pa;
     bool _current_stokes_as_pi;
     bool _current_stokes_as_pa;
+
+    // Downsampled tile data, kept while only the threshold, debiasing or fractional settings change
+    int _tile_data_z;
+    int _tile_data_mip;
+    std::unordered_map<std::string, int> _tile_data_stokes;
+    bool _keep_tile_data;
+    std::vector<std::unordered_map<std::string, std::vector<float>>> _tile_data;
 };
 
 void GetTiles(int image_width, int image_height, int mip, std::vector<carta::Tile>& tiles);
 
 CARTA::ImageBounds GetImageBounds(const carta::Tile& tile, int image_width, int image_height, int mip);
 
+// Vectorized equivalents of VectorField::CalcPi and VectorField::CalcPa, using the best instruction set available at runtime. The angle
+// is calculated with a polynomial approximation of atan2, accurate to about 1e-5 degrees.
+void CalculatePolarizedIntensity(const float* q, const float* u, float* pi, size_t size, double q_error, double u_error);
+void CalculatePolarizationAngle(const float* q, const float* u, float* pa, size_t size);
+
 } // namespace carta
 
 #endif // CARTA_SRC_DATASTREAM_VECTORFIELD_H_
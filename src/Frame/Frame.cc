@@ -7,6 +7,7 @@
 #include "Frame.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <fstream>
@@ -23,8 +24,11 @@
 #include "DataStream/Compression.h"
 #include "DataStream/Contouring.h"
 #include "DataStream/Smoothing.h"
+#include "ImageData/PolarizationCalculator.h"
 #include "ImageStats/StatsCalculator.h"
 #include "Logger/Logger.h"
+#include "Region/RegionMask.h"
+#include "ThreadingManager/ThreadingManager.h"
 #include "Timer/Timer.h"
 
 static const int HIGH_COMPRESSION_QUALITY(32);
@@ -35,6 +39,7 @@ Frame::Frame(uint32_t session_id, std::shared_ptr<FileLoader> loader, const std:
     : _session_id(session_id),
       _valid(true),
       _loader(loader),
+      _hdu(hdu),
       _tile_cache(0),
       _x_axis(0),
       _y_axis(1),
@@ -135,6 +140,20 @@ std::string Frame::GetFileName() {
     return filename;
 }
 
+std::string Frame::GetImageId() {
+    std::string image_id;
+
+    if (_loader && !_loader->IsGenerated()) {
+        std::error_code error;
+        auto modify_time = fs::last_write_time(_loader->GetFileName(), error);
+        if (!error) {
+            image_id = fmt::format("{}:{}:{}", _loader->GetFileName(), _hdu, modify_time.time_since_epoch().count());
+        }
+    }
+
+    return image_id;
+}
+
 std::shared_ptr<casacore::CoordinateSystem> Frame::CoordinateSystem(const StokesSource& stokes_source) {
     if (IsValid()) {
         return _loader->GetCoordinateSystem(stokes_source);
@@ -610,6 +629,9 @@ bool Frame::SetContourParameters(const CARTA::SetContourParameters& message) {
         message.smoothing_factor(), message.decimation_factor(), message.compression_level(), message.contour_chunk_size(),
         message.reference_file_id()};
 
+    // The viewport only changes the order in which contours are sent
+    _contour_bounds = message.image_bounds();
+
     if (_contour_settings != new_settings) {
         _contour_settings = new_settings;
         return true;
@@ -617,42 +639,111 @@ bool Frame::SetContourParameters(const CARTA::SetContourParameters& message) {
     return false;
 }
 
-bool Frame::ContourImage(ContourCallback& partial_contour_callback) {
-    // Always use the full image cache (for now)
-    FillImageCache();
+bool Frame::ContourImage(int z, int stokes, ContourCallback& partial_contour_callback) {
+    if (ZStokesChanged(z, stokes)) {
+        return false;
+    }
 
     double scale = 1.0;
     double offset = 0;
     bool smooth_successful = false;
     std::vector<std::vector<float>> vertex_data;
     std::vector<std::vector<int>> index_data;
+    int64_t priority_row_start = _contour_bounds.y_min();
+    int64_t priority_row_end = _contour_bounds.y_max();
+
+    if ((_contour_settings.smoothing_mode == CARTA::SmoothingMode::NoSmoothing || _contour_settings.smoothing_factor <= 1) &&
+        !_image_cache_valid && _use_tile_cache) {
+        // Stream rows of tiles from the tile cache rather than loading the full image; bands match the tile rows. Tracing stops if the
+        // tile cache is reset for another channel or stokes, so that bands from different planes are not mixed.
+        auto copy_tile_rows = [&](int64_t tile_y, int64_t j_start, int64_t j_end, float* rows) {
+            for (int64_t tile_x = 0; tile_x < _width; tile_x += TILE_SIZE) {
+                int64_t tile_width = std::min<int64_t>(TILE_SIZE, _width - tile_x);
+                auto tile = _tile_cache.Get(TileCache::Key(tile_x, tile_y), z, stokes, _loader, _image_mutex);
+                if (!tile) {
+                    return false;
+                }
+                for (int64_t j = j_start; j < j_end; j++) {
+                    auto tile_row = tile->begin() + (j - tile_y) * tile_width;
+                    std::copy(tile_row, tile_row + tile_width, rows + (j - j_start) * _width + tile_x);
+                }
+            }
+            return true;
+        };
+
+        // A band also needs the first row of the next tile row as its bottom seam. The first row of each tile row is kept by
+        // whichever band reads it first, so a band whose neighbour is already loaded does not read the next tile row again.
+        int64_t num_tile_rows = (_height - 1) / TILE_SIZE + 1;
+        std::vector<std::vector<float>> first_rows(num_tile_rows);
+        std::vector<std::once_flag> first_rows_loaded(num_tile_rows);
+
+        auto get_rows = [&](int64_t row_start, int64_t num_rows, std::vector<float>& buffer) -> const float* {
+            buffer.resize(num_rows * _width);
+            int64_t row_end = row_start + num_rows;
+            for (int64_t tile_y = row_start / TILE_SIZE * TILE_SIZE; tile_y < row_end; tile_y += TILE_SIZE) {
+                int64_t tile_row = tile_y / TILE_SIZE;
+                int64_t tile_height = std::min<int64_t>(TILE_SIZE, _height - tile_y);
+                int64_t j_start = std::max(row_start, tile_y);
+                int64_t j_end = std::min(row_end, tile_y + tile_height);
+                float* rows = buffer.data() + (j_start - row_start) * _width;
+
+                if (j_start == tile_y && j_end == tile_y + 1) {
+                    std::call_once(first_rows_loaded[tile_row], [&]() {
+                        first_rows[tile_row].resize(_width);
+                        if (!copy_tile_rows(tile_y, tile_y, tile_y + 1, first_rows[tile_row].data())) {
+                            first_rows[tile_row].clear();
+                        }
+                    });
+                    if (first_rows[tile_row].empty()) {
+                        return nullptr;
+                    }
+                    std::copy(first_rows[tile_row].begin(), first_rows[tile_row].end(), rows);
+                } else {
+                    if (!copy_tile_rows(tile_y, j_start, j_end, rows)) {
+                        return nullptr;
+                    }
+                    if (j_start == tile_y) {
+                        std::call_once(first_rows_loaded[tile_row], [&]() { first_rows[tile_row].assign(rows, rows + _width); });
+                    }
+                }
+            }
+            return buffer.data();
+        };
+        return TraceContours(get_rows, _width, _height, scale, offset, _contour_settings.levels, vertex_data, index_data,
+            _contour_settings.chunk_size, partial_contour_callback, TILE_SIZE, priority_row_start, priority_row_end);
+    }
+
+    FillImageCache();
     queuing_rw_mutex_scoped cache_lock(&_cache_mutex, false);
+    if (ZStokesChanged(z, stokes)) {
+        // Image cache has been filled for another plane
+        return false;
+    }
 
     if (_contour_settings.smoothing_mode == CARTA::SmoothingMode::NoSmoothing || _contour_settings.smoothing_factor <= 1) {
-        TraceContours(_image_cache.get(), _width, _height, scale, offset, _contour_settings.levels, vertex_data, index_data,
-            _contour_settings.chunk_size, partial_contour_callback);
-        return true;
+        return TraceContours(_image_cache.get(), _width, _height, scale, offset, _contour_settings.levels, vertex_data, index_data,
+            _contour_settings.chunk_size, partial_contour_callback, CONTOUR_BAND_ROWS, priority_row_start, priority_row_end);
     } else if (_contour_settings.smoothing_mode == CARTA::SmoothingMode::GaussianBlur) {
         // Smooth the image from cache
         int mask_size = (_contour_settings.smoothing_factor - 1) * 2 + 1;
         int64_t kernel_width = (mask_size - 1) / 2;
 
         int64_t source_width = _width;
-        int64_t source_height = _height;
         int64_t dest_width = _width - (2 * kernel_width);
         int64_t dest_height = _height - (2 * kernel_width);
-        std::unique_ptr<float[]> dest_array(new float[dest_width * dest_height]);
-        smooth_successful = GaussianSmooth(
-            _image_cache.get(), dest_array.get(), source_width, source_height, dest_width, dest_height, _contour_settings.smoothing_factor);
-        // Can release lock early, as we're no longer using the image cache
-        cache_lock.release();
-        if (smooth_successful) {
-            // Perform contouring with an offset based on the Gaussian smoothing apron size
-            offset = _contour_settings.smoothing_factor - 1;
-            TraceContours(dest_array.get(), dest_width, dest_height, scale, offset, _contour_settings.levels, vertex_data, index_data,
-                _contour_settings.chunk_size, partial_contour_callback);
-            return true;
-        }
+        // Perform contouring with an offset based on the Gaussian smoothing apron size
+        offset = _contour_settings.smoothing_factor - 1;
+
+        // Smooth each band of rows when it is traced, rather than allocating the full smoothed image
+        auto get_rows = [&](int64_t row_start, int64_t num_rows, std::vector<float>& buffer) -> const float* {
+            buffer.resize(num_rows * dest_width);
+            bool smoothed = GaussianSmoothSeparable(_image_cache.get() + row_start * source_width, buffer.data(), source_width,
+                num_rows + 2 * kernel_width, dest_width, num_rows, _contour_settings.smoothing_factor);
+            return smoothed ? buffer.data() : nullptr;
+        };
+        return TraceContours(get_rows, dest_width, dest_height, scale, offset, _contour_settings.levels, vertex_data, index_data,
+            _contour_settings.chunk_size, partial_contour_callback, CONTOUR_BAND_ROWS, priority_row_start - offset,
+            priority_row_end - offset);
     } else {
         // Block averaging
         CARTA::ImageBounds image_bounds = Message::ImageBounds(0, _width, 0, _height);
@@ -665,9 +756,9 @@ bool Frame::ContourImage(ContourCallback& partial_contour_callback) {
             scale = _contour_settings.smoothing_factor;
             size_t dest_width = ceil(double(image_bounds.x_max()) / _contour_settings.smoothing_factor);
             size_t dest_height = ceil(double(image_bounds.y_max()) / _contour_settings.smoothing_factor);
-            TraceContours(dest_vector.data(), dest_width, dest_height, scale, offset, _contour_settings.levels, vertex_data, index_data,
-                _contour_settings.chunk_size, partial_contour_callback);
-            return true;
+            return TraceContours(dest_vector.data(), dest_width, dest_height, scale, offset, _contour_settings.levels, vertex_data,
+                index_data, _contour_settings.chunk_size, partial_contour_callback, CONTOUR_BAND_ROWS, priority_row_start / scale,
+                priority_row_end / scale);
         }
         spdlog::warn("Smoothing mode not implemented yet!");
         return false;
@@ -970,7 +1061,7 @@ bool Frame::SetStatsRequirements(int region_id, const std::vector<CARTA::SetStat
     return true;
 }
 
-bool Frame::FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_data)> stats_data_callback, int region_id, int file_id) {
+bool Frame::FillRegionStatsData(std::function<void(CARTA::RegionStatsData& stats_data)> stats_data_callback, int region_id, int file_id) {
     if (region_id != IMAGE_REGION_ID) {
         return false;
     }
@@ -980,6 +1071,7 @@ bool Frame::FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_
     }
 
     int z(CurrentZ()); // Use current channel
+    thread_local MessageArena arena;
 
     for (auto stats_config : _image_required_stats) {
         // Get stokes index
@@ -988,8 +1080,9 @@ bool Frame::FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_
             continue;
         }
 
-        // Set response message
-        auto stats_data = Message::RegionStatsData(file_id, region_id, z, stokes);
+        // Set response message; the previous one has been sent
+        arena.Reset();
+        auto& stats_data = *Message::RegionStatsData(arena.Get(), file_id, region_id, z, stokes);
 
         // Set required stats types
         std::vector<CARTA::StatsType> required_stats;
@@ -1094,7 +1187,7 @@ bool Frame::FillSpatialProfileData(PointXy point, std::vector<CARTA::SetSpatialR
 
     if (spatial_configs.empty()) { // Only send a spatial data message for the cursor value with current stokes
         auto spatial_data = Message::SpatialProfileData(x, y, CurrentZ(), CurrentStokes(), cursor_value_with_current_stokes);
-        spatial_data_vec.push_back(spatial_data);
+        spatial_data_vec.push_back(std::move(spatial_data));
         return true;
     }
 
@@ -1340,7 +1433,7 @@ bool Frame::FillSpatialProfileData(PointXy point, std::vector<CARTA::SetSpatialR
         }
 
         // Fill the spatial profile data with respect to the stokes in a vector
-        spatial_data_vec.emplace_back(spatial_data);
+        spatial_data_vec.emplace_back(std::move(spatial_data));
     }
 
     spdlog::performance("Fill spatial profile in {:.3f} ms", t.Elapsed().ms());
@@ -1389,7 +1482,7 @@ bool Frame::SetSpectralRequirements(int region_id, const std::vector<CARTA::SetS
     return true;
 }
 
-bool Frame::FillSpectralProfileData(std::function<void(CARTA::SpectralProfileData profile_data)> cb, int region_id, bool stokes_changed) {
+bool Frame::FillSpectralProfileData(std::function<void(CARTA::SpectralProfileData& profile_data)> cb, int region_id, bool stokes_changed) {
     // Send cursor profile data incrementally using callback cb
     // If fixed stokes requirement and stokes changed, do not send that profile
     if (region_id != CURSOR_REGION_ID) {
@@ -1533,12 +1626,14 @@ bool Frame::FillSpectralProfileData(std::function<void(CARTA::SpectralProfileDat
                         // reset profile timer and send partial profile message
                         t_start_profile = t_end_slice;
 
-                        auto partial_data = Message::SpectralProfileData(CurrentStokes(), progress);
-                        auto partial_profile = partial_data.add_profiles();
+                        thread_local MessageArena arena;
+                        auto* partial_data = Message::SpectralProfileData(arena.Get(), CurrentStokes(), progress);
+                        auto partial_profile = partial_data->add_profiles();
                         partial_profile->set_stats_type(config.all_stats[0]);
                         partial_profile->set_coordinate(config.coordinate);
                         partial_profile->set_raw_values_fp32(spectral_data.data(), spectral_data.size() * sizeof(float));
-                        cb(partial_data);
+                        cb(*partial_data);
+                        arena.Reset();
                     }
                 }
             }
@@ -1614,6 +1709,7 @@ bool Frame::GetRegionData(const StokesRegion& stokes_region, std::vector<float>&
     // Get image data with a region applied
     Timer t;
     std::vector<bool> region_mask;
+    bool mask_applied(false);
 
     if (IsCurrentZStokes(stokes_region.stokes_source)) {
         try {
@@ -1623,9 +1719,16 @@ bool Frame::GetRegionData(const StokesRegion& stokes_region, std::vector<float>&
             data.resize(bounding_box.length().product());
 
             if (GetSlicerData(stokes_slicer, data.data())) {
-                // Next get the LCRegion as a mask (LCRegion is a Lattice<bool>)
-                casacore::Array<bool> tmpmask = stokes_region.image_region.asLCRegion().get();
-                region_mask = tmpmask.tovector();
+                auto xy_mask = stokes_region.region_mask;
+                if (xy_mask && (data.size() == static_cast<size_t>(xy_mask->Width()) * xy_mask->Height())) {
+                    // Apply rasterized mask for the bounding box directly
+                    xy_mask->ApplyToData(data.data());
+                    mask_applied = true;
+                } else {
+                    // Next get the LCRegion as a mask (LCRegion is a Lattice<bool>)
+                    casacore::Array<bool> tmpmask = stokes_region.image_region.asLCRegion().get();
+                    region_mask = tmpmask.tovector();
+                }
             } else {
                 data.clear();
             }
@@ -1679,9 +1782,11 @@ bool Frame::GetRegionData(const StokesRegion& stokes_region, std::vector<float>&
     }
 
     // Apply mask to data
-    for (size_t i = 0; i < data.size(); ++i) {
-        if (!region_mask[i]) {
-            data[i] = NAN;
+    if (!mask_applied) {
+        for (size_t i = 0; i < data.size(); ++i) {
+            if (!region_mask[i]) {
+                data[i] = NAN;
+            }
         }
     }
 
@@ -1720,6 +1825,8 @@ bool Frame::GetSlicerData(const StokesSlicer& stokes_slicer, float* data) {
         casacore::Array<float> image_cache_as_array(cache_shape, _image_cache.get(), casacore::StorageInitPolicy::SHARE);
         tmp = image_cache_as_array(cache_slicer);
         data_ok = true;
+    } else if (!stokes_slicer.stokes_source.IsOriginalImage() && GetComputedStokesData(stokes_slicer, data)) {
+        data_ok = true;
     } else {
         // Use loader to slice image
         std::unique_lock<std::mutex> ulock(_image_mutex);
@@ -1764,6 +1871,70 @@ bool Frame::UseLoaderSpectralData(const casacore::IPosition& region_shape) {
     return _loader->UseRegionSpectralData(region_shape, _image_mutex);
 }
 
+bool Frame::GetComputedStokesData(const StokesSlicer& stokes_slicer, float* data) {
+    // Read the stokes I, Q, U or V slices needed for the computed stokes once each, and calculate the result in a single pass.
+    // Falls back to the computed stokes image if the slices are not available.
+    int stokes = stokes_slicer.stokes_source.stokes;
+    if (_stokes_axis < 0) {
+        return false;
+    }
+
+    std::vector<std::string> stokes_types{"Q", "U"};
+    if (stokes == COMPUTE_STOKES_PTOTAL || stokes == COMPUTE_STOKES_PFTOTAL) {
+        stokes_types.push_back("V");
+    }
+    if (stokes == COMPUTE_STOKES_PFTOTAL || stokes == COMPUTE_STOKES_PFLINEAR) {
+        stokes_types.push_back("I");
+    }
+
+    // The computed stokes slicer is relative to the x, y and z ranges of the stokes source
+    const auto& stokes_source = stokes_slicer.stokes_source;
+    casacore::IPosition offset(_image_shape.size(), 0);
+    if (_x_axis >= 0) {
+        offset(_x_axis) = std::max(stokes_source.x_range.from, 0);
+    }
+    if (_y_axis >= 0) {
+        offset(_y_axis) = std::max(stokes_source.y_range.from, 0);
+    }
+    if (_z_axis >= 0) {
+        offset(_z_axis) = (stokes_source.z_range.from == CURRENT_Z ? CurrentZ() : std::max(stokes_source.z_range.from, 0));
+    }
+
+    size_t size = stokes_slicer.slicer.length().product();
+    bool has_stokes_types = !_loader->GetStokesIndices().empty();
+    std::unordered_map<std::string, std::vector<float>> stokes_data;
+    for (const auto& stokes_type : stokes_types) {
+        int stokes_index;
+        if (!_loader->GetStokesTypeIndex(StokesStringTypes[stokes_type], stokes_index)) {
+            if (has_stokes_types) {
+                return false;
+            }
+            // Same assumption as the polarization calculator (I, Q, U, V) if the image has no stokes types
+            stokes_index = StokesValues[StokesStringTypes[stokes_type]] - 1;
+            if (stokes_index >= (int)NumStokes()) {
+                return false;
+            }
+        }
+
+        casacore::IPosition start = stokes_slicer.slicer.start() + offset;
+        casacore::IPosition end = stokes_slicer.slicer.end() + offset;
+        start(_stokes_axis) = end(_stokes_axis) = stokes_index;
+        casacore::Slicer slicer(start, end, stokes_slicer.slicer.stride(), casacore::Slicer::endIsLast);
+        AxisRange z_range = (_z_axis >= 0 ? AxisRange(start(_z_axis), end(_z_axis)) : AxisRange(0));
+        StokesSlicer original_slicer(StokesSource(stokes_index, z_range), slicer); // may be sliced from the image cache
+
+        stokes_data[stokes_type].resize(size);
+        if (!GetSlicerData(original_slicer, stokes_data[stokes_type].data())) {
+            return false;
+        }
+    }
+
+    auto stokes_pointer = [&](const std::string& stokes_type) -> const float* {
+        return stokes_data.count(stokes_type) ? stokes_data[stokes_type].data() : nullptr;
+    };
+    return ComputeStokesData(stokes, stokes_pointer("I"), stokes_pointer("Q"), stokes_pointer("U"), stokes_pointer("V"), data, size);
+}
+
 bool Frame::GetLoaderPointSpectralData(std::vector<float>& profile, int stokes, CARTA::Point& point) {
     return _loader->GetCursorSpectralData(profile, stokes, point.x(), 1, point.y(), 1, _image_mutex);
 }
@@ -1794,6 +1965,23 @@ bool Frame::CalculateMoments(int file_id, GeneratorProgressCallback progress_cal
         }
 
         std::unique_lock<std::mutex> ulock(_image_mutex); // Must lock the image while doing moment calculations
+        if (moment_request.axis() == CARTA::MomentAxis::SPECTRAL && _x_axis == 0 && _y_axis == 1 && _z_axis == 2 &&
+            stokes_region.stokes_source.IsOriginalImage() && _loader->HasData(FileInfo::Data::SWIZZLED)) {
+            // Read contiguous spectra from the swizzled data, offset by the region bounding box
+            try {
+                casacore::Slicer bounding_box = stokes_region.image_region.toLatticeRegion(*CoordinateSystem(), ImageShape()).slicer();
+                int x_min(bounding_box.start()(0)), y_min(bounding_box.start()(1));
+                AxisRange z_range(bounding_box.start()(2), bounding_box.end()(2));
+                int stokes = (_stokes_axis >= 0 ? bounding_box.start()(_stokes_axis) : 0);
+                _moment_generator->SetSpectraReader(
+                    [this, x_min, y_min, z_range, stokes](std::vector<float>& data, int x, int count_x, int y, int count_y) {
+                        return _loader->GetSwizzledSpectra(data, stokes, z_range, x_min + x, count_x, y_min + y, count_y);
+                    });
+            } catch (casacore::AipsError& err) {
+                spdlog::debug("Cannot use swizzled data for moments: {}", err.getMesg());
+            }
+        }
+
         _moment_generator->CalculateMoments(file_id, stokes_region.image_region, _z_axis, _stokes_axis, name_index, progress_callback,
             moment_request, moment_response, collapse_results, region_state, GetStokesType(CurrentStokes()));
         ulock.unlock();
@@ -2454,6 +2642,8 @@ bool Frame::SetVectorOverlayParameters(const CARTA::SetVectorOverlayParameters&
 }
 
 bool Frame::CalculateVectorField(const std::function<void(CARTA::VectorOverlayTileData&)>& callback) {
+    // The cached tile data is used by one calculation at a time
+    std::unique_lock<std::mutex> vector_field_lock(_vector_field_mutex);
     if (_vector_field.ClearParameters(callback, _z_index)) {
         return true;
     }
@@ -2477,48 +2667,66 @@ bool Frame::DoVectorFieldCalculation(const std::function<void(CARTA::VectorOverl
     std::vector<Tile> tiles;
     GetTiles(_width, _height, mip, tiles);
 
-    // Initialize stokes maps for their flags, indices and data
+    // Initialize stokes maps for their flags and indices
     std::unordered_map<std::string, bool> stokes_flag{{"I", false}, {"Q", false}, {"U", false}};
-    std::unordered_map<std::string, int> stokes_indices{{"I", -1}, {"Q", -1}, {"U", -1}};
+    std::unordered_map<std::string, int> stokes_indices;
 
     // Set stokes flags and get their indices
     stokes_flag["I"] = (fractional || !std::isnan(threshold));
     stokes_flag["Q"] = stokes_flag["U"] = (calculate_pi || calculate_pa);
-    for (auto one : stokes_flag) {
-        std::string stokes = one.first;
-        if (stokes_flag[stokes] && !GetStokesTypeIndex(stokes + "x", stokes_indices[stokes])) {
-            return false;
+    if (current_stokes_as_pi || current_stokes_as_pa) {
+        stokes_indices["CUR"] = CurrentStokes();
+    }
+    if (calculate_pi || calculate_pa) {
+        for (auto one : stokes_flag) {
+            std::string stokes = one.first;
+            if (stokes_flag[stokes] && !GetStokesTypeIndex(stokes + "x", stokes_indices[stokes])) {
+                return false;
+            }
         }
     }
 
-    // Get image tiles data
+    // Downsampled tile data is cached for the channel, so that only PI and PA are recalculated when other settings change
+    size_t num_pixels = (size_t)std::ceil((float)_width / mip) * std::ceil((float)_height / mip);
+    auto missing_stokes = _vector_field.MissingTileData(_z_index, mip, tiles.size(), num_pixels, stokes_indices);
+
+    std::atomic<bool> success(true);
+    std::mutex callback_mutex;
+    int num_finished(0);
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < tiles.size(); ++i) {
+        if (!success) {
+            continue;
+        }
         auto& tile = tiles[i];
         auto bounds = GetImageBounds(tile, _width, _height, mip);
-        int width, height;
-        std::unordered_map<std::string, std::vector<float>> stokes_data;
-        double progress = (double)(i + 1) / tiles.size();
-
-        // Get current stokes data
-        if (current_stokes_as_pi || current_stokes_as_pa) {
-            if (!GetDownsampledRasterData(stokes_data["CUR"], width, height, _z_index, CurrentStokes(), bounds, mip)) {
-                return false;
+        int width = std::ceil((float)(bounds.x_max() - bounds.x_min()) / mip);
+        int height = std::ceil((float)(bounds.y_max() - bounds.y_min()) / mip);
+
+        // Get current stokes data, or stokes data I, Q, or U, which is not cached yet
+        auto& stokes_data = _vector_field.TileData(i);
+        for (const auto& stokes : missing_stokes) {
+            if (!GetDownsampledRasterData(stokes_data[stokes], width, height, _z_index, stokes_indices.at(stokes), bounds, mip)) {
+                success = false;
+                break;
             }
         }
-
-        // Get stokes data I, Q, or U
-        if (calculate_pi || calculate_pa) {
-            for (auto one : stokes_flag) {
-                std::string stokes = one.first;
-                if (stokes_flag[stokes] &&
-                    !GetDownsampledRasterData(stokes_data[stokes], width, height, _z_index, stokes_indices[stokes], bounds, mip)) {
-                    return false;
-                }
-            }
+        if (!success) {
+            continue;
         }
 
-        // Calculate PI or PA and then send a partial response message
-        _vector_field.CalculatePiPa(stokes_data, stokes_flag, tile, width, height, _z_index, progress, callback);
+        // Calculate PI or PA in parallel, then send partial response messages one at a time, with the progress in order of completion
+        auto response = _vector_field.CalculatePiPa(stokes_data, stokes_flag, tile, width, height, _z_index);
+        _vector_field.ReleaseTileData(i);
+        std::unique_lock<std::mutex> callback_lock(callback_mutex);
+        response.set_progress((double)(++num_finished) / tiles.size());
+        callback(response);
+    }
+
+    if (!success) {
+        _vector_field.ClearTileData();
+        return false;
     }
     return true;
 }
@@ -93,6 +93,8 @@ public:
 
     // Get the full name of image file
     std::string GetFileName();
+    // Identifies the image data across sessions (file, HDU and modification time); empty for images which are not files on disk
+    std::string GetImageId();
 
     // Returns shared ptr to CoordinateSystem
     std::shared_ptr<casacore::CoordinateSystem> CoordinateSystem(const StokesSource& stokes_source = StokesSource());
@@ -135,7 +137,8 @@ public:
     inline ContourSettings& GetContourParameters() {
         return _contour_settings;
     };
-    bool ContourImage(ContourCallback& partial_contour_callback);
+    // Trace contours of the given plane; returns false if the frame has changed to another z or stokes
+    bool ContourImage(int z, int stokes, ContourCallback& partial_contour_callback);
 
     // Histograms: image and cube
     bool SetHistogramRequirements(int region_id, const std::vector<CARTA::HistogramConfig>& histogram_configs);
@@ -149,7 +152,7 @@ public:
 
     // Stats: image
     bool SetStatsRequirements(int region_id, const std::vector<CARTA::SetStatsRequirements_StatsConfig>& stats_configs);
-    bool FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_data)> stats_data_callback, int region_id, int file_id);
+    bool FillRegionStatsData(std::function<void(CARTA::RegionStatsData& stats_data)> stats_data_callback, int region_id, int file_id);
 
     // Spatial: cursor
     void SetSpatialRequirements(const std::vector<CARTA::SetSpatialRequirements_SpatialConfig>& spatial_profiles);
@@ -159,7 +162,7 @@ public:
 
     // Spectral: cursor
     bool SetSpectralRequirements(int region_id, const std::vector<CARTA::SetSpectralRequirements_SpectralConfig>& spectral_configs);
-    bool FillSpectralProfileData(std::function<void(CARTA::SpectralProfileData profile_data)> cb, int region_id, bool stokes_changed);
+    bool FillSpectralProfileData(std::function<void(CARTA::SpectralProfileData& profile_data)> cb, int region_id, bool stokes_changed);
 
     // Set the flag connected = false, in order to stop the jobs and wait for jobs finished
     void WaitForTaskCancellation();
@@ -264,6 +267,9 @@ protected:
         return (z * 10) + stokes;
     }
 
+    // Computed stokes data from slices of the original stokes data, instead of the computed stokes image expression
+    bool GetComputedStokesData(const StokesSlicer& stokes_slicer, float* data);
+
     // For vector field calculation
     bool DoVectorFieldCalculation(const std::function<void(CARTA::VectorOverlayTileData&)>& callback);
 
@@ -279,6 +285,7 @@ protected:
 
     // Image loader for image type
     std::shared_ptr<FileLoader> _loader;
+    std::string _hdu;
 
     // Shape and axis info: X, Y, Z, Stokes
     casacore::IPosition _image_shape;
@@ -295,6 +302,7 @@ protected:
 
     // Contour settings
     ContourSettings _contour_settings;
+    CARTA::ImageBounds _contour_bounds; // viewport, contoured first
 
     // Image data cache and mutex
     long long int _image_cache_size;
@@ -335,8 +343,9 @@ protected:
     // Image fitter
     std::unique_ptr<ImageFitter> _image_fitter;
 
-    // Vector field settings
+    // Vector field settings and cached tile data
     VectorField _vector_field;
+    std::mutex _vector_field_mutex;
 };
 
 } // namespace carta
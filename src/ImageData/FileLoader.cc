@@ -858,6 +858,12 @@ bool FileLoader::GetCursorSpectralData(
     return false;
 }
 
+bool FileLoader::GetSwizzledSpectra(
+    std::vector<float>& data, int stokes, const AxisRange& z_range, int x, int count_x, int y, int count_y) {
+    // Must be implemented in subclasses
+    return false;
+}
+
 bool FileLoader::UseRegionSpectralData(const casacore::IPosition& region_shape, std::mutex& image_mutex) {
     // Must be implemented in subclasses; should call before GetRegionSpectralData
     return false;
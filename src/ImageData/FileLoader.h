@@ -23,6 +23,8 @@
 
 namespace carta {
 
+class RegionMask;
+
 struct StokesSlicer {
     StokesSource stokes_source;
     casacore::Slicer slicer;
@@ -34,6 +36,7 @@ struct StokesSlicer {
 struct StokesRegion {
     StokesSource stokes_source;
     casacore::ImageRegion image_region;
+    std::shared_ptr<RegionMask> region_mask; // xy mask of image_region, if rasterized in this image
 
     StokesRegion() {}
     StokesRegion(StokesSource stokes_source_, casacore::ImageRegion image_region_)
@@ -105,6 +108,8 @@ public:
     virtual bool GetRegionSpectralData(int region_id, const AxisRange& z_range, int stokes,
         const casacore::ArrayLattice<casacore::Bool>& mask, const casacore::IPosition& origin, std::mutex& image_mutex,
         std::map<CARTA::StatsType, std::vector<double>>& results, float& progress);
+    // Spectra in the z range for a block of pixels from swizzled data (z fastest, then y, then x); the image mutex must be locked
+    virtual bool GetSwizzledSpectra(std::vector<float>& data, int stokes, const AxisRange& z_range, int x, int count_x, int y, int count_y);
     virtual bool GetDownsampledRasterData(
         std::vector<float>& data, int z, int stokes, CARTA::ImageBounds& bounds, int mip, std::mutex& image_mutex);
     virtual bool GetChunk(
@@ -216,30 +216,35 @@ std::unique_ptr<casacore::ArrayBase> Hdf5Loader::GetStatsData(FileInfo::Data ds)
 
 bool Hdf5Loader::GetCursorSpectralData(
     std::vector<float>& data, int stokes, int cursor_x, int count_x, int cursor_y, int count_y, std::mutex& image_mutex) {
-    bool data_ok(false);
-    std::unique_lock<std::mutex> ulock(image_mutex);
-    bool has_swizzled = HasData(FileInfo::Data::SWIZZLED);
-    ulock.unlock();
-    if (has_swizzled) {
-        casacore::Slicer slicer;
-        if (_num_dims == 4) {
-            slicer = casacore::Slicer(
-                casacore::IPosition(4, 0, cursor_y, cursor_x, stokes), casacore::IPosition(4, _depth, count_y, count_x, 1));
-        } else if (_num_dims == 3) {
-            slicer = casacore::Slicer(casacore::IPosition(3, 0, cursor_y, cursor_x), casacore::IPosition(3, _depth, count_y, count_x));
-        }
+    std::lock_guard<std::mutex> lguard(image_mutex);
+    return GetSwizzledSpectra(data, stokes, AxisRange(0, _depth - 1), cursor_x, count_x, cursor_y, count_y);
+}
 
-        data.resize(_depth * count_y * count_x);
-        casacore::Array<float> tmp(slicer.length(), data.data(), casacore::StorageInitPolicy::SHARE);
-        std::lock_guard<std::mutex> lguard(image_mutex);
-        try {
-            LoadSwizzledData()->doGetSlice(tmp, slicer);
-            data_ok = true;
-        } catch (casacore::AipsError& err) {
-            spdlog::warn("Could not load cursor spectral data from swizzled HDF5 dataset. AIPS ERROR: {}", err.getMesg());
-        }
+bool Hdf5Loader::GetSwizzledSpectra(
+    std::vector<float>& data, int stokes, const AxisRange& z_range, int x, int count_x, int y, int count_y) {
+    if (!HasData(FileInfo::Data::SWIZZLED)) {
+        return false;
     }
-    return data_ok;
+
+    int depth = z_range.to - z_range.from + 1;
+    casacore::Slicer slicer;
+    if (_num_dims == 4) {
+        slicer = casacore::Slicer(casacore::IPosition(4, z_range.from, y, x, stokes), casacore::IPosition(4, depth, count_y, count_x, 1));
+    } else if (_num_dims == 3) {
+        slicer = casacore::Slicer(casacore::IPosition(3, z_range.from, y, x), casacore::IPosition(3, depth, count_y, count_x));
+    } else {
+        return false;
+    }
+
+    data.resize(static_cast<size_t>(depth) * count_y * count_x);
+    casacore::Array<float> tmp(slicer.length(), data.data(), casacore::StorageInitPolicy::SHARE);
+    try {
+        LoadSwizzledData()->doGetSlice(tmp, slicer);
+        return true;
+    } catch (casacore::AipsError& err) {
+        spdlog::warn("Could not load spectral data from swizzled HDF5 dataset. AIPS ERROR: {}", err.getMesg());
+    }
+    return false;
 }
 
 bool Hdf5Loader::UseRegionSpectralData(const casacore::IPosition& region_shape, std::mutex& image_mutex) {
@@ -34,6 +34,8 @@ public:
     bool GetRegionSpectralData(int region_id, const AxisRange& spectral_range, int stokes,
         const casacore::ArrayLattice<casacore::Bool>& mask, const casacore::IPosition& origin, std::mutex& image_mutex,
         std::map<CARTA::StatsType, std::vector<double>>& results, float& progress) override;
+    bool GetSwizzledSpectra(
+        std::vector<float>& data, int stokes, const AxisRange& z_range, int x, int count_x, int y, int count_y) override;
     bool GetDownsampledRasterData(
         std::vector<float>& data, int z, int stokes, CARTA::ImageBounds& bounds, int mip, std::mutex& image_mutex) override;
     bool GetChunk(std::vector<float>& data, int& data_width, int& data_height, int min_x, int min_y, int z, int stokes,
@@ -5,7 +5,10 @@
 */
 
 #include "PolarizationCalculator.h"
+#include "DataStream/VectorField.h"
 #include "Logger/Logger.h"
+#include "Util/Simd.h"
+#include "Util/Stokes.h"
 
 using namespace carta;
 
@@ -246,3 +249,113 @@ std::shared_ptr<casacore::ImageInterface<float>> PolarizationCalculator::Compute
     FiddleStokesCoordinate(*image_expr, casacore::Stokes::StokesTypes::Pangle);
     return image_expr;
 }
+
+// Total (if v is given) or linear polarized intensity, as a percentage of stokes I if i is given
+static void StokesIntensityScalar(
+    const float* i, const float* q, const float* u, const float* v, float* result, size_t start, size_t size) {
+    for (size_t k = start; k < size; ++k) {
+        float sum = q[k] * q[k] + u[k] * u[k];
+        if (v) {
+            sum += v[k] * v[k];
+        }
+        float p = std::sqrt(sum);
+        result[k] = i ? 100.0f * p / i[k] : p;
+    }
+}
+
+static void StokesIntensitySSE(const float* i, const float* q, const float* u, const float* v, float* result, size_t size) {
+    const __m128 percent = _mm_set1_ps(100.0f);
+    const size_t blocked_size = 4 * (size / 4);
+    for (size_t k = 0; k < blocked_size; k += 4) {
+        __m128 q_vec = _mm_loadu_ps(q + k);
+        __m128 u_vec = _mm_loadu_ps(u + k);
+        __m128 sum = _mm_add_ps(_mm_mul_ps(q_vec, q_vec), _mm_mul_ps(u_vec, u_vec));
+        if (v) {
+            __m128 v_vec = _mm_loadu_ps(v + k);
+            sum = _mm_add_ps(sum, _mm_mul_ps(v_vec, v_vec));
+        }
+        __m128 p = _mm_sqrt_ps(sum);
+        if (i) {
+            p = _mm_div_ps(_mm_mul_ps(percent, p), _mm_loadu_ps(i + k));
+        }
+        _mm_storeu_ps(result + k, p);
+    }
+    StokesIntensityScalar(i, q, u, v, result, blocked_size, size);
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX static void StokesIntensityAVX(const float* i, const float* q, const float* u, const float* v, float* result, size_t size) {
+    const __m256 percent = _mm256_set1_ps(100.0f);
+    const size_t blocked_size = 8 * (size / 8);
+    for (size_t k = 0; k < blocked_size; k += 8) {
+        __m256 q_vec = _mm256_loadu_ps(q + k);
+        __m256 u_vec = _mm256_loadu_ps(u + k);
+        __m256 sum = _mm256_add_ps(_mm256_mul_ps(q_vec, q_vec), _mm256_mul_ps(u_vec, u_vec));
+        if (v) {
+            __m256 v_vec = _mm256_loadu_ps(v + k);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(v_vec, v_vec));
+        }
+        __m256 p = _mm256_sqrt_ps(sum);
+        if (i) {
+            p = _mm256_div_ps(_mm256_mul_ps(percent, p), _mm256_loadu_ps(i + k));
+        }
+        _mm256_storeu_ps(result + k, p);
+    }
+    StokesIntensityScalar(i, q, u, v, result, blocked_size, size);
+}
+
+SIMD_TARGET_AVX512 static void StokesIntensityAVX512(
+    const float* i, const float* q, const float* u, const float* v, float* result, size_t size) {
+    const __m512 percent = _mm512_set1_ps(100.0f);
+    const size_t blocked_size = 16 * (size / 16);
+    for (size_t k = 0; k < blocked_size; k += 16) {
+        __m512 q_vec = _mm512_loadu_ps(q + k);
+        __m512 u_vec = _mm512_loadu_ps(u + k);
+        __m512 sum = _mm512_add_ps(_mm512_mul_ps(q_vec, q_vec), _mm512_mul_ps(u_vec, u_vec));
+        if (v) {
+            __m512 v_vec = _mm512_loadu_ps(v + k);
+            sum = _mm512_add_ps(sum, _mm512_mul_ps(v_vec, v_vec));
+        }
+        __m512 p = _mm512_sqrt_ps(sum);
+        if (i) {
+            p = _mm512_div_ps(_mm512_mul_ps(percent, p), _mm512_loadu_ps(i + k));
+        }
+        _mm512_storeu_ps(result + k, p);
+    }
+    StokesIntensityScalar(i, q, u, v, result, blocked_size, size);
+}
+#endif
+
+bool carta::ComputeStokesData(int stokes, const float* i, const float* q, const float* u, const float* v, float* result, size_t size) {
+    if (!q || !u) {
+        return false;
+    }
+
+    if (stokes == COMPUTE_STOKES_PANGLE) {
+        CalculatePolarizationAngle(q, u, result, size);
+        return true;
+    }
+
+    bool total = (stokes == COMPUTE_STOKES_PTOTAL || stokes == COMPUTE_STOKES_PFTOTAL);
+    bool fractional = (stokes == COMPUTE_STOKES_PFTOTAL || stokes == COMPUTE_STOKES_PFLINEAR);
+    bool linear = (stokes == COMPUTE_STOKES_PLINEAR || stokes == COMPUTE_STOKES_PFLINEAR);
+    if ((!total && !linear) || (total && !v) || (fractional && !i)) {
+        return false;
+    }
+
+    // Stokes which are not used by the kernels are set to null
+    const float* i_data = fractional ? i : nullptr;
+    const float* v_data = total ? v : nullptr;
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        StokesIntensityAVX512(i_data, q, u, v_data, result, size);
+        return true;
+    } else if (simd_level >= SimdLevel::AVX) {
+        StokesIntensityAVX(i_data, q, u, v_data, result, size);
+        return true;
+    }
+#endif
+    StokesIntensitySSE(i_data, q, u, v_data, result, size);
+    return true;
+}
@@ -48,6 +48,10 @@ private:
     bool _image_valid;
 };
 
+// Calculate a computed stokes type (COMPUTE_STOKES_*) element-wise from slices of the original stokes, in a single pass with the best
+// instruction set available at runtime. Stokes which are not needed for the type may be null. Returns false for other stokes types.
+bool ComputeStokesData(int stokes, const float* i, const float* q, const float* u, const float* v, float* result, size_t size);
+
 } // namespace carta
 
 #endif // CARTA_SRC_IMAGEDATA_POLARIZATIONCALCULATOR_H_
@@ -6,17 +6,77 @@
 
 #define SQ_FWHM_TO_SIGMA 1.0 / 8.0 / log(2.0)
 #define DEG_TO_RAD M_PI / 180.0
+// Gaussian components are evaluated where the exponent is within this value, beyond which they are below double precision
+#define GAUSSIAN_SUPPORT_EXPONENT 36.0
 
 #include "ImageFitter.h"
+#include "ThreadingManager/ThreadingManager.h"
 #include "Util/Message.h"
 
 #include <omp.h>
+#include <algorithm>
 
 using namespace carta;
 
+// Terms of a Gaussian component with exponent u^2 * inv_sq_std_x + v^2 * inv_sq_std_y, where (u, v) are the offsets from the center
+// rotated by theta, and the bounding box of its support
+struct GaussianTerms {
+    double center_x;
+    double center_y;
+    double amp;
+    double fwhm_x;
+    double fwhm_y;
+    double cos_theta;
+    double sin_theta;
+    double inv_sq_std_x;
+    double inv_sq_std_y;
+    double half_width;
+    double half_height;
+    // Indexes of the Gaussian parameters in the fitting parameters, or -1 if fixed
+    int fit_values_indexes[6];
+};
+
+static double GetFitParam(const gsl_vector* fit_values, const FitData& fit_data, size_t index) {
+    int fit_values_index = fit_data.fit_values_indexes[index];
+    return fit_values_index < 0 ? fit_data.initial_values[index] : gsl_vector_get(fit_values, fit_values_index);
+}
+
+static std::vector<GaussianTerms> GetGaussianTerms(const gsl_vector* fit_values, const FitData& fit_data) {
+    std::vector<GaussianTerms> components;
+    for (size_t k = 0; k < fit_data.fit_values_indexes.size() - 1; k += 6) {
+        GaussianTerms terms;
+        terms.center_x = GetFitParam(fit_values, fit_data, k);
+        terms.center_y = GetFitParam(fit_values, fit_data, k + 1);
+        terms.amp = GetFitParam(fit_values, fit_data, k + 2);
+        terms.fwhm_x = GetFitParam(fit_values, fit_data, k + 3);
+        terms.fwhm_y = GetFitParam(fit_values, fit_data, k + 4);
+        double pa = GetFitParam(fit_values, fit_data, k + 5);
+
+        const double dbl_sq_std_x = 2 * terms.fwhm_x * terms.fwhm_x * SQ_FWHM_TO_SIGMA;
+        const double dbl_sq_std_y = 2 * terms.fwhm_y * terms.fwhm_y * SQ_FWHM_TO_SIGMA;
+        const double theta_radian = (pa - 90.0) * DEG_TO_RAD; // counterclockwise rotation
+        terms.cos_theta = cos(theta_radian);
+        terms.sin_theta = sin(theta_radian);
+        terms.inv_sq_std_x = 1.0 / dbl_sq_std_x;
+        terms.inv_sq_std_y = 1.0 / dbl_sq_std_y;
+
+        // Bounding box of the ellipse where the exponent is GAUSSIAN_SUPPORT_EXPONENT
+        const double sq_cos = terms.cos_theta * terms.cos_theta;
+        const double sq_sin = terms.sin_theta * terms.sin_theta;
+        terms.half_width = sqrt(GAUSSIAN_SUPPORT_EXPONENT * (dbl_sq_std_x * sq_cos + dbl_sq_std_y * sq_sin));
+        terms.half_height = sqrt(GAUSSIAN_SUPPORT_EXPONENT * (dbl_sq_std_x * sq_sin + dbl_sq_std_y * sq_cos));
+
+        for (size_t i = 0; i < 6; ++i) {
+            terms.fit_values_indexes[i] = fit_data.fit_values_indexes[k + i];
+        }
+        components.push_back(terms);
+    }
+    return components;
+}
+
 ImageFitter::ImageFitter() {
     _fdf.f = FuncF;
-    _fdf.df = nullptr; // internally computed using finite difference approximations of f when set to NULL
+    _fdf.df = FuncDf;
     _fdf.fvv = nullptr;
     _fdf.params = &_fit_data;
 
@@ -40,7 +100,6 @@ bool ImageFitter::FitImage(size_t width, size_t height, float* image, double bea
     _fit_data.data = image;
     _fit_data.offset_x = offset_x;
     _fit_data.offset_y = offset_y;
-    _fdf.n = _fit_data.n;
     _beam_size = beam_size;
     _unit = unit;
     _create_model_data = create_model_image;
@@ -48,6 +107,7 @@ bool ImageFitter::FitImage(size_t width, size_t height, float* image, double bea
     _progress_callback = progress_callback;
 
     CalculateNanNumAndStd();
+    _fdf.n = _fit_data.n_notnan;
     SetInitialValues(initial_values, background_offset, fixed_params);
 
     // avoid SolveSystem crashes with insufficient data points
@@ -131,6 +191,9 @@ void ImageFitter::StopFitting() {
 void ImageFitter::CalculateNanNumAndStd() {
     std::vector<double> data_notnan;
     data_notnan.reserve(_fit_data.n);
+    _fit_data.notnan_data.clear();
+    _fit_data.notnan_x.clear();
+    _fit_data.notnan_y.clear();
 
     _fit_data.n_notnan = _fit_data.n;
     for (size_t i = 0; i < _fit_data.n; i++) {
@@ -138,6 +201,9 @@ void ImageFitter::CalculateNanNumAndStd() {
             _fit_data.n_notnan--;
         } else {
             data_notnan.push_back(_fit_data.data[i]);
+            _fit_data.notnan_data.push_back(_fit_data.data[i]);
+            _fit_data.notnan_x.push_back(i % _fit_data.width);
+            _fit_data.notnan_y.push_back(i / _fit_data.width);
         }
     }
 
@@ -250,8 +316,7 @@ int ImageFitter::SolveSystem(CARTA::FittingSolverType solver) {
         _fit_status.chisq *= _image_std * _image_std;
 
         if (!status || (status == GSL_EMAXITER && _fit_status.num_iter == _max_iter)) {
-            gsl_vector_scale(f, _image_std);
-            CalculateImageData(f);
+            CalculateImageData();
         }
     }
 
@@ -339,18 +404,71 @@ void ImageFitter::CalculateErrors() {
     }
 }
 
-void ImageFitter::CalculateImageData(const gsl_vector* residual) {
-    size_t size = residual->size;
-    _model_data.resize(size);
-    _residual_data.resize(size);
-    for (size_t i = 0; i < size; i++) {
-        if (_create_model_data) {
-            _model_data[i] = _fit_data.data[i] - gsl_vector_get(residual, i);
+void ImageFitter::CalculateImageData() {
+    if (!_create_model_data && !_create_residual_data) {
+        return;
+    }
+
+    size_t last_index = _fit_data.fit_values_indexes.size() - 1;
+    int background_offset_index = _fit_data.fit_values_indexes[last_index];
+    double background_offset =
+        background_offset_index < 0 ? _fit_data.initial_values[last_index] : gsl_vector_get(_fit_values, background_offset_index);
+    auto components = GetGaussianTerms(_fit_values, _fit_data);
+
+    // Model is accumulated in double precision for each row, adding each component only for the pixels in its support
+    _model_data.resize(_fit_data.n);
+    _residual_data.resize(_create_residual_data ? _fit_data.n : 0);
+    int64_t width = _fit_data.width;
+    int64_t height = _fit_data.n / _fit_data.width;
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for
+    for (int64_t y = 0; y < height; y++) {
+        thread_local std::vector<double> row_model;
+        row_model.assign(width, background_offset);
+
+        for (const auto& component : components) {
+            // Solve a * dx^2 + b * dx + c <= GAUSSIAN_SUPPORT_EXPONENT for the support in this row
+            double dy = y - component.center_y;
+            if (fabs(dy) > component.half_height) {
+                continue;
+            }
+            double a = component.cos_theta * component.cos_theta * component.inv_sq_std_x +
+                       component.sin_theta * component.sin_theta * component.inv_sq_std_y;
+            double b = 2.0 * component.cos_theta * component.sin_theta * (component.inv_sq_std_x - component.inv_sq_std_y) * dy;
+            double c = (component.sin_theta * component.sin_theta * component.inv_sq_std_x +
+                           component.cos_theta * component.cos_theta * component.inv_sq_std_y) *
+                       dy * dy;
+            double discriminant = b * b - 4.0 * a * (c - GAUSSIAN_SUPPORT_EXPONENT);
+            if (discriminant < 0.0) {
+                continue;
+            }
+            double root = sqrt(discriminant);
+            int64_t x_start = std::max<int64_t>(0, ceil(component.center_x + (-b - root) / (2.0 * a)));
+            int64_t x_end = std::min<int64_t>(width - 1, floor(component.center_x + (-b + root) / (2.0 * a)));
+
+            for (int64_t x = x_start; x <= x_end; x++) {
+                double dx = x - component.center_x;
+                row_model[x] += component.amp * exp(-((a * dx + b) * dx + c));
+            }
+        }
+
+        // NaN pixels are NaN in both images
+        const float* row_data = _fit_data.data + y * width;
+        float* row_model_data = _model_data.data() + y * width;
+        for (int64_t x = 0; x < width; x++) {
+            row_model_data[x] = isnan(row_data[x]) ? NAN : row_model[x];
         }
         if (_create_residual_data) {
-            _residual_data[i] = isnan(_fit_data.data[i]) ? _fit_data.data[i] : gsl_vector_get(residual, i);
+            float* row_residual_data = _residual_data.data() + y * width;
+            for (int64_t x = 0; x < width; x++) {
+                row_residual_data[x] = row_data[x] - row_model[x];
+            }
         }
     }
+
+    if (!_create_model_data) {
+        _model_data.clear();
+    }
 }
 
 std::string ImageFitter::GetLog() {
@@ -384,7 +502,7 @@ std::string ImageFitter::GetLog() {
     return log;
 }
 
-casa::SPIIF ImageFitter::GetImageData(casa::SPIIF image, const casacore::ImageRegion& image_region, std::vector<float> image_data) {
+casa::SPIIF ImageFitter::GetImageData(casa::SPIIF image, const casacore::ImageRegion& image_region, std::vector<float>& image_data) {
     casa::SPIIF sub_image(new casacore::SubImage<casacore::Float>(*image, image_region));
     casacore::CoordinateSystem csys = sub_image->coordinates();
     casacore::IPosition shape = sub_image->shape();
@@ -402,7 +520,7 @@ casa::SPIIF ImageFitter::GetImageData(casa::SPIIF image, const casacore::ImageRe
     }
     output_image->setImageInfo(image_info);
 
-    casacore::Array<float> data_array(shape, image_data.data());
+    casacore::Array<float> data_array(shape, image_data.data(), casacore::SHARE);
     output_image->put(data_array);
     output_image->flush();
     return output_image;
@@ -428,42 +546,89 @@ std::string ImageFitter::GetFilename(const std::string& filename, std::string su
 int ImageFitter::FuncF(const gsl_vector* fit_values, void* fit_data, gsl_vector* f) {
     struct FitData* d = (struct FitData*)fit_data;
 
+    // set residuals to zero to stop fitting procedure
+    if (d->stop_fitting) {
+        gsl_vector_set_zero(f);
+        return GSL_SUCCESS;
+    }
+
     size_t last_index = d->fit_values_indexes.size() - 1;
     int background_offset_index = d->fit_values_indexes[last_index];
     double background_offset =
         background_offset_index < 0 ? d->initial_values[last_index] : gsl_vector_get(fit_values, background_offset_index);
+    auto components = GetGaussianTerms(fit_values, *d);
 
-    for (size_t k = 0; k < d->fit_values_indexes.size() - 1; k += 6) {
-        // set residuals to zero to stop fitting procedure
-        if (d->stop_fitting) {
-            gsl_vector_set_zero(f);
-            return GSL_SUCCESS;
+    // Sum all components for each pixel, within their support
+    int64_t n_notnan = d->n_notnan;
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for
+    for (int64_t i = 0; i < n_notnan; i++) {
+        double model = background_offset;
+        for (const auto& component : components) {
+            double dx = d->notnan_x[i] - component.center_x;
+            double dy = d->notnan_y[i] - component.center_y;
+            if (fabs(dx) > component.half_width || fabs(dy) > component.half_height) {
+                continue;
+            }
+            double u = component.cos_theta * dx + component.sin_theta * dy;
+            double v = -component.sin_theta * dx + component.cos_theta * dy;
+            model += component.amp * exp(-(u * u * component.inv_sq_std_x + v * v * component.inv_sq_std_y));
         }
+        gsl_vector_set(f, i, d->notnan_data[i] - model);
+    }
 
-        double center_x, center_y, amp, fwhm_x, fwhm_y, pa;
-        std::tie(center_x, center_y, amp, fwhm_x, fwhm_y, pa) = GetGaussianParams(fit_values, k, d->fit_values_indexes, d->initial_values);
+    return GSL_SUCCESS;
+}
 
-        const double dbl_sq_std_x = 2 * fwhm_x * fwhm_x * SQ_FWHM_TO_SIGMA;
-        const double dbl_sq_std_y = 2 * fwhm_y * fwhm_y * SQ_FWHM_TO_SIGMA;
-        const double theta_radian = (pa - 90.0) * DEG_TO_RAD; // counterclockwise rotation
-        const double a = cos(theta_radian) * cos(theta_radian) / dbl_sq_std_x + sin(theta_radian) * sin(theta_radian) / dbl_sq_std_y;
-        const double dbl_b = 2 * (sin(2 * theta_radian) / (2 * dbl_sq_std_x) - sin(2 * theta_radian) / (2 * dbl_sq_std_y));
-        const double c = sin(theta_radian) * sin(theta_radian) / dbl_sq_std_x + cos(theta_radian) * cos(theta_radian) / dbl_sq_std_y;
+int ImageFitter::FuncDf(const gsl_vector* fit_values, void* fit_data, gsl_matrix* J) {
+    struct FitData* d = (struct FitData*)fit_data;
 
+    // set Jacobian to zero to stop fitting procedure
+    if (d->stop_fitting) {
+        gsl_matrix_set_zero(J);
+        return GSL_SUCCESS;
+    }
+
+    size_t last_index = d->fit_values_indexes.size() - 1;
+    int background_offset_index = d->fit_values_indexes[last_index];
+    auto components = GetGaussianTerms(fit_values, *d);
+
+    // Derivatives of the residual (data - model) for each pixel, which are zero outside the support of a component
+    int64_t n_notnan = d->n_notnan;
+    ThreadManager::ApplyThreadLimit();
 #pragma omp parallel for
-        for (size_t i = 0; i < d->n; i++) {
-            float data_i = d->data[i] - background_offset;
-            if (!isnan(data_i)) {
-                double dx = i % d->width - center_x;
-                double dy = i / d->width - center_y;
-                float data = amp * exp(-(a * dx * dx + dbl_b * dx * dy + c * dy * dy));
-                if (k == 0) {
-                    gsl_vector_set(f, i, data_i - data);
-                } else {
-                    gsl_vector_set(f, i, gsl_vector_get(f, i) - data);
+    for (int64_t i = 0; i < n_notnan; i++) {
+        double* row = gsl_matrix_ptr(J, i, 0);
+        std::fill(row, row + J->size2, 0.0);
+        if (background_offset_index >= 0) {
+            row[background_offset_index] = -1.0;
+        }
+
+        for (const auto& component : components) {
+            double dx = d->notnan_x[i] - component.center_x;
+            double dy = d->notnan_y[i] - component.center_y;
+            if (fabs(dx) > component.half_width || fabs(dy) > component.half_height) {
+                continue;
+            }
+            double u = component.cos_theta * dx + component.sin_theta * dy;
+            double v = -component.sin_theta * dx + component.cos_theta * dy;
+            double u_term = u * component.inv_sq_std_x;
+            double v_term = v * component.inv_sq_std_y;
+            double gaussian = exp(-(u * u_term + v * v_term));
+            double model = component.amp * gaussian;
+
+            double derivatives[6] = {
+                -2.0 * model * (u_term * component.cos_theta - v_term * component.sin_theta), // center x
+                -2.0 * model * (u_term * component.sin_theta + v_term * component.cos_theta), // center y
+                -gaussian,                                                                    // amp
+                -2.0 * model * u * u_term / component.fwhm_x,                                 // fwhm x
+                -2.0 * model * v * v_term / component.fwhm_y,                                 // fwhm y
+                2.0 * model * (v * u_term - u * v_term) * DEG_TO_RAD,                         // pa
+            };
+            for (size_t j = 0; j < 6; ++j) {
+                if (component.fit_values_indexes[j] >= 0) {
+                    row[component.fit_values_indexes[j]] += derivatives[j];
                 }
-            } else {
-                gsl_vector_set(f, i, 0);
             }
         }
     }
@@ -34,6 +34,12 @@ struct FitData {
     size_t n;
     /** @brief Number of pixels excluding nan pixels. */
     size_t n_notnan;
+    /** @brief Values of the pixels excluding nan pixels. */
+    std::vector<float> notnan_data;
+    /** @brief X coordinates of the pixels excluding nan pixels. */
+    std::vector<int> notnan_x;
+    /** @brief Y coordinates of the pixels excluding nan pixels. */
+    std::vector<int> notnan_y;
     /** @brief X-axis offset from the fitting region to the entire image. */
     size_t offset_x;
     /** @brief Y-axis offset from the fitting region to the entire image. */
@@ -139,7 +145,7 @@ private:
     GeneratorProgressCallback _progress_callback;
 
     /**
-     * @brief Calculate the number of NaN values and standard deviation of the image data.
+     * @brief Calculate the number of NaN values and standard deviation of the image data, and collect the pixels excluding NaN values.
      */
     void CalculateNanNumAndStd();
     /**
@@ -158,11 +164,8 @@ private:
     int SolveSystem(CARTA::FittingSolverType solver);
     /** @brief Calculate parameter errors after fitting. */
     void CalculateErrors();
-    /**
-     * @brief Calculate the model and residual image data after fitting.
-     * @param residual Pointer to the residual values
-     */
-    void CalculateImageData(const gsl_vector* residual);
+    /** @brief Calculate the model and residual image data from the fitting parameters, evaluating each component within its support. */
+    void CalculateImageData();
     /**
      * @brief Retrieve a log message describing the fitting status.
      * @return The log message
@@ -172,10 +175,10 @@ private:
      * @brief Generate a casacore ImageInterface object from the provided image data.
      * @param image The casacore ImageInterface object of the entire image
      * @param image_region The fitting region
-     * @param image_data The image data for the generated casacore ImageInterface object
+     * @param image_data The image data for the generated casacore ImageInterface object, which is not copied
      * @return A casacore ImageInterface object
      */
-    casa::SPIIF GetImageData(casa::SPIIF image, const casacore::ImageRegion& image_region, std::vector<float> image_data);
+    casa::SPIIF GetImageData(casa::SPIIF image, const casacore::ImageRegion& image_region, std::vector<float>& image_data);
     /**
      * @brief Generate filenames by adding a suffix.
      * @param filename Name of the fitting image file
@@ -191,13 +194,23 @@ private:
      */
     std::string GetGeneratedMomentFilename(const std::string& filename, std::string suffix);
 
+protected:
     /**
      * @brief Calculate the residual of the image data with the provided fitting parameters.
      * @param fit_params Fitting parameters
      * @param fit_data Fitting-related data
-     * @param f The residual of the image data
+     * @param f The residual of the image data, for the pixels excluding NaN values
      */
     static int FuncF(const gsl_vector* fit_params, void* fit_data, gsl_vector* f);
+    /**
+     * @brief Calculate the Jacobian of the residual analytically with the provided fitting parameters.
+     * @param fit_params Fitting parameters
+     * @param fit_data Fitting-related data
+     * @param J The Jacobian matrix, with a row for each pixel excluding NaN values and a column for each fitting parameter
+     */
+    static int FuncDf(const gsl_vector* fit_params, void* fit_data, gsl_matrix* J);
+
+private:
     /**
      * @brief Called after each iteration of the fitting.
      * @param iter The current iteration number
@@ -0,0 +1,139 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# FftConvolver.cc: implementation of FFT convolution of image planes
+
+#include "FftConvolver.h"
+
+#include <casacore/casa/Arrays/ArrayMath.h>
+
+#include <algorithm>
+
+using namespace carta;
+
+static bool IsFftLength(size_t length) {
+    for (size_t factor : {2, 3, 5}) {
+        while (length % factor == 0) {
+            length /= factor;
+        }
+    }
+    return length == 1;
+}
+
+size_t FftConvolver::FftLength(size_t length) {
+    size_t fft_length = std::max<size_t>(2, length + (length % 2));
+    while (!IsFftLength(fft_length)) {
+        fft_length += 2;
+    }
+    return fft_length;
+}
+
+FftConvolver::Workspace::~Workspace() {
+    // Destroying FFTW plans is not thread-safe either
+#pragma omp critical(fft_convolver_plan)
+    _plans.clear();
+}
+
+FftConvolver::Workspace::Plans& FftConvolver::Workspace::GetPlans(const casacore::IPosition& shape) {
+    auto plans = std::find_if(_plans.begin(), _plans.end(), [&](const Plans& p) { return p.shape.isEqual(shape); });
+    if (plans != _plans.end()) {
+        _plans.splice(_plans.begin(), _plans, plans);
+        return _plans.front();
+    }
+
+    if (_plans.size() >= FFT_CONVOLVER_MAX_SHAPES) {
+#pragma omp critical(fft_convolver_plan)
+        _plans.pop_back();
+    }
+    _plans.emplace_front();
+    _plans.front().shape = shape;
+    return _plans.front();
+}
+
+void FftConvolver::Workspace::Forward(casacore::Matrix<casacore::Complex>& transform, casacore::Matrix<casacore::Float>& data) {
+    auto& plans = GetPlans(data.shape());
+    if (plans.forward) {
+        plans.server.fft0(transform, data, false);
+    } else {
+#pragma omp critical(fft_convolver_plan)
+        plans.server.fft0(transform, data, false);
+        plans.forward = true;
+    }
+}
+
+void FftConvolver::Workspace::Inverse(casacore::Matrix<casacore::Float>& data, casacore::Matrix<casacore::Complex>& transform) {
+    auto& plans = GetPlans(data.shape());
+    if (plans.inverse) {
+        plans.server.fft0(data, transform, false);
+    } else {
+#pragma omp critical(fft_convolver_plan)
+        plans.server.fft0(data, transform, false);
+        plans.inverse = true;
+    }
+}
+
+FftConvolver::FftConvolver(const std::vector<float>& kernel, size_t kernel_width, size_t kernel_height, size_t width, size_t height)
+    : _width(width),
+      _height(height),
+      _kernel_width(kernel_width),
+      _kernel_height(kernel_height),
+      _center_x((kernel_width - 1) / 2),
+      _center_y((kernel_height - 1) / 2),
+      _kernel(kernel) {
+    // Padded so that the circular convolution does not wrap around for the pixels of the plane
+    _fft_width = FftLength(width + kernel_width - 1);
+    _fft_height = FftLength(height + kernel_height - 1);
+}
+
+void FftConvolver::Prepare(Workspace& workspace) {
+    if (IsPrepared()) {
+        return;
+    }
+
+    casacore::Matrix<casacore::Float> padded_kernel(_fft_width, _fft_height, 0.0);
+    for (size_t y = 0; y < _kernel_height; ++y) {
+        for (size_t x = 0; x < _kernel_width; ++x) {
+            padded_kernel(x, y) = _kernel[y * _kernel_width + x];
+        }
+    }
+
+    workspace.Forward(_kernel_transform, padded_kernel);
+    std::vector<float>().swap(_kernel);
+}
+
+bool FftConvolver::IsPrepared() const {
+    return !_kernel_transform.empty();
+}
+
+void FftConvolver::Convolve(const float* data, const bool* mask, float* result, Workspace& workspace) const {
+    // Buffers are reused while the shape is unchanged
+    auto& padded = workspace._padded;
+    auto& transform = workspace._transform;
+    casacore::IPosition fft_shape(2, _fft_width, _fft_height);
+    if (!padded.shape().isEqual(fft_shape)) {
+        padded.resize(fft_shape);
+    }
+
+    padded = 0.0f;
+    for (size_t y = 0; y < _height; ++y) {
+        const float* row = data + y * _width;
+        const bool* row_mask = (mask ? mask + y * _width : nullptr);
+        float* padded_row = padded.data() + y * _fft_width;
+        for (size_t x = 0; x < _width; ++x) {
+            padded_row[x] = (!row_mask || row_mask[x]) ? row[x] : 0.0f;
+        }
+    }
+
+    workspace.Forward(transform, padded);
+    transform *= _kernel_transform;
+    workspace.Inverse(padded, transform);
+
+    // Kernel center is at the origin of the kernel, so the result for each pixel is offset by the center
+    for (size_t y = 0; y < _height; ++y) {
+        const float* padded_row = padded.data() + (y + _center_y) * _fft_width + _center_x;
+        std::copy(padded_row, padded_row + _width, result + y * _width);
+    }
+}
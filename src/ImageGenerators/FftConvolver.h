@@ -0,0 +1,90 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# FftConvolver.h: linear convolution of image planes with a fixed kernel by FFT, with the kernel transform computed once
+
+#ifndef CARTA_SRC_IMAGEGENERATORS_FFTCONVOLVER_H_
+#define CARTA_SRC_IMAGEGENERATORS_FFTCONVOLVER_H_
+
+#include <casacore/casa/Arrays/Matrix.h>
+#include <casacore/casa/BasicSL/Complex.h>
+#include <casacore/scimath/Mathematics/FFTServer.h>
+
+#include <cstddef>
+#include <list>
+#include <vector>
+
+// Number of FFT shapes for which each workspace keeps its plans
+#define FFT_CONVOLVER_MAX_SHAPES 4
+
+namespace carta {
+
+class FftConvolver {
+public:
+    // FFT plans and work buffers for the convolutions in one thread. Each thread needs its own workspace; buffers and plans are
+    // released with the workspace.
+    class Workspace {
+    public:
+        Workspace() = default;
+        Workspace(Workspace&& other) = default;
+        ~Workspace();
+
+        // Real to complex and complex to real transforms as casacore::FFTServer::fft0, with the plans of the most recently used FFT
+        // shapes. FFTW planning is not thread-safe, so the first transform of each shape in each direction is serialized.
+        void Forward(casacore::Matrix<casacore::Complex>& transform, casacore::Matrix<casacore::Float>& data);
+        void Inverse(casacore::Matrix<casacore::Float>& data, casacore::Matrix<casacore::Complex>& transform);
+
+    private:
+        friend class FftConvolver;
+
+        struct Plans {
+            casacore::IPosition shape;
+            casacore::FFTServer<casacore::Float, casacore::Complex> server;
+            bool forward = false;
+            bool inverse = false;
+        };
+
+        // Plans for the shape, moved to the front of the list as most recently used
+        Plans& GetPlans(const casacore::IPosition& shape);
+
+        std::list<Plans> _plans;
+        casacore::Matrix<casacore::Float> _padded;
+        casacore::Matrix<casacore::Complex> _transform;
+    };
+
+    // Kernel (kernel_width x kernel_height, x fastest) centered on pixel ((kernel_width - 1) / 2, (kernel_height - 1) / 2), for planes
+    // of width x height. The kernel is transformed by Prepare.
+    FftConvolver(const std::vector<float>& kernel, size_t kernel_width, size_t kernel_height, size_t width, size_t height);
+
+    // Transform the kernel, if not done yet. Convolvers may be prepared concurrently, but each by only one thread.
+    void Prepare(Workspace& workspace);
+    bool IsPrepared() const;
+
+    // Convolve a plane (width x height, x fastest) with the prepared kernel, as casacore::LatticeConvolver with linear convolution:
+    // pixels outside the plane, and masked pixels if mask is set, are zero. May be called concurrently with the workspace of each thread.
+    void Convolve(const float* data, const bool* mask, float* result, Workspace& workspace) const;
+
+    // Smallest even FFT length with no prime factors larger than 5, not less than length
+    static size_t FftLength(size_t length);
+
+private:
+    size_t _width;
+    size_t _height;
+    size_t _kernel_width;
+    size_t _kernel_height;
+    size_t _center_x;
+    size_t _center_y;
+    size_t _fft_width;
+    size_t _fft_height;
+
+    // Kernel until it is prepared, then its transform zero padded to the FFT shape
+    std::vector<float> _kernel;
+    casacore::Matrix<casacore::Complex> _kernel_transform;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_IMAGEGENERATORS_FFTCONVOLVER_H_
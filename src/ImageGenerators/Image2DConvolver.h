@@ -43,7 +43,15 @@
 #include <scimath/Mathematics/Convolver.h>
 #include <scimath/Mathematics/VectorKernel.h>
 
+#include <list>
+#include <map>
 #include <memory>
+#include <utility>
+#include <vector>
+
+#include "FftConvolver.h"
+
+#define MAX_CACHED_FFT_CONVOLVERS 8
 
 namespace carta {
 
@@ -106,6 +114,14 @@ private:
     casa::ImageMomentsProgress* _progress_monitor; // used to report the progress
     mutable casacore::uInt _total_steps = 0;       // total number of steps for the beam convolution
 
+    // FFT convolvers for the plane shape and scaled kernel. LRU cache of at most MAX_CACHED_FFT_CONVOLVERS, since each holds a kernel
+    // transform the size of the padded plane
+    using FftConvolverPair = std::pair<std::vector<Double>, std::shared_ptr<FftConvolver>>;
+    mutable std::list<FftConvolverPair> _fft_convolver_queue;
+    mutable std::map<std::vector<Double>, std::list<FftConvolverPair>::iterator> _fft_convolvers;
+    // FFT plans and buffers for each thread, kept for the planes of one convolution
+    mutable std::vector<FftConvolver::Workspace> _fft_workspaces;
+
     void _checkKernelParameters(
         casacore::VectorKernel::KernelTypes kernelType, const casacore::Vector<casacore::Quantity>& parameters) const;
 
@@ -146,6 +162,18 @@ private:
         const std::vector<casacore::Quantity>& targetBeamParms, const casacore::GaussianBeam& inputBeam) const;
 
     void _logBeamInfo(const ImageInfo& imageInfo, const String& desc) const;
+
+    // Cached convolver for planes of the image with the kernel times scaleFactor
+    std::shared_ptr<FftConvolver> _getFftConvolver(
+        const casacore::Array<Double>& kernel, Double scaleFactor, const casacore::IPosition& imageShape) const;
+
+    // Start of each plane along the convolution axes in the slab of the image
+    std::vector<casacore::IPosition> _getPlaneStarts(const casacore::IPosition& slabStart, const casacore::IPosition& slabShape) const;
+
+    // Convolve the planes starting at each position with their convolver, or copy them if it is null. Planes are read and written in
+    // batches; the new convolvers of each batch are prepared in parallel, then its planes are convolved in parallel.
+    void _convolvePlanes(casacore::ImageInterface<T>& imageOut, const casacore::ImageInterface<T>& imageIn,
+        const std::vector<std::pair<casacore::IPosition, std::shared_ptr<FftConvolver>>>& planes) const;
 };
 
 } // namespace carta
@@ -11,8 +11,12 @@
 #define CARTA_SRC_IMAGEGENERATORS_IMAGE2DCONVOLVER_TCC_
 
 #include "../Logger/Logger.h"
+#include "ThreadingManager/ThreadingManager.h"
 #include "Util/Casacore.h"
 
+#include <omp.h>
+#include <algorithm>
+
 using namespace carta;
 
 template <class T>
@@ -180,6 +184,9 @@ void Image2DConvolver<T>::_convolve(SPIIT imageOut, const ImageInterface<T>& ima
             logFactors, factor1, pixelArea);
     }
 
+    // Release the FFT plans and buffers of the threads
+    _fft_workspaces.clear();
+
     imageOut->setUnits(brightnessUnitOut);
     imageOut->setImageInfo(iiOut);
 
@@ -246,10 +253,13 @@ void Image2DConvolver<T>::_doSingleBeam(ImageInfo& iiOut, Double& kernelVolume,
 
     // Convolve. We have already scaled the convolution kernel (with some trickery cleverer than what ImageConvolver can do) so no more
     // scaling
-    casa::ImageConvolver<T> aic;
-    Array<T> modKernel(kernel.shape());
-    casacore::convertArray(modKernel, scaleFactor * kernel);
-    aic.convolve(*this->_getLog(), *imageOut, imageIn, modKernel, casa::ImageConvolver<T>::NONE, 1.0, true);
+    auto convolver = _getFftConvolver(kernel, scaleFactor, imageIn.shape());
+    std::vector<std::pair<casacore::IPosition, std::shared_ptr<FftConvolver>>> planes;
+    for (const auto& planeStart : _getPlaneStarts(casacore::IPosition(imageIn.ndim(), 0), imageIn.shape())) {
+        planes.emplace_back(planeStart, convolver);
+    }
+    _convolvePlanes(*imageOut, imageIn, planes);
+    casacore::ImageUtilities::copyMiscellaneous(*imageOut, imageIn);
 
     // Overwrite some bits and pieces in the output image to do with the restoring beam  and image units
     casacore::Bool holdsOneSkyAxis;
@@ -300,6 +310,11 @@ void Image2DConvolver<T>::_doMultipleBeams(ImageInfo& iiOut, Double& kernelVolum
     }
 
     casacore::uInt count = (nChan > 0 && nPol > 0) ? nChan * nPol : nChan > 0 ? nChan : nPol;
+
+    // Planes are convolved in batches as their kernels are made, so that only the convolvers of one batch are held, besides those cached
+    ThreadManager::ApplyThreadLimit();
+    size_t batchSize = omp_get_max_threads();
+    std::vector<std::pair<casacore::IPosition, std::shared_ptr<FftConvolver>>> planes;
     if (_progress_monitor) {
         _progress_monitor->init(count * 2); // roughly estimate the total number of steps for the whole moments calculation is twice as the
                                             // number of steps for the beam convolution
@@ -365,7 +380,8 @@ void Image2DConvolver<T>::_doMultipleBeams(ImageInfo& iiOut, Double& kernelVolum
             spdlog::debug(message);
         }
 
-        casacore::TempImage<T> subImageOut(subImage.shape(), subImage.coordinates());
+        // Beams and kernels are set for each plane here, and the planes are convolved together below
+        std::shared_ptr<FftConvolver> convolver;
         if (doConvolve) {
             auto scaleFactor = _dealWithRestoringBeam(
                 brightnessUnitOut, beamOut, kernel, kernelVolume, kernelType, kernelParmsV, subCsys, inputBeam, imageIn.units(), i == 0);
@@ -399,42 +415,155 @@ void Image2DConvolver<T>::_doMultipleBeams(ImageInfo& iiOut, Double& kernelVolum
                 beamOut.setPA(originalParms[2]);
             }
 
-            Array<T> modKernel(kernel.shape());
-            casacore::convertArray(modKernel, scaleFactor * kernel);
-            casa::ImageConvolver<T> aic;
-            aic.convolve(*this->_getLog(), subImageOut, subImage, modKernel, casa::ImageConvolver<T>::NONE, 1.0, true);
+            convolver = _getFftConvolver(kernel, scaleFactor, imageIn.shape());
         } else {
             brightnessUnitOut = imageIn.units().getName();
             beamOut = inputBeam;
-            subImageOut.put(subImage.get());
         }
 
-        {
-            auto doMask = imageOut->isMasked() && imageOut->hasPixelMask();
-            Lattice<Bool>* pMaskOut = 0;
+        for (const auto& planeStart : _getPlaneStarts(start, end)) {
+            planes.emplace_back(planeStart, convolver);
+        }
+
+        if (!_targetres) {
+            iiOut.setBeam(channel, polarization, beamOut);
+        }
+
+        if (planes.size() >= batchSize) {
+            _convolvePlanes(*imageOut, imageIn, planes);
+            planes.clear();
+        }
+    }
+
+    _convolvePlanes(*imageOut, imageIn, planes);
+}
+
+template <class T>
+std::shared_ptr<FftConvolver> Image2DConvolver<T>::_getFftConvolver(
+    const casacore::Array<Double>& kernel, Double scaleFactor, const casacore::IPosition& imageShape) const {
+    // Planes have the lower of the convolution axes first, as the kernel
+    casacore::Array<Double> kernelMatrix = kernel.nonDegenerate(_axes);
+    size_t width = imageShape[std::min(_axes[0], _axes[1])];
+    size_t height = imageShape[std::max(_axes[0], _axes[1])];
+    size_t kernelWidth = kernelMatrix.shape()[0];
+    size_t kernelHeight = kernelMatrix.shape()[1];
+
+    std::vector<float> scaledKernel;
+    scaledKernel.reserve(kernelMatrix.nelements());
+    for (auto value : kernelMatrix) {
+        scaledKernel.push_back(scaleFactor * value);
+    }
+
+    // Planes with the same beam share the kernel transform
+    std::vector<Double> key{Double(width), Double(height), Double(kernelWidth), Double(kernelHeight)};
+    key.insert(key.end(), scaledKernel.begin(), scaledKernel.end());
+    auto cached = _fft_convolvers.find(key);
+    if (cached != _fft_convolvers.end()) {
+        // Move to front of queue as most recently used
+        _fft_convolver_queue.splice(_fft_convolver_queue.begin(), _fft_convolver_queue, cached->second);
+        return cached->second->second;
+    }
+
+    // Evict least recently used convolver; it is released when no planes still to be convolved use it
+    if (_fft_convolvers.size() >= MAX_CACHED_FFT_CONVOLVERS) {
+        _fft_convolvers.erase(_fft_convolver_queue.back().first);
+        _fft_convolver_queue.pop_back();
+    }
+
+    // The kernel is transformed when the convolver is prepared for the planes
+    auto convolver = std::make_shared<FftConvolver>(scaledKernel, kernelWidth, kernelHeight, width, height);
+    _fft_convolver_queue.emplace_front(key, convolver);
+    _fft_convolvers[key] = _fft_convolver_queue.begin();
+    return convolver;
+}
+
+template <class T>
+std::vector<casacore::IPosition> Image2DConvolver<T>::_getPlaneStarts(
+    const casacore::IPosition& slabStart, const casacore::IPosition& slabShape) const {
+    auto numPlanes = slabShape;
+    numPlanes[_axes[0]] = 1;
+    numPlanes[_axes[1]] = 1;
+
+    std::vector<casacore::IPosition> starts;
+    for (size_t i = 0; i < numPlanes.product(); ++i) {
+        auto start = slabStart;
+        size_t index = i;
+        for (size_t axis = 0; axis < numPlanes.size(); ++axis) {
+            start[axis] += index % numPlanes[axis];
+            index /= numPlanes[axis];
+        }
+        starts.push_back(start);
+    }
+    return starts;
+}
+
+template <class T>
+void Image2DConvolver<T>::_convolvePlanes(casacore::ImageInterface<T>& imageOut, const casacore::ImageInterface<T>& imageIn,
+    const std::vector<std::pair<casacore::IPosition, std::shared_ptr<FftConvolver>>>& planes) const {
+    casacore::IPosition planeShape(imageIn.ndim(), 1);
+    planeShape[_axes[0]] = imageIn.shape()[_axes[0]];
+    planeShape[_axes[1]] = imageIn.shape()[_axes[1]];
+    auto doMask = imageIn.isMasked();
+
+    // Image access is not thread-safe, so only the convolution of the planes in each batch is parallel
+    ThreadManager::ApplyThreadLimit();
+    size_t batchSize = omp_get_max_threads();
+    if (_fft_workspaces.size() < batchSize) {
+        _fft_workspaces.resize(batchSize);
+    }
+    std::vector<casacore::Array<T>> data(batchSize);
+    std::vector<casacore::Array<casacore::Bool>> masks(batchSize);
+    std::vector<casacore::Array<T>> results(batchSize);
+
+    for (size_t first = 0; first < planes.size(); first += batchSize) {
+        if (_stop) { // cancel calculations
+            break;
+        }
+
+        size_t count = std::min(batchSize, planes.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            casacore::Slicer slicer(planes[first + i].first, planeShape);
+            data[i].reference(imageIn.getSlice(slicer, true));
             if (doMask) {
-                pMaskOut = &imageOut->pixelMask();
-                if (!pMaskOut->isWritable()) {
-                    doMask = false;
-                }
+                masks[i].reference(imageIn.getMaskSlice(slicer, true));
+            }
+        }
+
+        // Convolvers made for this batch, each prepared by one thread
+        std::vector<FftConvolver*> newConvolvers;
+        for (size_t i = 0; i < count; ++i) {
+            auto convolver = planes[first + i].second.get();
+            if (convolver && !convolver->IsPrepared() &&
+                std::find(newConvolvers.begin(), newConvolvers.end(), convolver) == newConvolvers.end()) {
+                newConvolvers.push_back(convolver);
+            }
+        }
+
+        int64_t numPrepare = newConvolvers.size();
+        int64_t numConvolve = count;
+#pragma omp parallel
+        {
+            auto& workspace = _fft_workspaces[omp_get_thread_num()];
+
+#pragma omp for schedule(dynamic)
+            for (int64_t i = 0; i < numPrepare; ++i) {
+                newConvolvers[i]->Prepare(workspace);
             }
 
-            auto cursorShape = subImageOut.niceCursorShape();
-            auto outPos = start;
-            LatticeStepper stepper(subImageOut.shape(), cursorShape, casacore::LatticeStepper::RESIZE);
-            RO_MaskedLatticeIterator<T> iter(subImageOut, stepper);
-            for (iter.reset(); !iter.atEnd(); iter++) {
-                casacore::IPosition cursorShape = iter.cursorShape();
-                imageOut->putSlice(iter.cursor(), outPos);
-                if (doMask) {
-                    pMaskOut->putSlice(iter.getMask(), outPos);
+#pragma omp for schedule(dynamic)
+            for (int64_t i = 0; i < numConvolve; ++i) {
+                const auto& convolver = planes[first + i].second;
+                if (convolver) {
+                    results[i].resize(data[i].shape());
+                    convolver->Convolve(data[i].data(), (doMask ? masks[i].data() : nullptr), results[i].data(), workspace);
+                } else {
+                    results[i].reference(data[i]);
                 }
-                outPos = outPos + cursorShape;
             }
         }
 
-        if (!_targetres) {
-            iiOut.setBeam(channel, polarization, beamOut);
+        for (size_t i = 0; i < count; ++i) {
+            imageOut.putSlice(results[i], planes[first + i].first);
         }
     }
 }
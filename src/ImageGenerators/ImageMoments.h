@@ -21,13 +21,20 @@
 #include <imageanalysis/ImageAnalysis/MomentsBase.h>
 #include <imageanalysis/ImageAnalysis/SepImageConvolver.h>
 
+#include <functional>
+#include <vector>
+
 #include "Image2DConvolver.h"
+#include "MomentCalculator.h"
 
 namespace carta {
 
 template <class T>
 class ImageMoments : public casa::MomentsBase<T> {
 public:
+    // Read spectra along the moment axis for a block of pixels (x, count_x, y, count_y) of the image, with z fastest then y then x
+    using SpectraReader = std::function<bool(std::vector<T>& data, int x, int count_x, int y, int count_y)>;
+
     ImageMoments(const casacore::ImageInterface<T>& image, casacore::LogIO& os, casa::ImageMomentsProgressMonitor* progress_monitor,
         casacore::Bool over_write_output = false);
 
@@ -63,6 +70,10 @@ public:
         return _image->shape();
     }
 
+    // Read spectra for the native calculation with this function (e.g. from swizzled data) rather than iterating through the image,
+    // when the moment axis is the third axis
+    void SetSpectraReader(const SpectraReader& reader);
+
     // Stop the calculation
     void StopCalculation();
 
@@ -70,6 +81,7 @@ private:
     SPCIIT _image = SPCIIT(nullptr);
     std::unique_ptr<casa::ImageMomentsProgress> _progress_monitor;
     std::unique_ptr<Image2DConvolver<casacore::Float>> _image_2d_convolver;
+    SpectraReader _spectra_reader;
 
     casacore::Bool SetNewImage(const casacore::ImageInterface<T>& image);
 
@@ -84,6 +96,18 @@ private:
     void LineMultiApply(casacore::PtrBlock<casacore::MaskedLattice<T>*>& lattice_out, const casacore::MaskedLattice<T>& lattice_in,
         casacore::LineCollapser<T, T>& collapser, casacore::uInt collapse_axis);
 
+    // Iterate through a cube image with the native moments calculator, for the clip method without smoothing
+    void NativeMultiApply(casacore::PtrBlock<casacore::MaskedLattice<T>*>& lattice_out, const casacore::MaskedLattice<T>& lattice_in,
+        casacore::uInt collapse_axis);
+
+    // Read spectra for a chunk with the spectra reader and calculate moments, then transpose the results to the chunk layout
+    bool CalculateChunkSpectra(const MomentCalculator& calculator, const casacore::IPosition& chunk_pos,
+        const casacore::IPosition& chunk_shape, const casacore::Array<casacore::Bool>& mask_chunk, std::vector<T*>& results,
+        std::vector<casacore::Bool*>& result_masks);
+
+    // Get the coordinates (or velocities) of the moment axis and the increment for the integrated moment
+    void GetMomentAxisCoordinates(std::vector<casacore::Double>& coordinates, casacore::Double& integrated_scale);
+
     // Get a suitable chunk shape in order for the iteration
     casacore::IPosition ChunkShape(casacore::uInt axis, const casacore::MaskedLattice<T>& lattice_in);
 
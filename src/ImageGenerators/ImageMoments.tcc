@@ -37,6 +37,11 @@ casacore::Bool ImageMoments<T>::SetNewImage(const casacore::ImageInterface<T>& i
     return true;
 }
 
+template <class T>
+void ImageMoments<T>::SetSpectraReader(const SpectraReader& reader) {
+    _spectra_reader = reader;
+}
+
 template <class T>
 casacore::Bool ImageMoments<T>::setMomentAxis(const casacore::Int moment_axis) {
     if (!goodParameterStatus_p) {
@@ -88,6 +93,9 @@ casacore::Bool ImageMoments<T>::setMomentAxis(const casacore::Int moment_axis) {
         if (!_stop) { // check cancellation
             _image = image_copy;
         }
+
+        // Spectra read from the file are not convolved
+        _spectra_reader = nullptr;
     }
 
     worldMomentAxis_p = _image->coordinates().pixelAxisToWorldAxis(momentAxis_p);
@@ -342,6 +350,27 @@ std::vector<std::shared_ptr<casacore::MaskedLattice<T>>> ImageMoments<T>::create
         stdDeviation_p = noise;
     }
 
+    // Iterate optimally through the image, compute the moments, fill the output lattices
+    casacore::uInt out_images_size = output_images.size();
+    casacore::PtrBlock<casacore::MaskedLattice<T>*> ptr_blocks(out_images_size);
+    for (casacore::uInt i = 0; i < out_images_size; ++i) {
+        ptr_blocks[i] = output_images[i].get();
+    }
+
+    if (clip_method && MomentCalculator::IsSupported(moments_p.tovector())) {
+        // Do expensive calculation natively in one pass
+        NativeMultiApply(ptr_blocks, *_image, momentAxis_p);
+
+        if (_stop) {
+            output_images.clear();
+        } else {
+            for (auto& output_image : output_images) {
+                output_image->flush();
+            }
+        }
+        return output_images;
+    }
+
     // Create appropriate MomentCalculator object
     shared_ptr<casa::MomentCalcBase<T>> moment_calculator;
     if (clip_method || smooth_clip_method) {
@@ -354,13 +383,6 @@ std::vector<std::shared_ptr<casacore::MaskedLattice<T>>> ImageMoments<T>::create
         moment_calculator.reset(new casa::MomentFit<T>(*this, os_p, output_images.size()));
     }
 
-    // Iterate optimally through the image, compute the moments, fill the output lattices
-    casacore::uInt out_images_size = output_images.size();
-    casacore::PtrBlock<casacore::MaskedLattice<T>*> ptr_blocks(out_images_size);
-    for (casacore::uInt i = 0; i < out_images_size; ++i) {
-        ptr_blocks[i] = output_images[i].get();
-    }
-
     // Do expensive calculation
     LineMultiApply(ptr_blocks, *_image, *moment_calculator, momentAxis_p);
 
@@ -691,6 +713,215 @@ void ImageMoments<T>::LineMultiApply(casacore::PtrBlock<casacore::MaskedLattice<
     }
 }
 
+template <class T>
+void ImageMoments<T>::NativeMultiApply(casacore::PtrBlock<casacore::MaskedLattice<T>*>& lattice_out,
+    const casacore::MaskedLattice<T>& lattice_in, casacore::uInt collapse_axis) {
+    // Read chunks with the whole moment axis, and calculate all moments for the chunk in parallel over pixels
+    const casacore::uInt n_out = lattice_out.nelements();
+    AlwaysAssert(n_out > 0, AipsError);
+
+    std::vector<casacore::Double> coordinates;
+    casacore::Double integrated_scale;
+    GetMomentAxisCoordinates(coordinates, integrated_scale);
+    MomentCalculator calculator(moments_p.tovector(), coordinates, integrated_scale);
+    if (!noInclude_p) {
+        calculator.SetIncludeRange(selectRange_p(0), selectRange_p(1));
+    } else if (!noExclude_p) {
+        calculator.SetExcludeRange(selectRange_p(0), selectRange_p(1));
+    }
+
+    const casacore::IPosition& in_shape = lattice_in.shape();
+    const casacore::uInt in_ndim = in_shape.size();
+    const casacore::uInt out_dim = lattice_out[0]->ndim();
+    const casacore::IPosition display_axes = IPosition::makeAxisPath(in_ndim).otherAxes(in_ndim, IPosition(1, collapse_axis));
+    casacore::Bool use_mask = lattice_in.isMasked();
+
+    // Spectra are read for blocks of x and y, so the moment axis must be the third axis with no other axis to iterate
+    bool use_spectra_reader = _spectra_reader && (in_ndim == 3 || (in_ndim == 4 && in_shape[3] == 1)) && (collapse_axis == 2);
+
+    casacore::IPosition chunk_shape_init = ChunkShape(collapse_axis, lattice_in);
+    casacore::LatticeStepper my_stepper(in_shape, chunk_shape_init, LatticeStepper::RESIZE);
+    casacore::RO_MaskedLatticeIterator<T> lat_iter(lattice_in, my_stepper);
+
+    if (_progress_monitor && (_steps_for_beam_convolution == 0)) { // no beam convolution done before, so initialize the progress meter
+        casacore::uInt total_slices = in_shape.product() / in_shape[collapse_axis];
+        _progress_monitor->init(total_slices);
+    }
+
+    casacore::uInt n_done = 0; // Number of slices have done
+
+    for (lat_iter.reset(); !lat_iter.atEnd(); ++lat_iter) {
+        if (_stop) {
+            break;
+        }
+
+        const casacore::IPosition iter_pos = lat_iter.position();
+        casacore::IPosition chunk_shape(in_ndim); // resized at the end of each axis
+        for (casacore::uInt i = 0; i < in_ndim; ++i) {
+            chunk_shape[i] = std::min(chunk_shape_init[i], in_shape[i] - iter_pos[i]);
+        }
+        const casacore::Array<casacore::Bool> mask_chunk = use_mask ? lat_iter.getMask() : Array<Bool>();
+
+        // Chunk pixels are contiguous for each position on the collapse axis
+        size_t num_inner(1), num_outer(1);
+        for (casacore::uInt i = 0; i < in_ndim; ++i) {
+            if (i < collapse_axis) {
+                num_inner *= chunk_shape[i];
+            } else if (i > collapse_axis) {
+                num_outer *= chunk_shape[i];
+            }
+        }
+
+        casacore::IPosition result_array_shape = chunk_shape;
+        result_array_shape[collapse_axis] = 1;
+        std::vector<casacore::Array<T>> result_arrays(n_out);
+        std::vector<casacore::Array<casacore::Bool>> result_array_masks(n_out);
+        std::vector<T*> results(n_out);
+        std::vector<casacore::Bool*> result_masks(n_out);
+        for (casacore::uInt k = 0; k < n_out; ++k) {
+            result_arrays[k].resize(result_array_shape);
+            result_array_masks[k].resize(result_array_shape);
+            results[k] = result_arrays[k].data();
+            result_masks[k] = result_array_masks[k].data();
+        }
+
+        if (use_spectra_reader && !CalculateChunkSpectra(calculator, iter_pos, chunk_shape, mask_chunk, results, result_masks)) {
+            spdlog::warn("Could not read spectra for moments, reading the image instead.");
+            use_spectra_reader = false;
+        }
+
+        if (!use_spectra_reader) {
+            const casacore::Array<T>& chunk = lat_iter.cursor();
+            casacore::Bool delete_data(false), delete_mask(false);
+            const T* data = chunk.getStorage(delete_data);
+            const casacore::Bool* mask = use_mask ? mask_chunk.getStorage(delete_mask) : nullptr;
+            calculator.Calculate(data, mask, num_inner, num_outer, results, result_masks);
+            chunk.freeStorage(data, delete_data);
+            if (use_mask) {
+                mask_chunk.freeStorage(mask, delete_mask);
+            }
+        }
+
+        // Put results in the output lattices (as a chunk size)
+        for (casacore::uInt k = 0; k < n_out; ++k) {
+            casacore::IPosition result_pos = in_ndim == out_dim ? iter_pos : iter_pos.removeAxes(casacore::IPosition(1, collapse_axis));
+            casacore::Bool keep_axis = result_arrays[k].ndim() == lattice_out[k]->ndim();
+            if (!keep_axis) {
+                result_arrays[k].removeDegenerate(display_axes);
+            }
+            lattice_out[k]->putSlice(result_arrays[k], result_pos);
+
+            if (lattice_out[k]->hasPixelMask()) {
+                casacore::Lattice<casacore::Bool>& mask_out = lattice_out[k]->pixelMask();
+                if (mask_out.isWritable()) {
+                    if (!keep_axis) {
+                        result_array_masks[k].removeDegenerate(display_axes);
+                    }
+                    mask_out.putSlice(result_array_masks[k], result_pos);
+                }
+            }
+        }
+
+        if (_progress_monitor) {
+            n_done += num_inner * num_outer;
+            _progress_monitor->nstepsDone(n_done + _steps_for_beam_convolution);
+        }
+    }
+
+    if (_progress_monitor) {
+        _progress_monitor->done();
+    }
+}
+
+template <class T>
+bool ImageMoments<T>::CalculateChunkSpectra(const MomentCalculator& calculator, const casacore::IPosition& chunk_pos,
+    const casacore::IPosition& chunk_shape, const casacore::Array<casacore::Bool>& mask_chunk, std::vector<T*>& results,
+    std::vector<casacore::Bool*>& result_masks) {
+    size_t count_x(chunk_shape[0]), count_y(chunk_shape[1]), num_z(chunk_shape[2]);
+    size_t num_pixels = count_x * count_y;
+
+    std::vector<T> spectra;
+    if (!_spectra_reader(spectra, chunk_pos[0], count_x, chunk_pos[1], count_y) || (spectra.size() != num_pixels * num_z)) {
+        return false;
+    }
+
+    // Spectrum for pixel (x, y) is at (x * count_y + y) * num_z; the chunk mask and results have x fastest
+    std::unique_ptr<casacore::Bool[]> spectra_mask;
+    if (!mask_chunk.empty()) {
+        spectra_mask.reset(new casacore::Bool[spectra.size()]);
+        casacore::Bool delete_mask(false);
+        const casacore::Bool* mask = mask_chunk.getStorage(delete_mask);
+        for (size_t z = 0; z < num_z; ++z) {
+            for (size_t y = 0; y < count_y; ++y) {
+                for (size_t x = 0; x < count_x; ++x) {
+                    spectra_mask[(x * count_y + y) * num_z + z] = mask[(z * count_y + y) * count_x + x];
+                }
+            }
+        }
+        mask_chunk.freeStorage(mask, delete_mask);
+    }
+
+    size_t num_moments = results.size();
+    std::vector<std::vector<T>> spectra_results(num_moments, std::vector<T>(num_pixels));
+    std::vector<std::unique_ptr<casacore::Bool[]>> spectra_result_masks(num_moments);
+    std::vector<T*> spectra_results_ptrs(num_moments);
+    std::vector<casacore::Bool*> spectra_result_masks_ptrs(num_moments);
+    for (size_t k = 0; k < num_moments; ++k) {
+        spectra_result_masks[k].reset(new casacore::Bool[num_pixels]);
+        spectra_results_ptrs[k] = spectra_results[k].data();
+        spectra_result_masks_ptrs[k] = spectra_result_masks[k].get();
+    }
+
+    calculator.CalculateSpectra(spectra.data(), spectra_mask.get(), num_pixels, spectra_results_ptrs, spectra_result_masks_ptrs);
+
+    for (size_t k = 0; k < num_moments; ++k) {
+        for (size_t y = 0; y < count_y; ++y) {
+            for (size_t x = 0; x < count_x; ++x) {
+                results[k][y * count_x + x] = spectra_results[k][x * count_y + y];
+                result_masks[k][y * count_x + x] = spectra_result_masks[k][x * count_y + y];
+            }
+        }
+    }
+    return true;
+}
+
+template <class T>
+void ImageMoments<T>::GetMomentAxisCoordinates(std::vector<casacore::Double>& coordinates, casacore::Double& integrated_scale) {
+    // As casa::MomentCalcBase: world coordinates along the moment axis at the reference pixel of the other axes, as velocity (km/s) if
+    // converting the spectral axis
+    const casacore::CoordinateSystem& csys = _image->coordinates();
+    casacore::uInt num_coordinates = _image->shape()(momentAxis_p);
+    coordinates.resize(num_coordinates);
+
+    casacore::SpectralCoordinate spectral_coord;
+    if (convertToVelocity_p) {
+        spectral_coord = csys.spectralCoordinate();
+        spectral_coord.setVelocity(casacore::String("km/s"), velocityType_p);
+    }
+
+    casacore::Vector<casacore::Double> pixel(csys.referencePixel()), world;
+    for (casacore::uInt i = 0; i < num_coordinates; ++i) {
+        pixel(momentAxis_p) = i;
+        if (!csys.toWorld(world, pixel)) {
+            throw casacore::AipsError("Failed to convert moment axis pixel to world coordinate: " + csys.errorMessage());
+        }
+        coordinates[i] = world(worldMomentAxis_p);
+        if (convertToVelocity_p) {
+            spectral_coord.frequencyToVelocity(coordinates[i], world(worldMomentAxis_p));
+        }
+    }
+
+    // Increment for integrated moment, as velocity across the reference pixel if converting
+    if (convertToVelocity_p) {
+        casacore::Double velocity0, velocity1;
+        spectral_coord.pixelToVelocity(velocity0, spectral_coord.referencePixel()(0) - 0.5);
+        spectral_coord.pixelToVelocity(velocity1, spectral_coord.referencePixel()(0) + 0.5);
+        integrated_scale = std::abs(velocity1 - velocity0);
+    } else {
+        integrated_scale = std::abs(csys.increment()(worldMomentAxis_p));
+    }
+}
+
 template <class T>
 casacore::IPosition ImageMoments<T>::ChunkShape(casacore::uInt axis, const casacore::MaskedLattice<T>& lattice_in) {
     casacore::uInt ndim = lattice_in.ndim();
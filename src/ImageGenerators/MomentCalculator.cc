@@ -0,0 +1,312 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# MomentCalculator.cc: implementation of native moment calculation
+
+#include "MomentCalculator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ThreadingManager/ThreadingManager.h"
+
+// Number of pixels accumulated together along the contiguous axis
+#define MOMENT_PIXEL_BLOCK_SIZE 256
+// Largest scratch buffer of values for the median kept by a thread between calls
+#define MOMENT_SCRATCH_SIZE_MB 16
+
+using namespace carta;
+
+using MomentTypes = MomentCalculator::MomentTypes;
+
+MomentCalculator::MomentCalculator(const std::vector<int>& moments, const std::vector<double>& coordinates, double integrated_scale)
+    : _moments(moments),
+      _coordinates(coordinates),
+      _integrated_scale(integrated_scale),
+      _include(false),
+      _exclude(false),
+      _range_min(0.0),
+      _range_max(0.0),
+      _do_coordinates(false),
+      _do_abs_deviation(false),
+      _do_median(false) {
+    for (auto moment : _moments) {
+        if (moment == MomentTypes::WEIGHTED_MEAN_COORDINATE || moment == MomentTypes::WEIGHTED_DISPERSION_COORDINATE) {
+            _do_coordinates = true;
+        } else if (moment == MomentTypes::ABS_MEAN_DEVIATION) {
+            _do_abs_deviation = true;
+        } else if (moment == MomentTypes::MEDIAN) {
+            _do_median = true;
+        }
+    }
+}
+
+void MomentCalculator::SetIncludeRange(float min, float max) {
+    _include = true;
+    _exclude = false;
+    _range_min = min;
+    _range_max = max;
+}
+
+void MomentCalculator::SetExcludeRange(float min, float max) {
+    _include = false;
+    _exclude = true;
+    _range_min = min;
+    _range_max = max;
+}
+
+// Release the scratch buffer if it is too large to keep between calls
+static void TrimScratch(std::vector<float>& scratch) {
+    if (scratch.capacity() * sizeof(float) > MOMENT_SCRATCH_SIZE_MB * 1024 * 1024) {
+        std::vector<float>().swap(scratch);
+    }
+}
+
+bool MomentCalculator::IsSupported(const std::vector<int>& moments) {
+    for (auto moment : moments) {
+        if (moment < 0 || moment >= MomentTypes::NMOMENTS || moment == MomentTypes::MEDIAN_COORDINATE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MomentCalculator::Calculate(const float* data, const bool* mask, size_t num_inner, size_t num_outer,
+    const std::vector<float*>& results, const std::vector<bool*>& result_masks) const {
+    size_t num_z(NumZ());
+
+    // Values for the median of each block of pixels are gathered in the thread's scratch buffer. Blocks are narrowed so that the buffer
+    // can be kept between calls, unless the spectra are very long.
+    size_t block_size(MOMENT_PIXEL_BLOCK_SIZE);
+    if (_do_median) {
+        size_t scratch_pixels = MOMENT_SCRATCH_SIZE_MB * 1024 * 1024 / (sizeof(float) * std::max<size_t>(num_z, 1));
+        block_size = std::max<size_t>(1, std::min(block_size, scratch_pixels));
+    }
+    size_t blocks_per_outer = (num_inner + block_size - 1) / block_size;
+    int64_t num_blocks = blocks_per_outer * num_outer;
+
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel
+    {
+        thread_local std::vector<float> selected;
+
+#pragma omp for schedule(dynamic)
+        for (int64_t iblock = 0; iblock < num_blocks; ++iblock) {
+            size_t outer = iblock / blocks_per_outer;
+            size_t first = (iblock % blocks_per_outer) * block_size;
+            size_t num_pixels = std::min<size_t>(block_size, num_inner - first);
+
+            // Spectra for this outer index, and results for the first pixel in block
+            size_t data_offset = outer * num_z * num_inner;
+            size_t result_offset = outer * num_inner + first;
+            std::vector<float*> block_results(_moments.size());
+            std::vector<bool*> block_result_masks(_moments.size());
+            for (size_t i = 0; i < _moments.size(); ++i) {
+                block_results[i] = results[i] + result_offset;
+                block_result_masks[i] = result_masks[i] + result_offset;
+            }
+
+            CalculateBlock(data + data_offset, (mask ? mask + data_offset : nullptr), num_inner, first, num_pixels, block_results.data(),
+                block_result_masks.data(), selected);
+        }
+        TrimScratch(selected);
+    }
+}
+
+void MomentCalculator::CalculateSpectra(const float* data, const bool* mask, size_t num_spectra, const std::vector<float*>& results,
+    const std::vector<bool*>& result_masks) const {
+    size_t num_z(NumZ());
+    int64_t num_pixels = num_spectra;
+
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel
+    {
+        thread_local std::vector<float> selected; // values used, for the median
+
+#pragma omp for schedule(dynamic)
+        for (int64_t i = 0; i < num_pixels; ++i) {
+            // Spectrum is contiguous, so accumulate one pixel at a time
+            const float* spectrum = data + i * num_z;
+            const bool* spectrum_mask = (mask ? mask + i * num_z : nullptr);
+            MomentSums sums;
+            selected.clear();
+            for (size_t z = 0; z < num_z; ++z) {
+                if (UsePixel(spectrum[z], spectrum_mask ? spectrum_mask[z] : true)) {
+                    Accumulate(sums, spectrum[z], z);
+                    if (_do_median) {
+                        selected.push_back(spectrum[z]);
+                    }
+                }
+            }
+
+            if (_do_abs_deviation && sums.num_points > 0) {
+                float mean = sums.s0 / sums.num_points;
+                for (size_t z = 0; z < num_z; ++z) {
+                    if (UsePixel(spectrum[z], spectrum_mask ? spectrum_mask[z] : true)) {
+                        sums.sum_abs_deviation += std::abs(spectrum[z] - mean);
+                    }
+                }
+            }
+
+            float median = (_do_median ? Median(selected.data(), selected.size()) : 0.0);
+            SetMoments(sums, median, i, results.data(), result_masks.data());
+        }
+        TrimScratch(selected);
+    }
+}
+
+void MomentCalculator::CalculateBlock(const float* data, const bool* mask, size_t num_inner, size_t first, size_t num_pixels,
+    float** results, bool** result_masks, std::vector<float>& selected) const {
+    // Accumulate sums for each pixel over the spectrum, with pixels contiguous in the inner loop
+    size_t num_z(NumZ());
+    std::vector<MomentSums> sums(num_pixels);
+
+    // Values used for each pixel are gathered into its spectrum of the scratch buffer, for the median
+    if (_do_median) {
+        selected.resize(num_pixels * num_z);
+    }
+
+    for (size_t z = 0; z < num_z; ++z) {
+        const float* plane = data + z * num_inner + first;
+        const bool* plane_mask = (mask ? mask + z * num_inner + first : nullptr);
+        for (size_t j = 0; j < num_pixels; ++j) {
+            if (UsePixel(plane[j], plane_mask ? plane_mask[j] : true)) {
+                if (_do_median) {
+                    selected[j * num_z + sums[j].num_points] = plane[j];
+                }
+                Accumulate(sums[j], plane[j], z);
+            }
+        }
+    }
+
+    // Absolute deviation about the mean needs a second pass
+    if (_do_abs_deviation) {
+        std::vector<float> mean(num_pixels);
+        for (size_t j = 0; j < num_pixels; ++j) {
+            mean[j] = (sums[j].num_points > 0 ? sums[j].s0 / sums[j].num_points : 0.0);
+        }
+
+        for (size_t z = 0; z < num_z; ++z) {
+            const float* plane = data + z * num_inner + first;
+            const bool* plane_mask = (mask ? mask + z * num_inner + first : nullptr);
+            for (size_t j = 0; j < num_pixels; ++j) {
+                if (UsePixel(plane[j], plane_mask ? plane_mask[j] : true)) {
+                    sums[j].sum_abs_deviation += std::abs(plane[j] - mean[j]);
+                }
+            }
+        }
+    }
+
+    for (size_t j = 0; j < num_pixels; ++j) {
+        float median = (_do_median ? Median(selected.data() + j * num_z, sums[j].num_points) : 0.0);
+        SetMoments(sums[j], median, j, results, result_masks);
+    }
+}
+
+float MomentCalculator::Median(float* values, size_t num_values) {
+    // As casacore::median, which takes the mean of the middle values only for an even number of up to 100 values
+    if (num_values == 0) {
+        return 0.0;
+    }
+    size_t middle = num_values / 2;
+    std::nth_element(values, values + middle, values + num_values);
+    float median = values[middle];
+    if ((num_values % 2 == 0) && (num_values <= 100)) {
+        median = 0.5f * (*std::max_element(values, values + middle) + median);
+    }
+    return median;
+}
+
+inline bool MomentCalculator::UsePixel(float value, bool mask) const {
+    if (!mask) {
+        return false;
+    }
+    if (_include) {
+        return value >= _range_min && value <= _range_max;
+    }
+    if (_exclude) {
+        return value < _range_min || value > _range_max;
+    }
+    return true;
+}
+
+inline void MomentCalculator::Accumulate(MomentSums& sums, float value, size_t z) const {
+    double datum = value;
+    sums.s0 += datum;
+    sums.s0_sq += datum * datum;
+    if (_do_coordinates) {
+        double coordinate = _coordinates[z];
+        sums.s1 += datum * coordinate;
+        sums.s2 += datum * coordinate * coordinate;
+    }
+    if (value < sums.data_min) {
+        sums.data_min = value;
+        sums.index_min = z;
+    }
+    if (value > sums.data_max) {
+        sums.data_max = value;
+        sums.index_max = z;
+    }
+    ++sums.num_points;
+}
+
+void MomentCalculator::SetMoments(
+    const MomentSums& sums, float median, size_t j, float* const* results, bool* const* result_masks) const {
+    // Set moments from the sums, as casa::MomentCalcBase
+    if (sums.num_points == 0) {
+        // All pixels masked or out of range
+        for (size_t i = 0; i < _moments.size(); ++i) {
+            results[i][j] = 0.0;
+            result_masks[i][j] = false;
+        }
+        return;
+    }
+
+    float moments[MomentTypes::NMOMENTS];
+    bool moments_mask[MomentTypes::NMOMENTS];
+    std::fill(moments_mask, moments_mask + MomentTypes::NMOMENTS, true);
+    double n = sums.num_points;
+    moments[MomentTypes::AVERAGE] = sums.s0 / n;
+    moments[MomentTypes::INTEGRATED] = sums.s0 * _integrated_scale;
+    moments[MomentTypes::MEDIAN] = median;
+
+    if (std::abs(sums.s0) > 0.0) {
+        moments[MomentTypes::WEIGHTED_MEAN_COORDINATE] = sums.s1 / sums.s0;
+        moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] =
+            (sums.s2 / sums.s0) - moments[MomentTypes::WEIGHTED_MEAN_COORDINATE] * moments[MomentTypes::WEIGHTED_MEAN_COORDINATE];
+        moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] = std::abs(moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE]);
+        if (moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] > 0.0) {
+            moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] = std::sqrt(moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE]);
+        } else {
+            moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] = 0.0;
+        }
+    } else {
+        moments[MomentTypes::WEIGHTED_MEAN_COORDINATE] = 0.0;
+        moments[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] = 0.0;
+        moments_mask[MomentTypes::WEIGHTED_MEAN_COORDINATE] = false;
+        moments_mask[MomentTypes::WEIGHTED_DISPERSION_COORDINATE] = false;
+    }
+
+    if (sums.num_points > 1) {
+        double variance = (sums.s0_sq - sums.s0 * sums.s0 / n) / (n - 1.0);
+        moments[MomentTypes::STANDARD_DEVIATION] = (variance > 0.0 ? std::sqrt(variance) : 0.0);
+    } else {
+        moments[MomentTypes::STANDARD_DEVIATION] = 0.0;
+        moments_mask[MomentTypes::STANDARD_DEVIATION] = false;
+    }
+
+    moments[MomentTypes::RMS] = std::sqrt(sums.s0_sq / n);
+    moments[MomentTypes::ABS_MEAN_DEVIATION] = sums.sum_abs_deviation / n;
+    moments[MomentTypes::MAXIMUM] = sums.data_max;
+    moments[MomentTypes::MAXIMUM_COORDINATE] = _coordinates[sums.index_max];
+    moments[MomentTypes::MINIMUM] = sums.data_min;
+    moments[MomentTypes::MINIMUM_COORDINATE] = _coordinates[sums.index_min];
+
+    for (size_t i = 0; i < _moments.size(); ++i) {
+        results[i][j] = moments[_moments[i]];
+        result_masks[i][j] = moments_mask[_moments[i]];
+    }
+}
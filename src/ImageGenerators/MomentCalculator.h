@@ -0,0 +1,93 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# MomentCalculator.h: native calculation of moments for chunks of image data, as casa::MomentClip without smoothing
+
+#ifndef CARTA_SRC_IMAGEGENERATORS_MOMENTCALCULATOR_H_
+#define CARTA_SRC_IMAGEGENERATORS_MOMENTCALCULATOR_H_
+
+#include <imageanalysis/ImageAnalysis/MomentsBase.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace carta {
+
+class MomentCalculator {
+public:
+    using MomentTypes = casa::MomentsBase<casacore::Float>::MomentTypes;
+
+    // Moment types as casa::MomentsBase::MomentTypes. Coordinates are the world coordinates (or velocities) of the pixels along the
+    // moment axis, and integrated_scale the increment used for the integrated moment.
+    MomentCalculator(const std::vector<int>& moments, const std::vector<double>& coordinates, double integrated_scale);
+
+    // Use only pixel values in the range [min, max], or outside it
+    void SetIncludeRange(float min, float max);
+    void SetExcludeRange(float min, float max);
+
+    // Whether all moment types can be calculated natively; the median coordinate is not
+    static bool IsSupported(const std::vector<int>& moments);
+
+    // Calculate moments in one pass for a chunk of data and optional mask, with the moment axis of length NumZ() and pixels which are
+    // contiguous for each z: element (pixel j, z, outer index k) is at (k * NumZ() + z) * num_inner + j. Results and result masks for
+    // each moment are for pixel j + k * num_inner.
+    void Calculate(const float* data, const bool* mask, size_t num_inner, size_t num_outer, const std::vector<float*>& results,
+        const std::vector<bool*>& result_masks) const;
+
+    // Calculate moments for spectra which are contiguous along the moment axis, as in swizzled data: element (spectrum i, z) is at
+    // i * NumZ() + z. Results and result masks for each moment are for spectrum i.
+    void CalculateSpectra(const float* data, const bool* mask, size_t num_spectra, const std::vector<float*>& results,
+        const std::vector<bool*>& result_masks) const;
+
+    inline size_t NumZ() const {
+        return _coordinates.size();
+    }
+
+private:
+    // Sums over the spectrum of one pixel
+    struct MomentSums {
+        double s0 = 0.0;
+        double s0_sq = 0.0;
+        double s1 = 0.0;
+        double s2 = 0.0;
+        double sum_abs_deviation = 0.0;
+        int num_points = 0;
+        int index_min = 0;
+        int index_max = 0;
+        float data_min = 1.0e30;
+        float data_max = -1.0e30;
+    };
+
+    // Calculate moments for pixels first to first + num_pixels of a chunk of spectra, using selected as scratch for the median
+    void CalculateBlock(const float* data, const bool* mask, size_t num_inner, size_t first, size_t num_pixels, float** results,
+        bool** result_masks, std::vector<float>& selected) const;
+
+    // Whether the pixel is unmasked and in the include range, or outside the exclude range
+    bool UsePixel(float value, bool mask) const;
+    void Accumulate(MomentSums& sums, float value, size_t z) const;
+    // Set moments for pixel j from its sums and the median of its values
+    void SetMoments(const MomentSums& sums, float median, size_t j, float* const* results, bool* const* result_masks) const;
+    // Median of the values, which are partially sorted
+    static float Median(float* values, size_t num_values);
+
+    std::vector<int> _moments;
+    std::vector<double> _coordinates;
+    double _integrated_scale;
+
+    bool _include;
+    bool _exclude;
+    float _range_min;
+    float _range_max;
+
+    // Accumulate coordinate sums, deviations and values for the median only if needed
+    bool _do_coordinates;
+    bool _do_abs_deviation;
+    bool _do_median;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_IMAGEGENERATORS_MOMENTCALCULATOR_H_
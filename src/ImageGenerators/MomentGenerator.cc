@@ -115,6 +115,10 @@ void MomentGenerator::StopCalculation() {
     }
 }
 
+void MomentGenerator::SetSpectraReader(const ImageMoments<casacore::Float>::SpectraReader& reader) {
+    _spectra_reader = reader;
+}
+
 void MomentGenerator::SetMomentAxis(const CARTA::MomentRequest& moment_request) {
     if (moment_request.axis() == CARTA::MomentAxis::SPECTRAL) {
         _axis = _spectral_axis;
@@ -200,6 +204,9 @@ void MomentGenerator::ResetImageMoments(const casacore::ImageRegion& image_regio
 
     // Make an ImageMoments object and overwrite the output file if it already exists
     _image_moments.reset(new IM(casacore::SubImage<casacore::Float>(*_sub_image), os, this, true));
+    if (_spectra_reader) {
+        _image_moments->SetSpectraReader(_spectra_reader);
+    }
 }
 
 void MomentGenerator::SetImageRestFrequency(double rest_frequency) {
@@ -34,6 +34,9 @@ public:
         CARTA::MomentResponse& moment_response, std::vector<GeneratedImage>& collapse_results, const RegionState& region_state,
         const std::string& stokes);
 
+    // Read spectra from the file (e.g. swizzled data) for the moment calculation; see ImageMoments::SetSpectraReader
+    void SetSpectraReader(const ImageMoments<casacore::Float>::SpectraReader& reader);
+
     // Stop moments calculation
     void StopCalculation();
 
@@ -70,6 +73,7 @@ private:
     // Moments settings
     std::unique_ptr<casacore::ImageInterface<casacore::Float>> _sub_image;
     std::unique_ptr<ImageMoments<casacore::Float>> _image_moments;
+    ImageMoments<casacore::Float>::SpectraReader _spectra_reader;
     casacore::Vector<casacore::Int> _moments; // Moment types
     int _axis;                                // Moment axis
     casacore::Vector<float> _include_pix;
@@ -7,6 +7,7 @@
 #include "PvPreviewCube.h"
 
 #include <cmath>
+#include <future>
 #include <valarray>
 
 #include <casacore/images/Images/RebinImage.h>
@@ -16,6 +17,8 @@
 #include "Timer/Timer.h"
 
 #define LOAD_DATA_PROGRESS_INTERVAL 1000
+#define PREVIEW_CUBE_MAX_SLAB_SIZE 16777216
+#define PREVIEW_CUBE_PROFILE_CACHE_SIZE_MB 64
 
 namespace carta {
 
@@ -58,7 +61,9 @@ std::shared_ptr<casacore::ImageInterface<float>> PvPreviewCube::GetPreviewImage(
     GeneratorProgressCallback progress_callback, bool& cancel, std::string& message) {
     // Returns cached preview image; nullptr if not set
     if (_preview_image && !CubeLoaded()) {
-        LoadCubeData(progress_callback, cancel);
+        if (!LoadCubeData(progress_callback, cancel, message)) {
+            return nullptr;
+        }
         if (cancel) {
             message = _cancel_message;
         }
@@ -75,8 +80,8 @@ std::shared_ptr<casacore::ImageInterface<float>> PvPreviewCube::GetPreviewImage(
 
     if (_preview_image) {
         // Image already created, load data if cancelled
-        if (!CubeLoaded()) {
-            LoadCubeData(progress_callback, cancel);
+        if (!CubeLoaded() && !LoadCubeData(progress_callback, cancel, message)) {
+            return nullptr;
         }
         if (cancel) {
             message = _cancel_message;
@@ -126,7 +131,9 @@ std::shared_ptr<casacore::ImageInterface<float>> PvPreviewCube::GetPreviewImage(
         _preview_image.reset(new casacore::SubImage<float>(sub_image));
     }
 
-    LoadCubeData(progress_callback, cancel);
+    if (!LoadCubeData(progress_callback, cancel, message)) {
+        return nullptr;
+    }
     if (cancel) {
         message = _cancel_message;
     }
@@ -152,37 +159,47 @@ RegionState PvPreviewCube::GetPvCutRegion(const RegionState& source_region_state
     return RegionState(preview_frame_id, CARTA::RegionType::LINE, preview_line_points, source_region_state.rotation);
 }
 
-bool PvPreviewCube::GetRegionProfile(const casacore::Slicer& region_bounding_box, const casacore::ArrayLattice<casacore::Bool>& mask,
-    GeneratorProgressCallback progress_callback, std::vector<float>& profile, double& num_pixels, std::string& message) {
+bool PvPreviewCube::GetRegionProfile(const RegionMask& region_mask, GeneratorProgressCallback progress_callback,
+    std::vector<float>& profile, double& num_pixels, std::string& message) {
     // Set spectral profile and maximum number of pixels for region.
     // Returns false if no preview image
     if (!_preview_image || !CubeLoaded()) {
         return false;
     }
 
-    auto box_start = region_bounding_box.start();
-    auto box_length = region_bounding_box.length();
+    std::vector<int> region_pixels;
+    region_pixels.reserve(region_mask.Runs().size() * 3);
+    for (const auto& run : region_mask.Runs()) {
+        region_pixels.insert(region_pixels.end(), {run.y, run.x0, run.x1});
+    }
+
+    auto cached = _region_profiles.find(region_pixels);
+    if (cached != _region_profiles.end()) {
+        // Move to front of queue as most recently used
+        _region_profile_queue.splice(_region_profile_queue.begin(), _region_profile_queue, cached->second);
+        auto& region_profile = cached->second->second;
+        profile = region_profile.profile;
+        num_pixels = region_profile.num_pixels;
+        return true;
+    }
 
     // Initialize profile to channels in preview image
     size_t nchan = _preview_image->shape()(_preview_image->coordinates().spectralAxisNumber());
     profile.resize(nchan, NAN);
     std::vector<double> npix_per_chan(nchan, 0.0);
     auto data_shape = _cube_data.shape();
-    auto mask_shape = mask.shape();
+    size_t width(data_shape(0)), channel_size(data_shape(0) * data_shape(1));
+    const float* cube_data = _cube_data.data();
 
     for (size_t ichan = 0; ichan < nchan; ++ichan) {
+        // Accumulate pixels in region which are not NAN or inf
+        const float* channel_data = cube_data + ichan * channel_size;
         double chan_sum(0.0);
-        for (size_t ix = 0; ix < box_length[0]; ++ix) {
-            for (size_t iy = 0; iy < box_length[1]; ++iy) {
-                // Accumulate if pixel in region (mask=true) and is not NAN or inf
-                if (!mask.getAt(casacore::IPosition(2, ix, iy))) {
-                    continue;
-                }
-
-                float data_val = _cube_data(casacore::IPosition(3, ix + box_start[0], iy + box_start[1], ichan));
-
-                if (std::isfinite(data_val)) {
-                    chan_sum += data_val;
+        for (const auto& run : region_mask.Runs()) {
+            const float* row_data = channel_data + run.y * width;
+            for (int x = run.x0; x <= run.x1; ++x) {
+                if (std::isfinite(row_data[x])) {
+                    chan_sum += row_data[x];
                     ++npix_per_chan[ichan];
                 }
             }
@@ -195,9 +212,41 @@ bool PvPreviewCube::GetRegionProfile(const casacore::Slicer& region_bounding_box
     }
 
     num_pixels = *max_element(npix_per_chan.begin(), npix_per_chan.end());
+
+    CacheRegionProfile(region_pixels, {profile, num_pixels});
     return true;
 }
 
+static size_t RegionProfileSize(const std::vector<int>& region_pixels, const RegionProfile& region_profile) {
+    return (region_pixels.size() * sizeof(int)) + (region_profile.profile.size() * sizeof(float)) + sizeof(RegionProfile);
+}
+
+void PvPreviewCube::CacheRegionProfile(const std::vector<int>& region_pixels, const RegionProfile& region_profile) {
+    size_t max_size = PREVIEW_CUBE_PROFILE_CACHE_SIZE_MB * 1024 * 1024;
+    size_t size = RegionProfileSize(region_pixels, region_profile);
+    if (size > max_size) {
+        return;
+    }
+
+    // Evict least recently used profiles
+    while (!_region_profile_queue.empty() && (_region_profiles_size + size > max_size)) {
+        auto& oldest = _region_profile_queue.back();
+        _region_profiles_size -= RegionProfileSize(oldest.first, oldest.second);
+        _region_profiles.erase(oldest.first);
+        _region_profile_queue.pop_back();
+    }
+
+    _region_profile_queue.emplace_front(region_pixels, region_profile);
+    _region_profiles[region_pixels] = _region_profile_queue.begin();
+    _region_profiles_size += size;
+}
+
+void PvPreviewCube::ClearRegionProfiles() {
+    _region_profiles.clear();
+    _region_profile_queue.clear();
+    _region_profiles_size = 0;
+}
+
 void PvPreviewCube::StopCube() {
     _stop_cube = true;
 }
@@ -206,18 +255,20 @@ bool PvPreviewCube::DoRebin() {
     return _cube_parameters.rebin_xy > 1 || _cube_parameters.rebin_z > 1;
 }
 
-void PvPreviewCube::LoadCubeData(GeneratorProgressCallback progress_callback, bool& cancel) {
+bool PvPreviewCube::LoadCubeData(GeneratorProgressCallback progress_callback, bool& cancel, std::string& message) {
     // Cache preview image data in memory
     // First check if user cancelled.
     if (_stop_cube) {
         cancel = true;
         _stop_cube = false; // reset for next preview
-        return;
+        return true;
     }
 
+    // Cached profiles are for previous cube data
+    ClearRegionProfiles();
+
     Timer t;
     if (DoRebin()) {
-        casacore::Array<float> carta_cube_data;
         int spectral_axis(_preview_subimage.coordinates().spectralAxisNumber());
         auto subimage_shape = _preview_subimage.shape();
 
@@ -225,12 +276,7 @@ void PvPreviewCube::LoadCubeData(GeneratorProgressCallback progress_callback, bo
         auto width = subimage_shape(0);
         auto height = subimage_shape(1);
         auto nchan = subimage_shape(spectral_axis);
-        auto chan_size = width * height;
-
-        // Channel slicer start and length
-        casacore::IPosition start(subimage_shape.size(), 0);
-        casacore::IPosition length(subimage_shape);
-        length(spectral_axis) = 1;
+        size_t chan_size = width * height;
 
         // Rebin shape: same shape as casacore::RebinImage
         auto rebin_xy = _cube_parameters.rebin_xy;
@@ -240,61 +286,90 @@ void PvPreviewCube::LoadCubeData(GeneratorProgressCallback progress_callback, bo
         size_t rebin_nchan = std::ceil((float)nchan / (float)rebin_z);
         _cube_data.resize(casacore::IPosition(3, rebin_width, rebin_height, rebin_nchan));
         _cube_data = NAN;
-
-        casacore::IPosition rebin_channel_shape(2, rebin_width, rebin_height);
+        float* cube_data = _cube_data.data();
         size_t rebin_channel_size = rebin_width * rebin_height;
-        size_t new_chan(0);
+
+        // Output channels with all rebin_z channels in the image; a partial last channel remains NaN.
+        // Read whole output channels in each slab, with at most PREVIEW_CUBE_MAX_SLAB_SIZE pixels unless one output channel is larger.
+        size_t num_groups = nchan / rebin_z;
+        size_t group_size = chan_size * rebin_z;
+        size_t slab_groups = std::max<size_t>(1, PREVIEW_CUBE_MAX_SLAB_SIZE / group_size);
+
+        auto read_slab = [&](size_t first_group, casacore::Array<float>& slab) {
+            // Data for channels in output channels first_group to first_group + slab_groups, x fastest then y then channel
+            casacore::IPosition start(subimage_shape.size(), 0);
+            casacore::IPosition length(subimage_shape);
+            start(spectral_axis) = first_group * rebin_z;
+            length(spectral_axis) = std::min(slab_groups, num_groups - first_group) * rebin_z;
+            _preview_subimage.getSlice(slab, casacore::Slicer(start, length));
+        };
+
+        // Read next slab while rebinning current slab
+        casacore::Array<float> slabs[2];
+        std::future<void> next_slab;
+        if (num_groups > 0) {
+            next_slab = std::async(std::launch::async, read_slab, 0, std::ref(slabs[0]));
+        }
+
+        std::vector<float> rebinned_data(rebin_xy > 1 ? rebin_channel_size : 0);
 
         // Timer for progress updates
         auto t_start = std::chrono::high_resolution_clock::now();
-        for (auto ichan = 0; ichan < nchan; ichan += rebin_z) {
+        for (size_t first_group = 0, islab = 0; first_group < num_groups; first_group += slab_groups, ++islab) {
+            try {
+                // Rethrows an error from reading the slab
+                next_slab.get();
+            } catch (const casacore::AipsError& err) {
+                message = err.getMesg();
+                _cube_data.resize();
+                return false;
+            }
+            auto& slab = slabs[islab % 2];
+            size_t end_group = std::min(first_group + slab_groups, num_groups);
+
             // Check for cancel
             if (_stop_cube) {
                 cancel = true;
                 _cube_data.resize();
                 _stop_cube = false; // reset for next preview
-                return;
+                return true;
             }
 
-            // Check if can average next rebin_z channels
-            if (ichan + rebin_z - 1 >= nchan) {
-                break;
+            if (end_group < num_groups) {
+                next_slab = std::async(std::launch::async, read_slab, end_group, std::ref(slabs[(islab + 1) % 2]));
             }
 
-            // Accumulate rebin_z channels
-            std::vector<float> channel_sum(rebin_channel_size, 0.0);
-
-            for (int rebin_chan = 0; rebin_chan < rebin_z; ++rebin_chan) {
-                // Apply channel slicer to get data and mask for this channel
-                casacore::Array<float> data;
-                start(spectral_axis) = ichan + rebin_chan;
-                casacore::Slicer channel_slicer(start, length);
-                _preview_subimage.getSlice(data, channel_slicer, true);
-                auto channel_data = data.tovector();
-
-                if (rebin_xy > 1) {
-                    // Rebin channel data in xy
-                    std::vector<float> rebinned_data(rebin_channel_size, 0.0);
-                    BlockSmooth(channel_data.data(), rebinned_data.data(), width, height, rebin_width, rebin_height, 0, 0, rebin_xy);
-
-                    // Accumulate rebinned channel data
-                    std::transform(channel_sum.begin(), channel_sum.end(), rebinned_data.begin(), channel_sum.begin(), std::plus<float>());
-                } else {
-                    // Accumulate channel data
-                    std::transform(channel_sum.begin(), channel_sum.end(), channel_data.begin(), channel_sum.begin(), std::plus<float>());
+            bool delete_slab(false);
+            const float* slab_data = slab.getStorage(delete_slab);
+
+            for (size_t group = first_group; group < end_group; ++group) {
+                // Accumulate rebin_z channels in place in output channel
+                float* channel_sum = cube_data + group * rebin_channel_size;
+                std::fill(channel_sum, channel_sum + rebin_channel_size, 0.0);
+
+                for (int rebin_chan = 0; rebin_chan < rebin_z; ++rebin_chan) {
+                    const float* channel_data = slab_data + ((group - first_group) * rebin_z + rebin_chan) * chan_size;
+                    if (rebin_xy > 1) {
+                        // Rebin channel data in xy
+                        BlockSmooth(channel_data, rebinned_data.data(), width, height, rebin_width, rebin_height, 0, 0, rebin_xy);
+                        channel_data = rebinned_data.data();
+                    }
+
+                    for (size_t i = 0; i < rebin_channel_size; ++i) {
+                        channel_sum[i] += channel_data[i];
+                    }
                 }
-            }
 
-            // Get mean for rebin_z
-            std::transform(channel_sum.begin(), channel_sum.end(), channel_sum.begin(), [rebin_z](float& s) { return s / (float)rebin_z; });
+                // Get mean for rebin_z
+                for (size_t i = 0; i < rebin_channel_size; ++i) {
+                    channel_sum[i] /= (float)rebin_z;
+                }
+            }
 
-            // Reshape vector to 2D and set cube data for this output channel
-            casacore::Vector<float> channel_sumv(channel_sum);
-            auto channel_cube_data = channel_sumv.reform(rebin_channel_shape);
-            _cube_data[new_chan++] = channel_cube_data;
+            slab.freeStorage(slab_data, delete_slab);
 
             // Update progress at interval
-            float progress = (float)ichan / (float)nchan;
+            float progress = (float)(end_group * rebin_z) / (float)nchan;
             auto t_end = std::chrono::high_resolution_clock::now();
             auto dt = std::chrono::duration<double, std::milli>(t_end - t_start).count();
             if ((dt > LOAD_DATA_PROGRESS_INTERVAL) || (progress >= 1.0)) {
@@ -307,12 +382,18 @@ void PvPreviewCube::LoadCubeData(GeneratorProgressCallback progress_callback, bo
     } else {
         // No progress updates for each channel, but should be quick
         progress_callback(0.1);
-        _cube_data = _preview_subimage.get(true); // no degenerate axis
+        try {
+            _cube_data = _preview_subimage.get(true); // no degenerate axis
+        } catch (const casacore::AipsError& err) {
+            message = err.getMesg();
+            return false;
+        }
         spdlog::performance("PV preview cube data (no rebin) loaded in {:.3f} ms", t.Elapsed().ms());
     }
 
     // Most of time spent loading data, calculating profiles is minimal
     progress_callback(1.0);
+    return true;
 }
 
 bool PvPreviewCube::CubeLoaded() {
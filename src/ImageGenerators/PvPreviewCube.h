@@ -7,10 +7,15 @@
 #ifndef CARTA_SRC_IMAGEGENERATORS_PVPREVIEWCUBE_H_
 #define CARTA_SRC_IMAGEGENERATORS_PVPREVIEWCUBE_H_
 
+#include <list>
+#include <unordered_map>
+#include <vector>
+
 #include <casacore/images/Images/SubImage.h>
 
 #include "ImageGenerators/ImageGenerator.h"
 #include "Region/Region.h"
+#include "Region/RegionMask.h"
 #include "Util/File.h"
 #include "Util/Image.h"
 
@@ -43,6 +48,22 @@ struct PreviewCubeParameters {
     }
 };
 
+// Key for region profile cache: flattened pixel runs (y, x0, x1) of the region in the preview cube
+struct RegionPixelsHash {
+    std::size_t operator()(std::vector<int> const& pixels) const noexcept {
+        std::size_t h(pixels.size());
+        for (auto value : pixels) {
+            h ^= std::hash<int>{}(value) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+struct RegionProfile {
+    std::vector<float> profile;
+    double num_pixels;
+};
+
 class PvPreviewCube {
 public:
     PvPreviewCube(const PreviewCubeParameters& parameters);
@@ -75,10 +96,11 @@ public:
     // Set PV cut in preview cube
     RegionState GetPvCutRegion(const RegionState& source_region_state, int preview_frame_id);
 
-    // Apply region and mask to preview cube for spectral profile and maximum number of per-channel pixels.
+    // Apply region pixels to preview cube for spectral profile and maximum number of per-channel pixels.
+    // Profiles are cached by region pixels, so unchanged boxes are reused when the pv cut moves.
     // Include progress callback in case data must be loaded
-    bool GetRegionProfile(const casacore::Slicer& region_bounding_box, const casacore::ArrayLattice<casacore::Bool>& mask,
-        GeneratorProgressCallback progress_callback, std::vector<float>& profile, double& num_pixels, std::string& message);
+    bool GetRegionProfile(const RegionMask& region_mask, GeneratorProgressCallback progress_callback, std::vector<float>& profile,
+        double& num_pixels, std::string& message);
 
     // Cancel preview image and cube data cache.
     void StopCube();
@@ -87,8 +109,12 @@ private:
     // Rebin cube parameters > 1
     bool DoRebin();
 
-    // Cache cube data for preview image
-    void LoadCubeData(GeneratorProgressCallback progress_callback, bool& cancel);
+    // Add region profile to cache, evicting least recently used profiles to stay within the cache size
+    void CacheRegionProfile(const std::vector<int>& region_pixels, const RegionProfile& region_profile);
+    void ClearRegionProfiles();
+
+    // Cache cube data for preview image. Returns false with message if the data could not be read.
+    bool LoadCubeData(GeneratorProgressCallback progress_callback, bool& cancel, std::string& message);
 
     // Cube parameters
     PreviewCubeParameters _cube_parameters;
@@ -108,6 +134,12 @@ private:
     // Image cube cache
     casacore::Array<float> _cube_data;
 
+    // Region profiles in cube data, key is region pixels. LRU cache bounded by size in bytes of keys and profiles
+    using RegionProfilePair = std::pair<std::vector<int>, RegionProfile>;
+    std::list<RegionProfilePair> _region_profile_queue;
+    std::unordered_map<std::vector<int>, std::list<RegionProfilePair>::iterator, RegionPixelsHash> _region_profiles;
+    size_t _region_profiles_size = 0;
+
     // Flag to stop caching image cube
     bool _stop_cube;
     std::string _cancel_message;
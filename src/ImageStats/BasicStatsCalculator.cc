@@ -0,0 +1,188 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "BasicStatsCalculator.h"
+
+#include <limits>
+
+#include "ThreadingManager/ThreadingManager.h"
+#include "Util/Simd.h"
+
+// Number of values reduced by each call of the stats kernel
+#define BASIC_STATS_BLOCK_SIZE 4096
+
+namespace carta {
+
+struct PartialStats {
+    float min_val = std::numeric_limits<float>::max();
+    float max_val = std::numeric_limits<float>::lowest();
+    size_t num_pixels = 0;
+    double sum = 0;
+    double sum_squares = 0;
+};
+
+using StatsKernel = void (*)(const float*, int64_t, PartialStats&);
+
+// Finite values only. Sums are accumulated in double precision, as in the generic reduce.
+static inline void AccumulateStatsScalar(const float* data, int64_t size, PartialStats& stats) {
+    for (int64_t i = 0; i < size; i++) {
+        float val = data[i];
+        if (std::isfinite(val)) {
+            stats.min_val = std::min(stats.min_val, val);
+            stats.max_val = std::max(stats.max_val, val);
+            stats.num_pixels++;
+            stats.sum += (double)val;
+            stats.sum_squares += (double)val * val;
+        }
+    }
+}
+
+static void AccumulateStatsSSE(const float* data, int64_t size, PartialStats& stats) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 min_vec = _mm_set1_ps(stats.min_val);
+    __m128 max_vec = _mm_set1_ps(stats.max_val);
+    __m128i count = _mm_setzero_si128();
+    __m128d sum = _mm_setzero_pd();
+    __m128d sum_squares = _mm_setzero_pd();
+
+    const int64_t blocked_size = 4 * (size / 4);
+    for (int64_t i = 0; i < blocked_size; i += 4) {
+        __m128 val = _mm_loadu_ps(data + i);
+        // Ordered comparison, so that NaNs are also excluded
+        __m128 mask = _mm_cmplt_ps(_mm_andnot_ps(sign_mask, val), inf);
+        min_vec = _mm_min_ps(min_vec, _mm_blendv_ps(min_vec, val, mask));
+        max_vec = _mm_max_ps(max_vec, _mm_blendv_ps(max_vec, val, mask));
+        // Mask lanes are -1 for finite values
+        count = _mm_sub_epi32(count, _mm_castps_si128(mask));
+        val = _mm_and_ps(val, mask);
+        __m128d low = _mm_cvtps_pd(val);
+        __m128d high = _mm_cvtps_pd(_mm_movehl_ps(val, val));
+        sum = _mm_add_pd(sum, _mm_add_pd(low, high));
+        sum_squares = _mm_add_pd(sum_squares, _mm_add_pd(_mm_mul_pd(low, low), _mm_mul_pd(high, high)));
+    }
+
+    alignas(16) float min_vals[4], max_vals[4];
+    alignas(16) int32_t counts[4];
+    alignas(16) double sums[2], sums_squares[2];
+    _mm_store_ps(min_vals, min_vec);
+    _mm_store_ps(max_vals, max_vec);
+    _mm_store_si128((__m128i*)counts, count);
+    _mm_store_pd(sums, sum);
+    _mm_store_pd(sums_squares, sum_squares);
+    for (int lane = 0; lane < 4; lane++) {
+        stats.min_val = std::min(stats.min_val, min_vals[lane]);
+        stats.max_val = std::max(stats.max_val, max_vals[lane]);
+        stats.num_pixels += counts[lane];
+    }
+    stats.sum += sums[0] + sums[1];
+    stats.sum_squares += sums_squares[0] + sums_squares[1];
+    AccumulateStatsScalar(data + blocked_size, size - blocked_size, stats);
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX2 static void AccumulateStatsAVX2(const float* data, int64_t size, PartialStats& stats) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 min_vec = _mm256_set1_ps(stats.min_val);
+    __m256 max_vec = _mm256_set1_ps(stats.max_val);
+    __m256i count = _mm256_setzero_si256();
+    __m256d sum = _mm256_setzero_pd();
+    __m256d sum_squares = _mm256_setzero_pd();
+
+    const int64_t blocked_size = 8 * (size / 8);
+    for (int64_t i = 0; i < blocked_size; i += 8) {
+        __m256 val = _mm256_loadu_ps(data + i);
+        __m256 mask = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, val), inf, _CMP_LT_OQ);
+        min_vec = _mm256_min_ps(min_vec, _mm256_blendv_ps(min_vec, val, mask));
+        max_vec = _mm256_max_ps(max_vec, _mm256_blendv_ps(max_vec, val, mask));
+        count = _mm256_sub_epi32(count, _mm256_castps_si256(mask));
+        val = _mm256_and_ps(val, mask);
+        __m256d low = _mm256_cvtps_pd(_mm256_castps256_ps128(val));
+        __m256d high = _mm256_cvtps_pd(_mm256_extractf128_ps(val, 1));
+        sum = _mm256_add_pd(sum, _mm256_add_pd(low, high));
+        sum_squares = _mm256_add_pd(sum_squares, _mm256_add_pd(_mm256_mul_pd(low, low), _mm256_mul_pd(high, high)));
+    }
+
+    alignas(32) float min_vals[8], max_vals[8];
+    alignas(32) int32_t counts[8];
+    alignas(32) double sums[4], sums_squares[4];
+    _mm256_store_ps(min_vals, min_vec);
+    _mm256_store_ps(max_vals, max_vec);
+    _mm256_store_si256((__m256i*)counts, count);
+    _mm256_store_pd(sums, sum);
+    _mm256_store_pd(sums_squares, sum_squares);
+    for (int lane = 0; lane < 8; lane++) {
+        stats.min_val = std::min(stats.min_val, min_vals[lane]);
+        stats.max_val = std::max(stats.max_val, max_vals[lane]);
+        stats.num_pixels += counts[lane];
+    }
+    for (int lane = 0; lane < 4; lane++) {
+        stats.sum += sums[lane];
+        stats.sum_squares += sums_squares[lane];
+    }
+    AccumulateStatsScalar(data + blocked_size, size - blocked_size, stats);
+}
+
+SIMD_TARGET_AVX512 static void AccumulateStatsAVX512(const float* data, int64_t size, PartialStats& stats) {
+    const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+    __m512 min_vec = _mm512_set1_ps(stats.min_val);
+    __m512 max_vec = _mm512_set1_ps(stats.max_val);
+    __m512d sum = _mm512_setzero_pd();
+    __m512d sum_squares = _mm512_setzero_pd();
+    size_t num_pixels = 0;
+
+    for (int64_t i = 0; i < size; i += 16) {
+        // Masked load for the remainder
+        __mmask16 load_mask = size - i >= 16 ? 0xFFFF : (1 << (size - i)) - 1;
+        __m512 val = _mm512_maskz_loadu_ps(load_mask, data + i);
+        __mmask16 mask = _mm512_mask_cmp_ps_mask(load_mask, _mm512_abs_ps(val), inf, _CMP_LT_OQ);
+        min_vec = _mm512_mask_min_ps(min_vec, mask, min_vec, val);
+        max_vec = _mm512_mask_max_ps(max_vec, mask, max_vec, val);
+        num_pixels += __builtin_popcount(mask);
+        val = _mm512_maskz_mov_ps(mask, val);
+        __m512d low = _mm512_cvtps_pd(_mm512_castps512_ps256(val));
+        __m512d high = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(val), 1)));
+        sum = _mm512_add_pd(sum, _mm512_add_pd(low, high));
+        sum_squares = _mm512_add_pd(sum_squares, _mm512_add_pd(_mm512_mul_pd(low, low), _mm512_mul_pd(high, high)));
+    }
+
+    stats.min_val = _mm512_reduce_min_ps(min_vec);
+    stats.max_val = _mm512_reduce_max_ps(max_vec);
+    stats.num_pixels += num_pixels;
+    stats.sum += _mm512_reduce_add_pd(sum);
+    stats.sum_squares += _mm512_reduce_add_pd(sum_squares);
+}
+#endif
+
+template <>
+void BasicStatsCalculator<float>::reduce() {
+    StatsKernel accumulate_stats = AccumulateStatsSSE;
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        accumulate_stats = AccumulateStatsAVX512;
+    } else if (simd_level >= SimdLevel::AVX2) {
+        accumulate_stats = AccumulateStatsAVX2;
+    }
+#endif
+
+    const int64_t num_blocks = (_data_size + BASIC_STATS_BLOCK_SIZE - 1) / BASIC_STATS_BLOCK_SIZE;
+    ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for reduction(min: _min_val) reduction(max:_max_val) reduction(+:_num_pixels) reduction(+:_sum) reduction(+:_sum_squares)
+    for (int64_t block = 0; block < num_blocks; block++) {
+        int64_t start = block * BASIC_STATS_BLOCK_SIZE;
+        PartialStats stats;
+        accumulate_stats(_data + start, std::min((int64_t)BASIC_STATS_BLOCK_SIZE, (int64_t)_data_size - start), stats);
+        _min_val = std::min(_min_val, stats.min_val);
+        _max_val = std::max(_max_val, stats.max_val);
+        _num_pixels += stats.num_pixels;
+        _sum += stats.sum;
+        _sum_squares += stats.sum_squares;
+    }
+}
+
+} // namespace carta
@@ -77,6 +77,10 @@ public:
     BasicStats<T> GetStats() const;
 };
 
+// Vectorized, using the best instruction set available at runtime
+template <>
+void BasicStatsCalculator<float>::reduce();
+
 } // namespace carta
 
 #include "BasicStatsCalculator.tcc"
@@ -12,9 +12,115 @@
 
 #include "Logger/Logger.h"
 #include "ThreadingManager/ThreadingManager.h"
+#include "Util/Simd.h"
+
+// Number of values binned by each call of the fill kernel
+#define HISTOGRAM_FILL_BLOCK_SIZE 4096
 
 using namespace carta;
 
+using FillKernel = void (*)(const float*, int64_t, float, float, float, int64_t, int64_t*);
+
+// Values in [min_val, max_val] are counted in the bin (val - min_val) / bin_width, clamped to the last bin. The SIMD kernels calculate
+// the bin numbers with the same single-precision operations as the scalar remainder, so all kernels give the same counts. Conversions
+// which overflow (or are NaN for a zero bin width) give INT_MIN, which is clamped to the last bin by the unsigned minimum.
+static inline void FillBinsScalar(
+    const float* data, int64_t size, float min_val, float max_val, float bin_width, int64_t num_bins, int64_t* bins) {
+    for (int64_t i = 0; i < size; i++) {
+        auto val = data[i];
+        if (min_val <= val && val <= max_val) {
+            size_t bin_number = std::clamp((size_t)((val - min_val) / bin_width), (size_t)0, (size_t)num_bins - 1);
+            bins[bin_number]++;
+        }
+    }
+}
+
+static void FillBinsSSE(
+    const float* data, int64_t size, float min_val, float max_val, float bin_width, int64_t num_bins, int64_t* bins) {
+    const __m128 min_vec = _mm_set1_ps(min_val);
+    const __m128 max_vec = _mm_set1_ps(max_val);
+    const __m128 width_vec = _mm_set1_ps(bin_width);
+    const __m128i last_bin = _mm_set1_epi32(num_bins - 1);
+    alignas(16) int32_t bin_numbers[4];
+    const int64_t blocked_size = 4 * (size / 4);
+    for (int64_t i = 0; i < blocked_size; i += 4) {
+        __m128 val = _mm_loadu_ps(data + i);
+        int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(min_vec, val), _mm_cmple_ps(val, max_vec)));
+        if (mask) {
+            __m128i bin_number = _mm_cvttps_epi32(_mm_div_ps(_mm_sub_ps(val, min_vec), width_vec));
+            _mm_store_si128((__m128i*)bin_numbers, _mm_min_epu32(bin_number, last_bin));
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    bins[bin_numbers[lane]]++;
+                }
+            }
+        }
+    }
+    FillBinsScalar(data + blocked_size, size - blocked_size, min_val, max_val, bin_width, num_bins, bins);
+}
+
+#ifndef _ARM_ARCH_
+SIMD_TARGET_AVX2 static void FillBinsAVX2(
+    const float* data, int64_t size, float min_val, float max_val, float bin_width, int64_t num_bins, int64_t* bins) {
+    const __m256 min_vec = _mm256_set1_ps(min_val);
+    const __m256 max_vec = _mm256_set1_ps(max_val);
+    const __m256 width_vec = _mm256_set1_ps(bin_width);
+    const __m256i last_bin = _mm256_set1_epi32(num_bins - 1);
+    alignas(32) int32_t bin_numbers[8];
+    const int64_t blocked_size = 8 * (size / 8);
+    for (int64_t i = 0; i < blocked_size; i += 8) {
+        __m256 val = _mm256_loadu_ps(data + i);
+        int mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(min_vec, val, _CMP_LE_OQ), _mm256_cmp_ps(val, max_vec, _CMP_LE_OQ)));
+        if (mask) {
+            __m256i bin_number = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_sub_ps(val, min_vec), width_vec));
+            _mm256_store_si256((__m256i*)bin_numbers, _mm256_min_epu32(bin_number, last_bin));
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) {
+                    bins[bin_numbers[lane]]++;
+                }
+            }
+        }
+    }
+    FillBinsScalar(data + blocked_size, size - blocked_size, min_val, max_val, bin_width, num_bins, bins);
+}
+
+SIMD_TARGET_AVX512 static void FillBinsAVX512(
+    const float* data, int64_t size, float min_val, float max_val, float bin_width, int64_t num_bins, int64_t* bins) {
+    const __m512 min_vec = _mm512_set1_ps(min_val);
+    const __m512 max_vec = _mm512_set1_ps(max_val);
+    const __m512 width_vec = _mm512_set1_ps(bin_width);
+    const __m512i last_bin = _mm512_set1_epi32(num_bins - 1);
+    alignas(64) int32_t bin_numbers[16];
+    const int64_t blocked_size = 16 * (size / 16);
+    for (int64_t i = 0; i < blocked_size; i += 16) {
+        __m512 val = _mm512_loadu_ps(data + i);
+        unsigned int mask = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(min_vec, val, _CMP_LE_OQ), val, max_vec, _CMP_LE_OQ);
+        if (mask) {
+            __m512i bin_number = _mm512_cvttps_epi32(_mm512_div_ps(_mm512_sub_ps(val, min_vec), width_vec));
+            _mm512_store_si512(bin_numbers, _mm512_min_epu32(bin_number, last_bin));
+            // Visit the lanes in range only
+            while (mask) {
+                bins[bin_numbers[__builtin_ctz(mask)]]++;
+                mask &= mask - 1;
+            }
+        }
+    }
+    FillBinsScalar(data + blocked_size, size - blocked_size, min_val, max_val, bin_width, num_bins, bins);
+}
+#endif
+
+static FillKernel GetFillKernel() {
+#ifndef _ARM_ARCH_
+    auto simd_level = Simd::Level();
+    if (simd_level >= SimdLevel::AVX512) {
+        return FillBinsAVX512;
+    } else if (simd_level >= SimdLevel::AVX2) {
+        return FillBinsAVX2;
+    }
+#endif
+    return FillBinsSSE;
+}
+
 Histogram::Histogram(int num_bins, const HistogramBounds& bounds, const float* data, const size_t data_size)
     : _bin_width((bounds.max - bounds.min) / num_bins),
       _min_val(bounds.min),
@@ -49,6 +155,8 @@ void Histogram::Fill(const float* data, const size_t data_size) {
     std::vector<int64_t> temp_bins;
     const auto num_elements = data_size;
     const size_t num_bins = GetNbins();
+    const int64_t num_blocks = (num_elements + HISTOGRAM_FILL_BLOCK_SIZE - 1) / HISTOGRAM_FILL_BLOCK_SIZE;
+    auto fill_bins = GetFillKernel();
     ThreadManager::ApplyThreadLimit();
 #pragma omp parallel
     {
@@ -57,12 +165,10 @@ void Histogram::Fill(const float* data, const size_t data_size) {
 #pragma omp single
         { temp_bins.resize(num_bins * num_threads); }
 #pragma omp for
-        for (int64_t i = 0; i < num_elements; i++) {
-            auto val = data[i];
-            if (_min_val <= val && val <= _max_val) {
-                size_t bin_number = std::clamp((size_t)((val - _min_val) / _bin_width), (size_t)0, num_bins - 1);
-                temp_bins[thread_index * num_bins + bin_number]++;
-            }
+        for (int64_t block = 0; block < num_blocks; block++) {
+            int64_t start = block * HISTOGRAM_FILL_BLOCK_SIZE;
+            int64_t size = std::min((int64_t)HISTOGRAM_FILL_BLOCK_SIZE, (int64_t)num_elements - start);
+            fill_bins(data + start, size, _min_val, _max_val, _bin_width, num_bins, temp_bins.data() + thread_index * num_bins);
         }
 #pragma omp for
         for (int64_t i = 0; i < num_bins; i++) {
@@ -18,6 +18,7 @@
 #include "ThreadingManager/ThreadingManager.h"
 #include "Util/App.h"
 #include "Util/FileSystem.h"
+#include "Util/Simd.h"
 #include "Util/Token.h"
 #include "WebBrowser.h"
 
@@ -95,6 +96,7 @@ int main(int argc, char* argv[]) {
         }
 
         spdlog::info("{}: Version {}", executable_path, VERSION_ID);
+        spdlog::info("Using {} kernels for SIMD operations.", carta::Simd::Name(carta::Simd::Level()));
 
         if (!CheckFolderPaths(settings.top_level_folder, settings.starting_folder)) {
             carta::logger::FlushLogFile();
@@ -116,7 +118,7 @@ int main(int argc, char* argv[]) {
             Session::SetControllerDeploymentFlag(settings.controller_deployment);
         }
 
-        carta::ThreadManager::StartEventHandlingThreads(settings.event_thread_count);
+        carta::ThreadManager::StartEventHandlingThreads(settings.event_thread_count, settings.dispatch_thread_count);
         carta::ThreadManager::SetThreadLimit(settings.omp_thread_count);
 
         // One FileListHandler works for all sessions.
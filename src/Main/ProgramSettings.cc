@@ -184,6 +184,8 @@ void ProgramSettings::ApplyCommandLineSettings(int argc, char** argv) {
         ("host", "only listen on the specified interface (IP address or hostname)", cxxopts::value<string>(), "<interface>")
         ("p,port", fmt::format("manually set the HTTP and WebSocket port (default: {} or nearest available port)", DEFAULT_SOCKET_PORT), cxxopts::value<std::vector<int>>(), "<port>")
         ("t,omp_threads", "manually set OpenMP thread pool count", cxxopts::value<int>(), "<threads>")
+        ("event_thread_count", "set number of threads for data tasks and long-running requests", cxxopts::value<int>(), "<threads>")
+        ("dispatch_thread_count", "set number of threads for handling incoming messages", cxxopts::value<int>(), "<threads>")
         ("top_level_folder", "set top-level folder for data files", cxxopts::value<string>(), "<dir>")
         ("frontend_folder", "set folder from which frontend files are served", cxxopts::value<string>(), "<dir>")
         ("exit_timeout", "number of seconds to stay alive after last session exits", cxxopts::value<int>(), "<sec>")
@@ -320,6 +322,8 @@ global configuration files, respectively.
     applyOptionalArgument(http_url_prefix, "http_url_prefix", result);
 
     applyOptionalArgument(omp_thread_count, "omp_threads", result);
+    applyOptionalArgument(event_thread_count, "event_thread_count", result);
+    applyOptionalArgument(dispatch_thread_count, "dispatch_thread_count", result);
     applyOptionalArgument(wait_time, "exit_timeout", result);
     applyOptionalArgument(init_wait_time, "initial_timeout", result);
 
@@ -45,6 +45,7 @@ struct ProgramSettings {
     std::vector<int> port;
     int omp_thread_count = OMP_THREAD_COUNT;
     int event_thread_count = 2;
+    int dispatch_thread_count = 2;
     std::string top_level_folder = "/";
     std::string starting_folder = ".";
     std::string host = "0.0.0.0";
@@ -85,6 +86,7 @@ struct ProgramSettings {
         {"verbosity", &verbosity},
         {"omp_threads", &omp_thread_count},
         {"event_thread_count", &event_thread_count},
+        {"dispatch_thread_count", &dispatch_thread_count},
         {"exit_timeout", &wait_time},
         {"initial_timeout", &init_wait_time},
         {"idle_timeout", &idle_session_wait_time}
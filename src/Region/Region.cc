@@ -8,15 +8,18 @@
 
 #include "Region.h"
 
+#include <casacore/lattices/LRegions/LCBox.h>
 #include <casacore/lattices/LRegions/LCExtension.h>
+#include <casacore/lattices/LRegions/LCPixelSet.h>
 #include <casacore/lattices/LRegions/RegionType.h>
 
+#include "Logger/Logger.h"
 #include "RegionConverter.h"
 
 using namespace carta;
 
 Region::Region(const RegionState& state, std::shared_ptr<casacore::CoordinateSystem> csys)
-    : _coord_sys(csys), _valid(false), _region_changed(false), _lcregion_set(false), _region_state(state) {
+    : _coord_sys(csys), _valid(false), _region_changed(false), _lcregion_set(false), _region_mask_set(false), _region_state(state) {
     _valid = CheckPoints(state.control_points, state.type);
 }
 
@@ -50,6 +53,8 @@ void Region::ResetRegionCache() {
     std::lock_guard<std::mutex> guard(_lcregion_mutex);
     _lcregion.reset();
     _lcregion_set = false;
+    _region_mask.reset();
+    _region_mask_set = false;
     _region_converter.reset();
 }
 
@@ -148,19 +153,17 @@ std::shared_ptr<casacore::LCRegion> Region::GetImageRegion(int file_id, std::sha
     if (!lcregion) {
         if (IsInReferenceImage(file_id)) {
             if (!_lcregion_set) {
-                // Create LCRegion from TableRecord
-                casacore::TableRecord region_record;
-                if (GetRegionState().IsRotbox()) {
-                    // ControlPointsRecord is unrotated box for export, apply rotation for LCRegion
-                    region_record = GetRotboxRecordForLCRegion(image_shape);
+                if (IsPoint()) {
+                    // Create LCBox from TableRecord
+                    casacore::TableRecord region_record = GetControlPointsRecord(image_shape);
+                    try {
+                        lcregion.reset(casacore::LCRegion::fromRecord(region_record, ""));
+                    } catch (const casacore::AipsError& err) {
+                        // Region is outside image
+                    }
                 } else {
-                    region_record = GetControlPointsRecord(image_shape);
-                }
-
-                try {
-                    lcregion.reset(casacore::LCRegion::fromRecord(region_record, ""));
-                } catch (const casacore::AipsError& err) {
-                    // Region is outside image
+                    // Create LCRegion from rasterized mask, nullptr if outside image
+                    lcregion = GetRegionMaskLCRegion(GetRegionMask(file_id, image_shape), image_shape);
                 }
                 _lcregion_set = true;
 
@@ -228,6 +231,79 @@ casacore::ArrayLattice<casacore::Bool> Region::GetImageRegionMask(int file_id) {
     return mask;
 }
 
+std::shared_ptr<RegionMask> Region::GetRegionMask(int file_id, const casacore::IPosition& image_shape) {
+    // Return cached mask for closed region applied to reference image, as runs of pixels in each row.
+    // Matched images use LCRegion converted from the reference image.
+    if (IsAnnotation() || IsLineType() || IsPoint() || !IsInReferenceImage(file_id)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(_lcregion_mutex);
+    if (!_region_mask_set) {
+        _region_mask = CreateRegionMask(GetRegionState(), image_shape);
+        _region_mask_set = true;
+    }
+    return _region_mask;
+}
+
+std::shared_ptr<RegionMask> Region::CreateRegionMask(const RegionState& region_state, const casacore::IPosition& image_shape) {
+    // Rasterize region in pixel coordinates from control points
+    int width(image_shape(0)), height(image_shape(1));
+    if (region_state.control_points.size() < 2) {
+        return nullptr;
+    }
+
+    switch (region_state.type) {
+        case CARTA::RegionType::RECTANGLE: {
+            // Polygon with 4 corners, with rotation applied
+            casacore::Vector<casacore::Double> x, y;
+            if (region_state.GetRectangleCorners(x, y)) {
+                return RegionMask::Polygon(x.tovector(), y.tovector(), width, height);
+            }
+            break;
+        }
+        case CARTA::RegionType::POLYGON: {
+            std::vector<double> x, y;
+            for (const auto& point : region_state.control_points) {
+                x.push_back(point.x());
+                y.push_back(point.y());
+            }
+            return RegionMask::Polygon(x, y, width, height);
+        }
+        case CARTA::RegionType::ELLIPSE: {
+            // Control points are [(cx, cy), (bmaj, bmin)]; carta rotation is of major axis from y-axis, i.e. of minor axis from x-axis
+            auto& center = region_state.control_points[0];
+            auto& radii = region_state.control_points[1];
+            double theta = region_state.rotation * M_PI / 180.0;
+            return RegionMask::Ellipse(center.x(), center.y(), radii.y(), radii.x(), theta, width, height);
+        }
+        default:
+            break;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<casacore::LCRegion> Region::GetRegionMaskLCRegion(
+    std::shared_ptr<RegionMask> region_mask, const casacore::IPosition& image_shape) {
+    // Return 2D pixel set for the mask bounding box
+    std::shared_ptr<casacore::LCRegion> lcregion;
+    if (!region_mask) {
+        return lcregion;
+    }
+
+    try {
+        casacore::IPosition blc(2, region_mask->BlcX(), region_mask->BlcY());
+        casacore::IPosition trc(2, region_mask->BlcX() + region_mask->Width() - 1, region_mask->BlcY() + region_mask->Height() - 1);
+        casacore::LCBox box(blc, trc, casacore::IPosition(2, image_shape(0), image_shape(1)));
+        casacore::Array<casacore::Bool> mask(box.shape());
+        region_mask->FillMask(mask.data());
+        lcregion.reset(new casacore::LCPixelSet(mask, box));
+    } catch (const casacore::AipsError& err) {
+        spdlog::error("Error creating region from mask: {}", err.getMesg());
+    }
+    return lcregion;
+}
+
 casacore::TableRecord Region::GetImageRegionRecord(
     int file_id, std::shared_ptr<casacore::CoordinateSystem> csys, const casacore::IPosition& image_shape) {
     // Return Record describing any region type applied to image, in pixel coordinates.
@@ -255,7 +331,7 @@ casacore::TableRecord Region::GetImageRegionRecord(
 casacore::TableRecord Region::GetControlPointsRecord(const casacore::IPosition& image_shape) {
     // Return region Record in pixel coords in format of LCRegion::toRecord() from control points.
     // Rotated box is returned as unrotated LCBox, rotation retrieved from RegionState.
-    // For rotated box for analytics, use GetRotboxRecordForLCRegion() as polygon.
+    // For rotated box for analytics, use GetRegionMask().
     casacore::TableRecord record;
 
     auto region_state = GetRegionState();
@@ -375,25 +451,6 @@ casacore::TableRecord Region::GetControlPointsRecord(const casacore::IPosition&
     return record;
 }
 
-casacore::TableRecord Region::GetRotboxRecordForLCRegion(const casacore::IPosition& image_shape) {
-    // Convert rotated box corners to polygon and create LCPolygon-type record
-    casacore::TableRecord record;
-    casacore::Vector<casacore::Double> x, y;
-    if (GetRegionState().GetRectangleCorners(x, y)) {
-        // LCPolygon::toRecord includes last point as first point to close region
-        x.resize(5, true);
-        y.resize(5, true);
-        x(4) = x(0);
-        y(4) = y(0);
-
-        record.define("name", "LCPolygon");
-        record.define("x", x);
-        record.define("y", y);
-    }
-    CompleteRegionRecord(record, image_shape);
-    return record;
-}
-
 void Region::CompleteRegionRecord(casacore::TableRecord& record, const casacore::IPosition& image_shape) {
     // Add common Record fields for record defining region
     if (!record.empty()) {
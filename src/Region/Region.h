@@ -20,6 +20,7 @@
 #include <casacore/tables/Tables/TableRecord.h>
 
 #include "RegionConverter.h"
+#include "RegionMask.h"
 #include "RegionState.h"
 #include "Util/Stokes.h"
 
@@ -77,6 +78,10 @@ public:
     std::shared_ptr<casacore::LCRegion> GetImageRegion(int file_id, std::shared_ptr<casacore::CoordinateSystem> csys,
         const casacore::IPosition& shape, const StokesSource& stokes_source = StokesSource(), bool report_error = true);
     casacore::ArrayLattice<casacore::Bool> GetImageRegionMask(int file_id);
+    // Rasterized mask for closed region applied to reference image; nullptr for matched image, point, or outside image.
+    std::shared_ptr<RegionMask> GetRegionMask(int file_id, const casacore::IPosition& shape);
+    // Rasterized mask for rectangle, ellipse, or polygon RegionState in pixel coordinates of image with shape
+    static std::shared_ptr<RegionMask> CreateRegionMask(const RegionState& region_state, const casacore::IPosition& shape);
 
     // Record for region applied to image, for export.  Not for converting to LCRegion for analytics.
     casacore::TableRecord GetImageRegionRecord(
@@ -91,9 +96,11 @@ private:
     void ResetRegionCache();
     std::shared_ptr<casacore::LCRegion> GetCachedLCRegion(int file_id, const StokesSource& stokes_source);
 
+    // LCRegion defined by native mask for closed region in reference image
+    std::shared_ptr<casacore::LCRegion> GetRegionMaskLCRegion(std::shared_ptr<RegionMask> region_mask, const casacore::IPosition& shape);
+
     // Record in pixel coordinates from control points, for reference image
     casacore::TableRecord GetControlPointsRecord(const casacore::IPosition& shape);
-    casacore::TableRecord GetRotboxRecordForLCRegion(const casacore::IPosition& shape);
     void CompleteRegionRecord(casacore::TableRecord& record, const casacore::IPosition& image_shape);
 
     // Coordinate system of reference image
@@ -111,6 +118,8 @@ private:
     std::shared_ptr<casacore::LCRegion> _lcregion;
     std::mutex _lcregion_mutex;
     bool _lcregion_set; // may be nullptr if outside image
+    std::shared_ptr<RegionMask> _region_mask;
+    bool _region_mask_set; // may be nullptr if outside image
 
     // Converter to handle region applied to matched image
     std::unique_ptr<RegionConverter> _region_converter;
@@ -432,13 +432,26 @@ std::shared_ptr<casacore::LCRegion> RegionConverter::GetAppliedPolygonRegion(
             RemoveHorizontalPolygonPoints(x, y);
         }
     } else {
-        // Rectangle and polygon have one vector for each segment of original rectangle/polygon
+        // Rectangle and polygon have one vector for each segment of original rectangle/polygon.
+        // Convert the points of all segments in one call, then fix each segment.
+        std::vector<CARTA::Point> all_points;
         for (auto& segment : polygon_points) {
-            casacore::Vector<casacore::Double> segment_x, segment_y;
-            if (!PointsToImagePixels(segment, output_csys, segment_x, segment_y)) {
-                spdlog::error("Error approximating region as polygon in matched image.");
-                return lc_region;
+            all_points.insert(all_points.end(), segment.begin(), segment.end());
+        }
+        casacore::Vector<casacore::Double> all_x, all_y;
+        if (!PointsToImagePixels(all_points, output_csys, all_x, all_y)) {
+            spdlog::error("Error approximating region as polygon in matched image.");
+            return lc_region;
+        }
+
+        size_t segment_start(0);
+        for (auto& segment : polygon_points) {
+            casacore::Vector<casacore::Double> segment_x(segment.size()), segment_y(segment.size());
+            for (size_t i = 0; i < segment.size(); ++i) {
+                segment_x[i] = all_x[segment_start + i];
+                segment_y[i] = all_y[segment_start + i];
             }
+            segment_start += segment.size();
 
             // If short segment with only starting point, do not fix.
             if (has_distortion && segment_x.size() > 1) {
@@ -788,21 +801,21 @@ casacore::TableRecord RegionConverter::GetPolygonRecord(std::shared_ptr<casacore
         size_t npoints(_wcs_control_points.size() / 2);
         casacore::Vector<casacore::Float> x(npoints), y(npoints); // Record fields
 
-        // Convert each wcs control point to pixel coords in output csys
-        for (size_t i = 0; i < _wcs_control_points.size(); i += 2) {
-            std::vector<casacore::Quantity> world_point(2);
-            world_point[0] = _wcs_control_points[i];
-            world_point[1] = _wcs_control_points[i + 1];
-            casacore::Vector<casacore::Double> pixel_point;
-            if (WorldPointToImagePixels(world_point, output_csys, pixel_point)) {
-                // Add to x and y Vectors
-                int index(i / 2);
-                x(index) = pixel_point(0);
-                y(index) = pixel_point(1);
-            } else {
-                spdlog::error("Error converting region type {} to image pixels.", type);
-                return record;
-            }
+        // Convert wcs control points to pixel coords in output csys
+        casacore::Vector<casacore::String> reference_units = _reference_coord_sys->worldAxisUnits();
+        casacore::Vector<casacore::Double> x_world(npoints), y_world(npoints);
+        for (size_t i = 0; i < npoints; ++i) {
+            x_world(i) = _wcs_control_points[i * 2].getValue(reference_units(0));
+            y_world(i) = _wcs_control_points[(i * 2) + 1].getValue(reference_units(1));
+        }
+        casacore::Vector<casacore::Double> x_pixel, y_pixel;
+        if (!WorldPointsToImagePixels(x_world, y_world, output_csys, x_pixel, y_pixel)) {
+            spdlog::error("Error converting region type {} to image pixels.", type);
+            return record;
+        }
+        for (size_t i = 0; i < npoints; ++i) {
+            x(i) = x_pixel(i);
+            y(i) = y_pixel(i);
         }
 
         if (type == CARTA::RegionType::POLYGON) {
@@ -849,24 +862,15 @@ casacore::TableRecord RegionConverter::GetRotboxRecord(std::shared_ptr<casacore:
             }
 
             // Convert reference world coord points to output pixel points
-            casacore::Vector<casacore::Double> ref_x_world = world_coords.row(0);
-            casacore::Vector<casacore::Double> ref_y_world = world_coords.row(1);
-            casacore::Vector<casacore::String> ref_world_units = _reference_coord_sys->worldAxisUnits();
+            casacore::Vector<casacore::Double> out_x, out_y;
+            if (!WorldPointsToImagePixels(world_coords.row(0), world_coords.row(1), output_csys, out_x, out_y)) {
+                spdlog::error("Error converting rectangle coordinates to image.");
+                return record;
+            }
             casacore::Vector<casacore::Float> out_x_pix(num_points), out_y_pix(num_points);
             for (size_t i = 0; i < num_points; i++) {
-                // Reference world point as Quantity
-                std::vector<casacore::Quantity> ref_world_point;
-                ref_world_point.push_back(casacore::Quantity(ref_x_world(i), ref_world_units(0)));
-                ref_world_point.push_back(casacore::Quantity(ref_y_world(i), ref_world_units(1)));
-                // Convert to output pixel point
-                casacore::Vector<casacore::Double> out_pixel_point;
-                if (WorldPointToImagePixels(ref_world_point, output_csys, out_pixel_point)) {
-                    out_x_pix(i) = out_pixel_point(0);
-                    out_y_pix(i) = out_pixel_point(1);
-                } else {
-                    spdlog::error("Error converting rectangle coordinates to image.");
-                    return record;
-                }
+                out_x_pix(i) = out_x(i);
+                out_y_pix(i) = out_y(i);
             }
 
             // Add fields for this region type
@@ -931,33 +935,29 @@ casacore::TableRecord RegionConverter::GetEllipseRecord(std::shared_ptr<casacore
 bool RegionConverter::PointsToImagePixels(const std::vector<CARTA::Point>& points, std::shared_ptr<casacore::CoordinateSystem> output_csys,
     casacore::Vector<casacore::Double>& x, casacore::Vector<casacore::Double>& y) {
     // Convert pixel coords in reference image (points) to pixel coords in output image coordinate system (x and y).
-    // ref pixels -> ref world -> output world -> output pixels
+    // ref pixels -> ref world -> output world -> output pixels, for all points in one call rather than one point at a time
     bool converted(true);
     try {
-        // Convert each pixel point to output csys pixel
         size_t npoints(points.size());
-        x.resize(npoints);
-        y.resize(npoints);
+        size_t num_axes(_reference_coord_sys->nPixelAxes());
+        casacore::Matrix<casacore::Double> pixel_coords(num_axes, npoints, 0.0);
+        casacore::Matrix<casacore::Double> world_coords(num_axes, npoints);
+        for (size_t i = 0; i < npoints; ++i) {
+            pixel_coords(0, i) = points[i].x();
+            pixel_coords(1, i) = points[i].y();
+        }
 
-        for (auto i = 0; i < npoints; ++i) {
-            // Convert pixel to world (reference image) [x, y]
-            std::vector<casacore::Quantity> world_point;
-            if (CartaPointToWorld(points[i], world_point)) {
-                // Convert world to pixel (output image) [x, y]
-                casacore::Vector<casacore::Double> pixel_point;
-                if (WorldPointToImagePixels(world_point, output_csys, pixel_point)) {
-                    x(i) = pixel_point(0);
-                    y(i) = pixel_point(1);
-                } else { // world to pixel failed
-                    spdlog::error("Error converting region to output image pixel coords.");
-                    converted = false;
-                    break;
-                }
-            } else { // pixel to world failed
-                spdlog::error("Error converting region to reference image world coords.");
-                converted = false;
-                break;
-            }
+        // Convert pixel to world (reference image) [x, y]
+        casacore::Vector<casacore::Bool> failures;
+        if (!_reference_coord_sys->toWorldMany(world_coords, pixel_coords, failures)) {
+            spdlog::error("Error converting region to reference image world coords.");
+            return false;
+        }
+
+        // Convert world to pixel (output image) [x, y]
+        if (!WorldPointsToImagePixels(world_coords.row(0), world_coords.row(1), output_csys, x, y)) {
+            spdlog::error("Error converting region to output image pixel coords.");
+            converted = false;
         }
     } catch (const casacore::AipsError& err) {
         spdlog::error("Error converting region to output image: {}", err.getMesg());
@@ -970,44 +970,103 @@ bool RegionConverter::PointsToImagePixels(const std::vector<CARTA::Point>& point
 bool RegionConverter::WorldPointToImagePixels(std::vector<casacore::Quantity>& world_point,
     std::shared_ptr<casacore::CoordinateSystem> output_csys, casacore::Vector<casacore::Double>& pixel_point) {
     // Convert reference world-coord point to output pixel-coord point: ref world -> output world -> output pixels.
-    // Both images must have direction coordinates or linear coordinates.
     // Returns pixel points with success or throws exception (catch in calling function).
-    bool success(false);
+    casacore::Vector<casacore::String> reference_units = _reference_coord_sys->worldAxisUnits();
+    casacore::Vector<casacore::Double> x_world(1, world_point[0].getValue(reference_units(0)));
+    casacore::Vector<casacore::Double> y_world(1, world_point[1].getValue(reference_units(1)));
+    casacore::Vector<casacore::Double> x, y;
+    if (!WorldPointsToImagePixels(x_world, y_world, output_csys, x, y)) {
+        return false;
+    }
+
+    pixel_point.resize(2);
+    pixel_point(0) = x(0);
+    pixel_point(1) = y(0);
+    return true;
+}
+
+bool RegionConverter::WorldPointsToImagePixels(const casacore::Vector<casacore::Double>& x_world,
+    const casacore::Vector<casacore::Double>& y_world, std::shared_ptr<casacore::CoordinateSystem> output_csys,
+    casacore::Vector<casacore::Double>& x, casacore::Vector<casacore::Double>& y) {
+    // Convert reference world-coord points (in reference world axis units) to output pixel-coord points:
+    // ref world -> output world -> output pixels. Both images must have direction coordinates or linear coordinates.
+    // Returns pixel points with success or throws exception (catch in calling function).
+    size_t npoints(x_world.size());
+    casacore::Vector<casacore::String> reference_units = _reference_coord_sys->worldAxisUnits();
+    casacore::Vector<casacore::Bool> failures;
+
     if (_reference_coord_sys->hasDirectionCoordinate() && output_csys->hasDirectionCoordinate()) {
         // Input and output direction reference frames
+        const casacore::DirectionCoordinate& output_dir_coord = output_csys->directionCoordinate();
         casacore::MDirection::Types reference_dir_type = _reference_coord_sys->directionCoordinate().directionType();
-        casacore::MDirection::Types output_dir_type = output_csys->directionCoordinate().directionType();
-
-        // Convert world point from reference to output coord sys
-        casacore::MDirection world_direction(world_point[0], world_point[1], reference_dir_type);
+        casacore::MDirection::Types output_dir_type = output_dir_coord.directionType();
+
+        // Unit conversion factors for reference world units -> rad -> output world units
+        double x_to_rad = casacore::Quantity(1.0, reference_units(0)).getValue("rad");
+        double y_to_rad = casacore::Quantity(1.0, reference_units(1)).getValue("rad");
+        casacore::Vector<casacore::String> output_units = output_dir_coord.worldAxisUnits();
+        double rad_to_x = casacore::Quantity(1.0, "rad").getValue(output_units(0));
+        double rad_to_y = casacore::Quantity(1.0, "rad").getValue(output_units(1));
+
+        // Convert world points from reference to output direction frame
+        casacore::Matrix<casacore::Double> world_coords(2, npoints);
+        std::unique_lock<std::mutex> convert_lock(_direction_convert_mutex, std::defer_lock);
+        casacore::MDirection::Convert* converter(nullptr);
         if (reference_dir_type != output_dir_type) {
-            world_direction = casacore::MDirection::Convert(world_direction, output_dir_type)();
+            convert_lock.lock();
+            auto& cached_converter = _direction_converters[output_dir_type];
+            if (!cached_converter) {
+                cached_converter = std::make_unique<casacore::MDirection::Convert>(
+                    casacore::MDirection::Ref(reference_dir_type), casacore::MDirection::Ref(output_dir_type));
+            }
+            converter = cached_converter.get();
         }
 
-        // Convert output world point to pixel point
-        output_csys->directionCoordinate().toPixel(pixel_point, world_direction);
-        success = true;
+        for (size_t i = 0; i < npoints; ++i) {
+            casacore::MVDirection direction(x_world(i) * x_to_rad, y_world(i) * y_to_rad);
+            if (converter) {
+                direction = (*converter)(direction).getValue();
+            }
+            world_coords(0, i) = direction.getLong() * rad_to_x;
+            world_coords(1, i) = direction.getLat() * rad_to_y;
+        }
+        if (convert_lock.owns_lock()) {
+            convert_lock.unlock();
+        }
+
+        // Convert output world points to pixel points; as for single points, failed points are not rejected
+        casacore::Matrix<casacore::Double> pixel_coords(2, npoints);
+        output_dir_coord.toPixelMany(pixel_coords, world_coords, failures);
+        x.resize(npoints);
+        y.resize(npoints);
+        x = pixel_coords.row(0);
+        y = pixel_coords.row(1);
+        return true;
     } else if (_reference_coord_sys->hasLinearCoordinate() && output_csys->hasLinearCoordinate()) {
         // Get linear axes indices
         auto indices = output_csys->linearAxesNumbers();
         if (indices.size() != 2) {
             return false;
         }
+
         // Input and output linear frames
         casacore::Vector<casacore::String> output_units = output_csys->worldAxisUnits();
-        casacore::Vector<casacore::Double> world_point_value(output_csys->nWorldAxes(), 0);
-        world_point_value(indices(0)) = world_point[0].get(output_units(indices(0))).getValue();
-        world_point_value(indices(1)) = world_point[1].get(output_units(indices(1))).getValue();
-
-        // Convert world point to output pixel point
-        casacore::Vector<casacore::Double> tmp_pixel_point;
-        output_csys->toPixel(tmp_pixel_point, world_point_value);
+        double x_scale = casacore::Quantity(1.0, reference_units(0)).getValue(output_units(indices(0)));
+        double y_scale = casacore::Quantity(1.0, reference_units(1)).getValue(output_units(indices(1)));
+        casacore::Matrix<casacore::Double> world_coords(output_csys->nWorldAxes(), npoints, 0.0);
+        for (size_t i = 0; i < npoints; ++i) {
+            world_coords(indices(0), i) = x_world(i) * x_scale;
+            world_coords(indices(1), i) = y_world(i) * y_scale;
+        }
 
-        // Only fill the pixel coordinate results
-        pixel_point.resize(2);
-        pixel_point(0) = tmp_pixel_point(indices(0));
-        pixel_point(1) = tmp_pixel_point(indices(1));
-        success = true;
+        // Convert world points to output pixel points, and only fill the pixel coordinate results
+        casacore::Matrix<casacore::Double> pixel_coords(output_csys->nPixelAxes(), npoints);
+        output_csys->toPixelMany(pixel_coords, world_coords, failures);
+        x.resize(npoints);
+        y.resize(npoints);
+        x = pixel_coords.row(indices(0));
+        y = pixel_coords.row(indices(1));
+        return true;
     }
-    return success;
+    return false;
 }
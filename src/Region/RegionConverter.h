@@ -10,6 +10,8 @@
 #define CARTA_SRC_REGION_REGIONCONVERTER_H_
 
 #include <atomic>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,6 +20,7 @@
 #include <casacore/lattices/LRegions/LCPolygon.h>
 #include <casacore/lattices/LRegions/LCRegion.h>
 #include <casacore/lattices/Lattices/ArrayLattice.h>
+#include <casacore/measures/Measures/MDirection.h>
 #include <casacore/tables/Tables/TableRecord.h>
 
 #include "RegionState.h"
@@ -78,6 +81,10 @@ private:
     // World point as (x,y) quantities to output pixel point as (x,y) vector
     bool WorldPointToImagePixels(std::vector<casacore::Quantity>& world_point, std::shared_ptr<casacore::CoordinateSystem> output_csys,
         casacore::Vector<casacore::Double>& pixel_point);
+    // World points in reference world axis units to output pixel points, converted in one call
+    bool WorldPointsToImagePixels(const casacore::Vector<casacore::Double>& x_world, const casacore::Vector<casacore::Double>& y_world,
+        std::shared_ptr<casacore::CoordinateSystem> output_csys, casacore::Vector<casacore::Double>& x,
+        casacore::Vector<casacore::Double>& y);
 
     // Reference image region parameters
     RegionState _region_state;
@@ -96,6 +103,10 @@ private:
     std::mutex _region_mutex;
     std::unordered_map<int, std::shared_ptr<casacore::LCRegion>> _converted_regions;
     std::unordered_map<int, std::shared_ptr<casacore::LCRegion>> _polygon_regions;
+
+    // Conversion from the reference direction frame to output direction frames, reused for every point and region update
+    std::mutex _direction_convert_mutex;
+    std::map<casacore::MDirection::Types, std::unique_ptr<casacore::MDirection::Convert>> _direction_converters;
 };
 
 } // namespace carta
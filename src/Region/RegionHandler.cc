@@ -21,11 +21,14 @@
 #include "ImageStats/StatsCalculator.h"
 #include "LineBoxRegions.h"
 #include "Logger/Logger.h"
+#include "ThreadingManager/ThreadingManager.h"
 #include "Timer/Timer.h"
 #include "Util/File.h"
 #include "Util/Image.h"
 
 #define LINE_PROFILE_PROGRESS_INTERVAL 500
+#define LINE_PROFILE_MAX_SLAB_SIZE 16777216 // maximum number of pixels read at once for box region profiles
+#define LINE_PROFILE_MAX_SLAB_OVERHEAD 2    // maximum ratio of slab area to box areas when grouping box regions
 
 namespace carta {
 
@@ -900,6 +903,9 @@ bool RegionHandler::ApplyRegionToFile(int region_id, int file_id, const AxisRang
 
         casacore::IPosition image_shape(_frames.at(file_id)->ImageShape(stokes_source));
 
+        // Rasterized xy mask to apply to region data directly, if region is in this image
+        stokes_region.region_mask = _regions.at(region_id)->GetRegionMask(file_id, image_shape);
+
         // Create LCBox with z range and stokes using a slicer
         casacore::Slicer z_stokes_slicer = _frames.at(file_id)->GetImageSlicer(z_range, stokes).slicer;
 
@@ -1238,31 +1244,21 @@ bool RegionHandler::CalculatePvPreviewImage(int frame_id, int preview_id, bool q
     casacore::Matrix<float> preview_data_matrix(data_shape, preview_data.data(), casacore::StorageInitPolicy::SHARE);
     preview_data_matrix = FLOAT_NAN;
 
-    // Do not collide with line spatial profile (coord sys copy crash)
-    std::unique_lock<std::mutex> profile_lock(_line_profile_mutex);
+    // Boxes are in the preview image, so rasterize them directly instead of setting temporary regions.
+    auto preview_shape = preview_frame->ImageShape();
     for (size_t iregion = 0; iregion < num_regions; ++iregion) {
-        // Set box region with next temp region id
-        int box_region_id(TEMP_REGION_ID);
-        SetRegion(box_region_id, box_regions[iregion], preview_frame_csys);
-
-        if (!RegionSet(box_region_id)) {
+        if (!box_regions[iregion].RegionDefined()) {
             continue;
         }
 
-        // Get box region LCRegion and mask
+        // Get box region pixels in preview image
         bool cancel(false);
-        auto box_lc_region = ApplyRegionToFile(box_region_id, frame_id);
-
-        if (!box_lc_region) {
-            RemoveRegion(box_region_id);
+        auto box_mask = Region::CreateRegionMask(box_regions[iregion], preview_shape);
+        if (!box_mask) {
             continue;
         }
 
-        auto bounding_box = box_lc_region->boundingBox();
-        auto box_mask = _regions.at(box_region_id)->GetImageRegionMask(frame_id);
-        RemoveRegion(box_region_id);
-
-        // Use PvPreviewCube to calculate profile with lcregion and mask
+        // Use PvPreviewCube to calculate profile with region pixels, or reuse profile if box pixels unchanged
         std::vector<float> profile;
         double max_num_pixels(0.0);
         std::string message;
@@ -1271,7 +1267,7 @@ bool RegionHandler::CalculatePvPreviewImage(int frame_id, int preview_id, bool q
         std::unique_lock pv_cube_lock(_pv_cube_mutex);
         if (preview_cube && preview_cube->HasSameParameters(cube_parameters)) {
             // Progress for loading data here if needed due to prior cancel
-            if (preview_cube->GetRegionProfile(bounding_box, box_mask, progress_callback, profile, max_num_pixels, message)) {
+            if (preview_cube->GetRegionProfile(*box_mask, progress_callback, profile, max_num_pixels, message)) {
                 // spdlog::debug("PV preview profile {} of {} max num pixels={}", iregion, num_regions, max_num_pixels);
                 casacore::Vector<float> const profile_v(profile);
                 if (reverse) {
@@ -1291,7 +1287,6 @@ bool RegionHandler::CalculatePvPreviewImage(int frame_id, int preview_id, bool q
         }
     }
 
-    profile_lock.unlock();
     RemoveRegion(preview_cut_id);
 
     // Use PvGenerator to set PV image for headers only
@@ -1760,7 +1755,7 @@ bool RegionHandler::GetRegionHistogramData(
 // ***** Fill spectral profile *****
 
 bool RegionHandler::FillSpectralProfileData(
-    std::function<void(CARTA::SpectralProfileData profile_data)> cb, int region_id, int file_id, bool stokes_changed) {
+    std::function<void(CARTA::SpectralProfileData& profile_data)> cb, int region_id, int file_id, bool stokes_changed) {
     // Fill spectral profiles for given region and file ids.  This could be:
     // 1. a specific region and a specific file
     // 2. a specific region and ALL_FILES
@@ -2120,7 +2115,7 @@ bool RegionHandler::GetRegionSpectralData(int region_id, int file_id, const Axis
 
 // ***** Fill stats data *****
 
-bool RegionHandler::FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_data)> cb, int region_id, int file_id) {
+bool RegionHandler::FillRegionStatsData(std::function<void(CARTA::RegionStatsData& stats_data)> cb, int region_id, int file_id) {
     // Fill stats data for given region and file
     if (!RegionFileIdsValid(region_id, file_id, true)) {
         return false;
@@ -2285,7 +2280,7 @@ bool RegionHandler::FillPointSpatialProfileData(int file_id, int region_id, std:
     return _frames.at(file_id)->FillSpatialProfileData(point, _spatial_req.at(config_id), spatial_data_vec);
 }
 
-bool RegionHandler::FillLineSpatialProfileData(int file_id, int region_id, std::function<void(CARTA::SpatialProfileData profile_data)> cb) {
+bool RegionHandler::FillLineSpatialProfileData(int file_id, int region_id, std::function<void(CARTA::SpatialProfileData& profile_data)> cb) {
     // Line spatial profiles.  Use callback to return each profile individually.
     Timer t;
     if (!RegionFileIdsValid(region_id, file_id, true)) {
@@ -2474,77 +2469,259 @@ bool RegionHandler::GetLineProfiles(int file_id, int region_id, int width, const
 
     if (line_box_regions.GetLineBoxRegions(line_region_state, line_coord_sys, width, increment, box_regions, message)) {
         auto t_start = std::chrono::high_resolution_clock::now();
-        auto num_profiles = box_regions.size();
-        size_t iprofile;
-        // Use completed profiles (not iprofile) for progress.
-        // iprofile not in order so progress is uneven.
-        size_t completed_profiles(0);
-
-        // Return this to column 0 when uncomment (moved for format check):
-        // #pragma omp parallel for private(iprofile) shared(progress, t_start, completed_profiles)
-        for (iprofile = 0; iprofile < num_profiles; ++iprofile) {
-            if (cancelled) {
-                continue;
+
+        auto check_cancel = [&]() {
+            // Frame/region closing or line changed, PV generator cancelled, or line spatial profile requirements removed
+            cancelled = CancelLineProfiles(region_id, file_id, line_region_state) || (per_z && _stop_pv[file_id]) ||
+                        (!per_z && !HasSpatialRequirements(region_id, file_id, coordinate, width));
+            return cancelled;
+        };
+        auto box_progress_callback = [&](float box_progress) {
+            progress = box_progress;
+            if (per_z) {
+                // Update progress if time interval elapsed
+                auto t_end = std::chrono::high_resolution_clock::now();
+                auto dt = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+                if ((dt > LINE_PROFILE_PROGRESS_INTERVAL) || (progress >= 1.0)) {
+                    t_start = t_end;
+                    progress_callback(progress);
+                }
             }
+        };
+
+        // Pixels in each box for this image, converted serially since coordinate conversions are not thread-safe
+        std::vector<std::shared_ptr<RegionMask>> box_masks;
+        if (!GetBoxRegionMasks(file_id, box_regions, line_region_state.reference_file_id, line_coord_sys, check_cancel, box_masks)) {
+            profiles.resize();
+            return false;
+        }
 
-            // Frame/region closing, or line changed
-            if (CancelLineProfiles(region_id, file_id, line_region_state)) {
-                cancelled = true;
+        bool profiles_ok(false);
+        if (per_z && IsComputedStokes(stokes_index)) {
+            // Combine mean profiles of the stokes components, as for region spectral profiles
+            int num_components(2);
+            if (stokes_index == COMPUTE_STOKES_PFTOTAL) {
+                num_components = 4;
+            } else if (stokes_index == COMPUTE_STOKES_PTOTAL || stokes_index == COMPUTE_STOKES_PFLINEAR) {
+                num_components = 3;
             }
 
-            // PV generator: check if user canceled
-            if (per_z && _stop_pv[file_id]) {
-                spdlog::debug("Stopping line profiles: PV generator cancelled");
-                cancelled = true;
+            int component(0);
+            casacore::IPosition profiles_shape;
+            auto get_mean_profiles = [&](ProfilesMap& component_profiles, std::string coordinate) {
+                auto component_progress_callback = [&](float component_progress) {
+                    box_progress_callback(std::min((component + component_progress) / num_components, 1.0f));
+                };
+                int component_stokes;
+                casacore::Matrix<float> component_profiles_matrix;
+                bool component_ok = _frames.at(file_id)->GetStokesTypeIndex(coordinate, component_stokes) &&
+                                    GetBoxRegionProfiles(file_id, box_masks, z_range, component_stokes, reverse, check_cancel,
+                                        component_progress_callback, component_profiles_matrix);
+                if (component_ok) {
+                    profiles_shape = component_profiles_matrix.shape();
+                    component_profiles[CARTA::StatsType::Mean] =
+                        std::vector<double>(component_profiles_matrix.begin(), component_profiles_matrix.end());
+                }
+                ++component;
+                return component_ok;
+            };
+
+            ProfilesMap mean_profiles;
+            profiles_ok = GetComputedStokesProfiles(mean_profiles, stokes_index, get_mean_profiles);
+            if (profiles_ok) {
+                auto& mean_profile = mean_profiles[CARTA::StatsType::Mean];
+                profiles.resize(profiles_shape);
+                std::copy(mean_profile.begin(), mean_profile.end(), profiles.begin());
             }
+        } else {
+            profiles_ok = GetBoxRegionProfiles(
+                file_id, box_masks, z_range, stokes_index, reverse, check_cancel, box_progress_callback, profiles);
+        }
 
-            // Line spatial profile: check if requirements removed
-            if (!per_z && !HasSpatialRequirements(region_id, file_id, coordinate, width)) {
-                cancelled = true;
+        if (!profiles_ok) {
+            if (!cancelled) {
+                message = "Failed to get image data for line profiles.";
             }
+            profiles.resize();
+            return false;
+        }
+        return (progress >= 1.0) && !allEQ(profiles, NAN);
+    }
+
+    return false;
+}
+
+bool RegionHandler::GetBoxRegionMasks(int file_id, const std::vector<RegionState>& box_regions, int reference_file_id,
+    std::shared_ptr<casacore::CoordinateSystem> reference_csys, const std::function<bool()>& check_cancel,
+    std::vector<std::shared_ptr<RegionMask>>& box_masks) {
+    // Get pixels in each box region in the image of file_id, nullptr if outside image. Returns false if cancelled.
+    auto frame = _frames.at(file_id);
+    auto image_shape = frame->ImageShape();
+    size_t num_boxes(box_regions.size());
+    box_masks.assign(num_boxes, nullptr);
+
+    for (size_t i = 0; i < num_boxes; ++i) {
+        if (!box_regions[i].RegionDefined()) {
+            continue;
+        }
+
+        if (file_id == reference_file_id) {
+            box_masks[i] = Region::CreateRegionMask(box_regions[i], image_shape);
+            continue;
+        }
 
-            if (cancelled) {
-                profiles.resize();
+        // Convert box to matched image with a temporary region which is not added to the region map
+        if (check_cancel()) {
+            return false;
+        }
+
+        // Do not collide with PV preview (coord sys copy crash)
+        std::lock_guard<std::mutex> profile_guard(_line_profile_mutex);
+        auto box_region = std::make_shared<Region>(box_regions[i], reference_csys);
+        if (!box_region->IsValid()) {
+            continue;
+        }
+
+        bool report_error(false);
+        auto lc_region = frame->GetImageRegion(file_id, box_region, StokesSource(), report_error);
+        if (!lc_region) {
+            continue;
+        }
+
+        try {
+            auto bounding_box = lc_region->boundingBox();
+            auto start = bounding_box.start();
+            auto length = bounding_box.length();
+            casacore::Array<casacore::Bool> mask = lc_region->get();
+            casacore::Bool delete_mask(false);
+            const casacore::Bool* mask_data = mask.getStorage(delete_mask);
+            box_masks[i] = RegionMask::FromMask(mask_data, start(0), start(1), length(0), length(1));
+            mask.freeStorage(mask_data, delete_mask);
+        } catch (const casacore::AipsError& err) {
+            spdlog::debug("Line box region {} not applied to file {}: {}", i, file_id, err.getMesg());
+        }
+    }
+
+    return true;
+}
+
+bool RegionHandler::GetBoxRegionProfiles(int file_id, const std::vector<std::shared_ptr<RegionMask>>& box_masks,
+    const AxisRange& z_range, int stokes_index, bool reverse, const std::function<bool()>& check_cancel,
+    const std::function<void(float)>& progress_callback, casacore::Matrix<float>& profiles) {
+    // Get mean of each box region in the image of file_id for z-range, reading the image data once for each group of neighboring
+    // boxes and block of channels. Returns false if cancelled or the data could not be read.
+    auto frame = _frames.at(file_id);
+    auto image_shape = frame->ImageShape();
+    size_t num_profiles(box_masks.size());
+    size_t num_z(z_range.to - z_range.from + 1);
+
+    if (reverse) {
+        profiles.resize(casacore::IPosition(2, num_z, num_profiles));
+    } else {
+        profiles.resize(casacore::IPosition(2, num_profiles, num_z));
+    }
+    profiles = NAN;
+
+    size_t total_work(num_profiles * num_z), completed_work(0);
+    size_t first_box(0);
+    while (first_box < num_profiles) {
+        // Group consecutive boxes while the bounding box of the group is not much larger than the boxes
+        int x_min(image_shape(0)), x_max(-1), y_min(image_shape(1)), y_max(-1);
+        size_t boxes_area(0), end_box(first_box);
+        for (; end_box < num_profiles; ++end_box) {
+            auto& mask = box_masks[end_box];
+            if (!mask) {
                 continue;
             }
 
-            // Get mean profile for requested file_id and log number of pixels in region
-            double num_pixels(0.0);
-            casacore::Vector<float> region_profile = GetTemporaryRegionProfile(
-                iprofile, file_id, box_regions[iprofile], line_coord_sys, per_z, z_range, stokes_index, num_pixels);
-            // spdlog::debug(
-            //     "File {} region {} line profile {} of {} max num pixels={}", file_id, region_id, iprofile, num_profiles, num_pixels);
+            int group_x_min = std::min(x_min, mask->BlcX());
+            int group_x_max = std::max(x_max, mask->BlcX() + mask->Width() - 1);
+            int group_y_min = std::min(y_min, mask->BlcY());
+            int group_y_max = std::max(y_max, mask->BlcY() + mask->Height() - 1);
+            size_t group_area = static_cast<size_t>(group_x_max - group_x_min + 1) * (group_y_max - group_y_min + 1);
+            size_t box_area = static_cast<size_t>(mask->Width()) * mask->Height();
+            if ((boxes_area > 0) && (group_area > LINE_PROFILE_MAX_SLAB_OVERHEAD * (boxes_area + box_area))) {
+                break;
+            }
+
+            x_min = group_x_min;
+            x_max = group_x_max;
+            y_min = group_y_min;
+            y_max = group_y_max;
+            boxes_area += box_area;
+        }
 
-            if (profiles.empty()) {
-                if (reverse) {
-                    profiles.resize(casacore::IPosition(2, region_profile.size(), num_profiles));
-                } else {
-                    profiles.resize(casacore::IPosition(2, num_profiles, region_profile.size()));
+        size_t num_boxes(end_box - first_box);
+        if (boxes_area > 0) {
+            // Read the group bounding box in blocks of channels
+            size_t slab_width(x_max - x_min + 1);
+            size_t slab_area = slab_width * (y_max - y_min + 1);
+            size_t block_z = std::min(num_z, std::max<size_t>(1, LINE_PROFILE_MAX_SLAB_SIZE / slab_area));
+            std::vector<float> slab;
+
+            for (size_t z_start = 0; z_start < num_z; z_start += block_z) {
+                if (check_cancel()) {
+                    return false;
                 }
-            }
 
-            if (reverse) {
-                profiles.column(iprofile) = region_profile;
-            } else {
-                profiles.row(iprofile) = region_profile;
-            }
+                size_t block_size = std::min(block_z, num_z - z_start);
+                AxisRange block_range(z_range.from + z_start, z_range.from + z_start + block_size - 1);
+                auto stokes_slicer = frame->GetImageSlicer(AxisRange(x_min, x_max), AxisRange(y_min, y_max), block_range, stokes_index);
+                slab.resize(slab_area * block_size);
 
-            progress = float(++completed_profiles) / float(num_profiles);
+                std::shared_lock frame_lock(frame->GetActiveTaskMutex());
+                bool data_ok = frame->GetSlicerData(stokes_slicer, slab.data());
+                frame_lock.unlock();
+                if (!data_ok) {
+                    return false;
+                }
 
-            if (per_z) {
-                // Update progress if time interval elapsed
-                auto t_end = std::chrono::high_resolution_clock::now();
-                auto dt = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+                // Mean of finite values for each box and channel
+                int64_t num_means = num_boxes * block_size;
+                ThreadManager::ApplyThreadLimit();
+#pragma omp parallel for schedule(dynamic)
+                for (int64_t i = 0; i < num_means; ++i) {
+                    size_t ibox = first_box + i / block_size;
+                    size_t iz = i % block_size;
+                    auto& mask = box_masks[ibox];
+                    if (!mask) {
+                        continue;
+                    }
 
-                if ((dt > LINE_PROFILE_PROGRESS_INTERVAL) || (progress >= 1.0)) {
-                    t_start = t_end;
-                    progress_callback(progress);
+                    const float* plane = slab.data() + iz * slab_area;
+                    double sum(0.0);
+                    size_t count(0);
+                    for (const auto& run : mask->Runs()) {
+                        const float* row = plane + (run.y - y_min) * slab_width + (run.x0 - x_min);
+                        for (int x = 0; x <= run.x1 - run.x0; ++x) {
+                            if (std::isfinite(row[x])) {
+                                sum += row[x];
+                                ++count;
+                            }
+                        }
+                    }
+
+                    float mean = (count > 0 ? sum / count : NAN);
+                    if (reverse) {
+                        profiles(z_start + iz, ibox) = mean;
+                    } else {
+                        profiles(ibox, z_start + iz) = mean;
+                    }
                 }
+
+                completed_work += num_boxes * block_size;
+                progress_callback(float(completed_work) / float(total_work));
             }
+        } else {
+            // Boxes outside image
+            completed_work += num_boxes * num_z;
+            progress_callback(float(completed_work) / float(total_work));
         }
+
+        first_box = end_box;
     }
 
-    return (!cancelled) && (progress >= 1.0) && !allEQ(profiles, NAN);
+    return true;
 }
 
 bool RegionHandler::CancelLineProfiles(int region_id, int file_id, RegionState& region_state) {
@@ -2563,97 +2740,6 @@ bool RegionHandler::CancelLineProfiles(int region_id, int file_id, RegionState&
     return cancel;
 }
 
-casacore::Vector<float> RegionHandler::GetTemporaryRegionProfile(int region_idx, int file_id, RegionState& region_state,
-    std::shared_ptr<casacore::CoordinateSystem> reference_csys, bool per_z, const AxisRange& z_range, int stokes_index,
-    double& num_pixels) {
-    // Create temporary region with RegionState and CoordinateSystem
-    // Return stats/spectral profile (depending on per_z) for given file_id image, and number of pixels in the region.
-
-    // Initialize return values
-    auto profile_size = per_z ? (z_range.to - z_range.from + 1) : 1;
-    casacore::Vector<float> profile(profile_size, NAN);
-    num_pixels = 0.0;
-
-    if (!region_state.RegionDefined()) {
-        return profile;
-    }
-
-    std::lock_guard<std::mutex> guard(_line_profile_mutex);
-    // Set temporary region
-    int region_id(TEMP_REGION_ID);
-    SetRegion(region_id, region_state, reference_csys);
-    if (!RegionSet(region_id, true)) {
-        return profile;
-    }
-
-    if (per_z) {
-        // Temp region spectral requirements
-        std::vector<CARTA::StatsType> required_stats = {CARTA::StatsType::NumPixels, CARTA::StatsType::Mean};
-        ConfigId config_id(file_id, region_id);
-        std::string coordinate("z"); // current stokes
-        SpectralConfig spectral_config(coordinate, required_stats);
-        RegionSpectralConfig region_config;
-        region_config.configs.push_back(spectral_config);
-
-        // Check cancel: currently temp per-z profile is only for PV image generator
-        if (_stop_pv[file_id]) {
-            RemoveRegion(region_id);
-            return profile;
-        }
-
-        // Set region spectral requirements
-        std::unique_lock<std::mutex> ulock(_spectral_mutex);
-        _spectral_req[config_id] = region_config;
-        ulock.unlock();
-
-        // Do not report errors for line regions outside image
-        bool report_error(false);
-
-        // Get region spectral profiles converted to file_id image if necessary
-        GetRegionSpectralData(region_id, file_id, z_range, coordinate, stokes_index, required_stats, report_error,
-            [&](std::map<CARTA::StatsType, std::vector<double>> results, float progress) {
-                // Callback only sets return values when progress is complete.
-                if (progress == 1.0) {
-                    // Get mean spectral profile and max NumPixels for small region.
-                    auto npix_per_chan = results[CARTA::StatsType::NumPixels];
-                    num_pixels = *max_element(npix_per_chan.begin(), npix_per_chan.end());
-                    profile = casacore::Vector<float>(results[CARTA::StatsType::Mean]); // TODO: use double for profile
-                }
-            });
-    } else {
-        // Use BasicStats to get num_pixels and mean for current channel and stokes
-        // Get region as LCRegion
-        StokesRegion stokes_region;
-        std::shared_ptr<casacore::LCRegion> lc_region;
-        std::shared_lock frame_lock(_frames.at(file_id)->GetActiveTaskMutex());
-        if (ApplyRegionToFile(region_id, file_id, z_range, stokes_index, lc_region, stokes_region)) {
-            // Get region data by applying LCRegion to image
-            std::vector<float> region_data;
-            if (_frames.at(file_id)->GetRegionData(stokes_region, region_data, false)) {
-                // Very small region, just calc needed stats here
-                num_pixels = 0;
-                double sum(0.0);
-                for (size_t i = 0; i < region_data.size(); ++i) {
-                    float val(region_data[i]);
-                    if (std::isfinite(val)) {
-                        num_pixels++;
-                        sum += (double)val;
-                    }
-                }
-                if (num_pixels > 0) {
-                    profile[0] = sum / num_pixels;
-                }
-            }
-        }
-        frame_lock.unlock();
-    }
-
-    // Remove temporary region
-    RemoveRegion(region_id);
-
-    return profile;
-}
-
 void RegionHandler::GetStokesPtotal(
     const ProfilesMap& profiles_q, const ProfilesMap& profiles_u, const ProfilesMap& profiles_v, ProfilesMap& profiles_ptotal) {
     auto calc_step1 = [&](double q, double u) { return (std::pow(q, 2) + std::pow(u, 2)); };
@@ -61,10 +61,10 @@ public:
     bool FillRegionHistogramData(
         std::function<void(CARTA::RegionHistogramData histogram_data)> region_histogram_callback, int region_id, int file_id);
     bool FillSpectralProfileData(
-        std::function<void(CARTA::SpectralProfileData profile_data)> cb, int region_id, int file_id, bool stokes_changed);
-    bool FillRegionStatsData(std::function<void(CARTA::RegionStatsData stats_data)> cb, int region_id, int file_id);
+        std::function<void(CARTA::SpectralProfileData& profile_data)> cb, int region_id, int file_id, bool stokes_changed);
+    bool FillRegionStatsData(std::function<void(CARTA::RegionStatsData& stats_data)> cb, int region_id, int file_id);
     bool FillPointSpatialProfileData(int file_id, int region_id, std::vector<CARTA::SpatialProfileData>& spatial_data_vec);
-    bool FillLineSpatialProfileData(int file_id, int region_id, std::function<void(CARTA::SpatialProfileData profile_data)> cb);
+    bool FillLineSpatialProfileData(int file_id, int region_id, std::function<void(CARTA::SpatialProfileData& profile_data)> cb);
 
     // Calculate moments
     bool CalculateMoments(int file_id, int region_id, const std::shared_ptr<Frame>& frame, GeneratorProgressCallback progress_callback,
@@ -142,9 +142,15 @@ private:
     bool GetLineProfiles(int file_id, int region_id, int width, const AxisRange& z_range, bool per_z, int stokes_index,
         const std::string& coordinate, std::function<void(float)>& progress_callback, casacore::Matrix<float>& profiles,
         casacore::Quantity& increment, bool& cancelled, std::string& message, bool reverse = false);
+    // Get pixels of each box region in the image of file_id, converting the boxes if defined in another image
+    bool GetBoxRegionMasks(int file_id, const std::vector<RegionState>& box_regions, int reference_file_id,
+        std::shared_ptr<casacore::CoordinateSystem> reference_csys, const std::function<bool()>& check_cancel,
+        std::vector<std::shared_ptr<RegionMask>>& box_masks);
+    // Get mean of each box region in the image of file_id for z-range, reading the image data once for neighboring boxes
+    bool GetBoxRegionProfiles(int file_id, const std::vector<std::shared_ptr<RegionMask>>& box_masks, const AxisRange& z_range,
+        int stokes_index, bool reverse, const std::function<bool()>& check_cancel, const std::function<void(float)>& progress_callback,
+        casacore::Matrix<float>& profiles);
     bool CancelLineProfiles(int region_id, int file_id, RegionState& region_state);
-    casacore::Vector<float> GetTemporaryRegionProfile(int region_idx, int file_id, RegionState& region_state,
-        std::shared_ptr<casacore::CoordinateSystem> csys, bool per_z, const AxisRange& z_range, int stokes_index, double& num_pixels);
 
     // Get computed stokes profiles for a region
     using ProfilesMap = std::map<CARTA::StatsType, std::vector<double>>;
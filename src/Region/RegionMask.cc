@@ -0,0 +1,231 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# RegionMask.cc: implementation of run-length pixel mask for closed regions
+
+#include "RegionMask.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Pixel centers this close to the boundary (in pixels) are in the region, to allow for rounding of the control points
+#define REGION_MASK_TOLERANCE 1.0e-6
+
+using namespace carta;
+
+static void AddRun(std::vector<MaskRun>& runs, int y, double x_start, double x_end, int width) {
+    // Add pixels with centers from x_start to x_end. The ends are clamped to [-1, width] before conversion, since ends far outside the
+    // image (e.g. for an edge nearly parallel to the row) would overflow int; pixels outside the bounding box are removed by SetRuns.
+    if (!(x_start <= x_end)) {
+        return;
+    }
+    int x0 = std::ceil(std::min(std::max(x_start - REGION_MASK_TOLERANCE, -1.0), (double)width));
+    int x1 = std::floor(std::min(std::max(x_end + REGION_MASK_TOLERANCE, -1.0), (double)width));
+    if (x0 <= x1) {
+        runs.push_back({y, x0, x1});
+    }
+}
+
+std::shared_ptr<RegionMask> RegionMask::Polygon(const std::vector<double>& x, const std::vector<double>& y, int width, int height) {
+    // Scanline fill with the even-odd rule at pixel centers, adding pixel centers on the edges
+    size_t npoints = std::min(x.size(), y.size());
+    if (npoints < 3) {
+        return nullptr;
+    }
+
+    auto x_minmax = std::minmax_element(x.begin(), x.begin() + npoints);
+    auto y_minmax = std::minmax_element(y.begin(), y.begin() + npoints);
+    std::shared_ptr<RegionMask> mask(new RegionMask());
+    if (!mask->SetBoundingBox(*x_minmax.first, *x_minmax.second, *y_minmax.first, *y_minmax.second, width, height)) {
+        return nullptr;
+    }
+
+    std::vector<std::vector<MaskRun>> row_runs(mask->_height);
+    std::vector<double> crossings;
+    for (int row = 0; row < mask->_height; ++row) {
+        int pixel_y = mask->_blc_y + row;
+        double y_center = pixel_y;
+        auto& runs = row_runs[row];
+        crossings.clear();
+
+        for (size_t i = 0; i < npoints; ++i) {
+            size_t j = (i + 1) % npoints;
+            double x0(x[i]), y0(y[i]), x1(x[j]), y1(y[j]);
+
+            // Half-open rule so that vertices on the scanline are counted once
+            if ((y0 <= y_center && y_center < y1) || (y1 <= y_center && y_center < y0)) {
+                crossings.push_back(x0 + (y_center - y0) * (x1 - x0) / (y1 - y0));
+            }
+
+            // Edge through the pixel centers, which may be excluded by the half-open rule
+            if (std::min(y0, y1) - REGION_MASK_TOLERANCE <= y_center && y_center <= std::max(y0, y1) + REGION_MASK_TOLERANCE) {
+                if (std::abs(y1 - y0) <= REGION_MASK_TOLERANCE) {
+                    AddRun(runs, pixel_y, std::min(x0, x1), std::max(x0, x1), width);
+                } else {
+                    double x_edge = x0 + (y_center - y0) * (x1 - x0) / (y1 - y0);
+                    double x_pixel = std::round(x_edge);
+                    if (std::abs(x_edge - x_pixel) <= REGION_MASK_TOLERANCE) {
+                        AddRun(runs, pixel_y, x_pixel, x_pixel, width);
+                    }
+                }
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            AddRun(runs, pixel_y, crossings[i], crossings[i + 1], width);
+        }
+    }
+
+    if (!mask->SetRuns(row_runs)) {
+        return nullptr;
+    }
+    return mask;
+}
+
+std::shared_ptr<RegionMask> RegionMask::Ellipse(
+    double center_x, double center_y, double radius_x, double radius_y, double theta, int width, int height) {
+    // Solve (u / radius_x)^2 + (v / radius_y)^2 <= 1 for x in each row, where u and v are the offsets along the rotated axes
+    if (!(radius_x > 0.0) || !(radius_y > 0.0)) {
+        return nullptr;
+    }
+
+    double cos_theta = std::cos(theta);
+    double sin_theta = std::sin(theta);
+    double half_width = std::hypot(radius_x * cos_theta, radius_y * sin_theta);
+    double half_height = std::hypot(radius_x * sin_theta, radius_y * cos_theta);
+
+    std::shared_ptr<RegionMask> mask(new RegionMask());
+    if (!mask->SetBoundingBox(
+            center_x - half_width, center_x + half_width, center_y - half_height, center_y + half_height, width, height)) {
+        return nullptr;
+    }
+
+    // Quadratic a * dx^2 + b * dx * dy + c * dy^2 <= 1
+    double inv_rx2 = 1.0 / (radius_x * radius_x);
+    double inv_ry2 = 1.0 / (radius_y * radius_y);
+    double a = cos_theta * cos_theta * inv_rx2 + sin_theta * sin_theta * inv_ry2;
+    double b = 2.0 * sin_theta * cos_theta * (inv_rx2 - inv_ry2);
+    double c = sin_theta * sin_theta * inv_rx2 + cos_theta * cos_theta * inv_ry2;
+
+    std::vector<std::vector<MaskRun>> row_runs(mask->_height);
+    for (int row = 0; row < mask->_height; ++row) {
+        int pixel_y = mask->_blc_y + row;
+        double dy = pixel_y - center_y;
+        double discriminant = b * b * dy * dy - 4.0 * a * (c * dy * dy - (1.0 + REGION_MASK_TOLERANCE));
+        if (discriminant < 0.0) {
+            continue;
+        }
+        double root = std::sqrt(discriminant);
+        AddRun(row_runs[row], pixel_y, center_x + (-b * dy - root) / (2.0 * a), center_x + (-b * dy + root) / (2.0 * a), width);
+    }
+
+    if (!mask->SetRuns(row_runs)) {
+        return nullptr;
+    }
+    return mask;
+}
+
+std::shared_ptr<RegionMask> RegionMask::FromMask(const bool* mask, int blc_x, int blc_y, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RegionMask> region_mask(new RegionMask());
+    region_mask->_blc_x = blc_x;
+    region_mask->_blc_y = blc_y;
+    region_mask->_width = width;
+    region_mask->_height = height;
+
+    std::vector<std::vector<MaskRun>> row_runs(height);
+    for (int row = 0; row < height; ++row) {
+        const bool* row_mask = mask + static_cast<size_t>(row) * width;
+        int x = 0;
+        while (x < width) {
+            if (!row_mask[x]) {
+                ++x;
+                continue;
+            }
+            int x_start = x;
+            while (x < width && row_mask[x]) {
+                ++x;
+            }
+            row_runs[row].push_back({blc_y + row, blc_x + x_start, blc_x + x - 1});
+        }
+    }
+
+    if (!region_mask->SetRuns(row_runs)) {
+        return nullptr;
+    }
+    return region_mask;
+}
+
+bool RegionMask::SetBoundingBox(double x_min, double x_max, double y_min, double y_max, int width, int height) {
+    int blc_x = std::max(0.0, std::ceil(x_min - REGION_MASK_TOLERANCE));
+    int blc_y = std::max(0.0, std::ceil(y_min - REGION_MASK_TOLERANCE));
+    int trc_x = std::min(width - 1.0, std::floor(x_max + REGION_MASK_TOLERANCE));
+    int trc_y = std::min(height - 1.0, std::floor(y_max + REGION_MASK_TOLERANCE));
+    if (blc_x > trc_x || blc_y > trc_y) {
+        return false;
+    }
+
+    _blc_x = blc_x;
+    _blc_y = blc_y;
+    _width = trc_x - blc_x + 1;
+    _height = trc_y - blc_y + 1;
+    return true;
+}
+
+bool RegionMask::SetRuns(std::vector<std::vector<MaskRun>>& row_runs) {
+    // Limit runs to the bounding box, then merge overlapping and adjacent runs in each row
+    int trc_x = _blc_x + _width - 1;
+    _runs.clear();
+    _num_pixels = 0;
+
+    for (auto& runs : row_runs) {
+        std::sort(runs.begin(), runs.end(), [](const MaskRun& a, const MaskRun& b) { return a.x0 < b.x0; });
+        size_t row_start = _runs.size();
+        for (auto run : runs) {
+            run.x0 = std::max(run.x0, _blc_x);
+            run.x1 = std::min(run.x1, trc_x);
+            if (run.x0 > run.x1) {
+                continue;
+            }
+            if (_runs.size() > row_start && run.x0 <= _runs.back().x1 + 1) {
+                _runs.back().x1 = std::max(_runs.back().x1, run.x1);
+            } else {
+                _runs.push_back(run);
+            }
+        }
+    }
+
+    for (const auto& run : _runs) {
+        _num_pixels += run.x1 - run.x0 + 1;
+    }
+    return !_runs.empty();
+}
+
+void RegionMask::FillMask(bool* mask) const {
+    std::fill(mask, mask + static_cast<size_t>(_width) * _height, false);
+    for (const auto& run : _runs) {
+        bool* row_mask = mask + static_cast<size_t>(run.y - _blc_y) * _width;
+        std::fill(row_mask + (run.x0 - _blc_x), row_mask + (run.x1 - _blc_x + 1), true);
+    }
+}
+
+void RegionMask::ApplyToData(float* data) const {
+    size_t i_run(0);
+    for (int row = 0; row < _height; ++row) {
+        int pixel_y = _blc_y + row;
+        float* row_data = data + static_cast<size_t>(row) * _width;
+        int x(0); // first pixel in row not yet masked or kept
+        for (; i_run < _runs.size() && _runs[i_run].y == pixel_y; ++i_run) {
+            std::fill(row_data + x, row_data + (_runs[i_run].x0 - _blc_x), NAN);
+            x = _runs[i_run].x1 - _blc_x + 1;
+        }
+        std::fill(row_data + x, row_data + _width, NAN);
+    }
+}
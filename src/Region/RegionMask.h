@@ -0,0 +1,81 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+//# RegionMask.h: run-length pixel mask for closed regions, rasterized by scanline
+
+#ifndef CARTA_SRC_REGION_REGIONMASK_H_
+#define CARTA_SRC_REGION_REGIONMASK_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace carta {
+
+// Pixels x0 to x1 (inclusive) in image row y
+struct MaskRun {
+    int y;
+    int x0;
+    int x1;
+};
+
+class RegionMask {
+public:
+    // A pixel is in the region if its center is inside or on the boundary of the shape, as for LCPolygon and LCEllipsoid.
+    // Returns nullptr if no pixel of the image (width x height) is in the region.
+    static std::shared_ptr<RegionMask> Polygon(const std::vector<double>& x, const std::vector<double>& y, int width, int height);
+    // Ellipse with radius_x along the axis at angle theta (radians) from the x-axis, and radius_y perpendicular to it
+    static std::shared_ptr<RegionMask> Ellipse(
+        double center_x, double center_y, double radius_x, double radius_y, double theta, int width, int height);
+    // Runs of a pixel mask for the bounding box with corner (blc_x, blc_y), e.g. from an LCRegion; nullptr if no pixel is set
+    static std::shared_ptr<RegionMask> FromMask(const bool* mask, int blc_x, int blc_y, int width, int height);
+
+    // Bounding box, limited to the image
+    inline int BlcX() const {
+        return _blc_x;
+    }
+    inline int BlcY() const {
+        return _blc_y;
+    }
+    inline int Width() const {
+        return _width;
+    }
+    inline int Height() const {
+        return _height;
+    }
+
+    // Runs in increasing y then x, not overlapping or adjacent
+    inline const std::vector<MaskRun>& Runs() const {
+        return _runs;
+    }
+    inline size_t NumPixels() const {
+        return _num_pixels;
+    }
+
+    // Fill the mask for the bounding box (width x height, x fastest)
+    void FillMask(bool* mask) const;
+    // Set pixels outside the region to NaN in data for the bounding box (width x height, x fastest)
+    void ApplyToData(float* data) const;
+
+private:
+    RegionMask() = default;
+
+    // Set bounding box of pixel centers within the shape extent; returns false if outside image
+    bool SetBoundingBox(double x_min, double x_max, double y_min, double y_max, int width, int height);
+    // Set runs from the pixel intervals in each row of the bounding box; returns false if there are none
+    bool SetRuns(std::vector<std::vector<MaskRun>>& row_runs);
+
+    int _blc_x = 0;
+    int _blc_y = 0;
+    int _width = 0;
+    int _height = 0;
+    size_t _num_pixels = 0;
+    std::vector<MaskRun> _runs;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_REGION_REGIONMASK_H_
@@ -32,7 +32,7 @@ struct RegionState {
         return (reference_file_id != rhs.reference_file_id) || (type != rhs.type) || RegionChanged(rhs);
     }
 
-    bool RegionDefined() {
+    bool RegionDefined() const {
         return !control_points.empty();
     }
 
@@ -82,7 +82,8 @@ struct RegionState {
         return type > CARTA::POLYGON;
     }
 
-    bool GetRectangleCorners(casacore::Vector<casacore::Double>& x, casacore::Vector<casacore::Double>& y, bool apply_rotation = true) {
+    bool GetRectangleCorners(
+        casacore::Vector<casacore::Double>& x, casacore::Vector<casacore::Double>& y, bool apply_rotation = true) const {
         // Convert rectangle points [[cx, cy], [width, height]] to corner points. Optionally apply rotation.
         if (type != CARTA::RECTANGLE && type != CARTA::ANNRECTANGLE && type != CARTA::ANNTEXT) {
             return false;
@@ -75,3 +75,24 @@ OnMessageTask* PvPreviewUpdateTask::execute() {
     _session->SendPvPreview(_file_id, _region_id, _preview_region);
     return nullptr;
 }
+
+OnMessageTask* DispatchMessagesTask::execute() {
+    std::vector<char> message;
+    while (_session->PopInboundMessage(message)) {
+        auto event_type = static_cast<CARTA::EventType>(reinterpret_cast<const EventHeader*>(message.data())->type);
+        bool long_running = SessionManager::IsLongRunningEvent(event_type);
+        if (long_running != _long_running) {
+            // Continue on the other thread pool; the session's dispatch stays active, so messages are still handled in order
+            _session->UnpopInboundMessage(std::move(message));
+            if (long_running) {
+                ThreadManager::QueueTask(new DispatchMessagesTask(_session, _session_manager, true));
+            } else {
+                ThreadManager::QueueDispatchTask(new DispatchMessagesTask(_session, _session_manager, false));
+            }
+            return nullptr;
+        }
+        _session_manager->HandleMessage(_session, message);
+        _session_manager->ReleaseBuffer(std::move(message));
+    }
+    return nullptr;
+}
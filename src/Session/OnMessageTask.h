@@ -116,6 +116,19 @@ public:
     ~PvPreviewUpdateTask() = default;
 };
 
+// Handles the session's incoming messages in order. Runs on a dispatch thread, and moves to a worker thread (and back) for
+// long-running requests, so that a slow handler does not block the dispatch of other sessions' messages.
+class DispatchMessagesTask : public OnMessageTask {
+    OnMessageTask* execute() override;
+    SessionManager* _session_manager;
+    bool _long_running;
+
+public:
+    DispatchMessagesTask(Session* session, SessionManager* session_manager, bool long_running = false)
+        : OnMessageTask(session), _session_manager(session_manager), _long_running(long_running) {}
+    ~DispatchMessagesTask() = default;
+};
+
 } // namespace carta
 
 #include "OnMessageTask.tcc"
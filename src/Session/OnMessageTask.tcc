@@ -36,6 +36,8 @@ class GeneralMessageTask : public OnMessageTask {
             _session->OnFittingRequest(_message, _request_id);
         } else if constexpr (std::is_same_v<T, CARTA::SetVectorOverlayParameters>) {
             _session->OnSetVectorOverlayParameters(_message);
+        } else if constexpr (std::is_same_v<T, CARTA::SaveFile>) {
+            _session->OnSaveFile(_message, _request_id);
         } else {
             spdlog::warn("Bad event type for GeneralMessageTask!");
         }
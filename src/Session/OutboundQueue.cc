@@ -0,0 +1,214 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "OutboundQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <carta-protobuf/raster_tile.pb.h>
+#include <carta-protobuf/spatial_profile.pb.h>
+#include <carta-protobuf/spectral_profile.pb.h>
+
+#include "Util/Message.h"
+
+using namespace carta;
+
+OutboundQueue::OutboundQueue(size_t byte_budget) : _byte_budget(byte_budget), _buffered_bytes(0) {}
+
+std::string OutboundQueue::SupersedeKey(CARTA::EventType event_type, const google::protobuf::MessageLite& message) {
+    switch (event_type) {
+        case CARTA::EventType::RASTER_TILE_DATA: {
+            // A newer tile at the same position replaces an older one only within the same tile sync, since the frontend expects every
+            // tile of a sync between its start and end messages
+            auto& tile_data = static_cast<const CARTA::RasterTileData&>(message);
+            if (tile_data.tiles_size() == 1) {
+                auto& tile = tile_data.tiles(0);
+                return fmt::format("{}:{}:{}:{}:{}:{}:{}:{}", static_cast<int>(event_type), tile_data.file_id(), tile_data.channel(),
+                    tile_data.stokes(), tile_data.sync_id(), tile.layer(), tile.x(), tile.y());
+            }
+            break;
+        }
+        case CARTA::EventType::SPATIAL_PROFILE_DATA: {
+            // Only the latest cursor, point or line region profile for the same coordinates is of interest
+            auto& profile_data = static_cast<const CARTA::SpatialProfileData&>(message);
+            std::string coordinates;
+            for (const auto& profile : profile_data.profiles()) {
+                coordinates += profile.coordinate() + (profile.has_line_axis() ? "/line," : ",");
+            }
+            return fmt::format("{}:{}:{}:{}:{}", static_cast<int>(event_type), profile_data.file_id(), profile_data.region_id(),
+                profile_data.stokes(), coordinates);
+        }
+        case CARTA::EventType::SPECTRAL_PROFILE_DATA: {
+            // Partial profiles are superseded by later ones; the complete profile is always delivered
+            auto& profile_data = static_cast<const CARTA::SpectralProfileData&>(message);
+            if (profile_data.progress() < 1.0) {
+                return fmt::format(
+                    "{}:{}:{}:{}", static_cast<int>(event_type), profile_data.file_id(), profile_data.region_id(), profile_data.stokes());
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return std::string();
+}
+
+void OutboundQueue::Push(OutboundMessage&& message) {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    size_t message_size = message.data.size();
+
+    if (!message.supersede_key.empty()) {
+        auto latest = _latest.find(message.supersede_key);
+        if (latest != _latest.end()) {
+            if (OverBudget(message_size)) {
+                // Discard the superseded message which has not been written to the socket yet
+                size_t superseded_size = latest->second->data.size();
+                _stats.queued_bytes -= superseded_size;
+                _stats.dropped_bytes += superseded_size;
+                ++_stats.dropped_count;
+                _queue.erase(latest->second);
+            }
+            _latest.erase(latest);
+        }
+    }
+
+    _queue.push_back(std::move(message));
+    if (!_queue.back().supersede_key.empty()) {
+        _latest[_queue.back().supersede_key] = std::prev(_queue.end());
+    }
+    _stats.queued_bytes += message_size;
+    _stats.peak_bytes = std::max(_stats.peak_bytes, _stats.queued_bytes + _buffered_bytes);
+}
+
+bool OutboundQueue::Pop(OutboundMessage& message, size_t buffered_amount) {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    _buffered_bytes = buffered_amount;
+    if (_queue.empty() || _buffered_bytes > _byte_budget) {
+        // Hold messages here while the socket drains, so that droppable ones can still be superseded
+        return false;
+    }
+
+    if (!_queue.front().supersede_key.empty()) {
+        auto latest = _latest.find(_queue.front().supersede_key);
+        if (latest != _latest.end() && latest->second == _queue.begin()) {
+            _latest.erase(latest);
+        }
+    }
+
+    message = std::move(_queue.front());
+    _queue.pop_front();
+    _stats.queued_bytes -= message.data.size();
+    return true;
+}
+
+void OutboundQueue::SetBufferedAmount(size_t buffered_amount) {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    _buffered_bytes = buffered_amount;
+    _stats.peak_bytes = std::max(_stats.peak_bytes, _stats.queued_bytes + _buffered_bytes);
+}
+
+void OutboundQueue::Clear() {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    _queue.clear();
+    _latest.clear();
+    _stats.queued_bytes = 0;
+}
+
+bool OutboundQueue::OverBudget() {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    return OverBudget(0);
+}
+
+OutboundStats OutboundQueue::Stats() {
+    std::unique_lock<std::mutex> ulock(_mutex);
+    return _stats;
+}
+
+bool OutboundQueue::OverBudget(size_t additional_bytes) const {
+    return _stats.queued_bytes + _buffered_bytes + additional_bytes > _byte_budget;
+}
+
+OutboundBatch::OutboundBatch(size_t max_size) : _max_size(max_size), _count(0), _compress(false) {}
+
+bool OutboundBatch::Add(OutboundMessage& message) {
+    if (_count == 0) {
+        _first = std::move(message);
+        _compress = _first.compress;
+        _count = 1;
+        return true;
+    }
+
+    size_t batch_size = (_count == 1) ? sizeof(EventHeader) + sizeof(uint32_t) + _first.data.size() : _envelope.size();
+    if (message.compress != _compress || batch_size + sizeof(uint32_t) + message.data.size() > _max_size) {
+        return false;
+    }
+
+    if (_count == 1) {
+        _envelope.resize(sizeof(EventHeader));
+        EventHeader* head = (EventHeader*)_envelope.data();
+        head->type = BATCHED_EVENTS_EVENT_TYPE;
+        head->icd_version = ICD_VERSION;
+        head->request_id = 0;
+        AppendToEnvelope(_first.data);
+    }
+    AppendToEnvelope(message.data);
+    ++_count;
+    return true;
+}
+
+std::string_view OutboundBatch::Frame() {
+    if (_count == 1) {
+        return std::string_view(_first.data.data(), _first.data.size());
+    } else if (_count > 1) {
+        return std::string_view(_envelope.data(), _envelope.size());
+    }
+    return std::string_view();
+}
+
+void OutboundBatch::Clear() {
+    _count = 0;
+    _compress = false;
+    _first.data.clear();
+    _envelope.clear();
+}
+
+std::vector<std::string_view> OutboundBatch::Unpack(std::string_view frame) {
+    std::vector<std::string_view> messages;
+    if (frame.size() < sizeof(EventHeader)) {
+        return messages;
+    }
+
+    EventHeader head;
+    std::memcpy(&head, frame.data(), sizeof(EventHeader));
+    if (head.type != BATCHED_EVENTS_EVENT_TYPE) {
+        messages.push_back(frame);
+        return messages;
+    }
+
+    size_t offset = sizeof(EventHeader);
+    while (offset + sizeof(uint32_t) <= frame.size()) {
+        uint32_t length;
+        std::memcpy(&length, frame.data() + offset, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        if (offset + length > frame.size()) {
+            break;
+        }
+        messages.push_back(frame.substr(offset, length));
+        offset += length;
+    }
+    return messages;
+}
+
+void OutboundBatch::AppendToEnvelope(const std::vector<char>& data) {
+    uint32_t length = data.size();
+    size_t offset = _envelope.size();
+    _envelope.resize(offset + sizeof(uint32_t) + length);
+    std::memcpy(_envelope.data() + offset, &length, sizeof(uint32_t));
+    std::memcpy(_envelope.data() + offset + sizeof(uint32_t), data.data(), length);
+}
@@ -0,0 +1,113 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// # OutboundQueue.h: per-session queue of serialized messages waiting to be written to the WebSocket
+
+#ifndef CARTA_SRC_SESSION_OUTBOUNDQUEUE_H_
+#define CARTA_SRC_SESSION_OUTBOUNDQUEUE_H_
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/message_lite.h>
+
+#include <carta-protobuf/enums.pb.h>
+
+#define OUTBOUND_BYTE_BUDGET_MB 16
+#define MAX_BATCH_SIZE_KB 1024
+
+namespace carta {
+
+struct OutboundMessage {
+    std::vector<char> data;
+    bool compress = false;
+    CARTA::EventType event_type = CARTA::EventType::EMPTY_EVENT;
+    // Whether the message may be packed with others into a batched frame, which the client must have negotiated before it was sent
+    bool batch = false;
+    // Messages with the same key replace each other when the budget is exceeded; empty key for messages which are always delivered
+    std::string supersede_key;
+};
+
+struct OutboundStats {
+    size_t queued_bytes = 0;
+    size_t peak_bytes = 0;
+    size_t dropped_bytes = 0;
+    size_t dropped_count = 0;
+};
+
+class OutboundQueue {
+public:
+    OutboundQueue(size_t byte_budget = OUTBOUND_BYTE_BUDGET_MB * 1024 * 1024);
+
+    // Key identifying the data stream of a droppable message (tiles, cursor/point spatial profiles, partial spectral profiles).
+    // Returns an empty string for messages which must always be delivered (acks, sync messages, final results, etc.)
+    static std::string SupersedeKey(CARTA::EventType event_type, const google::protobuf::MessageLite& message);
+
+    // Thread-safe. If the session is over budget, a queued message with the same supersede key is discarded.
+    void Push(OutboundMessage&& message);
+    // Called on the uWS loop thread. Returns false if the queue is empty or the socket already buffers more than the budget.
+    bool Pop(OutboundMessage& message, size_t buffered_amount);
+    // Record the amount of data buffered by the socket after writing or draining
+    void SetBufferedAmount(size_t buffered_amount);
+    void Clear();
+
+    bool OverBudget();
+    OutboundStats Stats();
+
+private:
+    bool OverBudget(size_t additional_bytes) const;
+
+    std::mutex _mutex;
+    std::list<OutboundMessage> _queue;
+    // Latest queued message for each supersede key
+    std::unordered_map<std::string, std::list<OutboundMessage>::iterator> _latest;
+
+    size_t _byte_budget;
+    size_t _buffered_bytes;
+    OutboundStats _stats;
+};
+
+// Packs consecutive outbound messages with the same compression setting into a single WebSocket frame
+class OutboundBatch {
+public:
+    OutboundBatch(size_t max_size = MAX_BATCH_SIZE_KB * 1024);
+
+    // Returns false (leaving the message untouched) if the batch is full or the message uses a different compression setting
+    bool Add(OutboundMessage& message);
+    // Frame to write to the socket; a single message is written without the batch envelope
+    std::string_view Frame();
+    bool Compress() const {
+        return _compress;
+    }
+    size_t Count() const {
+        return _count;
+    }
+    bool Empty() const {
+        return _count == 0;
+    }
+    void Clear();
+
+    // Split a frame into its messages (each starting with its EventHeader)
+    static std::vector<std::string_view> Unpack(std::string_view frame);
+
+private:
+    void AppendToEnvelope(const std::vector<char>& data);
+
+    size_t _max_size;
+    size_t _count;
+    bool _compress;
+    OutboundMessage _first;
+    std::vector<char> _envelope;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_SESSION_OUTBOUNDQUEUE_H_
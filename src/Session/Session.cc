@@ -48,6 +48,7 @@ int Session::_exit_after_num_seconds = 5;
 bool Session::_exit_when_all_sessions_closed = false;
 bool Session::_controller_deployment = false;
 std::thread* Session::_animation_thread = nullptr;
+ContourCache Session::_contour_cache;
 
 Session::Session(uWS::WebSocket<false, true, PerSocketData>* ws, uWS::Loop* loop, uint32_t id, std::string address,
     std::shared_ptr<FileListHandler> file_list_handler)
@@ -62,6 +63,9 @@ Session::Session(uWS::WebSocket<false, true, PerSocketData>* ws, uWS::Loop* loop
       _sync_id(0),
       _animation_id(0),
       _animation_active(false),
+      _dispatch_active(false),
+      _batch_messages(false),
+      _message_zstd_level(0),
       _cursor_settings(this),
       _loaders(LOADER_CACHE_SIZE) {
     auto& settings = ProgramSettings::GetInstance();
@@ -99,6 +103,9 @@ void ExitNoSessions(int s) {
 }
 
 Session::~Session() {
+    auto outbound_stats = _out_msgs.Stats();
+    spdlog::info("Session {} outbound messages: peak {:.3f} MB queued, {} superseded messages dropped ({:.3f} MB)", _id,
+        outbound_stats.peak_bytes / 1.0e6, outbound_stats.dropped_count, outbound_stats.dropped_bytes / 1.0e6);
     --_num_sessions;
     spdlog::debug("{} ~Session : num sessions = {}", fmt::ptr(this), _num_sessions);
     if (!_num_sessions) {
@@ -397,8 +404,21 @@ void Session::OnRegisterViewer(const CARTA::RegisterViewer& message, uint16_t ic
     if (_enable_scripting) {
         feature_flags |= CARTA::ServerFeatureFlags::SCRIPTING;
     }
+    // Batch outgoing messages only for clients which can unpack them
+    bool batch_messages = success && (message.client_feature_flags() & CLIENT_BATCHED_EVENTS_FLAG);
+    if (batch_messages) {
+        feature_flags |= SERVER_BATCHED_EVENTS_FLAG;
+    }
+    // Compress large messages with zstd on the sending thread instead of deflate on the loop thread
+    bool zstd_messages = success && (message.client_feature_flags() & CLIENT_ZSTD_EVENTS_FLAG);
+    if (zstd_messages) {
+        feature_flags |= SERVER_ZSTD_EVENTS_FLAG;
+    }
     ack_message.set_server_feature_flags(feature_flags);
     SendEvent(CARTA::EventType::REGISTER_VIEWER_ACK, request_id, ack_message);
+    // The ack itself is never batched or compressed, since the client only knows to expect them once it has received it
+    _batch_messages = batch_messages;
+    _message_zstd_level = zstd_messages ? std::clamp(MESSAGE_ZSTD_LEVEL, 1, 3) : 0;
 }
 
 void Session::OnFileListRequest(const CARTA::FileListRequest& request, uint32_t request_id) {
@@ -702,11 +722,13 @@ void Session::OnAddRequiredTiles(const CARTA::AddRequiredTiles& message, int ani
     {
         int num_threads = omp_get_num_threads();
         int stride = std::min(num_tiles, std::min(num_threads, MAX_TILING_TASKS));
+        // Tile messages are serialized when sent, so each thread reuses its arena for every tile
+        thread_local MessageArena arena;
 #pragma omp for
         for (int j = 0; j < stride; j++) {
             for (int i = j; i < num_tiles; i += stride) {
                 const auto& encoded_coordinate = message.tiles(i);
-                auto raster_tile_data = Message::RasterTileData(file_id, sync_id, animation_id);
+                auto& raster_tile_data = *Message::RasterTileData(arena.Get(), file_id, sync_id, animation_id);
                 auto tile = Tile::Decode(encoded_coordinate);
                 if (_frames.count(file_id) &&
                     _frames.at(file_id)->FillRasterTileData(raster_tile_data, tile, z, stokes, compression_type, compression_quality)) {
@@ -716,6 +738,7 @@ void Session::OnAddRequiredTiles(const CARTA::AddRequiredTiles& message, int ani
                 } else {
                     spdlog::warn("Discarding stale tile request for channel={}, layer={}, x={}, y={}", z, tile.layer, tile.x, tile.y);
                 }
+                arena.Reset();
             }
         }
     }
@@ -1105,7 +1128,7 @@ void Session::OnResumeSession(const CARTA::ResumeSession& message, uint32_t requ
     WaitForTaskCancellation();
 
     // Clear the message queue
-    _out_msgs.clear();
+    _out_msgs.Clear();
 
     // Reconnect the session
     ConnectCalled();
@@ -1627,7 +1650,7 @@ bool Session::SendSpatialProfileData(int file_id, int region_id) {
     // return true if data sent
     bool data_sent(false);
 
-    auto send_results = [&](int file_id, int region_id, std::vector<CARTA::SpatialProfileData> spatial_profile_data_vec) {
+    auto send_results = [&](int file_id, int region_id, std::vector<CARTA::SpatialProfileData>& spatial_profile_data_vec) {
         for (auto& spatial_profile_data : spatial_profile_data_vec) {
             spatial_profile_data.set_file_id(file_id);
             spatial_profile_data.set_region_id(region_id);
@@ -1648,7 +1671,7 @@ bool Session::SendSpatialProfileData(int file_id, int region_id) {
                 send_results(file_id, region_id, spatial_profile_data_vec);
             }
         } else if (_region_handler->IsLineRegion(region_id)) {
-            data_sent = _region_handler->FillLineSpatialProfileData(file_id, region_id, [&](CARTA::SpatialProfileData profile_data) {
+            data_sent = _region_handler->FillLineSpatialProfileData(file_id, region_id, [&](CARTA::SpatialProfileData& profile_data) {
                 if (profile_data.profiles_size() > 0) {
                     SendFileEvent(file_id, CARTA::EventType::SPATIAL_PROFILE_DATA, 0, profile_data);
                 }
@@ -1699,7 +1722,7 @@ bool Session::SendSpectralProfileData(int file_id, int region_id, bool stokes_ch
     if ((region_id > CURSOR_REGION_ID) || (region_id == ALL_REGIONS) || (file_id == ALL_FILES)) {
         // Region spectral profile
         data_sent = _region_handler->FillSpectralProfileData(
-            [&](CARTA::SpectralProfileData profile_data) {
+            [&](CARTA::SpectralProfileData& profile_data) {
                 if (profile_data.profiles_size() > 0) {
                     // send (partial) profile data to the frontend for each region/file combo
                     SendFileEvent(profile_data.file_id(), CARTA::EventType::SPECTRAL_PROFILE_DATA, 0, profile_data);
@@ -1710,7 +1733,7 @@ bool Session::SendSpectralProfileData(int file_id, int region_id, bool stokes_ch
         // Cursor spectral profile
         if (_frames.count(file_id)) {
             data_sent = _frames.at(file_id)->FillSpectralProfileData(
-                [&](CARTA::SpectralProfileData profile_data) {
+                [&](CARTA::SpectralProfileData& profile_data) {
                     if (profile_data.profiles_size() > 0) {
                         profile_data.set_file_id(file_id);
                         profile_data.set_region_id(region_id);
@@ -1769,7 +1792,7 @@ bool Session::SendRegionStatsData(int file_id, int region_id) {
         return data_sent;
     }
 
-    auto region_stats_data_callback = [&](CARTA::RegionStatsData region_stats_data) {
+    auto region_stats_data_callback = [&](CARTA::RegionStatsData& region_stats_data) {
         if (region_stats_data.statistics_size() > 0) {
             SendFileEvent(region_stats_data.file_id(), CARTA::EventType::REGION_STATS_DATA, 0, region_stats_data);
         }
@@ -1825,31 +1848,55 @@ bool Session::SendContourData(int file_id, bool ignore_empty) {
         auto frame = _frames.at(file_id);
         const ContourSettings settings = frame->GetContourParameters();
         int num_levels = settings.levels.size();
+        // Plane to trace; the same values are used for the messages and the cache key even if the channel changes during tracing
+        int z(frame->CurrentZ()), stokes(frame->CurrentStokes());
 
         if (!num_levels) {
             if (ignore_empty) {
                 return false;
             } else {
-                auto empty_response =
-                    Message::ContourImageData(file_id, settings.reference_file_id, frame->CurrentZ(), frame->CurrentStokes(), 1.0);
+                auto empty_response = Message::ContourImageData(file_id, settings.reference_file_id, z, stokes, 1.0);
                 SendFileEvent(file_id, CARTA::EventType::CONTOUR_IMAGE_DATA, 0, empty_response);
                 return true;
             }
         }
 
-        int64_t total_vertices = 0;
+#if _DISABLE_CONTOUR_COMPRESSION_
+        const int compression_level = 0;
+#else
+        const int compression_level = std::max(0, std::min(20, settings.compression_level));
+#endif
+
+        // Replay contours already encoded for this plane, e.g. by another session or before a channel change
+        std::string cache_key;
+        auto image_id = frame->GetImageId();
+        if (!image_id.empty()) {
+            cache_key = ContourCache::Key(image_id, z, stokes, settings.levels, settings.smoothing_mode, settings.smoothing_factor,
+                settings.decimation, compression_level);
+            auto cached = _contour_cache.Get(cache_key);
+            if (cached) {
+                MessageArena arena;
+                for (size_t i = 0; i < cached->contour_sets.size(); i++) {
+                    auto& response =
+                        *Message::ContourImageData(arena.Get(), file_id, settings.reference_file_id, z, stokes, cached->progress[i]);
+                    *response.add_contour_sets() = cached->contour_sets[i];
+                    SendFileEvent(file_id, CARTA::EventType::CONTOUR_IMAGE_DATA, 0, response, compression_level < 1);
+                    arena.Reset();
+                }
+                return true;
+            }
+        }
+
+        auto cache_entry = std::make_shared<ContourCacheEntry>();
+        std::mutex cache_entry_mutex;
+        std::atomic<int64_t> total_vertices = 0;
 
         auto callback = [&](double level, double progress, const std::vector<float>& vertices, const std::vector<int>& indices) {
+            // Levels are traced in parallel, so each thread builds its messages on its own arena
+            thread_local MessageArena arena;
             // Currently only supports identical reference file IDs
-            auto partial_response =
-                Message::ContourImageData(file_id, settings.reference_file_id, frame->CurrentZ(), frame->CurrentStokes(), progress);
-            std::vector<char> compression_buffer;
+            auto& partial_response = *Message::ContourImageData(arena.Get(), file_id, settings.reference_file_id, z, stokes, progress);
             const float pixel_rounding = std::max(1, std::min(32, settings.decimation));
-#if _DISABLE_CONTOUR_COMPRESSION_
-            const int compression_level = 0;
-#else
-            const int compression_level = std::max(0, std::min(20, settings.compression_level));
-#endif
             // Fill contour set
             auto contour_set = partial_response.add_contour_sets();
             contour_set->set_level(level);
@@ -1867,25 +1914,42 @@ bool Session::SendContourData(int file_id, bool ignore_empty) {
                     std::vector<int32_t> vertices_shuffled;
                     RoundAndEncodeVertices(vertices, vertices_shuffled, pixel_rounding);
 
-                    // Compress using Zstd library
+                    // Compress using Zstd library, directly into the message bytes field
                     const size_t src_size = N * sizeof(int32_t);
-                    compression_buffer.resize(ZSTD_compressBound(src_size));
+                    auto raw_coordinates = contour_set->mutable_raw_coordinates();
+                    raw_coordinates->resize(ZSTD_compressBound(src_size));
                     size_t compressed_size = ZSTD_compress(
-                        compression_buffer.data(), compression_buffer.size(), vertices_shuffled.data(), src_size, compression_level);
-
-                    contour_set->set_raw_coordinates(compression_buffer.data(), compressed_size);
+                        raw_coordinates->data(), raw_coordinates->size(), vertices_shuffled.data(), src_size, compression_level);
+                    raw_coordinates->resize(compressed_size);
                     contour_set->set_raw_start_indices(indices.data(), indices.size() * sizeof(int32_t));
                     contour_set->set_uncompressed_coordinates_size(src_size);
                     contour_set->set_decimation_factor(pixel_rounding);
                 }
             }
+            if (!cache_key.empty()) {
+                std::unique_lock<std::mutex> ulock(cache_entry_mutex);
+                if (cache_entry && cache_entry->size < CONTOUR_CACHE_SIZE_MB * 1024 * 1024) {
+                    cache_entry->Add(progress, *contour_set);
+                } else {
+                    // Too large to cache
+                    cache_entry.reset();
+                }
+            }
             // Only use deflate compression if contours don't have ZSTD compression
             SendFileEvent(partial_response.file_id(), CARTA::EventType::CONTOUR_IMAGE_DATA, 0, partial_response, compression_level < 1);
+            arena.Reset();
         };
 
-        if (frame->ContourImage(callback)) {
+        if (frame->ContourImage(z, stokes, callback)) {
+            if (!cache_key.empty()) {
+                _contour_cache.Put(cache_key, cache_entry);
+            }
             return true;
         }
+        if (z != frame->CurrentZ() || stokes != frame->CurrentStokes()) {
+            // Superseded by the contours for the new plane
+            return false;
+        }
         SendLogEvent("Error processing contours", {"contours"}, CARTA::ErrorSeverity::WARNING);
     }
     return false;
@@ -1967,38 +2031,111 @@ void Session::SendEvent(CARTA::EventType event_type, uint32_t event_id, const go
 
     size_t message_length = message.ByteSizeLong();
     size_t required_size = message_length + sizeof(EventHeader);
-    std::pair<std::vector<char>, bool> msg_vs_compress;
-    std::vector<char>& msg = msg_vs_compress.first;
-    msg.resize(required_size, 0);
-    EventHeader* head = (EventHeader*)msg.data();
+    // Skip compression on files smaller than 1 kB
+    compress = compress && required_size > 1024;
+    int zstd_level = _message_zstd_level;
+    bool zstd_compress = compress && zstd_level > 0;
+
+    // Leave room for the header of the zstd envelope before the message
+    size_t offset = zstd_compress ? sizeof(EventHeader) : 0;
+    OutboundMessage outbound_message;
+    std::vector<char>& msg = outbound_message.data;
+    msg.resize(offset + required_size, 0);
+    EventHeader* head = (EventHeader*)(msg.data() + offset);
 
     head->type = event_type;
     head->icd_version = ICD_VERSION;
     head->request_id = event_id;
-    message.SerializeToArray(msg.data() + sizeof(EventHeader), message_length);
-    // Skip compression on files smaller than 1 kB
-    msg_vs_compress.second = compress && required_size > 1024;
-    _out_msgs.push(msg_vs_compress);
-    // spdlog::debug("***** Queued message type={} queue size={}", event_type, _out_msgs.size());
+    message.SerializeToArray(msg.data() + offset + sizeof(EventHeader), message_length);
+    outbound_message.compress = compress && !zstd_compress;
+    if (zstd_compress) {
+        // Compress here on the sending (worker) thread rather than with deflate on the loop thread
+        EventHeader* envelope = (EventHeader*)msg.data();
+        envelope->type = ZSTD_COMPRESSED_EVENT_TYPE;
+        envelope->icd_version = ICD_VERSION;
+        envelope->request_id = event_id;
+        if (!ZstdCompressPayload(msg, sizeof(EventHeader), zstd_level)) {
+            // Send incompressible messages as they are
+            msg.erase(msg.begin(), msg.begin() + sizeof(EventHeader));
+        }
+    }
+    outbound_message.event_type = event_type;
+    outbound_message.batch = _batch_messages;
+    outbound_message.supersede_key = OutboundQueue::SupersedeKey(event_type, message);
+    _out_msgs.Push(std::move(outbound_message));
 
     // uWS::Loop::defer(function) is the only thread-safe function.
     // Use it to defer the calling of a function to the thread that runs the Loop.
     if (_loop && _socket) {
-        _loop->defer([&]() {
-            std::pair<std::vector<char>, bool> msg;
-            if (_connected) {
-                while (_out_msgs.try_pop(msg)) {
-                    std::string_view sv(msg.first.data(), msg.first.size());
-                    _socket->cork([&]() {
-                        auto status = _socket->send(sv, uWS::OpCode::BINARY, msg.second);
-                        if (status == uWS::WebSocket<false, true, PerSocketData>::DROPPED) {
-                            spdlog::error("Failed to send message of size {} kB", sv.size() / 1024.0);
-                        }
-                    });
-                }
+        _loop->defer([&]() { FlushOutboundQueue(); });
+    }
+}
+
+void Session::FlushOutboundQueue() {
+    if (!_connected) {
+        return;
+    }
+
+    auto send_frame = [&](std::string_view sv, bool compress) {
+        _socket->cork([&]() {
+            auto status = _socket->send(sv, uWS::OpCode::BINARY, compress);
+            if (status == uWS::WebSocket<false, true, PerSocketData>::DROPPED) {
+                spdlog::error("Failed to send message of size {} kB", sv.size() / 1024.0);
             }
         });
+    };
+
+    OutboundMessage msg;
+    OutboundBatch batch;
+    while (_out_msgs.Pop(msg, _socket->getBufferedAmount())) {
+        if (!msg.batch) {
+            // Preserve order with any batch so far
+            if (!batch.Empty()) {
+                send_frame(batch.Frame(), batch.Compress());
+                batch.Clear();
+            }
+            send_frame(std::string_view(msg.data.data(), msg.data.size()), msg.compress);
+        } else if (!batch.Add(msg)) {
+            // Batch is full or compression setting changed: one frame (and one compression pass) for the batch so far
+            send_frame(batch.Frame(), batch.Compress());
+            batch.Clear();
+            batch.Add(msg);
+        }
+    }
+    if (!batch.Empty()) {
+        send_frame(batch.Frame(), batch.Compress());
     }
+    _out_msgs.SetBufferedAmount(_socket->getBufferedAmount());
+}
+
+void Session::OnDrain() {
+    FlushOutboundQueue();
+}
+
+bool Session::QueueInboundMessage(std::vector<char>&& message) {
+    std::unique_lock<std::mutex> ulock(_inbound_mutex);
+    _inbound_msgs.push_back(std::move(message));
+    if (_dispatch_active) {
+        return false;
+    }
+    _dispatch_active = true;
+    return true;
+}
+
+bool Session::PopInboundMessage(std::vector<char>& message) {
+    std::unique_lock<std::mutex> ulock(_inbound_mutex);
+    if (_inbound_msgs.empty()) {
+        _dispatch_active = false;
+        return false;
+    }
+    message = std::move(_inbound_msgs.front());
+    _inbound_msgs.pop_front();
+    return true;
+}
+
+void Session::UnpopInboundMessage(std::vector<char>&& message) {
+    std::unique_lock<std::mutex> ulock(_inbound_mutex);
+    _inbound_msgs.push_front(std::move(message));
 }
 
 void Session::SendFileEvent(
@@ -12,6 +12,7 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <list>
 #include <map>
 #include <mutex>
 #include <tuple>
@@ -24,12 +25,14 @@
 #include <casacore/casa/aips.h>
 
 #include "AnimationObject.h"
+#include "Cache/ContourCache.h"
 #include "Cache/LoaderCache.h"
 #include "CursorSettings.h"
 #include "FileList/FileListHandler.h"
 #include "Frame/Frame.h"
 #include "ImageData/StokesFilesConnector.h"
 #include "Main/ProgramSettings.h"
+#include "OutboundQueue.h"
 #include "Region/RegionHandler.h"
 #include "SessionContext.h"
 #include "Table/TableController.h"
@@ -39,6 +42,7 @@
 #define HISTOGRAM_CANCEL -1.0
 #define UPDATE_HISTOGRAM_PROGRESS_PER_SECONDS 2.0
 #define LOADER_CACHE_SIZE 25
+#define MESSAGE_ZSTD_LEVEL 1 // 1-3: fast enough to replace permessage-deflate
 
 namespace carta {
 
@@ -220,6 +224,19 @@ public:
 
     // Close cached image if it has been updated
     void CloseCachedImage(const std::string& directory, const std::string& file);
+
+    // Socket backpressure has been drained; called on the uWS loop thread
+    void OnDrain();
+
+    // Incoming messages are handled in order by one dispatch task at a time. Returns true if a new dispatch task is needed.
+    bool QueueInboundMessage(std::vector<char>&& message);
+    // Returns false (and ends the dispatch task) if no messages are waiting
+    bool PopInboundMessage(std::vector<char>& message);
+    // Put a popped message back at the front, for the dispatch task which continues on another thread pool
+    void UnpopInboundMessage(std::vector<char>&& message);
+    OutboundStats GetOutboundStats() {
+        return _out_msgs.Stats();
+    }
     bool AnimationActive() {
         return _animation_active;
     }
@@ -269,6 +286,8 @@ protected:
     void SendFileEvent(
         int file_id, CARTA::EventType event_type, u_int32_t event_id, google::protobuf::MessageLite& message, bool compress = true);
     void SendLogEvent(const std::string& message, std::vector<std::string> tags, CARTA::ErrorSeverity severity);
+    // Write queued messages to the socket until its buffered amount exceeds the outbound budget; runs on the uWS loop thread
+    void FlushOutboundQueue();
 
     // uWebSockets
     uWS::WebSocket<false, true, PerSocketData>* _socket;
@@ -310,8 +329,17 @@ protected:
     // Cube histogram progress: 0.0 to 1.0 (complete)
     float _histogram_progress;
 
-    // message queue <msg, compress>
-    concurrent_queue<std::pair<std::vector<char>, bool>> _out_msgs;
+    // Incoming messages waiting to be parsed and handled
+    std::list<std::vector<char>> _inbound_msgs;
+    std::mutex _inbound_mutex;
+    bool _dispatch_active;
+
+    // Outbound message queue with a per-session byte budget
+    OutboundQueue _out_msgs;
+    // Pack queued messages into batched frames (negotiated at REGISTER_VIEWER)
+    std::atomic<bool> _batch_messages;
+    // zstd level for compressing messages before queueing, 0 to use permessage-deflate (negotiated at REGISTER_VIEWER)
+    std::atomic<int> _message_zstd_level;
 
     // context that enables all tasks associated with a session to be cancelled.
     SessionContext _base_context;
@@ -330,6 +358,8 @@ protected:
     static bool _exit_when_all_sessions_closed;
     static bool _controller_deployment;
     static std::thread* _animation_thread;
+    // Encoded contours shared by all sessions
+    static ContourCache _contour_cache;
 
     // Callbacks for scripting responses from the frontend
     std::unordered_map<int, std::tuple<ScriptingResponseCallback, ScriptingSessionClosedCallback>> _scripting_callbacks;
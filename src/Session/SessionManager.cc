@@ -8,13 +8,19 @@
 #include "Logger/Logger.h"
 #include "OnMessageTask.h"
 #include "ThreadingManager/ThreadingManager.h"
+#include "Timer/Timer.h"
 #include "Util/Message.h"
 #include "Util/Token.h"
 
 namespace carta {
 
 SessionManager::SessionManager(ProgramSettings& settings, std::string auth_token, std::shared_ptr<FileListHandler> file_list_handler)
-    : _session_number(0), _app(uWS::App()), _settings(settings), _auth_token(auth_token), _file_list_handler(file_list_handler) {}
+    : _session_number(0),
+      _app(uWS::App()),
+      _settings(settings),
+      _auth_token(auth_token),
+      _file_list_handler(file_list_handler),
+      _loop_latency("uWS loop") {}
 
 void SessionManager::DeleteSession(uint32_t session_id) {
     std::unique_lock<std::mutex> ulock(_sessions_mutex);
@@ -125,12 +131,15 @@ void SessionManager::OnDrain(WSType* ws) {
         auto session = _sessions.at(session_id);
         spdlog::debug("Draining WebSocket backpressure: client {} [{}]. Remaining buffered amount: {} (bytes).", session->GetId(),
             session->GetAddress(), ws->getBufferedAmount());
+        // Resume writing messages held back while the socket buffer was over budget
+        session->OnDrain();
     } catch (const std::out_of_range& e) {
         spdlog::debug("Draining WebSocket backpressure: unknown client. Remaining buffered amount: {} (bytes).", ws->getBufferedAmount());
     }
 }
 
 void SessionManager::OnMessage(WSType* ws, std::string_view sv_message, uWS::OpCode op_code) {
+    Timer t;
     uint32_t session_id = static_cast<PerSocketData*>(ws->getUserData())->session_id;
     Session* session;
     try {
@@ -144,393 +153,16 @@ void SessionManager::OnMessage(WSType* ws, std::string_view sv_message, uWS::OpC
         if (sv_message.length() >= sizeof(EventHeader)) {
             session->UpdateLastMessageTimestamp();
 
-            EventHeader head = *reinterpret_cast<const EventHeader*>(sv_message.data());
-            const char* event_buf = sv_message.data() + sizeof(EventHeader);
-            int event_length = sv_message.length() - sizeof(EventHeader);
-
-            CARTA::EventType event_type = static_cast<CARTA::EventType>(head.type);
-            logger::LogReceivedEventType(event_type);
-
-            auto event_type_name = CARTA::EventType_Name(CARTA::EventType(event_type));
-
-            bool message_parsed(false);
-            OnMessageTask* tsk = nullptr;
-
-            switch (event_type) {
-                case CARTA::EventType::REGISTER_VIEWER: {
-                    CARTA::RegisterViewer message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnRegisterViewer(message, head.icd_version, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::RESUME_SESSION: {
-                    CARTA::ResumeSession message;
-                    spdlog::debug("({})({}) resuming session", fmt::ptr(session), session->GetId());
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnResumeSession(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_IMAGE_CHANNELS: {
-                    CARTA::SetImageChannels message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->ImageChannelLock(message.file_id());
-                        if (!session->ImageChannelTaskTestAndSet(message.file_id())) {
-                            tsk = new SetImageChannelsTask(session, message.file_id());
-                        }
-                        // has its own queue to keep channels in order during animation
-                        session->AddToSetChannelQueue(message, head.request_id);
-                        session->ImageChannelUnlock(message.file_id());
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_CURSOR: {
-                    CARTA::SetCursor message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->AddCursorSetting(message, head.request_id);
-                        tsk = new SetCursorTask(session, message.file_id());
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_HISTOGRAM_REQUIREMENTS: {
-                    CARTA::SetHistogramRequirements message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        if (message.histograms_size() == 0) {
-                            session->CancelSetHistRequirements();
-                        } else {
-                            session->ResetHistContext();
-                            tsk = new GeneralMessageTask<CARTA::SetHistogramRequirements>(session, message, head.request_id);
-                        }
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CLOSE_FILE: {
-                    CARTA::CloseFile message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnCloseFile(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::START_ANIMATION: {
-                    CARTA::StartAnimation message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->CancelExistingAnimation();
-                        tsk = new StartAnimationTask(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_ANIMATION: {
-                    CARTA::StopAnimation message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->StopAnimation(message.file_id(), message.end_frame());
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::ANIMATION_FLOW_CONTROL: {
-                    CARTA::AnimationFlowControl message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->HandleAnimationFlowControlEvt(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::FILE_INFO_REQUEST: {
-                    CARTA::FileInfoRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnFileInfoRequest(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::OPEN_FILE: {
-                    CARTA::OpenFile message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        if (!message.lel_expr()) {
-                            for (auto& session_map : _sessions) {
-                                session_map.second->CloseCachedImage(message.directory(), message.file());
-                            }
-                        }
-                        session->OnOpenFile(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::ADD_REQUIRED_TILES: {
-                    CARTA::AddRequiredTiles message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::AddRequiredTiles>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::REGION_FILE_INFO_REQUEST: {
-                    CARTA::RegionFileInfoRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnRegionFileInfoRequest(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::IMPORT_REGION: {
-                    CARTA::ImportRegion message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnImportRegion(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::EXPORT_REGION: {
-                    CARTA::ExportRegion message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnExportRegion(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_CONTOUR_PARAMETERS: {
-                    CARTA::SetContourParameters message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::SetContourParameters>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SCRIPTING_RESPONSE: {
-                    CARTA::ScriptingResponse message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnScriptingResponse(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_REGION: {
-                    CARTA::SetRegion message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnSetRegion(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::REMOVE_REGION: {
-                    CARTA::RemoveRegion message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnRemoveRegion(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_SPECTRAL_REQUIREMENTS: {
-                    CARTA::SetSpectralRequirements message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnSetSpectralRequirements(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CATALOG_FILE_INFO_REQUEST: {
-                    CARTA::CatalogFileInfoRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnCatalogFileInfo(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::OPEN_CATALOG_FILE: {
-                    CARTA::OpenCatalogFile message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnOpenCatalogFile(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CLOSE_CATALOG_FILE: {
-                    CARTA::CloseCatalogFile message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnCloseCatalogFile(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CATALOG_FILTER_REQUEST: {
-                    CARTA::CatalogFilterRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnCatalogFilter(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_MOMENT_CALC: {
-                    CARTA::StopMomentCalc message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnStopMomentCalc(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SAVE_FILE: {
-                    CARTA::SaveFile message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnSaveFile(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CONCAT_STOKES_FILES: {
-                    CARTA::ConcatStokesFiles message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnConcatStokesFiles(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_FILE_LIST: {
-                    CARTA::StopFileList message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        if (message.file_list_type() == CARTA::Image) {
-                            session->StopImageFileList();
-                        } else {
-                            session->StopCatalogFileList();
-                        }
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_SPATIAL_REQUIREMENTS: {
-                    CARTA::SetSpatialRequirements message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::SetSpatialRequirements>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_STATS_REQUIREMENTS: {
-                    CARTA::SetStatsRequirements message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::SetStatsRequirements>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::MOMENT_REQUEST: {
-                    CARTA::MomentRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::MomentRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::FILE_LIST_REQUEST: {
-                    CARTA::FileListRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::FileListRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::REGION_LIST_REQUEST: {
-                    CARTA::RegionListRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::RegionListRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CATALOG_LIST_REQUEST: {
-                    CARTA::CatalogListRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::CatalogListRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::PV_REQUEST: {
-                    CARTA::PvRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        if (message.has_preview_settings()) {
-                            session->StopPvPreviewUpdates(message.preview_settings().preview_id());
-                        }
-                        tsk = new GeneralMessageTask<CARTA::PvRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_PV_CALC: {
-                    CARTA::StopPvCalc message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnStopPvCalc(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::FITTING_REQUEST: {
-                    CARTA::FittingRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::FittingRequest>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::SET_VECTOR_OVERLAY_PARAMETERS: {
-                    CARTA::SetVectorOverlayParameters message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        tsk = new GeneralMessageTask<CARTA::SetVectorOverlayParameters>(session, message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_FITTING: {
-                    CARTA::StopFitting message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnStopFitting(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::STOP_PV_PREVIEW: {
-                    CARTA::StopPvPreview message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnStopPvPreview(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::CLOSE_PV_PREVIEW: {
-                    CARTA::ClosePvPreview message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnClosePvPreview(message);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                case CARTA::EventType::REMOTE_FILE_REQUEST: {
-                    CARTA::RemoteFileRequest message;
-                    if (message.ParseFromArray(event_buf, event_length)) {
-                        session->OnRemoteFileRequest(message, head.request_id);
-                        message_parsed = true;
-                    }
-                    break;
-                }
-                default: {
-                    spdlog::warn("Bad event type {}!", event_type);
-                    break;
-                }
-            }
-
-            if (!message_parsed) {
-                spdlog::warn("Bad {} message!", event_type_name);
-            }
-
-            if (tsk) {
-                ThreadManager::QueueTask(tsk);
+            // Only copy the message here; parsing and handling is done on a dispatch thread, in order for each session
+            auto message = AcquireBuffer(sv_message.length());
+            std::copy(sv_message.begin(), sv_message.end(), message.begin());
+            auto event_type = static_cast<CARTA::EventType>(reinterpret_cast<const EventHeader*>(message.data())->type);
+            if (IsCancelEvent(event_type)) {
+                // Cancellations only set flags, and must not wait behind the requests they cancel
+                HandleMessage(session, message);
+                ReleaseBuffer(std::move(message));
+            } else if (session->QueueInboundMessage(std::move(message))) {
+                ThreadManager::QueueDispatchTask(new DispatchMessagesTask(session, this));
             }
         }
     } else if (op_code == uWS::OpCode::TEXT) {
@@ -546,6 +178,460 @@ void SessionManager::OnMessage(WSType* ws, std::string_view sv_message, uWS::OpC
             }
         }
     }
+
+    _loop_latency.Add(t.Elapsed());
+    if (_loop_latency.Count() >= LOOP_LATENCY_REPORT_COUNT) {
+        spdlog::performance("Loop thread message handling: {}", _loop_latency.Summary());
+        _loop_latency.Reset();
+    }
+}
+
+bool SessionManager::IsLongRunningEvent(CARTA::EventType event_type) {
+    switch (event_type) {
+        case CARTA::EventType::RESUME_SESSION:
+        case CARTA::EventType::FILE_INFO_REQUEST:
+        case CARTA::EventType::OPEN_FILE:
+        case CARTA::EventType::REGION_FILE_INFO_REQUEST:
+        case CARTA::EventType::IMPORT_REGION:
+        case CARTA::EventType::EXPORT_REGION:
+        case CARTA::EventType::SET_REGION:
+        case CARTA::EventType::CATALOG_FILE_INFO_REQUEST:
+        case CARTA::EventType::OPEN_CATALOG_FILE:
+        case CARTA::EventType::CATALOG_FILTER_REQUEST:
+        case CARTA::EventType::CONCAT_STOKES_FILES:
+        case CARTA::EventType::REMOTE_FILE_REQUEST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool SessionManager::IsCancelEvent(CARTA::EventType event_type) {
+    switch (event_type) {
+        case CARTA::EventType::STOP_MOMENT_CALC:
+        case CARTA::EventType::STOP_FILE_LIST:
+        case CARTA::EventType::STOP_PV_CALC:
+        case CARTA::EventType::STOP_FITTING:
+        case CARTA::EventType::STOP_PV_PREVIEW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void SessionManager::HandleMessage(Session* session, const std::vector<char>& raw_message) {
+    EventHeader head = *reinterpret_cast<const EventHeader*>(raw_message.data());
+    const char* event_buf = raw_message.data() + sizeof(EventHeader);
+    int event_length = raw_message.size() - sizeof(EventHeader);
+
+    CARTA::EventType event_type = static_cast<CARTA::EventType>(head.type);
+    logger::LogReceivedEventType(event_type);
+
+    auto event_type_name = CARTA::EventType_Name(CARTA::EventType(event_type));
+
+    bool message_parsed(false);
+    OnMessageTask* tsk = nullptr;
+
+    switch (event_type) {
+        case CARTA::EventType::REGISTER_VIEWER: {
+            CARTA::RegisterViewer message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnRegisterViewer(message, head.icd_version, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::RESUME_SESSION: {
+            CARTA::ResumeSession message;
+            spdlog::debug("({})({}) resuming session", fmt::ptr(session), session->GetId());
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnResumeSession(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_IMAGE_CHANNELS: {
+            CARTA::SetImageChannels message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->ImageChannelLock(message.file_id());
+                if (!session->ImageChannelTaskTestAndSet(message.file_id())) {
+                    tsk = new SetImageChannelsTask(session, message.file_id());
+                }
+                // has its own queue to keep channels in order during animation
+                session->AddToSetChannelQueue(message, head.request_id);
+                session->ImageChannelUnlock(message.file_id());
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_CURSOR: {
+            CARTA::SetCursor message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->AddCursorSetting(message, head.request_id);
+                tsk = new SetCursorTask(session, message.file_id());
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_HISTOGRAM_REQUIREMENTS: {
+            CARTA::SetHistogramRequirements message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                if (message.histograms_size() == 0) {
+                    session->CancelSetHistRequirements();
+                } else {
+                    session->ResetHistContext();
+                    tsk = new GeneralMessageTask<CARTA::SetHistogramRequirements>(session, message, head.request_id);
+                }
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CLOSE_FILE: {
+            CARTA::CloseFile message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnCloseFile(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::START_ANIMATION: {
+            CARTA::StartAnimation message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->CancelExistingAnimation();
+                tsk = new StartAnimationTask(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_ANIMATION: {
+            CARTA::StopAnimation message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->StopAnimation(message.file_id(), message.end_frame());
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::ANIMATION_FLOW_CONTROL: {
+            CARTA::AnimationFlowControl message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->HandleAnimationFlowControlEvt(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::FILE_INFO_REQUEST: {
+            CARTA::FileInfoRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnFileInfoRequest(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::OPEN_FILE: {
+            CARTA::OpenFile message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                if (!message.lel_expr()) {
+                    std::unique_lock<std::mutex> ulock(_sessions_mutex);
+                    for (auto& session_map : _sessions) {
+                        session_map.second->CloseCachedImage(message.directory(), message.file());
+                    }
+                }
+                session->OnOpenFile(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::ADD_REQUIRED_TILES: {
+            CARTA::AddRequiredTiles message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::AddRequiredTiles>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::REGION_FILE_INFO_REQUEST: {
+            CARTA::RegionFileInfoRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnRegionFileInfoRequest(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::IMPORT_REGION: {
+            CARTA::ImportRegion message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnImportRegion(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::EXPORT_REGION: {
+            CARTA::ExportRegion message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnExportRegion(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_CONTOUR_PARAMETERS: {
+            CARTA::SetContourParameters message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::SetContourParameters>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SCRIPTING_RESPONSE: {
+            CARTA::ScriptingResponse message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnScriptingResponse(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_REGION: {
+            CARTA::SetRegion message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnSetRegion(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::REMOVE_REGION: {
+            CARTA::RemoveRegion message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnRemoveRegion(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_SPECTRAL_REQUIREMENTS: {
+            CARTA::SetSpectralRequirements message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnSetSpectralRequirements(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CATALOG_FILE_INFO_REQUEST: {
+            CARTA::CatalogFileInfoRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnCatalogFileInfo(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::OPEN_CATALOG_FILE: {
+            CARTA::OpenCatalogFile message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnOpenCatalogFile(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CLOSE_CATALOG_FILE: {
+            CARTA::CloseCatalogFile message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnCloseCatalogFile(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CATALOG_FILTER_REQUEST: {
+            CARTA::CatalogFilterRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnCatalogFilter(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_MOMENT_CALC: {
+            CARTA::StopMomentCalc message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnStopMomentCalc(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SAVE_FILE: {
+            CARTA::SaveFile message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::SaveFile>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CONCAT_STOKES_FILES: {
+            CARTA::ConcatStokesFiles message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnConcatStokesFiles(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_FILE_LIST: {
+            CARTA::StopFileList message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                if (message.file_list_type() == CARTA::Image) {
+                    session->StopImageFileList();
+                } else {
+                    session->StopCatalogFileList();
+                }
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_SPATIAL_REQUIREMENTS: {
+            CARTA::SetSpatialRequirements message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::SetSpatialRequirements>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_STATS_REQUIREMENTS: {
+            CARTA::SetStatsRequirements message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::SetStatsRequirements>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::MOMENT_REQUEST: {
+            CARTA::MomentRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::MomentRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::FILE_LIST_REQUEST: {
+            CARTA::FileListRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::FileListRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::REGION_LIST_REQUEST: {
+            CARTA::RegionListRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::RegionListRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CATALOG_LIST_REQUEST: {
+            CARTA::CatalogListRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::CatalogListRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::PV_REQUEST: {
+            CARTA::PvRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                if (message.has_preview_settings()) {
+                    session->StopPvPreviewUpdates(message.preview_settings().preview_id());
+                }
+                tsk = new GeneralMessageTask<CARTA::PvRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_PV_CALC: {
+            CARTA::StopPvCalc message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnStopPvCalc(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::FITTING_REQUEST: {
+            CARTA::FittingRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::FittingRequest>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::SET_VECTOR_OVERLAY_PARAMETERS: {
+            CARTA::SetVectorOverlayParameters message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                tsk = new GeneralMessageTask<CARTA::SetVectorOverlayParameters>(session, message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_FITTING: {
+            CARTA::StopFitting message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnStopFitting(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::STOP_PV_PREVIEW: {
+            CARTA::StopPvPreview message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnStopPvPreview(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::CLOSE_PV_PREVIEW: {
+            CARTA::ClosePvPreview message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnClosePvPreview(message);
+                message_parsed = true;
+            }
+            break;
+        }
+        case CARTA::EventType::REMOTE_FILE_REQUEST: {
+            CARTA::RemoteFileRequest message;
+            if (message.ParseFromArray(event_buf, event_length)) {
+                session->OnRemoteFileRequest(message, head.request_id);
+                message_parsed = true;
+            }
+            break;
+        }
+        default: {
+            spdlog::warn("Bad event type {}!", event_type);
+            break;
+        }
+    }
+
+    if (!message_parsed) {
+        spdlog::warn("Bad {} message!", event_type_name);
+    }
+
+    if (tsk) {
+        ThreadManager::QueueTask(tsk);
+    }
+}
+
+std::vector<char> SessionManager::AcquireBuffer(size_t size) {
+    std::vector<char> buffer;
+    {
+        std::unique_lock<std::mutex> ulock(_buffer_pool_mutex);
+        if (!_buffer_pool.empty()) {
+            buffer = std::move(_buffer_pool.back());
+            _buffer_pool.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void SessionManager::ReleaseBuffer(std::vector<char>&& buffer) {
+    if (buffer.capacity() > MAX_POOLED_BUFFER_SIZE) {
+        return;
+    }
+    std::unique_lock<std::mutex> ulock(_buffer_pool_mutex);
+    if (_buffer_pool.size() < MAX_POOLED_BUFFERS) {
+        _buffer_pool.push_back(std::move(buffer));
+    }
 }
 
 void SessionManager::Listen(std::string host, std::vector<int> ports, int default_port, int& port) {
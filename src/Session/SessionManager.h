@@ -12,8 +12,12 @@
 
 #include "Main/ProgramSettings.h"
 #include "Session.h"
+#include "Timer/LatencyHistogram.h"
 
 #define MAX_SOCKET_PORT_TRIALS 100
+#define MAX_POOLED_BUFFERS 64
+#define MAX_POOLED_BUFFER_SIZE 1024 * 1024
+#define LOOP_LATENCY_REPORT_COUNT 1000
 
 namespace carta {
 class SessionManager {
@@ -27,8 +31,18 @@ public:
     // Called on disconnect. Cleans up sessions. In future, we may want to delay this (in case of unintentional disconnects)
     void OnDisconnect(WSType* ws, int code, std::string_view message);
     void OnDrain(WSType* ws);
-    // Forward message requests to session callbacks after parsing message into relevant ProtoBuf message
+    // Queue binary messages for the session's dispatch task; runs on the uWS loop thread
     void OnMessage(WSType* ws, std::string_view sv_message, uWS::OpCode op_code);
+    // Forward message requests to session callbacks after parsing message into relevant ProtoBuf message; runs on a dispatch thread
+    void HandleMessage(Session* session, const std::vector<char>& raw_message);
+    // Cancellation requests, handled on the loop thread ahead of any queued messages
+    static bool IsCancelEvent(CARTA::EventType event_type);
+    // Requests handled synchronously which may take long (file and catalog access, region import and export), run on the
+    // event-handling worker threads so that they do not hold up the dispatch threads shared by all sessions
+    static bool IsLongRunningEvent(CARTA::EventType event_type);
+    // Pool of buffers for copying incoming messages off the loop thread
+    std::vector<char> AcquireBuffer(size_t size);
+    void ReleaseBuffer(std::vector<char>&& buffer);
     void Listen(std::string host, std::vector<int> ports, int default_port, int& port);
     uWS::App& App();
     void RunApp();
@@ -48,6 +62,11 @@ private:
     ProgramSettings& _settings;
     std::string _auth_token;
     std::shared_ptr<FileListHandler> _file_list_handler;
+    // Incoming message buffers
+    std::vector<std::vector<char>> _buffer_pool;
+    std::mutex _buffer_pool_mutex;
+    // Time spent on the loop thread per incoming message
+    LatencyHistogram _loop_latency;
 
     std::string IPAsText(std::string_view binary);
 };
@@ -6,6 +6,8 @@
 
 #include "ThreadingManager.h"
 
+#include <algorithm>
+
 namespace carta {
 int ThreadManager::_omp_thread_count = 0;
 std::list<OnMessageTask*> ThreadManager::_task_queue;
@@ -13,6 +15,9 @@ std::mutex ThreadManager::_task_queue_mtx;
 std::condition_variable ThreadManager::_task_queue_cv;
 volatile bool ThreadManager::_has_exited = false;
 std::list<std::thread*> ThreadManager::_workers;
+std::list<OnMessageTask*> ThreadManager::_dispatch_queue;
+std::mutex ThreadManager::_dispatch_queue_mtx;
+std::condition_variable ThreadManager::_dispatch_queue_cv;
 
 void ThreadManager::ApplyThreadLimit() {
     // Skip application if we are already inside an OpenMP parallel block
@@ -38,38 +43,50 @@ void ThreadManager::QueueTask(OnMessageTask* tsk) {
     _task_queue_cv.notify_one();
 }
 
-void ThreadManager::StartEventHandlingThreads(int num_threads) {
-    auto thread_lambda = []() {
-        OnMessageTask* tsk;
-
-        do {
-            std::unique_lock<std::mutex> lock(_task_queue_mtx);
-
-            if (_task_queue.empty()) {
-                _task_queue_cv.wait(lock);
-            } else {
-                tsk = _task_queue.front();
-                _task_queue.pop_front();
-                lock.unlock();
-                tsk->execute();
-                delete tsk;
-            }
-
-            if (_has_exited) {
-                return;
-            }
-        } while (true);
-    };
+void ThreadManager::QueueDispatchTask(OnMessageTask* tsk) {
+    std::unique_lock<std::mutex> lock(_dispatch_queue_mtx);
+    _dispatch_queue.push_back(tsk);
+    _dispatch_queue_cv.notify_one();
+}
+
+void ThreadManager::RunTasks(std::list<OnMessageTask*>& queue, std::mutex& queue_mtx, std::condition_variable& queue_cv) {
+    OnMessageTask* tsk;
+
+    do {
+        std::unique_lock<std::mutex> lock(queue_mtx);
+
+        if (queue.empty()) {
+            queue_cv.wait(lock);
+        } else {
+            tsk = queue.front();
+            queue.pop_front();
+            lock.unlock();
+            tsk->execute();
+            delete tsk;
+        }
 
+        if (_has_exited) {
+            return;
+        }
+    } while (true);
+}
+
+void ThreadManager::StartEventHandlingThreads(int num_threads, int num_dispatch_threads) {
     // Start worker threads
     for (int i = 0; i < num_threads; i++) {
-        _workers.push_back(new std::thread(thread_lambda));
+        _workers.push_back(new std::thread([]() { RunTasks(_task_queue, _task_queue_mtx, _task_queue_cv); }));
+    }
+
+    // Start message dispatch threads
+    for (int i = 0; i < std::max(num_dispatch_threads, 1); i++) {
+        _workers.push_back(new std::thread([]() { RunTasks(_dispatch_queue, _dispatch_queue_mtx, _dispatch_queue_cv); }));
     }
 }
 
 void ThreadManager::ExitEventHandlingThreads() {
     _has_exited = true;
     _task_queue_cv.notify_all();
+    _dispatch_queue_cv.notify_all();
 
     while (!_workers.empty()) {
         std::thread* thr = _workers.front();
@@ -29,13 +29,24 @@ class ThreadManager {
     static std::mutex _task_queue_mtx;
     static std::condition_variable _task_queue_cv;
     static std::list<std::thread*> _workers;
+    // Separate queue and threads for parsing and handling incoming messages, so that long-running
+    // data tasks do not delay control messages (and vice versa)
+    static std::list<OnMessageTask*> _dispatch_queue;
+    static std::mutex _dispatch_queue_mtx;
+    static std::condition_variable _dispatch_queue_cv;
     static volatile bool _has_exited;
 
+    static void RunTasks(std::list<OnMessageTask*>& queue, std::mutex& queue_mtx, std::condition_variable& queue_cv);
+
 public:
     static void ApplyThreadLimit();
     static void SetThreadLimit(int count);
-    static void StartEventHandlingThreads(int num_threads);
+    // Starts num_threads workers for data tasks and num_dispatch_threads for parsing and handling incoming messages, so the
+    // backend runs num_threads + num_dispatch_threads event threads in total (in addition to the OpenMP pool). Dispatch threads
+    // only run short handlers, and hand long-running requests to the workers.
+    static void StartEventHandlingThreads(int num_threads, int num_dispatch_threads);
     static void QueueTask(OnMessageTask*);
+    static void QueueDispatchTask(OnMessageTask*);
     static void ExitEventHandlingThreads();
 };
 
@@ -0,0 +1,57 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <spdlog/fmt/fmt.h>
+
+using namespace carta;
+
+LatencyHistogram::LatencyHistogram(const std::string& name) : _name(name) {
+    Reset();
+}
+
+void LatencyHistogram::Add(const TimeDelta& delta) {
+    double us = std::max(delta.us(), 0.0);
+    // Bin i holds durations in [2^(i-1), 2^i) us; bin 0 holds durations below 1 us
+    int bin = us < 1.0 ? 0 : static_cast<int>(std::floor(std::log2(us))) + 1;
+    ++_bins[std::min(bin, LATENCY_HISTOGRAM_BINS - 1)];
+    ++_count;
+    _total_us += us;
+    _max_us = std::max(_max_us, us);
+}
+
+void LatencyHistogram::Reset() {
+    _bins.fill(0);
+    _count = 0;
+    _total_us = 0.0;
+    _max_us = 0.0;
+}
+
+double LatencyHistogram::Percentile(double fraction) const {
+    if (!_count) {
+        return 0.0;
+    }
+
+    size_t target = std::ceil(std::clamp(fraction, 0.0, 1.0) * _count);
+    size_t accumulated(0);
+    for (int i = 0; i < LATENCY_HISTOGRAM_BINS; ++i) {
+        accumulated += _bins[i];
+        if (accumulated >= std::max(target, size_t(1))) {
+            return std::ldexp(1.0, i);
+        }
+    }
+    return _max_us;
+}
+
+std::string LatencyHistogram::Summary() const {
+    double mean = _count ? _total_us / _count : 0.0;
+    return fmt::format("{}: {} events, mean {:.1f} us, p50 < {:.0f} us, p90 < {:.0f} us, p99 < {:.0f} us, max {:.1f} us", _name, _count,
+        mean, Percentile(0.5), Percentile(0.9), Percentile(0.99), _max_us);
+}
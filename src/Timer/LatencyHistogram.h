@@ -0,0 +1,45 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// # LatencyHistogram.h: histogram of durations in power-of-two microsecond bins; not thread-safe
+
+#ifndef CARTA_SRC_TIMER_LATENCYHISTOGRAM_H_
+#define CARTA_SRC_TIMER_LATENCYHISTOGRAM_H_
+
+#include <array>
+#include <string>
+
+#include "Timer.h"
+
+#define LATENCY_HISTOGRAM_BINS 32
+
+namespace carta {
+
+class LatencyHistogram {
+public:
+    LatencyHistogram(const std::string& name);
+    ~LatencyHistogram() = default;
+
+    void Add(const TimeDelta& delta);
+    void Reset();
+    size_t Count() const {
+        return _count;
+    }
+    // Upper bound (us) of the bin containing the given fraction of events
+    double Percentile(double fraction) const;
+    std::string Summary() const;
+
+private:
+    std::string _name;
+    std::array<size_t, LATENCY_HISTOGRAM_BINS> _bins;
+    size_t _count;
+    double _total_us;
+    double _max_us;
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_TIMER_LATENCYHISTOGRAM_H_
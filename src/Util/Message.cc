@@ -692,6 +692,52 @@ CARTA::ListProgress Message::ListProgress(
     message.set_percentage(percentage);
     return message;
 }
+
+CARTA::RasterTileData* Message::RasterTileData(google::protobuf::Arena* arena, int32_t file_id, int32_t sync_id, int32_t animation_id) {
+    auto* message = google::protobuf::Arena::CreateMessage<CARTA::RasterTileData>(arena);
+    message->set_file_id(file_id);
+    message->set_sync_id(sync_id);
+    message->set_animation_id(animation_id);
+    return message;
+}
+
+CARTA::SpectralProfileData* Message::SpectralProfileData(google::protobuf::Arena* arena, int32_t stokes, float progress) {
+    auto* message = google::protobuf::Arena::CreateMessage<CARTA::SpectralProfileData>(arena);
+    message->set_stokes(stokes);
+    message->set_progress(progress);
+    return message;
+}
+
+CARTA::RegionStatsData* Message::RegionStatsData(
+    google::protobuf::Arena* arena, int32_t file_id, int32_t region_id, int32_t channel, int32_t stokes) {
+    auto* message = google::protobuf::Arena::CreateMessage<CARTA::RegionStatsData>(arena);
+    message->set_file_id(file_id);
+    message->set_region_id(region_id);
+    message->set_channel(channel);
+    message->set_stokes(stokes);
+    return message;
+}
+
+CARTA::ContourImageData* Message::ContourImageData(
+    google::protobuf::Arena* arena, int32_t file_id, uint32_t reference_file_id, int32_t channel, int32_t stokes, double progress) {
+    auto* message = google::protobuf::Arena::CreateMessage<CARTA::ContourImageData>(arena);
+    message->set_file_id(file_id);
+    message->set_reference_file_id(reference_file_id);
+    message->set_channel(channel);
+    message->set_stokes(stokes);
+    message->set_progress(progress);
+    return message;
+}
+
+carta::MessageArena::MessageArena() : _initial_block(MESSAGE_ARENA_BLOCK_SIZE), _arena(Options(_initial_block)) {}
+
+google::protobuf::ArenaOptions carta::MessageArena::Options(std::vector<char>& initial_block) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = initial_block.data();
+    options.initial_block_size = initial_block.size();
+    return options;
+}
+
 CARTA::RemoteFileRequest Message::RemoteFileRequest(int32_t file_id, const string& hips, const string& wcs, int32_t width, int32_t height,
     const string& projection, float fov, float ra, float dec, const string& coordsys, float rotation_angle, const string& object) {
     CARTA::RemoteFileRequest message;
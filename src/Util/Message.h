@@ -40,6 +40,8 @@
 #include <carta-protobuf/vector_overlay.pb.h>
 #include <carta-protobuf/vector_overlay_tile.pb.h>
 
+#include <google/protobuf/arena.h>
+
 #include <casacore/casa/Quanta/Quantum.h>
 
 #include "Image.h"
@@ -53,7 +55,47 @@ struct EventHeader {
     uint16_t icd_version;
     uint32_t request_id;
 };
+// Optional protocol extension negotiated at REGISTER_VIEWER: the client sets CLIENT_BATCHED_EVENTS_FLAG, and the server echoes
+// SERVER_BATCHED_EVENTS_FLAG if it will pack several messages into one frame. A batched frame starts with an EventHeader of type
+// BATCHED_EVENTS_EVENT_TYPE, followed by each message (with its own header) prefixed by its uint32_t length.
+// These values are not yet in the ICD (carta-protobuf enums.proto), so they are kept here, clear of the ICD EventType and feature
+// flag values, until it defines them.
+const uint16_t BATCHED_EVENTS_EVENT_TYPE = 1000;
+const uint32_t CLIENT_BATCHED_EVENTS_FLAG = 1 << 16;
+const uint32_t SERVER_BATCHED_EVENTS_FLAG = 1 << 16;
+// Optional protocol extension negotiated at REGISTER_VIEWER with CLIENT_ZSTD_EVENTS_FLAG and SERVER_ZSTD_EVENTS_FLAG: large
+// messages are zstd-compressed by the backend worker threads instead of using permessage-deflate. A compressed message is an
+// EventHeader of type ZSTD_COMPRESSED_EVENT_TYPE, with the request id of the original message, followed by a zstd frame of the
+// original message (with its own header). Also kept here until the ICD defines them.
+const uint16_t ZSTD_COMPRESSED_EVENT_TYPE = 1001;
+const uint32_t CLIENT_ZSTD_EVENTS_FLAG = 1 << 17;
+const uint32_t SERVER_ZSTD_EVENTS_FLAG = 1 << 17;
 struct HistogramConfig;
+
+#define MESSAGE_ARENA_BLOCK_SIZE 64 * 1024
+
+// Arena for building high-volume data stream messages (tiles, profiles, stats, contours). The initial block is kept across
+// Reset(), so a message built, sent and reset in a loop does not allocate for the message objects themselves.
+class MessageArena {
+public:
+    MessageArena();
+    MessageArena(const MessageArena&) = delete;
+    MessageArena& operator=(const MessageArena&) = delete;
+
+    google::protobuf::Arena* Get() {
+        return &_arena;
+    }
+    // Free all messages created on the arena; only call once they have been serialized
+    void Reset() {
+        _arena.Reset();
+    }
+
+private:
+    static google::protobuf::ArenaOptions Options(std::vector<char>& initial_block);
+
+    std::vector<char> _initial_block;
+    google::protobuf::Arena _arena;
+};
 } // namespace carta
 
 class Message {
@@ -154,6 +196,14 @@ public:
     static CARTA::ListProgress ListProgress(
         const CARTA::FileListType& file_list_type, int32_t total_count, int32_t checked_count, float percentage);
 
+    // Response messages allocated on an arena, which owns the returned message
+    static CARTA::RasterTileData* RasterTileData(google::protobuf::Arena* arena, int32_t file_id, int32_t sync_id, int32_t animation_id);
+    static CARTA::SpectralProfileData* SpectralProfileData(google::protobuf::Arena* arena, int32_t stokes, float progress);
+    static CARTA::RegionStatsData* RegionStatsData(
+        google::protobuf::Arena* arena, int32_t file_id, int32_t region_id, int32_t channel, int32_t stokes);
+    static CARTA::ContourImageData* ContourImageData(
+        google::protobuf::Arena* arena, int32_t file_id, uint32_t reference_file_id, int32_t channel, int32_t stokes, double progress);
+
     // Decode messages
     static CARTA::EventType EventType(std::vector<char>& message);
 
@@ -0,0 +1,62 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "Simd.h"
+
+#include <algorithm>
+
+namespace carta {
+
+std::atomic<int> Simd::_level_limit = static_cast<int>(SimdLevel::AVX512);
+
+static SimdLevel DetectSimdLevel() {
+#ifdef _ARM_ARCH_
+    return SimdLevel::SSE;
+#else
+    // The builtins also check that the operating system saves the extended registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    } else if (__builtin_cpu_supports("avx")) {
+        return SimdLevel::AVX;
+    }
+    return SimdLevel::SSE;
+#endif
+}
+
+SimdLevel Simd::HostLevel() {
+    static const SimdLevel host_level = DetectSimdLevel();
+    return host_level;
+}
+
+SimdLevel Simd::Level() {
+    return static_cast<SimdLevel>(std::min(static_cast<int>(HostLevel()), _level_limit.load(std::memory_order_relaxed)));
+}
+
+void Simd::SetLevelLimit(SimdLevel level) {
+    _level_limit = static_cast<int>(level);
+}
+
+std::string Simd::Name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512:
+            return "AVX-512";
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::AVX:
+            return "AVX";
+        default:
+#ifdef _ARM_ARCH_
+            return "NEON";
+#else
+            return "SSE4";
+#endif
+    }
+}
+
+} // namespace carta
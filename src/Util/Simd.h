@@ -0,0 +1,45 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef CARTA_SRC_UTIL_SIMD_H_
+#define CARTA_SRC_UTIL_SIMD_H_
+
+#include <atomic>
+#include <string>
+
+#ifdef _ARM_ARCH_
+#include <sse2neon/sse2neon.h>
+#else
+#include <x86intrin.h>
+
+// Kernels for instruction sets above the build baseline are compiled with these attributes, and only called after checking
+// Simd::Level() at runtime
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace carta {
+
+// Instruction sets with dispatched kernels, in increasing order. SSE is the baseline of every build (emulated with NEON on ARM).
+enum class SimdLevel { SSE = 0, AVX, AVX2, AVX512 };
+
+class Simd {
+    static std::atomic<int> _level_limit;
+
+public:
+    // Best instruction set supported by both the CPU and the operating system, detected once
+    static SimdLevel HostLevel();
+    // Instruction set used by dispatched kernels: the host level, unless a lower limit has been set
+    static SimdLevel Level();
+    // Limit the instruction set used by dispatched kernels, e.g. to compare kernels in benchmarks
+    static void SetLevelLimit(SimdLevel level);
+    static std::string Name(SimdLevel level);
+};
+
+} // namespace carta
+
+#endif // CARTA_SRC_UTIL_SIMD_H_
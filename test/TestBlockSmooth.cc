@@ -134,7 +134,7 @@ public:
         return std::move(scalar_result);
     }
 
-#ifdef __AVX__
+#ifndef _ARM_ARCH_
     Matrix2F DownsampleTileAVX(const Matrix2F& m, int downsample_factor) {
         int result_rows = ceil(m.nrow() / (float)(downsample_factor));
         int result_columns = ceil(m.ncolumn() / (float)(downsample_factor));
@@ -207,9 +207,12 @@ TEST_F(BlockSmoothingTest, TestSSEPerformance) {
 }
 #endif
 
-#ifdef __AVX__
+#ifndef _ARM_ARCH_
 
 TEST_F(BlockSmoothingTest, TestAVXAccuracy) {
+    if (Simd::HostLevel() < SimdLevel::AVX) {
+        GTEST_SKIP() << "AVX is not supported by this host";
+    }
     for (auto nan_fraction : nan_fractions) {
         for (auto i = 0; i < NUM_ITERS; i++) {
             auto m1 = RandomMatrix(size_random(mt), size_random(mt), nan_fraction);
@@ -232,6 +235,9 @@ TEST_F(BlockSmoothingTest, TestAVXAccuracy) {
 
 #ifdef COMPILE_PERFORMANCE_TESTS
 TEST_F(BlockSmoothingTest, TestAVXPerformance) {
+    if (Simd::HostLevel() < SimdLevel::AVX) {
+        GTEST_SKIP() << "AVX is not supported by this host";
+    }
     carta::Timer t;
     for (auto i = 0; i < NUM_ITERS; i++) {
         auto m1 = RandomMatrix(size_random(mt), size_random(mt), 0);
@@ -6,11 +6,22 @@
 
 #include <gtest/gtest.h>
 
+#include <omp.h>
+#include <atomic>
+#include <random>
+#include <set>
+
+#include "Cache/ContourCache.h"
 #include "CommonTestUtilities.h"
+#include "DataStream/Contouring.h"
 #include "ImageData/FileLoader.h"
 #include "Util/Message.h"
 #include "src/Frame/Frame.h"
 
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include "Timer/Timer.h"
+#endif
+
 static const std::string IMAGE_OPTS = "-s 0";
 static const std::string IMAGE_OPTS_NAN = "-s 0 -n row column -d 10";
 
@@ -50,7 +61,7 @@ public:
             progresses[level] = progress;
             ulock.unlock();
         };
-        EXPECT_TRUE(frame->ContourImage(callback));
+        EXPECT_TRUE(frame->ContourImage(frame->CurrentZ(), frame->CurrentStokes(), callback));
 
         // Check the number of resulting contour levels
         EXPECT_EQ(progresses.size(), levels.size());
@@ -122,6 +133,57 @@ public:
         return (0 <= x && x < width && 0 <= y && y < height);
     }
 
+    // Smooth random image, so that contours cross many bands
+    static std::vector<float> WavyImage(int width, int height, float nan_fraction) {
+        std::mt19937 mt(42);
+        std::normal_distribution<float> noise(0, 0.2);
+        std::uniform_real_distribution<float> uniform(0, 1);
+        std::vector<float> image(width * height);
+        for (int j = 0; j < height; ++j) {
+            for (int i = 0; i < width; ++i) {
+                image[j * width + i] = uniform(mt) < nan_fraction ? NAN : std::sin(i * 0.03) * std::cos(j * 0.02) + noise(mt);
+            }
+        }
+        return image;
+    }
+
+    struct ContourSummary {
+        std::unordered_map<double, int> segment_count;
+        std::unordered_map<double, std::set<std::pair<float, float>>> vertices;
+        std::unordered_map<double, int> final_count;
+    };
+
+    ContourSummary TraceImage(std::vector<float>& image, int width, int height, const std::vector<double>& levels, int chunk_size,
+        int64_t band_rows = CONTOUR_BAND_ROWS, int64_t priority_row_start = 0, int64_t priority_row_end = 0, bool copy_rows = false) {
+        ContourSummary summary;
+        auto callback = [&](double level, double progress, const std::vector<float>& vertices, const std::vector<int>& indices) {
+            std::unique_lock<std::mutex> ulock(_callback_mutex);
+            EXPECT_EQ(summary.final_count[level], 0); // No partial data after the final message for a level
+            if (progress >= 1.0) {
+                summary.final_count[level]++;
+            }
+            summary.segment_count[level] += indices.size();
+            for (int i = 0; i + 1 < vertices.size(); i += 2) {
+                summary.vertices[level].insert({vertices[i], vertices[i + 1]});
+            }
+        };
+        std::vector<std::vector<float>> vertex_data;
+        std::vector<std::vector<int>> index_data;
+        if (copy_rows) {
+            // Rows are read into the band buffer, as from the tile cache
+            auto get_rows = [&](int64_t row_start, int64_t num_rows, std::vector<float>& buffer) -> const float* {
+                buffer.assign(image.begin() + row_start * width, image.begin() + (row_start + num_rows) * width);
+                return buffer.data();
+            };
+            EXPECT_TRUE(carta::TraceContours(get_rows, width, height, 1.0, 0, levels, vertex_data, index_data, chunk_size, callback,
+                band_rows, priority_row_start, priority_row_end));
+        } else {
+            EXPECT_TRUE(carta::TraceContours(image.data(), width, height, 1.0, 0, levels, vertex_data, index_data, chunk_size, callback,
+                band_rows, priority_row_start, priority_row_end));
+        }
+        return summary;
+    }
+
 private:
     std::mutex _callback_mutex;
 };
@@ -167,3 +229,153 @@ TEST_F(ContourTest, BlockAverageHdf5File) {
 TEST_F(ContourTest, BlockAverageHdf5FileNaN) {
     GenerateContour(500, 500, IMAGE_OPTS, CARTA::FileType::HDF5, CARTA::SmoothingMode::BlockAverage);
 }
+
+TEST_F(ContourTest, BandsMatchSingleSweep) {
+    int width(301), height(457);
+    std::vector<double> levels{-0.5, 0, 0.5, 5.0};
+    for (float nan_fraction : {0.0f, 0.05f}) {
+        auto image = WavyImage(width, height, nan_fraction);
+        auto single_sweep = TraceImage(image, width, height, levels, 0, height);
+        for (int64_t band_rows : {1, 7, 64, CONTOUR_BAND_ROWS}) {
+            for (int chunk_size : {0, 100}) {
+                auto banded = TraceImage(image, width, height, levels, chunk_size, band_rows);
+                for (auto level : levels) {
+                    // Segments crossing seams are stitched back together
+                    EXPECT_EQ(banded.final_count[level], 1);
+                    EXPECT_EQ(banded.segment_count[level], single_sweep.segment_count[level]);
+                    EXPECT_EQ(banded.vertices[level], single_sweep.vertices[level]);
+                }
+            }
+        }
+    }
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST_F(ContourTest, StreamedRowsMatchFullImage) {
+    int width(256), height(333);
+    std::vector<double> levels{-0.5, 0, 0.5};
+    auto image = WavyImage(width, height, 0.05f);
+    auto full_image = TraceImage(image, width, height, levels, 0);
+    for (auto priority_rows : std::vector<std::pair<int64_t, int64_t>>{{0, 0}, {100, 200}, {300, 333}}) {
+        auto streamed = TraceImage(image, width, height, levels, 100, 32, priority_rows.first, priority_rows.second, true);
+        for (auto level : levels) {
+            EXPECT_EQ(streamed.final_count[level], 1);
+            EXPECT_EQ(streamed.segment_count[level], full_image.segment_count[level]);
+            EXPECT_EQ(streamed.vertices[level], full_image.vertices[level]);
+        }
+    }
+}
+
+TEST_F(ContourTest, PriorityRowsSentFirst) {
+    int width(64), height(512);
+    std::vector<double> levels{0};
+    auto image = WavyImage(width, height, 0.0f);
+    std::vector<int64_t> requested_rows;
+    std::mutex rows_mutex;
+    auto get_rows = [&](int64_t row_start, int64_t num_rows, std::vector<float>& buffer) -> const float* {
+        std::unique_lock<std::mutex> ulock(rows_mutex);
+        requested_rows.push_back(row_start);
+        return row_start == 0 ? nullptr : image.data() + row_start * width;
+    };
+    auto callback = [&](double level, double progress, const std::vector<float>& vertices, const std::vector<int>& indices) {};
+    std::vector<std::vector<float>> vertex_data;
+    std::vector<std::vector<int>> index_data;
+    // The first band cannot be read
+    EXPECT_FALSE(carta::TraceContours(get_rows, width, height, 1.0, 0, levels, vertex_data, index_data, 100, callback, 64, 300, 310));
+    ASSERT_EQ(requested_rows.size(), 8);
+    // The band containing the priority rows is dispatched first
+    auto first_rows = requested_rows.begin() + std::min<size_t>(omp_get_max_threads(), requested_rows.size());
+    EXPECT_NE(std::find(requested_rows.begin(), first_rows, 256), first_rows);
+}
+
+TEST_F(ContourTest, CacheKeyIncludesSettings) {
+    std::vector<double> levels{0.1, 0.2};
+    auto key = carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 1, 4, 4, 8);
+    EXPECT_EQ(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 1, 4, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 1, 0, levels, 1, 4, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 1, levels, 1, 4, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, {0.1, 0.2000001}, 1, 4, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 2, 4, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 1, 3, 4, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 1, 4, 2, 8));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:1", 0, 0, levels, 1, 4, 4, 0));
+    EXPECT_NE(key, carta::ContourCache::Key("image.fits:0:2", 0, 0, levels, 1, 4, 4, 8));
+}
+
+TEST_F(ContourTest, CacheEvictsLeastRecentlyUsed) {
+    auto make_entry = [](size_t num_bytes) {
+        auto entry = std::make_shared<carta::ContourCacheEntry>();
+        CARTA::ContourSet contour_set;
+        contour_set.set_level(1.0);
+        contour_set.set_raw_coordinates(std::string(num_bytes, 'x'));
+        entry->Add(0.5, contour_set);
+        entry->Add(1.0, CARTA::ContourSet());
+        return entry;
+    };
+
+    auto entry = make_entry(1000);
+    carta::ContourCache cache(3 * entry->size);
+    cache.Put("a", entry);
+    cache.Put("b", make_entry(1000));
+    cache.Put("c", make_entry(1000));
+    EXPECT_EQ(cache.Count(), 3);
+
+    // Touch "a", so that "b" is evicted first
+    auto cached = cache.Get("a");
+    ASSERT_TRUE(cached);
+    ASSERT_EQ(cached->contour_sets.size(), 2);
+    EXPECT_EQ(cached->progress, std::vector<double>({0.5, 1.0}));
+    EXPECT_EQ(cached->contour_sets[0].raw_coordinates().size(), 1000);
+
+    cache.Put("d", make_entry(1000));
+    EXPECT_EQ(cache.Count(), 3);
+    EXPECT_LE(cache.Size(), 3 * entry->size);
+    EXPECT_TRUE(cache.Get("a"));
+    EXPECT_FALSE(cache.Get("b"));
+    EXPECT_TRUE(cache.Get("c"));
+    EXPECT_TRUE(cache.Get("d"));
+
+    // Entries larger than the budget are not cached
+    cache.Put("e", make_entry(10000));
+    EXPECT_FALSE(cache.Get("e"));
+    EXPECT_EQ(cache.Count(), 3);
+
+    cache.Clear();
+    EXPECT_EQ(cache.Count(), 0);
+    EXPECT_EQ(cache.Size(), 0);
+}
+
+TEST_F(ContourTest, BandPerformance) {
+    int width(4000), height(4000);
+    auto image = WavyImage(width, height, 0.0f);
+    std::vector<std::vector<float>> vertex_data;
+    std::vector<std::vector<int>> index_data;
+    std::atomic<int64_t> segment_count(0);
+    auto callback = [&](double level, double progress, const std::vector<float>& vertices, const std::vector<int>& indices) {
+        segment_count += indices.size();
+    };
+
+    for (int num_levels : {3, 20}) {
+        std::vector<double> levels;
+        for (int i = 0; i < num_levels; ++i) {
+            levels.push_back(-1.0 + 2.0 * i / num_levels);
+        }
+
+        // A single band per level is equivalent to tracing each level over the whole image
+        segment_count = 0;
+        carta::Timer t_single;
+        carta::TraceContours(image.data(), width, height, 1.0, 0, levels, vertex_data, index_data, 100000, callback, height);
+        auto dt_single = t_single.Elapsed();
+        int64_t single_sweep_segments = segment_count;
+
+        segment_count = 0;
+        carta::Timer t_banded;
+        carta::TraceContours(image.data(), width, height, 1.0, 0, levels, vertex_data, index_data, 100000, callback);
+        auto dt_banded = t_banded.Elapsed();
+
+        spdlog::info("{} levels on {}x{} image: whole image per level {:.3f} ms, row bands {:.3f} ms ({:.2f}x)", num_levels, width, height,
+            dt_single.ms(), dt_banded.ms(), dt_single.ms() / dt_banded.ms());
+        EXPECT_EQ(segment_count, single_sweep_segments);
+    }
+}
+#endif
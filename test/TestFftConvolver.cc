@@ -0,0 +1,155 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <omp.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ImageGenerators/FftConvolver.h"
+
+using namespace carta;
+
+class FftConvolverTest : public ::testing::Test {
+public:
+    std::mt19937 mt;
+
+    FftConvolverTest() : mt(42) {}
+
+    std::vector<float> RandomValues(size_t size) {
+        std::uniform_real_distribution<float> value(-1.0, 1.0);
+        std::vector<float> values(size);
+        for (auto& v : values) {
+            v = value(mt);
+        }
+        return values;
+    }
+
+    // Direct linear convolution, with zero outside the plane and for masked pixels
+    static std::vector<float> Convolve(const std::vector<float>& data, const std::vector<bool>& mask, size_t width, size_t height,
+        const std::vector<float>& kernel, size_t kernel_width, size_t kernel_height) {
+        int center_x = (kernel_width - 1) / 2;
+        int center_y = (kernel_height - 1) / 2;
+        std::vector<float> result(width * height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                double sum(0.0);
+                for (int ky = 0; ky < kernel_height; ++ky) {
+                    for (int kx = 0; kx < kernel_width; ++kx) {
+                        int data_x = x + center_x - kx;
+                        int data_y = y + center_y - ky;
+                        if (data_x >= 0 && data_x < width && data_y >= 0 && data_y < height) {
+                            size_t index = data_y * width + data_x;
+                            if (mask.empty() || mask[index]) {
+                                sum += data[index] * kernel[ky * kernel_width + kx];
+                            }
+                        }
+                    }
+                }
+                result[y * width + x] = sum;
+            }
+        }
+        return result;
+    }
+};
+
+TEST_F(FftConvolverTest, FftLength) {
+    EXPECT_EQ(FftConvolver::FftLength(1), 2);
+    EXPECT_EQ(FftConvolver::FftLength(7), 8);
+    EXPECT_EQ(FftConvolver::FftLength(11), 12);
+    EXPECT_EQ(FftConvolver::FftLength(13), 16);
+    EXPECT_EQ(FftConvolver::FftLength(97), 100);
+    EXPECT_EQ(FftConvolver::FftLength(121), 128);
+    EXPECT_EQ(FftConvolver::FftLength(1000), 1000);
+}
+
+TEST_F(FftConvolverTest, MatchesDirectConvolution) {
+    // One workspace for more FFT shapes than it keeps plans for
+    FftConvolver::Workspace workspace;
+    for (auto shape : {std::make_pair(40, 30), std::make_pair(33, 51), std::make_pair(7, 5)}) {
+        size_t width(shape.first), height(shape.second);
+        for (size_t kernel_size : {1, 5, 11}) {
+            auto data = RandomValues(width * height);
+            auto kernel = RandomValues(kernel_size * kernel_size);
+            std::vector<float> result(width * height);
+            FftConvolver convolver(kernel, kernel_size, kernel_size, width, height);
+            EXPECT_FALSE(convolver.IsPrepared());
+            convolver.Prepare(workspace);
+            EXPECT_TRUE(convolver.IsPrepared());
+            convolver.Convolve(data.data(), nullptr, result.data(), workspace);
+
+            auto expected = Convolve(data, {}, width, height, kernel, kernel_size, kernel_size);
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_NEAR(result[i], expected[i], 1.0e-4) << "pixel " << i;
+            }
+        }
+    }
+}
+
+TEST_F(FftConvolverTest, MaskedPixelsAreZero) {
+    size_t width(32), height(24), kernel_size(7);
+    auto data = RandomValues(width * height);
+    auto kernel = RandomValues(kernel_size * kernel_size);
+    std::vector<bool> mask(width * height);
+    std::unique_ptr<bool[]> mask_data(new bool[width * height]);
+    for (size_t i = 0; i < mask.size(); ++i) {
+        mask[i] = mask_data[i] = (i % 3 != 0);
+        if (!mask[i]) {
+            data[i] = NAN;
+        }
+    }
+
+    std::vector<float> result(width * height);
+    FftConvolver::Workspace workspace;
+    FftConvolver convolver(kernel, kernel_size, kernel_size, width, height);
+    convolver.Prepare(workspace);
+    convolver.Convolve(data.data(), mask_data.get(), result.data(), workspace);
+
+    auto expected = Convolve(data, mask, width, height, kernel, kernel_size, kernel_size);
+    for (size_t i = 0; i < result.size(); ++i) {
+        ASSERT_NEAR(result[i], expected[i], 1.0e-4) << "pixel " << i;
+    }
+}
+
+TEST_F(FftConvolverTest, ParallelPlanes) {
+    // Convolvers prepared and planes convolved concurrently, with kernels of different FFT shapes in each thread
+    size_t width(48), height(40), num_planes(16);
+    std::vector<std::vector<float>> planes(num_planes);
+    std::vector<std::vector<float>> results(num_planes, std::vector<float>(width * height));
+    for (auto& plane : planes) {
+        plane = RandomValues(width * height);
+    }
+    auto kernel = RandomValues(5 * 5);
+    auto wide_kernel = RandomValues(15 * 15);
+    FftConvolver convolver(kernel, 5, 5, width, height);
+    FftConvolver wide_convolver(wide_kernel, 15, 15, width, height);
+    std::vector<FftConvolver::Workspace> workspaces(omp_get_max_threads());
+
+#pragma omp parallel
+    {
+        auto& workspace = workspaces[omp_get_thread_num()];
+#pragma omp for
+        for (int64_t i = 0; i < 2; ++i) {
+            (i % 2 ? wide_convolver : convolver).Prepare(workspace);
+        }
+#pragma omp for
+        for (int64_t i = 0; i < num_planes; ++i) {
+            (i % 2 ? wide_convolver : convolver).Convolve(planes[i].data(), nullptr, results[i].data(), workspace);
+        }
+    }
+
+    for (size_t i = 0; i < num_planes; ++i) {
+        auto expected = (i % 2 ? Convolve(planes[i], {}, width, height, wide_kernel, 15, 15)
+                               : Convolve(planes[i], {}, width, height, kernel, 5, 5));
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_NEAR(results[i][j], expected[j], 1.0e-4) << "plane " << i << " pixel " << j;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DataStream/Smoothing.h"
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include "Logger/Logger.h"
+#include "Timer/Timer.h"
+#endif
+
+#define MAX_ABS_ERROR 1.0e-5f
+
+using namespace carta;
+
+class GaussianSmoothingTest : public ::testing::Test {
+public:
+    std::mt19937 mt;
+    std::uniform_real_distribution<float> float_random;
+
+    GaussianSmoothingTest() : mt(42), float_random(0, 1.0f) {}
+
+    std::vector<float> RandomImage(int64_t width, int64_t height, float nan_fraction) {
+        std::vector<float> image(width * height);
+        for (int64_t j = 0; j < height; j++) {
+            for (int64_t i = 0; i < width; i++) {
+                image[j * width + i] =
+                    float_random(mt) < nan_fraction ? NAN : std::sin(i * 0.05f) * std::cos(j * 0.03f) + float_random(mt) - 0.5f;
+            }
+        }
+        return image;
+    }
+
+    // Two passes of RunKernel, as previously used by GaussianSmooth
+    static std::vector<float> RunKernelSmooth(const std::vector<float>& src, int64_t src_width, int64_t src_height, int smoothing_factor) {
+        int64_t apron = smoothing_factor - 1;
+        int64_t dest_width = src_width - 2 * apron;
+        int64_t dest_height = src_height - 2 * apron;
+        std::vector<float> kernel(2 * apron + 1);
+        MakeKernel(kernel, apron / 2.0);
+        std::vector<float> temp(dest_width * src_height);
+        std::vector<float> dest(dest_width * dest_height);
+        RunKernel(kernel, src.data(), temp.data(), src_width, src_height, dest_width, src_height, false);
+        RunKernel(kernel, temp.data(), dest.data(), dest_width, src_height, dest_width, dest_height, true);
+        return dest;
+    }
+};
+
+TEST_F(GaussianSmoothingTest, MatchesRunKernel) {
+    int64_t width(397), height(311);
+    for (float nan_fraction : {0.0f, 0.1f, 0.9f}) {
+        auto image = RandomImage(width, height, nan_fraction);
+        for (int smoothing_factor : {2, 4, 7, 16, 17, 33}) {
+            int64_t apron = smoothing_factor - 1;
+            int64_t dest_width = width - 2 * apron;
+            int64_t dest_height = height - 2 * apron;
+            auto expected = RunKernelSmooth(image, width, height, smoothing_factor);
+            std::vector<float> smoothed(dest_width * dest_height);
+            // GaussianSmooth keeps the truncated kernel for all smoothing factors, so contours do not change
+            ASSERT_TRUE(GaussianSmooth(image.data(), smoothed.data(), width, height, dest_width, dest_height, smoothing_factor));
+            for (int64_t y = 0; y < dest_height; y++) {
+                for (int64_t x = 0; x < dest_width; x++) {
+                    // Unlike RunKernel, pixels which are NaN in the source are kept
+                    float val = smoothed[y * dest_width + x];
+                    float expected_val = std::isnan(image[(y + apron) * width + x + apron]) ? NAN : expected[y * dest_width + x];
+                    ASSERT_EQ(std::isnan(val), std::isnan(expected_val));
+                    if (!std::isnan(expected_val)) {
+                        ASSERT_NEAR(val, expected_val, MAX_ABS_ERROR);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(GaussianSmoothingTest, KeepsOriginalNaNs) {
+    int64_t width(256), height(256);
+    auto image = RandomImage(width, height, 0.05f);
+    for (int smoothing_factor : {4, 17}) {
+        int64_t apron = smoothing_factor - 1;
+        int64_t dest_width = width - 2 * apron;
+        int64_t dest_height = height - 2 * apron;
+        std::vector<float> smoothed(dest_width * dest_height);
+        ASSERT_TRUE(GaussianSmooth(image.data(), smoothed.data(), width, height, dest_width, dest_height, smoothing_factor));
+        for (int64_t y = 0; y < dest_height; y++) {
+            for (int64_t x = 0; x < dest_width; x++) {
+                EXPECT_EQ(std::isnan(smoothed[y * dest_width + x]), std::isnan(image[(y + apron) * width + x + apron]));
+            }
+        }
+    }
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST_F(GaussianSmoothingTest, SmoothingPerformance) {
+    int64_t width(4000), height(4000);
+    auto image = RandomImage(width, height, 0.01f);
+    std::vector<float> smoothed(width * height);
+
+    for (int smoothing_factor : {4, 8, 16}) {
+        int64_t apron = smoothing_factor - 1;
+        int64_t dest_width = width - 2 * apron;
+        int64_t dest_height = height - 2 * apron;
+        Timer t;
+        RunKernelSmooth(image, width, height, smoothing_factor);
+        auto run_kernel_time = t.Elapsed();
+        t = Timer();
+        GaussianSmoothSeparable(image.data(), smoothed.data(), width, height, dest_width, dest_height, smoothing_factor);
+        auto separable_time = t.Elapsed();
+        spdlog::info("Smoothing factor {}: RunKernel {:.3f} ms, separable {:.3f} ms", smoothing_factor, run_kernel_time.ms(),
+            separable_time.ms());
+        EXPECT_LT(separable_time.ms(), run_kernel_time.ms());
+    }
+}
+#endif
@@ -0,0 +1,121 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <casacore/casa/Arrays/ArrayLogical.h>
+#include <casacore/casa/Arrays/ArrayMath.h>
+#include <casacore/coordinates/Coordinates/CoordinateUtil.h>
+#include <casacore/images/Images/TempImage.h>
+#include <casacore/lattices/Lattices/TempLattice.h>
+#include <imageanalysis/ImageAnalysis/CasaImageBeamSet.h>
+#include <imageanalysis/ImageAnalysis/Image2DConvolver.h>
+
+#include "ImageGenerators/Image2DConvolver.h"
+#include "ThreadingManager/ThreadingManager.h"
+
+#define NUM_CHANNELS 10
+
+class Image2DConvolverTest : public ::testing::Test {
+public:
+    // Cube of random values with a beam per channel, which grows with the channel, and a masked block
+    static std::shared_ptr<casacore::TempImage<casacore::Float>> MultipleBeamImage(int width, int height) {
+        casacore::CoordinateSystem coordinates = casacore::CoordinateUtil::defaultCoords3D();
+        casacore::IPosition shape(3, width, height, NUM_CHANNELS);
+        auto image = std::make_shared<casacore::TempImage<casacore::Float>>(shape, coordinates);
+
+        std::mt19937 mt(42);
+        std::uniform_real_distribution<float> value(-1.0, 1.0);
+        casacore::Array<casacore::Float> data(shape);
+        for (auto& v : data) {
+            v = value(mt);
+        }
+        image->put(data);
+
+        casacore::TempLattice<casacore::Bool> mask(shape);
+        mask.set(true);
+        casacore::Array<casacore::Bool> masked_block(casacore::IPosition(3, 5, 4, NUM_CHANNELS), false);
+        mask.putSlice(masked_block, casacore::IPosition(3, 10, 20, 0));
+        image->attachMask(mask);
+
+        double pixel_size = PixelSize(*image);
+        casacore::ImageBeamSet beams(NUM_CHANNELS, 1);
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+            beams.setBeam(channel, 0,
+                casacore::GaussianBeam(casacore::Quantity(pixel_size * (3.0 + 0.2 * channel), "arcsec"),
+                    casacore::Quantity(pixel_size * (2.0 + 0.1 * channel), "arcsec"), casacore::Quantity(10.0 * channel, "deg")));
+        }
+        casacore::ImageInfo image_info;
+        image_info.setBeams(beams);
+        image->setImageInfo(image_info);
+        image->setUnits("Jy/beam");
+        return image;
+    }
+
+    static double PixelSize(const casacore::ImageInterface<casacore::Float>& image) {
+        const auto& coordinates = image.coordinates();
+        auto axis = coordinates.directionAxesNumbers()[0];
+        return casacore::Quantity(fabs(coordinates.increment()[axis]), coordinates.worldAxisUnits()[axis]).getValue("arcsec");
+    }
+
+    // Convolves the image with the carta and casa convolvers, and checks that the results agree
+    static void CompareConvolvers(const std::shared_ptr<casacore::TempImage<casacore::Float>>& image, bool targetres,
+        const casacore::Quantity& major, const casacore::Quantity& minor, const casacore::Quantity& pa) {
+        std::pair<casacore::uInt, casacore::uInt> axes(0, 1);
+
+        casa::Image2DConvolver<casacore::Float> casa_convolver(image, nullptr, "", "", false);
+        casa_convolver.setAxes(axes);
+        casa_convolver.setKernel("gaussian", major, minor, pa);
+        casa_convolver.setScale(-1);
+        casa_convolver.setTargetRes(targetres);
+        auto casa_image = casa_convolver.convolve();
+
+        // Fewer threads than channels, so that the planes are convolved in several batches and the last one is partial
+        for (int threads : {1, 3, 4}) {
+            carta::ThreadManager::SetThreadLimit(threads);
+            carta::Image2DConvolver<casacore::Float> carta_convolver(image, nullptr, "", "", false, nullptr);
+            carta_convolver.setAxes(axes);
+            carta_convolver.setKernel("gaussian", major, minor, pa);
+            carta_convolver.setScale(-1);
+            carta_convolver.setTargetRes(targetres);
+            auto carta_image = carta_convolver.convolve();
+
+            ASSERT_TRUE(carta_image->shape().isEqual(casa_image->shape()));
+            EXPECT_EQ(carta_image->units().getName(), casa_image->units().getName());
+            EXPECT_EQ(carta_image->imageInfo().getBeamSet(), casa_image->imageInfo().getBeamSet());
+
+            casacore::Array<casacore::Float> casa_data = casa_image->get();
+            casacore::Array<casacore::Float> carta_data = carta_image->get();
+            float tolerance = 1e-4 * casacore::max(casacore::abs(casa_data));
+            auto casa_value = casa_data.begin();
+            for (auto carta_value = carta_data.begin(); carta_value != carta_data.end(); ++carta_value, ++casa_value) {
+                EXPECT_NEAR(*carta_value, *casa_value, tolerance);
+            }
+
+            casacore::Array<casacore::Bool> casa_mask = casa_image->getMask();
+            casacore::Array<casacore::Bool> carta_mask = carta_image->getMask();
+            EXPECT_TRUE(casacore::allEQ(carta_mask, casa_mask));
+        }
+        carta::ThreadManager::SetThreadLimit(0);
+    }
+};
+
+TEST_F(Image2DConvolverTest, MultipleBeamsToTargetResolution) {
+    auto image = MultipleBeamImage(64, 48);
+    casacore::GaussianBeam common_beam = casa::CasaImageBeamSet(image->imageInfo().getBeamSet()).getCommonBeam();
+    CompareConvolvers(image, true, common_beam.getMajor(), common_beam.getMinor(), common_beam.getPA(true));
+}
+
+TEST_F(Image2DConvolverTest, MultipleBeamsWithKernel) {
+    auto image = MultipleBeamImage(64, 48);
+    double pixel_size = PixelSize(*image);
+    CompareConvolvers(image, false, casacore::Quantity(pixel_size * 4.0, "arcsec"), casacore::Quantity(pixel_size * 3.0, "arcsec"),
+        casacore::Quantity(30.0, "deg"));
+}
@@ -7,6 +7,9 @@
 #define SQ_FWHM_TO_SIGMA 1 / 8 / log(2)
 #define DEG_TO_RAD M_PI / 180.0
 
+#include <algorithm>
+#include <random>
+
 #include <gtest/gtest.h>
 
 #include "Frame/Frame.h"
@@ -17,6 +20,14 @@
 
 #include "CommonTestUtilities.h"
 
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include "Timer/Timer.h"
+#endif
+
+// Central difference step and maximum difference (relative to the larger of 1 and the analytic value) for the Jacobian
+#define FINITE_DIFFERENCE_STEP 1.0e-5
+#define MAX_JACOBIAN_ERROR 1.0e-6
+
 // Allows testing of protected methods in Frame without polluting the original class
 class TestFrame : public Frame {
 public:
@@ -29,8 +40,78 @@ public:
     FRIEND_TEST(ImageFittingTest, ThreeComponentFitting);
 };
 
+// Allows testing of the residual and Jacobian functions of ImageFitter
+class TestImageFitter : public carta::ImageFitter {
+public:
+    using ImageFitter::FuncDf;
+    using ImageFitter::FuncF;
+};
+
 class ImageFittingTest : public ::testing::Test {
 public:
+    // Fitting data for all pixels of the image, with parameters as ImageFitter: 6 for each component and the background offset
+    static carta::FitData GetFitData(std::vector<float>& image, size_t width, const std::vector<double>& initial_values,
+        const std::vector<bool>& fixed_params, gsl_vector*& fit_values) {
+        carta::FitData fit_data;
+        fit_data.data = image.data();
+        fit_data.width = width;
+        fit_data.n = image.size();
+        fit_data.n_notnan = image.size();
+        fit_data.notnan_data = image;
+        for (size_t i = 0; i < image.size(); ++i) {
+            fit_data.notnan_x.push_back(i % width);
+            fit_data.notnan_y.push_back(i / width);
+        }
+        fit_data.offset_x = 0;
+        fit_data.offset_y = 0;
+        fit_data.initial_values = initial_values;
+        fit_data.stop_fitting = false;
+
+        fit_values = gsl_vector_alloc(std::count(fixed_params.begin(), fixed_params.end(), false));
+        int index(0);
+        for (size_t i = 0; i < fixed_params.size(); ++i) {
+            if (fixed_params[i]) {
+                fit_data.fit_values_indexes.push_back(-1);
+            } else {
+                gsl_vector_set(fit_values, index, initial_values[i]);
+                fit_data.fit_values_indexes.push_back(index++);
+            }
+        }
+        return fit_data;
+    }
+
+    // Compare the analytic Jacobian with central differences of the residual
+    static void CheckJacobian(std::vector<float>& image, size_t width, const std::vector<double>& values, const std::vector<bool>& fixed) {
+        gsl_vector* fit_values;
+        auto fit_data = GetFitData(image, width, values, fixed, fit_values);
+        size_t n(image.size()), p(fit_values->size);
+        gsl_matrix* jacobian = gsl_matrix_alloc(n, p);
+        gsl_vector* f_plus = gsl_vector_alloc(n);
+        gsl_vector* f_minus = gsl_vector_alloc(n);
+        TestImageFitter::FuncDf(fit_values, &fit_data, jacobian);
+
+        for (size_t j = 0; j < p; ++j) {
+            double value = gsl_vector_get(fit_values, j);
+            gsl_vector_set(fit_values, j, value + FINITE_DIFFERENCE_STEP);
+            TestImageFitter::FuncF(fit_values, &fit_data, f_plus);
+            gsl_vector_set(fit_values, j, value - FINITE_DIFFERENCE_STEP);
+            TestImageFitter::FuncF(fit_values, &fit_data, f_minus);
+            gsl_vector_set(fit_values, j, value);
+
+            for (size_t i = 0; i < n; ++i) {
+                double expected = (gsl_vector_get(f_plus, i) - gsl_vector_get(f_minus, i)) / (2 * FINITE_DIFFERENCE_STEP);
+                double derivative = gsl_matrix_get(jacobian, i, j);
+                ASSERT_NEAR(derivative, expected, MAX_JACOBIAN_ERROR * std::max(1.0, fabs(derivative)))
+                    << "pixel " << i << " parameter " << j;
+            }
+        }
+
+        gsl_vector_free(f_minus);
+        gsl_vector_free(f_plus);
+        gsl_matrix_free(jacobian);
+        gsl_vector_free(fit_values);
+    }
+
     void SetInitialValues(std::vector<float> gaussian_model) {
         _initial_values = {};
         for (size_t i = 0; i < gaussian_model[0]; i++) {
@@ -84,6 +165,26 @@ public:
         }
     }
 
+#ifdef COMPILE_PERFORMANCE_TESTS
+    // Mean time in ms to fit the image, excluding image generation and loading
+    double FitImageTime(std::vector<float> gaussian_model, int repeats) {
+        std::string file_path = GetGeneratedFilePath(gaussian_model);
+        std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(file_path));
+        std::unique_ptr<TestFrame> frame(new TestFrame(0, loader, "0"));
+        auto progress_callback = [&](float progress) {};
+
+        Timer t;
+        for (int i = 0; i < repeats; ++i) {
+            CARTA::FittingResponse fitting_response;
+            carta::ImageFitter image_fitter;
+            bool success = image_fitter.FitImage(frame->Width(), frame->Height(), frame->GetImageCacheData(), 0.0, "", _initial_values,
+                _fixed_params, 0.0, CARTA::FittingSolverType::Cholesky, false, false, fitting_response, progress_callback);
+            EXPECT_TRUE(success);
+        }
+        return t.Elapsed().ms() / repeats;
+    }
+#endif
+
     void FitImageWithFov(std::vector<float> gaussian_model, int region_id, std::string failed_message = "") {
         std::string file_path = GetGeneratedFilePath(gaussian_model);
         std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(file_path));
@@ -286,3 +387,39 @@ TEST_F(ImageFittingTest, insufficientData) {
     SetFov(CARTA::RegionType::RECTANGLE, {63.5, 63.5, 2, 2}, 0);
     FitImageWithFov(gaussian_model, 0, "insufficient data points");
 }
+
+TEST_F(ImageFittingTest, JacobianMatchesFiniteDifferences) {
+    size_t width(64), height(48);
+    std::vector<float> image(width * height);
+    std::mt19937 mt(42);
+    std::uniform_real_distribution<float> noise(-1.0, 1.0);
+    for (auto& value : image) {
+        value = noise(mt);
+    }
+
+    // Rotated components (center x, center y, amp, fwhm x, fwhm y, pa) and background offset, overlapping and crossing the image edges
+    std::vector<double> values = {20.3, 24.1, 10.0, 12.0, 5.0, 30.0, 40.7, 20.2, -4.0, 6.5, 14.0, 135.0, 60.2, 3.4, 7.0, 9.0, 4.0, 250.0,
+        0.5};
+    std::vector<bool> all_unfixed(values.size(), false);
+    CheckJacobian(image, width, values, all_unfixed);
+
+    std::vector<bool> fixed_params = {
+        false, false, false, false, false, true, true, true, false, false, false, false, false, false, true, false, true, false, true};
+    CheckJacobian(image, width, values, fixed_params);
+
+    std::vector<double> one_component = {31.6, 22.9, 5.0, 8.0, 3.0, 72.0, 1.0};
+    CheckJacobian(image, width, one_component, {false, false, false, false, false, false, false});
+    CheckJacobian(image, width, one_component, {true, false, true, false, true, false, true});
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST_F(ImageFittingTest, FittingPerformance) {
+    std::vector<float> gaussian_model = {3, 64, 64, 20, 20, 10, 210, 32, 32, 20, 20, 10, 210, 96, 96, 20, 20, 10, 210};
+    std::vector<bool> fixed_params(18, false);
+    fixed_params.push_back(true);
+    SetInitialValues(gaussian_model);
+    SetFixedParams(fixed_params);
+
+    spdlog::info("Three component fitting of 128x128 image: {:.3f} ms", FitImageTime(gaussian_model, 10));
+}
+#endif
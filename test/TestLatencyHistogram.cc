@@ -0,0 +1,77 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <cmath>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Timer/LatencyHistogram.h"
+
+using namespace carta;
+
+TEST(LatencyHistogramTest, Empty) {
+    LatencyHistogram histogram("empty");
+    EXPECT_EQ(histogram.Count(), 0);
+    EXPECT_EQ(histogram.Percentile(0.5), 0.0);
+    EXPECT_EQ(histogram.Percentile(1.0), 0.0);
+}
+
+TEST(LatencyHistogramTest, PowerOfTwoBins) {
+    LatencyHistogram histogram("bins");
+    // Below 1 us, and negative durations, are counted in the first bin
+    histogram.Add(TimeDelta{0.5});
+    EXPECT_EQ(histogram.Percentile(1.0), 1.0);
+    histogram.Reset();
+    histogram.Add(TimeDelta{-3.0});
+    EXPECT_EQ(histogram.Percentile(1.0), 1.0);
+
+    // Bin upper bounds are exclusive
+    for (double us : {1.0, 2.0, 3.0, 4.0, 1000.0, 1024.0}) {
+        histogram.Reset();
+        histogram.Add(TimeDelta{us});
+        double upper = std::ldexp(1.0, static_cast<int>(std::floor(std::log2(us))) + 1);
+        EXPECT_EQ(histogram.Percentile(1.0), upper) << us << " us";
+    }
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram("percentiles");
+    for (int i = 0; i < 90; ++i) {
+        histogram.Add(TimeDelta{3.0});
+    }
+    for (int i = 0; i < 9; ++i) {
+        histogram.Add(TimeDelta{100.0});
+    }
+    histogram.Add(TimeDelta{5000.0});
+
+    EXPECT_EQ(histogram.Count(), 100);
+    EXPECT_EQ(histogram.Percentile(0.0), 4.0);
+    EXPECT_EQ(histogram.Percentile(0.5), 4.0);
+    EXPECT_EQ(histogram.Percentile(0.9), 4.0);
+    EXPECT_EQ(histogram.Percentile(0.91), 128.0);
+    EXPECT_EQ(histogram.Percentile(0.99), 128.0);
+    EXPECT_EQ(histogram.Percentile(1.0), 8192.0);
+    // Fractions outside [0, 1] are clamped
+    EXPECT_EQ(histogram.Percentile(2.0), 8192.0);
+
+    auto summary = histogram.Summary();
+    EXPECT_NE(summary.find("percentiles: 100 events"), std::string::npos) << summary;
+    EXPECT_NE(summary.find("mean 61.7 us"), std::string::npos) << summary;
+    EXPECT_NE(summary.find("max 5000.0 us"), std::string::npos) << summary;
+
+    histogram.Reset();
+    EXPECT_EQ(histogram.Count(), 0);
+    EXPECT_EQ(histogram.Percentile(1.0), 0.0);
+}
+
+TEST(LatencyHistogramTest, LongDurationsInLastBin) {
+    LatencyHistogram histogram("long");
+    histogram.Add(TimeDelta{1.0e12});
+    histogram.Add(TimeDelta{1.0e13});
+    EXPECT_EQ(histogram.Count(), 2);
+    EXPECT_EQ(histogram.Percentile(0.5), std::ldexp(1.0, LATENCY_HISTOGRAM_BINS - 1));
+}
@@ -16,6 +16,7 @@
 #include "ThreadingManager/ThreadingManager.h"
 
 #define TASK_THREAD_COUNT 3
+#define DISPATCH_THREAD_COUNT 2
 
 int main(int argc, char** argv) {
     // Set gtest environment
@@ -57,7 +58,7 @@ int main(int argc, char** argv) {
         omp_threads = omp_get_num_procs();
     }
 
-    carta::ThreadManager::StartEventHandlingThreads(TASK_THREAD_COUNT);
+    carta::ThreadManager::StartEventHandlingThreads(TASK_THREAD_COUNT, DISPATCH_THREAD_COUNT);
     carta::ThreadManager::SetThreadLimit(omp_threads);
 
     ProgramSettings::GetInstance().user_directory = fs::path(getenv("HOME")) / CARTA_USER_FOLDER_PREFIX;
@@ -0,0 +1,174 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Session/OnMessageTask.h"
+#include "Session/Session.h"
+#include "Session/SessionManager.h"
+#include "ThreadingManager/ThreadingManager.h"
+
+#define DISPATCH_TIMEOUT_MS 10000
+
+using namespace carta;
+
+class DispatchTestSession : public Session {
+public:
+    DispatchTestSession() : Session(nullptr, nullptr, 0, "", nullptr), handled_count(0), active_tasks(0), max_active_tasks(0) {}
+
+    // Messages handled by this session's dispatch tasks, in handling order
+    std::vector<int> handled;
+    std::atomic<int> handled_count;
+    std::atomic<int> active_tasks;
+    std::atomic<int> max_active_tasks;
+};
+
+// Pops a session's inbound messages as DispatchMessagesTask does, recording the index stored in each message
+class RecordMessagesTask : public OnMessageTask {
+    OnMessageTask* execute() override {
+        auto session = static_cast<DispatchTestSession*>(_session);
+        int active = ++session->active_tasks;
+        int max_active = session->max_active_tasks;
+        while (active > max_active && !session->max_active_tasks.compare_exchange_weak(max_active, active)) {
+        }
+
+        std::vector<char> message;
+        while (_session->PopInboundMessage(message)) {
+            int index;
+            std::memcpy(&index, message.data(), sizeof(index));
+            session->handled.push_back(index);
+            ++session->handled_count;
+            if (index % 100 == 0) {
+                // Let the producer get ahead, so that messages arrive while the task is running
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+
+        --session->active_tasks;
+        return nullptr;
+    }
+
+public:
+    RecordMessagesTask(Session* session) : OnMessageTask(session) {}
+    ~RecordMessagesTask() = default;
+};
+
+static std::vector<char> IndexMessage(int index) {
+    std::vector<char> message(sizeof(index));
+    std::memcpy(message.data(), &index, sizeof(index));
+    return message;
+}
+
+static bool WaitForMessages(const std::vector<std::unique_ptr<DispatchTestSession>>& sessions, int num_messages) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto& session : sessions) {
+        // Handled messages are only read once no task is using the session
+        while (session->GetRefCount() > 0 || session->handled_count < num_messages) {
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(DISPATCH_TIMEOUT_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+TEST(MessageDispatchTest, InboundQueueStartsOneTask) {
+    DispatchTestSession session;
+    EXPECT_TRUE(session.QueueInboundMessage(IndexMessage(0)));
+    EXPECT_FALSE(session.QueueInboundMessage(IndexMessage(1)));
+
+    std::vector<char> message;
+    ASSERT_TRUE(session.PopInboundMessage(message));
+    EXPECT_EQ(message, IndexMessage(0));
+    // Messages queued while the task is running are handled by the same task
+    EXPECT_FALSE(session.QueueInboundMessage(IndexMessage(2)));
+    ASSERT_TRUE(session.PopInboundMessage(message));
+    EXPECT_EQ(message, IndexMessage(1));
+    ASSERT_TRUE(session.PopInboundMessage(message));
+    EXPECT_EQ(message, IndexMessage(2));
+
+    // Task ends when the queue is empty, and the next message needs a new one
+    EXPECT_FALSE(session.PopInboundMessage(message));
+    EXPECT_TRUE(session.QueueInboundMessage(IndexMessage(3)));
+    ASSERT_TRUE(session.PopInboundMessage(message));
+    EXPECT_EQ(message, IndexMessage(3));
+    EXPECT_FALSE(session.PopInboundMessage(message));
+}
+
+TEST(MessageDispatchTest, PerSessionOrdering) {
+    // Messages for several sessions arrive interleaved, and are handled on the dispatch threads
+    int num_sessions(4), num_messages(2000);
+    std::vector<std::unique_ptr<DispatchTestSession>> sessions;
+    for (int i = 0; i < num_sessions; ++i) {
+        sessions.push_back(std::make_unique<DispatchTestSession>());
+    }
+
+    for (int index = 0; index < num_messages; ++index) {
+        for (auto& session : sessions) {
+            if (session->QueueInboundMessage(IndexMessage(index))) {
+                ThreadManager::QueueDispatchTask(new RecordMessagesTask(session.get()));
+            }
+        }
+    }
+
+    ASSERT_TRUE(WaitForMessages(sessions, num_messages));
+    for (auto& session : sessions) {
+        EXPECT_EQ(session->max_active_tasks, 1);
+        ASSERT_EQ(session->handled.size(), num_messages);
+        for (int index = 0; index < num_messages; ++index) {
+            ASSERT_EQ(session->handled[index], index);
+        }
+    }
+}
+
+TEST(MessageDispatchTest, CancelEvents) {
+    EXPECT_TRUE(SessionManager::IsCancelEvent(CARTA::EventType::STOP_MOMENT_CALC));
+    EXPECT_TRUE(SessionManager::IsCancelEvent(CARTA::EventType::STOP_FILE_LIST));
+    EXPECT_TRUE(SessionManager::IsCancelEvent(CARTA::EventType::STOP_PV_CALC));
+    EXPECT_TRUE(SessionManager::IsCancelEvent(CARTA::EventType::STOP_FITTING));
+    EXPECT_TRUE(SessionManager::IsCancelEvent(CARTA::EventType::STOP_PV_PREVIEW));
+    EXPECT_FALSE(SessionManager::IsCancelEvent(CARTA::EventType::SAVE_FILE));
+    EXPECT_FALSE(SessionManager::IsCancelEvent(CARTA::EventType::SET_IMAGE_CHANNELS));
+    EXPECT_FALSE(SessionManager::IsCancelEvent(CARTA::EventType::CLOSE_FILE));
+}
+
+TEST(MessageDispatchTest, UnpopKeepsOrder) {
+    // A dispatch task moving to the other thread pool puts the message back, and the session's dispatch stays active
+    DispatchTestSession session;
+    EXPECT_TRUE(session.QueueInboundMessage(IndexMessage(0)));
+    EXPECT_FALSE(session.QueueInboundMessage(IndexMessage(1)));
+
+    std::vector<char> message;
+    ASSERT_TRUE(session.PopInboundMessage(message));
+    session.UnpopInboundMessage(std::move(message));
+    EXPECT_FALSE(session.QueueInboundMessage(IndexMessage(2)));
+
+    for (int index = 0; index < 3; ++index) {
+        ASSERT_TRUE(session.PopInboundMessage(message));
+        EXPECT_EQ(message, IndexMessage(index));
+    }
+    EXPECT_FALSE(session.PopInboundMessage(message));
+}
+
+TEST(MessageDispatchTest, LongRunningEvents) {
+    EXPECT_TRUE(SessionManager::IsLongRunningEvent(CARTA::EventType::OPEN_FILE));
+    EXPECT_TRUE(SessionManager::IsLongRunningEvent(CARTA::EventType::FILE_INFO_REQUEST));
+    EXPECT_TRUE(SessionManager::IsLongRunningEvent(CARTA::EventType::SET_REGION));
+    EXPECT_TRUE(SessionManager::IsLongRunningEvent(CARTA::EventType::IMPORT_REGION));
+    EXPECT_TRUE(SessionManager::IsLongRunningEvent(CARTA::EventType::OPEN_CATALOG_FILE));
+    EXPECT_FALSE(SessionManager::IsLongRunningEvent(CARTA::EventType::SET_IMAGE_CHANNELS));
+    EXPECT_FALSE(SessionManager::IsLongRunningEvent(CARTA::EventType::SET_CURSOR));
+    EXPECT_FALSE(SessionManager::IsLongRunningEvent(CARTA::EventType::ADD_REQUIRED_TILES));
+    EXPECT_FALSE(SessionManager::IsLongRunningEvent(CARTA::EventType::STOP_MOMENT_CALC));
+}
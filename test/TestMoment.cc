@@ -6,8 +6,10 @@
 
 #include <gtest/gtest.h>
 
+#include "ImageData/FileLoader.h"
 #include "ImageGenerators/ImageMoments.h"
 #include "Logger/Logger.h"
+#include "Timer/Timer.h"
 
 #include <casacore/images/Images/PagedImage.h>
 #include <imageanalysis/ImageAnalysis/ImageMoments.h>
@@ -16,7 +18,7 @@
 
 using namespace carta;
 
-class MomentTest : public ::testing::Test, public FileFinder {
+class MomentTest : public ::testing::Test, public FileFinder, public ImageGenerator {
 public:
     static void GetImageData(std::shared_ptr<const casacore::ImageInterface<casacore::Float>> image, std::vector<float>& data) {
         // Get spectral and stokes indices
@@ -72,14 +74,6 @@ public:
     }
 
     static void GenerateMoments(const std::shared_ptr<casacore::ImageInterface<float>>& image, int moments_axis) {
-        // create casa/carta moments generators
-        casacore::LogOrigin casa_log("casa::ImageMoment", "createMoments", WHERE);
-        casacore::LogIO casa_os(casa_log);
-        casacore::LogOrigin carta_log("carta::ImageMoment", "createMoments", WHERE);
-        casacore::LogIO carta_os(carta_log);
-        casa::ImageMoments<float> casa_image_moments(*image, casa_os, true);
-        carta::ImageMoments<float> carta_image_moments(*image, carta_os, nullptr, true);
-
         // set moment types
         casacore::Vector<casacore::Int> moments(12);
         moments[0] = 0;   // AVERAGE
@@ -95,9 +89,23 @@ public:
         moments[10] = 11; // MINIMUM
         moments[11] = 12; // MINIMUM_COORDINATE
 
-        // the other settings
         casacore::Vector<float> include_pix;
         casacore::Vector<float> exclude_pix;
+        GenerateMoments(image, moments_axis, moments, include_pix, exclude_pix);
+    }
+
+    static void GenerateMoments(const std::shared_ptr<casacore::ImageInterface<float>>& image, int moments_axis,
+        const casacore::Vector<casacore::Int>& moments, const casacore::Vector<float>& include_pix,
+        const casacore::Vector<float>& exclude_pix) {
+        // create casa/carta moments generators
+        casacore::LogOrigin casa_log("casa::ImageMoment", "createMoments", WHERE);
+        casacore::LogIO casa_os(casa_log);
+        casacore::LogOrigin carta_log("carta::ImageMoment", "createMoments", WHERE);
+        casacore::LogIO carta_os(carta_log);
+        casa::ImageMoments<float> casa_image_moments(*image, casa_os, true);
+        carta::ImageMoments<float> carta_image_moments(*image, carta_os, nullptr, true);
+
+        // the other settings
         casacore::Bool do_temp(true);
         casacore::Bool remove_axis(false);
 
@@ -150,3 +158,115 @@ TEST_F(MomentTest, CheckConsistencyForBeamConvolutions) {
         spdlog::warn("Fail to open the file {}! Ignore the Moment test.", file_path);
     }
 }
+
+TEST_F(MomentTest, CheckNativeConsistency) {
+    // Moments other than the median coordinate are calculated natively
+    std::string file_path = FitsImagePath("M17_SWex_unittest.fits");
+    std::shared_ptr<casacore::ImageInterface<float>> image;
+    int moment_axis(2);
+
+    if (OpenImage(image, file_path)) {
+        casacore::Vector<casacore::Int> moments(12);
+        moments[0] = 0;   // AVERAGE
+        moments[1] = 1;   // INTEGRATED
+        moments[2] = 2;   // WEIGHTED_MEAN_COORDINATE
+        moments[3] = 3;   // WEIGHTED_DISPERSION_COORDINATE
+        moments[4] = 4;   // MEDIAN
+        moments[5] = 6;   // STANDARD_DEVIATION
+        moments[6] = 7;   // RMS
+        moments[7] = 8;   // ABS_MEAN_DEVIATION
+        moments[8] = 9;   // MAXIMUM
+        moments[9] = 10;  // MAXIMUM_COORDINATE
+        moments[10] = 11; // MINIMUM
+        moments[11] = 12; // MINIMUM_COORDINATE
+
+        casacore::Vector<float> no_range;
+        casacore::Vector<float> pixel_range(2);
+        pixel_range[0] = 0.0;
+        pixel_range[1] = 0.5;
+        GenerateMoments(image, moment_axis, moments, no_range, no_range);
+        GenerateMoments(image, moment_axis, moments, pixel_range, no_range);
+        GenerateMoments(image, moment_axis, moments, no_range, pixel_range);
+    } else {
+        spdlog::warn("Fail to open the file {}! Ignore the Moment test.", file_path);
+    }
+}
+
+TEST_F(MomentTest, CheckSwizzledConsistency) {
+    // Moments from spectra in the swizzled dataset are the same as from the image
+    auto file_path = GeneratedHdf5ImagePath("40 30 50");
+    std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(file_path));
+    loader->OpenFile("0");
+    ASSERT_TRUE(loader->HasData(FileInfo::Data::SWIZZLED));
+    auto image = loader->GetImage();
+    int depth = image->shape()(2);
+
+    casacore::Vector<casacore::Int> moments(5);
+    moments[0] = 0; // AVERAGE
+    moments[1] = 2; // WEIGHTED_MEAN_COORDINATE
+    moments[2] = 4; // MEDIAN
+    moments[3] = 6; // STANDARD_DEVIATION
+    moments[4] = 9; // MAXIMUM
+
+    casacore::LogOrigin log("carta::ImageMoment", "createMoments", WHERE);
+    casacore::LogIO os(log);
+    carta::ImageMoments<float> image_moments(*image, os, nullptr, true);
+    image_moments.setMoments(moments);
+    image_moments.setMomentAxis(2);
+    auto image_results = image_moments.createMoments(true, "image_moments", false);
+
+    carta::ImageMoments<float> swizzled_moments(*image, os, nullptr, true);
+    swizzled_moments.setMoments(moments);
+    swizzled_moments.setMomentAxis(2);
+    swizzled_moments.SetSpectraReader([&](std::vector<float>& data, int x, int count_x, int y, int count_y) {
+        return loader->GetSwizzledSpectra(data, 0, AxisRange(0, depth - 1), x, count_x, y, count_y);
+    });
+    auto swizzled_results = swizzled_moments.createMoments(true, "swizzled_moments", false);
+
+    ASSERT_EQ(image_results.size(), swizzled_results.size());
+    for (int i = 0; i < image_results.size(); ++i) {
+        CompareImageData(dynamic_pointer_cast<casacore::ImageInterface<casacore::Float>>(image_results[i]),
+            dynamic_pointer_cast<casacore::ImageInterface<casacore::Float>>(swizzled_results[i]));
+    }
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+
+TEST_F(MomentTest, SwizzledPerformance) {
+    // 1 GB cube
+    auto file_path = GeneratedHdf5ImagePath("512 512 1024");
+    std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(file_path));
+    loader->OpenFile("0");
+    ASSERT_TRUE(loader->HasData(FileInfo::Data::SWIZZLED));
+    auto image = loader->GetImage();
+    int depth = image->shape()(2);
+
+    casacore::Vector<casacore::Int> moments(2);
+    moments[0] = 0; // AVERAGE
+    moments[1] = 9; // MAXIMUM
+
+    casacore::LogOrigin log("carta::ImageMoment", "createMoments", WHERE);
+    casacore::LogIO os(log);
+
+    carta::Timer t;
+    carta::ImageMoments<float> image_moments(*image, os, nullptr, true);
+    image_moments.setMoments(moments);
+    image_moments.setMomentAxis(2);
+    image_moments.createMoments(true, "image_moments", false);
+    auto image_time = t.Elapsed();
+
+    t = carta::Timer();
+    carta::ImageMoments<float> swizzled_moments(*image, os, nullptr, true);
+    swizzled_moments.setMoments(moments);
+    swizzled_moments.setMomentAxis(2);
+    swizzled_moments.SetSpectraReader([&](std::vector<float>& data, int x, int count_x, int y, int count_y) {
+        return loader->GetSwizzledSpectra(data, 0, AxisRange(0, depth - 1), x, count_x, y, count_y);
+    });
+    swizzled_moments.createMoments(true, "swizzled_moments", false);
+    auto swizzled_time = t.Elapsed();
+
+    spdlog::info("Moments from image: {:.3f} ms, from swizzled data: {:.3f} ms", image_time.ms(), swizzled_time.ms());
+    EXPECT_LT(swizzled_time.ms(), image_time.ms());
+}
+
+#endif
@@ -0,0 +1,381 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "DataStream/Compression.h"
+#include "Session/OutboundQueue.h"
+#include "Util/Message.h"
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include <zlib.h>
+#include <spdlog/fmt/fmt.h>
+#include "Timer/Timer.h"
+#endif
+
+using namespace carta;
+
+static OutboundMessage MakeOutboundMessage(size_t size, const std::string& key = "", bool compress = false) {
+    OutboundMessage message;
+    message.data.resize(size, 0);
+    message.supersede_key = key;
+    message.compress = compress;
+    return message;
+}
+
+static OutboundMessage MakeEventMessage(uint16_t event_type, uint32_t request_id, size_t payload_size, bool compress = false) {
+    auto message = MakeOutboundMessage(sizeof(EventHeader) + payload_size, "", compress);
+    EventHeader head{event_type, ICD_VERSION, request_id};
+    std::memcpy(message.data.data(), &head, sizeof(EventHeader));
+    for (size_t i = 0; i < payload_size; ++i) {
+        message.data[sizeof(EventHeader) + i] = static_cast<char>(i % 251);
+    }
+    return message;
+}
+
+TEST(OutboundQueueTest, SupersedeKeys) {
+    auto ack = Message::SetRegionAck(1, true, "");
+    EXPECT_TRUE(OutboundQueue::SupersedeKey(CARTA::EventType::SET_REGION_ACK, ack).empty());
+
+    auto cursor_profile = Message::SpatialProfileData(10, 20, 0, 0, 1.0);
+    cursor_profile.set_file_id(0);
+    auto key = OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, cursor_profile);
+    EXPECT_FALSE(key.empty());
+    auto next_cursor_profile = Message::SpatialProfileData(11, 21, 0, 0, 2.0);
+    next_cursor_profile.set_file_id(0);
+    EXPECT_EQ(OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, next_cursor_profile), key);
+
+    auto partial_profile = Message::SpectralProfileData(0, 0.5);
+    EXPECT_FALSE(OutboundQueue::SupersedeKey(CARTA::EventType::SPECTRAL_PROFILE_DATA, partial_profile).empty());
+    auto complete_profile = Message::SpectralProfileData(0, 1.0);
+    EXPECT_TRUE(OutboundQueue::SupersedeKey(CARTA::EventType::SPECTRAL_PROFILE_DATA, complete_profile).empty());
+}
+
+TEST(OutboundQueueTest, TileSupersedeKeys) {
+    auto tile_data = Message::RasterTileData(0, 1, 0);
+    tile_data.set_channel(5);
+    tile_data.set_stokes(0);
+    auto* tile = tile_data.add_tiles();
+    tile->set_layer(2);
+    tile->set_x(1);
+    tile->set_y(3);
+    auto key = OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, tile_data);
+    EXPECT_FALSE(key.empty());
+    EXPECT_EQ(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, tile_data), key);
+
+    // Tiles for another channel, stokes or tile sync are not superseded
+    auto other_channel = tile_data;
+    other_channel.set_channel(6);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, other_channel), key);
+    auto other_stokes = tile_data;
+    other_stokes.set_stokes(1);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, other_stokes), key);
+    auto other_sync = tile_data;
+    other_sync.set_sync_id(2);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, other_sync), key);
+    auto other_position = tile_data;
+    other_position.mutable_tiles(0)->set_x(2);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, other_position), key);
+
+    // Messages with several tiles are always delivered
+    tile_data.add_tiles();
+    EXPECT_TRUE(OutboundQueue::SupersedeKey(CARTA::EventType::RASTER_TILE_DATA, tile_data).empty());
+}
+
+TEST(OutboundQueueTest, SpatialProfileSupersedeKeys) {
+    std::vector<float> profile(10, 1.0);
+    std::string unit("arcsec");
+    std::string coordinate_i("I"), coordinate_q("Q");
+    auto line_profile = Message::SpatialProfileData(
+        0, 1, 0, 0, 0, 0, 0.0, 0, 9, profile, coordinate_i, 0, CARTA::ProfileAxisType::Offset, 5.0, 0.0, 1.0, unit);
+    auto key = OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, line_profile);
+    EXPECT_FALSE(key.empty());
+
+    // Profiles of other line regions or coordinates are not superseded
+    auto other_coordinate = Message::SpatialProfileData(
+        0, 1, 0, 0, 0, 1, 0.0, 0, 9, profile, coordinate_q, 0, CARTA::ProfileAxisType::Offset, 5.0, 0.0, 1.0, unit);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, other_coordinate), key);
+    auto other_region = Message::SpatialProfileData(
+        0, 2, 0, 0, 0, 0, 0.0, 0, 9, profile, coordinate_i, 0, CARTA::ProfileAxisType::Offset, 5.0, 0.0, 1.0, unit);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, other_region), key);
+
+    // Line profile is not superseded by a point profile with the same coordinate
+    auto point_profile = Message::SpatialProfileData(10, 20, 0, 0, 1.0);
+    point_profile.set_file_id(0);
+    point_profile.set_region_id(1);
+    point_profile.add_profiles()->set_coordinate(coordinate_i);
+    EXPECT_NE(OutboundQueue::SupersedeKey(CARTA::EventType::SPATIAL_PROFILE_DATA, point_profile), key);
+}
+
+TEST(OutboundQueueTest, KeepsSupersededMessagesWithinBudget) {
+    OutboundQueue queue(1000);
+    queue.Push(MakeOutboundMessage(100, "cursor"));
+    queue.Push(MakeOutboundMessage(100, "cursor"));
+
+    auto stats = queue.Stats();
+    EXPECT_EQ(stats.queued_bytes, 200);
+    EXPECT_EQ(stats.dropped_count, 0);
+}
+
+TEST(OutboundQueueTest, DropsSupersededMessagesOverBudget) {
+    OutboundQueue queue(1000);
+    queue.Push(MakeOutboundMessage(600, "tile"));
+    queue.Push(MakeOutboundMessage(300));
+    queue.Push(MakeOutboundMessage(500, "tile"));
+
+    auto stats = queue.Stats();
+    EXPECT_EQ(stats.queued_bytes, 800);
+    EXPECT_EQ(stats.dropped_count, 1);
+    EXPECT_EQ(stats.dropped_bytes, 600);
+    EXPECT_EQ(stats.peak_bytes, 900);
+
+    // Order of the remaining messages is preserved
+    OutboundMessage message;
+    ASSERT_TRUE(queue.Pop(message, 0));
+    EXPECT_EQ(message.data.size(), 300);
+    ASSERT_TRUE(queue.Pop(message, 0));
+    EXPECT_EQ(message.data.size(), 500);
+    EXPECT_FALSE(queue.Pop(message, 0));
+}
+
+TEST(OutboundQueueTest, CriticalMessagesAlwaysQueued) {
+    OutboundQueue queue(100);
+    for (int i = 0; i < 10; ++i) {
+        queue.Push(MakeOutboundMessage(50));
+    }
+
+    auto stats = queue.Stats();
+    EXPECT_EQ(stats.queued_bytes, 500);
+    EXPECT_EQ(stats.dropped_count, 0);
+    EXPECT_TRUE(queue.OverBudget());
+}
+
+TEST(OutboundQueueTest, HoldsMessagesWhileSocketBuffered) {
+    OutboundQueue queue(1000);
+    queue.Push(MakeOutboundMessage(100));
+
+    OutboundMessage message;
+    EXPECT_FALSE(queue.Pop(message, 2000));
+    EXPECT_EQ(queue.Stats().queued_bytes, 100);
+
+    // Socket buffer counts towards the budget, so the next profile supersedes the held one
+    queue.Push(MakeOutboundMessage(100, "profile"));
+    queue.Push(MakeOutboundMessage(100, "profile"));
+    EXPECT_EQ(queue.Stats().dropped_count, 1);
+
+    EXPECT_TRUE(queue.Pop(message, 0));
+    EXPECT_TRUE(queue.Pop(message, 0));
+    EXPECT_FALSE(queue.Pop(message, 0));
+}
+
+TEST(OutboundQueueTest, PoppedMessagesAreNotSuperseded) {
+    OutboundQueue queue(100);
+    queue.Push(MakeOutboundMessage(80, "profile"));
+
+    OutboundMessage message;
+    ASSERT_TRUE(queue.Pop(message, 0));
+    queue.SetBufferedAmount(80);
+    queue.Push(MakeOutboundMessage(80, "profile"));
+
+    auto stats = queue.Stats();
+    EXPECT_EQ(stats.queued_bytes, 80);
+    EXPECT_EQ(stats.dropped_count, 0);
+}
+
+TEST(OutboundQueueTest, SingleMessageBatchIsUnwrapped) {
+    OutboundBatch batch;
+    auto message = MakeEventMessage(CARTA::EventType::RASTER_TILE_SYNC, 1, 100);
+    auto expected = message.data;
+    ASSERT_TRUE(batch.Add(message));
+
+    auto frame = batch.Frame();
+    ASSERT_EQ(frame.size(), expected.size());
+    EXPECT_EQ(std::memcmp(frame.data(), expected.data(), expected.size()), 0);
+    EXPECT_EQ(OutboundBatch::Unpack(frame).size(), 1);
+}
+
+TEST(OutboundQueueTest, BatchRoundTrip) {
+    OutboundBatch batch;
+    std::vector<std::vector<char>> expected;
+    for (int i = 0; i < 62; ++i) {
+        auto message = MakeEventMessage(CARTA::EventType::RASTER_TILE_DATA, i, 1000 + i);
+        expected.push_back(message.data);
+        ASSERT_TRUE(batch.Add(message));
+    }
+    EXPECT_EQ(batch.Count(), 62);
+
+    auto frame = batch.Frame();
+    EventHeader head;
+    std::memcpy(&head, frame.data(), sizeof(EventHeader));
+    EXPECT_EQ(head.type, BATCHED_EVENTS_EVENT_TYPE);
+
+    auto messages = OutboundBatch::Unpack(frame);
+    ASSERT_EQ(messages.size(), expected.size());
+    for (int i = 0; i < messages.size(); ++i) {
+        ASSERT_EQ(messages[i].size(), expected[i].size());
+        EXPECT_EQ(std::memcmp(messages[i].data(), expected[i].data(), expected[i].size()), 0);
+    }
+}
+
+TEST(OutboundQueueTest, BatchLimits) {
+    OutboundBatch batch(4096);
+    auto first = MakeEventMessage(CARTA::EventType::SPATIAL_PROFILE_DATA, 0, 1000, true);
+    auto uncompressed = MakeEventMessage(CARTA::EventType::RASTER_TILE_DATA, 0, 1000, false);
+    auto large = MakeEventMessage(CARTA::EventType::SPATIAL_PROFILE_DATA, 0, 4000, true);
+    ASSERT_TRUE(batch.Add(first));
+
+    // Different compression setting or exceeding the size limit starts a new batch
+    EXPECT_FALSE(batch.Add(uncompressed));
+    EXPECT_EQ(uncompressed.data.size(), sizeof(EventHeader) + 1000);
+    EXPECT_FALSE(batch.Add(large));
+    EXPECT_EQ(batch.Count(), 1);
+    EXPECT_TRUE(batch.Compress());
+
+    batch.Clear();
+    EXPECT_TRUE(batch.Empty());
+    EXPECT_TRUE(batch.Add(large));
+}
+
+TEST(OutboundQueueTest, ZstdPayloadRoundTrip) {
+    auto message = MakeEventMessage(CARTA::EventType::SPATIAL_PROFILE_DATA, 3, 10000);
+    auto original = message.data;
+    for (int level = 1; level <= 3; ++level) {
+        auto compressed = original;
+        ASSERT_TRUE(ZstdCompressPayload(compressed, sizeof(EventHeader), level));
+        EXPECT_LT(compressed.size(), original.size());
+        // Header is left untouched
+        EXPECT_EQ(std::memcmp(compressed.data(), original.data(), sizeof(EventHeader)), 0);
+        ASSERT_TRUE(ZstdDecompressPayload(compressed, sizeof(EventHeader)));
+        EXPECT_EQ(compressed, original);
+    }
+}
+
+TEST(OutboundQueueTest, ZstdSkipsIncompressiblePayload) {
+    std::mt19937 mt(0);
+    std::uniform_int_distribution<int> byte_random(0, 255);
+    std::vector<char> buffer(sizeof(EventHeader) + 2048);
+    for (auto& v : buffer) {
+        v = static_cast<char>(byte_random(mt));
+    }
+    auto original = buffer;
+    EXPECT_FALSE(ZstdCompressPayload(buffer, sizeof(EventHeader), 1));
+    EXPECT_EQ(buffer, original);
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST(OutboundQueueTest, ZstdDeflatePerformance) {
+    std::mt19937 mt(0);
+    std::uniform_real_distribution<float> float_random(0, 1.0f);
+
+    // Uncompressed raster tile, spatial profile and catalog column payloads
+    std::vector<std::pair<std::string, std::vector<char>>> payloads;
+    std::vector<float> tile(256 * 256);
+    for (int i = 0; i < tile.size(); ++i) {
+        tile[i] = std::round(float_random(mt) * 1000.0f) * 1.0e-3f + (i % 256) * 0.01f;
+    }
+    std::vector<float> profile(8192);
+    for (int i = 0; i < profile.size(); ++i) {
+        profile[i] = std::sin(i * 0.01f) + float_random(mt) * 0.01f;
+    }
+    std::vector<double> column(100000);
+    for (int i = 0; i < column.size(); ++i) {
+        column[i] = 180.0 + i * 1.0e-4;
+    }
+    auto add_payload = [&](const std::string& name, const char* data, size_t size) {
+        std::vector<char> buffer(sizeof(EventHeader) + size);
+        std::memcpy(buffer.data() + sizeof(EventHeader), data, size);
+        payloads.emplace_back(name, buffer);
+    };
+    add_payload("raster tile", (const char*)tile.data(), tile.size() * sizeof(float));
+    add_payload("spatial profile", (const char*)profile.data(), profile.size() * sizeof(float));
+    add_payload("catalog column", (const char*)column.data(), column.size() * sizeof(double));
+
+    for (auto& [name, payload] : payloads) {
+        double payload_mb = payload.size() / 1.0e6;
+
+        carta::Timer t_deflate;
+        uLongf deflate_size = compressBound(payload.size());
+        std::vector<Bytef> deflate_buffer(deflate_size);
+        compress2(deflate_buffer.data(), &deflate_size, (const Bytef*)payload.data(), payload.size(), Z_BEST_SPEED);
+        double deflate_ms = t_deflate.Elapsed().ms();
+        fmt::print("{}: deflate {:.3f} ms/MB, ratio {:.2f}\n", name, deflate_ms / payload_mb, (double)payload.size() / deflate_size);
+
+        for (int level = 1; level <= 3; ++level) {
+            auto buffer = payload;
+            carta::Timer t_zstd;
+            ZstdCompressPayload(buffer, sizeof(EventHeader), level);
+            double zstd_ms = t_zstd.Elapsed().ms();
+            fmt::print("{}: zstd level {} {:.3f} ms/MB, ratio {:.2f}\n", name, level, zstd_ms / payload_mb,
+                (double)payload.size() / buffer.size());
+        }
+    }
+}
+
+TEST(OutboundQueueTest, BatchedDeflatePerformance) {
+    // Tile request with 60 uncompressed tiles and two sync messages
+    std::mt19937 mt(0);
+    std::uniform_real_distribution<float> float_random(0, 1.0f);
+    std::vector<OutboundMessage> messages;
+    messages.push_back(MakeEventMessage(CARTA::EventType::RASTER_TILE_SYNC, 0, 32, true));
+    for (int i = 0; i < 60; ++i) {
+        std::vector<float> tile(256 * 256);
+        for (int j = 0; j < tile.size(); ++j) {
+            tile[j] = std::round(float_random(mt) * 100.0f) + j / 256;
+        }
+        auto message = MakeEventMessage(CARTA::EventType::RASTER_TILE_DATA, 0, tile.size() * sizeof(float), true);
+        std::memcpy(message.data.data() + sizeof(EventHeader), tile.data(), tile.size() * sizeof(float));
+        messages.push_back(message);
+    }
+    messages.push_back(MakeEventMessage(CARTA::EventType::RASTER_TILE_SYNC, 0, 32, true));
+
+    auto deflate_frames = [](const std::vector<std::string_view>& frames) {
+        size_t compressed_size(0);
+        for (auto& frame : frames) {
+            uLongf dest_size = compressBound(frame.size());
+            std::vector<Bytef> dest(dest_size);
+            compress2(dest.data(), &dest_size, (const Bytef*)frame.data(), frame.size(), Z_BEST_SPEED);
+            compressed_size += dest_size;
+        }
+        return compressed_size;
+    };
+
+    size_t total_bytes(0);
+    std::vector<std::string_view> single_frames;
+    for (auto& message : messages) {
+        single_frames.emplace_back(message.data.data(), message.data.size());
+        total_bytes += message.data.size();
+    }
+    carta::Timer t_single;
+    deflate_frames(single_frames);
+    double single_ms = t_single.Elapsed().ms();
+
+    carta::Timer t_batched;
+    std::vector<OutboundBatch> batches(1, OutboundBatch(MAX_BATCH_SIZE_KB * 1024));
+    std::vector<std::string_view> batched_frames;
+    for (auto message : messages) {
+        if (!batches.back().Add(message)) {
+            batches.emplace_back(MAX_BATCH_SIZE_KB * 1024);
+            batches.back().Add(message);
+        }
+    }
+    for (auto& batch : batches) {
+        batched_frames.push_back(batch.Frame());
+    }
+    deflate_frames(batched_frames);
+    double batched_ms = t_batched.Elapsed().ms();
+
+    double total_mb = total_bytes / 1.0e6;
+    fmt::print("Single messages: {} frames, {:.1f} frames/s, {:.3f} ms/MB\n", single_frames.size(),
+        single_frames.size() / (single_ms * 1.0e-3), single_ms / total_mb);
+    fmt::print("Batched messages: {} frames, {:.1f} frames/s, {:.3f} ms/MB\n", batched_frames.size(),
+        batched_frames.size() / (batched_ms * 1.0e-3), batched_ms / total_mb);
+    EXPECT_LT(batched_frames.size(), single_frames.size());
+}
+#endif
@@ -63,6 +63,7 @@ public:
         }
         EXPECT_TRUE(p1.omp_thread_count == p2.omp_thread_count);
         EXPECT_TRUE(p1.event_thread_count == p2.event_thread_count);
+        EXPECT_TRUE(p1.dispatch_thread_count == p2.dispatch_thread_count);
         EXPECT_TRUE(p1.top_level_folder == p2.top_level_folder);
         EXPECT_TRUE(p1.starting_folder == p2.starting_folder);
         EXPECT_TRUE(p1.host == p2.host);
@@ -165,6 +166,15 @@ TEST_F(ProgramSettingsTest, ExpectedValuesLong) {
     EXPECT_EQ(settings.enable_scripting, true);
 }
 
+TEST_F(ProgramSettingsTest, ThreadCounts) {
+    auto settings = SettingsFromString("carta_backend");
+    EXPECT_EQ(settings.event_thread_count, 2);
+    EXPECT_EQ(settings.dispatch_thread_count, 2);
+    settings = SettingsFromString("carta_backend --event_thread_count 6 --dispatch_thread_count 3");
+    EXPECT_EQ(settings.event_thread_count, 6);
+    EXPECT_EQ(settings.dispatch_thread_count, 3);
+}
+
 TEST_F(ProgramSettingsTest, ExpectedValuesShort) {
     auto settings = SettingsFromString("carta_backend -p 1234 -t 10");
     EXPECT_EQ(settings.port[0], 1234);
@@ -4,6 +4,12 @@
    SPDX-License-Identifier: GPL-3.0-or-later
 */
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <casacore/lattices/LRegions/LCEllipsoid.h>
+#include <casacore/lattices/LRegions/LCPolygon.h>
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
@@ -13,6 +19,9 @@
 #include "Region/RegionHandler.h"
 #include "src/Frame/Frame.h"
 
+// casacore regions are defined and evaluated in single precision
+#define BOUNDARY_TOLERANCE 1.0e-3
+
 using namespace carta;
 
 class RegionTest : public ::testing::Test {
@@ -28,6 +37,36 @@ public:
         RegionState region_state(file_id, type, control_points, rotation);
         return region_handler.SetRegion(region_id, region_state, csys);
     }
+
+    // Pixels of the image (width x height) in the region, from the mask of its bounding box
+    static std::vector<bool> ImageMask(const casacore::LCRegion* region, int width, int height) {
+        std::vector<bool> pixels(width * height, false);
+        auto fixed_region = dynamic_cast<const casacore::LCRegionFixed*>(region);
+        if (fixed_region) {
+            const auto& mask = fixed_region->getMask();
+            auto blc = fixed_region->boundingBox().start();
+            for (int y = 0; y < mask.shape()(1); ++y) {
+                for (int x = 0; x < mask.shape()(0); ++x) {
+                    if (mask(casacore::IPosition(2, x, y))) {
+                        pixels[(blc(1) + y) * width + blc(0) + x] = true;
+                    }
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // Pixels may only differ where their centers are on the boundary
+    static void CompareMasks(const std::vector<bool>& mask, const std::vector<bool>& lc_mask, int width, int height,
+        std::function<bool(double, double)> on_boundary) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (mask[y * width + x] != lc_mask[y * width + x]) {
+                    ASSERT_TRUE(on_boundary(x, y)) << "pixel " << x << "," << y << " previous mask " << lc_mask[y * width + x];
+                }
+            }
+        }
+    }
 };
 
 TEST_F(RegionTest, TestSetUpdateRemoveRegion) {
@@ -416,3 +455,85 @@ TEST_F(RegionTest, TestReferenceImagePolygonRecord) {
     ASSERT_FLOAT_EQ(y[2], points[5]);
     ASSERT_FLOAT_EQ(y[3], points[7]);
 }
+
+TEST_F(RegionTest, TestRotboxMaskMatchesLCPolygon) {
+    std::string image_path = FileFinder::FitsImagePath("noise_3d.fits"); // 10x10x10
+    std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(image_path));
+    std::shared_ptr<Frame> frame(new Frame(0, loader, "0"));
+    auto csys = frame->CoordinateSystem();
+    auto image_shape = frame->ImageShape();
+    int width(image_shape(0)), height(image_shape(1));
+
+    // Center, size, and rotation; some rectangles extend past the image
+    std::vector<std::vector<float>> rectangles = {{5.0, 5.0, 4.0, 3.0, 30.0}, {4.3, 5.7, 6.2, 2.5, 65.0}, {2.0, 7.5, 9.0, 4.0, 110.0},
+        {6.6, 3.1, 3.3, 8.8, 200.0}, {5.0, 5.0, 14.0, 6.0, 45.0}, {8.2, 1.4, 5.0, 5.0, 315.0}};
+    carta::RegionHandler region_handler;
+    int file_id(0);
+    for (const auto& rectangle : rectangles) {
+        int region_id(-1);
+        std::vector<float> points(rectangle.begin(), rectangle.begin() + 4);
+        ASSERT_TRUE(SetRegion(region_handler, file_id, region_id, CARTA::RegionType::RECTANGLE, points, rectangle[4], csys));
+        auto region = region_handler.GetRegion(region_id);
+        ASSERT_TRUE(region);
+        auto lc_region = region->GetImageRegion(file_id, csys, image_shape);
+        ASSERT_TRUE(lc_region);
+
+        // Previous LCRegion was the polygon of the rotated corners
+        casacore::Vector<casacore::Double> x, y;
+        ASSERT_TRUE(region->GetRegionState().GetRectangleCorners(x, y));
+        casacore::LCPolygon polygon(x, y, casacore::IPosition(2, width, height));
+        auto on_boundary = [&](double px, double py) {
+            for (size_t i = 0, j = x.size() - 1; i < x.size(); j = i++) {
+                double dx(x(i) - x(j)), dy(y(i) - y(j));
+                double t = std::max(0.0, std::min(1.0, ((px - x(j)) * dx + (py - y(j)) * dy) / (dx * dx + dy * dy)));
+                if (std::hypot(px - x(j) - t * dx, py - y(j) - t * dy) < BOUNDARY_TOLERANCE) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        CompareMasks(ImageMask(lc_region.get(), width, height), ImageMask(&polygon, width, height), width, height, on_boundary);
+    }
+}
+
+TEST_F(RegionTest, TestRotatedEllipseMaskMatchesLCEllipsoid) {
+    std::string image_path = FileFinder::FitsImagePath("noise_3d.fits"); // 10x10x10
+    std::shared_ptr<carta::FileLoader> loader(carta::FileLoader::GetLoader(image_path));
+    std::shared_ptr<Frame> frame(new Frame(0, loader, "0"));
+    auto csys = frame->CoordinateSystem();
+    auto image_shape = frame->ImageShape();
+    int width(image_shape(0)), height(image_shape(1));
+
+    // Center, semi-axes (bmaj, bmin), and rotation; includes bmaj < bmin and ellipses extending past the image
+    std::vector<std::vector<float>> ellipses = {{5.0, 5.0, 4.0, 3.0, 30.0}, {4.3, 5.7, 2.5, 4.2, 65.0}, {2.0, 7.5, 5.0, 1.5, 110.0},
+        {6.6, 3.1, 3.3, 3.3, 20.0}, {5.0, 5.0, 7.0, 3.0, 135.0}, {8.2, 1.4, 2.0, 6.0, 315.0}};
+    carta::RegionHandler region_handler;
+    int file_id(0);
+    for (const auto& ellipse : ellipses) {
+        int region_id(-1);
+        std::vector<float> points(ellipse.begin(), ellipse.begin() + 4);
+        ASSERT_TRUE(SetRegion(region_handler, file_id, region_id, CARTA::RegionType::ELLIPSE, points, ellipse[4], csys));
+        auto region = region_handler.GetRegion(region_id);
+        ASSERT_TRUE(region);
+        auto lc_region = region->GetImageRegion(file_id, csys, image_shape);
+        ASSERT_TRUE(lc_region);
+
+        // Previous LCRegion was the LCEllipsoid of the control points record, with the major axis at theta from the x-axis
+        float cx(points[0]), cy(points[1]), bmaj(points[2]), bmin(points[3]);
+        float major(bmaj), minor(bmin), rotation(ellipse[4] + 90.0);
+        if (bmaj <= bmin) {
+            major = bmin;
+            minor = bmaj;
+            rotation = ellipse[4];
+        }
+        float theta = rotation * M_PI / 180.0;
+        casacore::LCEllipsoid lc_ellipse(cx, cy, major, minor, theta, casacore::IPosition(2, width, height));
+        auto on_boundary = [&](double px, double py) {
+            double u = (px - cx) * std::cos(theta) + (py - cy) * std::sin(theta);
+            double v = -(px - cx) * std::sin(theta) + (py - cy) * std::cos(theta);
+            double r = std::sqrt((u * u) / (major * major) + (v * v) / (minor * minor));
+            return std::abs(r - 1.0) * minor < BOUNDARY_TOLERANCE;
+        };
+        CompareMasks(ImageMask(lc_region.get(), width, height), ImageMask(&lc_ellipse, width, height), width, height, on_boundary);
+    }
+}
@@ -0,0 +1,341 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <casacore/casa/Arrays/Vector.h>
+#include <casacore/lattices/LRegions/LCEllipsoid.h>
+#include <casacore/lattices/LRegions/LCPolygon.h>
+#include <gtest/gtest.h>
+
+#include "Region/RegionMask.h"
+
+// Pixel centers closer to the boundary may be rounded either way
+#define BOUNDARY_TOLERANCE 1.0e-5
+// casacore regions are defined and evaluated in single precision
+#define CASACORE_BOUNDARY_TOLERANCE 1.0e-3
+
+#define OUTSIDE 0
+#define INSIDE 1
+#define BOUNDARY 2
+
+using namespace carta;
+
+class RegionMaskTest : public ::testing::Test {
+public:
+    std::mt19937 mt;
+
+    RegionMaskTest() : mt(42) {}
+
+    // Pixel center inside (even-odd rule), outside, or on an edge of the polygon
+    static int InPolygon(
+        const std::vector<double>& x, const std::vector<double>& y, double px, double py, double tolerance = BOUNDARY_TOLERANCE) {
+        bool inside(false);
+        size_t npoints = x.size();
+        for (size_t i = 0, j = npoints - 1; i < npoints; j = i++) {
+            double dx(x[i] - x[j]), dy(y[i] - y[j]);
+            double t = std::max(0.0, std::min(1.0, ((px - x[j]) * dx + (py - y[j]) * dy) / (dx * dx + dy * dy)));
+            if (std::hypot(px - x[j] - t * dx, py - y[j] - t * dy) < tolerance) {
+                return BOUNDARY;
+            }
+            if ((y[i] > py) != (y[j] > py) && px < x[j] + (py - y[j]) * dx / dy) {
+                inside = !inside;
+            }
+        }
+        return inside ? INSIDE : OUTSIDE;
+    }
+
+    // Pixel center inside, outside, or on the boundary of the ellipse
+    static int InEllipse(double cx, double cy, double rx, double ry, double theta, double px, double py,
+        double tolerance = BOUNDARY_TOLERANCE) {
+        double u = (px - cx) * std::cos(theta) + (py - cy) * std::sin(theta);
+        double v = -(px - cx) * std::sin(theta) + (py - cy) * std::cos(theta);
+        double r = std::sqrt((u * u) / (rx * rx) + (v * v) / (ry * ry));
+        if (std::abs(r - 1.0) * std::min(rx, ry) < tolerance) {
+            return BOUNDARY;
+        }
+        return r < 1.0 ? INSIDE : OUTSIDE;
+    }
+
+    // Pixels of the full image (width x height) in the mask
+    static std::vector<bool> ImageMask(const std::shared_ptr<RegionMask>& mask, int width, int height) {
+        std::vector<bool> pixels(static_cast<size_t>(width) * height, false);
+        if (mask) {
+            std::unique_ptr<bool[]> mask_pixels(new bool[static_cast<size_t>(mask->Width()) * mask->Height()]);
+            mask->FillMask(mask_pixels.get());
+            for (int y = 0; y < mask->Height(); ++y) {
+                for (int x = 0; x < mask->Width(); ++x) {
+                    if (mask_pixels[static_cast<size_t>(y) * mask->Width() + x]) {
+                        pixels[static_cast<size_t>(mask->BlcY() + y) * width + mask->BlcX() + x] = true;
+                    }
+                }
+            }
+        }
+        return pixels;
+    }
+
+    static std::vector<bool> ImageMask(const casacore::LCRegionFixed& region, int width, int height) {
+        std::vector<bool> pixels(static_cast<size_t>(width) * height, false);
+        const auto& mask = region.getMask();
+        auto blc = region.boundingBox().start();
+        for (int y = 0; y < mask.shape()(1); ++y) {
+            for (int x = 0; x < mask.shape()(0); ++x) {
+                if (mask(casacore::IPosition(2, x, y))) {
+                    pixels[static_cast<size_t>(blc(1) + y) * width + blc(0) + x] = true;
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // Compares every pixel of the image, including those crossed by the edges of the shape or outside the bounding box, except pixel
+    // centers on the boundary
+    static void CompareMasks(const std::vector<bool>& mask, const std::vector<bool>& casacore_mask, int width, int height,
+        std::function<int(double, double)> in_region) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t i = static_cast<size_t>(y) * width + x;
+                if (mask[i] != casacore_mask[i]) {
+                    ASSERT_EQ(in_region(x, y), BOUNDARY) << "pixel " << x << "," << y << " casacore " << casacore_mask[i];
+                }
+            }
+        }
+    }
+
+    // Shape in single precision, as for casacore
+    static void ToFloat(std::vector<double>& values) {
+        for (auto& value : values) {
+            value = static_cast<float>(value);
+        }
+    }
+
+    void CheckPolygon(std::vector<double> x, std::vector<double> y, int width, int height) {
+        ToFloat(x);
+        ToFloat(y);
+        auto mask = RegionMask::Polygon(x, y, width, height);
+        std::vector<bool> casacore_mask(static_cast<size_t>(width) * height, false);
+        try {
+            casacore::Vector<casacore::Float> lc_x(x.size()), lc_y(y.size());
+            for (size_t i = 0; i < x.size(); ++i) {
+                lc_x(i) = x[i];
+                lc_y(i) = y[i];
+            }
+            casacore::LCPolygon polygon(lc_x, lc_y, casacore::IPosition(2, width, height));
+            casacore_mask = ImageMask(polygon, width, height);
+        } catch (const casacore::AipsError& err) {
+            // Polygon outside the image
+        }
+        CompareMasks(ImageMask(mask, width, height), casacore_mask, width, height,
+            [&](double px, double py) { return InPolygon(x, y, px, py, CASACORE_BOUNDARY_TOLERANCE); });
+    }
+
+    static std::vector<int> ExpectedMask(const RegionMask& mask, std::function<int(double, double)> in_region) {
+        std::vector<int> expected;
+        for (int y = mask.BlcY(); y < mask.BlcY() + mask.Height(); ++y) {
+            for (int x = mask.BlcX(); x < mask.BlcX() + mask.Width(); ++x) {
+                expected.push_back(in_region(x, y));
+            }
+        }
+        return expected;
+    }
+
+    static void CheckMask(const RegionMask& mask, const std::vector<int>& expected) {
+        std::unique_ptr<bool[]> pixels(new bool[expected.size()]);
+        mask.FillMask(pixels.get());
+        size_t num_pixels(0);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i] != BOUNDARY) {
+                ASSERT_EQ(pixels[i], expected[i] == INSIDE) << "pixel " << i;
+            }
+            num_pixels += pixels[i];
+        }
+        ASSERT_EQ(mask.NumPixels(), num_pixels);
+    }
+};
+
+TEST_F(RegionMaskTest, PolygonMatchesPixelCenters) {
+    std::uniform_real_distribution<double> position(-5.0, 45.0);
+    int width(40), height(30);
+    for (int npoints : {3, 4, 5, 9}) {
+        for (int trial = 0; trial < 20; ++trial) {
+            // Random polygons may be self-intersecting
+            std::vector<double> x(npoints), y(npoints);
+            for (int i = 0; i < npoints; ++i) {
+                x[i] = position(mt);
+                y[i] = position(mt);
+            }
+            auto mask = RegionMask::Polygon(x, y, width, height);
+            ASSERT_TRUE(mask);
+            auto expected = ExpectedMask(*mask, [&](double px, double py) { return InPolygon(x, y, px, py); });
+            CheckMask(*mask, expected);
+        }
+    }
+}
+
+TEST_F(RegionMaskTest, EllipseMatchesPixelCenters) {
+    std::uniform_real_distribution<double> position(0.0, 40.0);
+    std::uniform_real_distribution<double> radius(0.5, 15.0);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    int width(40), height(30);
+    for (int trial = 0; trial < 50; ++trial) {
+        double cx(position(mt)), cy(position(mt)), rx(radius(mt)), ry(radius(mt)), theta(angle(mt));
+        auto mask = RegionMask::Ellipse(cx, cy, rx, ry, theta, width, height);
+        if (!mask) {
+            continue;
+        }
+        auto expected = ExpectedMask(*mask, [&](double px, double py) { return InEllipse(cx, cy, rx, ry, theta, px, py); });
+        CheckMask(*mask, expected);
+    }
+}
+
+TEST_F(RegionMaskTest, PolygonMatchesLCPolygon) {
+    // Vertices outside the image, so that edges cross the image boundary
+    std::uniform_real_distribution<double> position(-5.0, 45.0);
+    int width(40), height(30);
+    for (int npoints : {3, 4, 5, 9}) {
+        for (int trial = 0; trial < 20; ++trial) {
+            std::vector<double> x(npoints), y(npoints);
+            for (int i = 0; i < npoints; ++i) {
+                x[i] = position(mt);
+                y[i] = position(mt);
+            }
+            CheckPolygon(x, y, width, height);
+        }
+    }
+}
+
+TEST_F(RegionMaskTest, RotatedRectangleMatchesLCPolygon) {
+    std::uniform_real_distribution<double> position(-5.0, 45.0);
+    std::uniform_real_distribution<double> size(0.5, 30.0);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    int width(40), height(30);
+    for (int trial = 0; trial < 50; ++trial) {
+        double cx(position(mt)), cy(position(mt)), half_width(size(mt) / 2), half_height(size(mt) / 2), theta(angle(mt));
+        std::vector<double> x, y;
+        for (auto corner : {std::make_pair(-1, -1), std::make_pair(1, -1), std::make_pair(1, 1), std::make_pair(-1, 1)}) {
+            double dx(corner.first * half_width), dy(corner.second * half_height);
+            x.push_back(cx + dx * std::cos(theta) - dy * std::sin(theta));
+            y.push_back(cy + dx * std::sin(theta) + dy * std::cos(theta));
+        }
+        CheckPolygon(x, y, width, height);
+    }
+}
+
+TEST_F(RegionMaskTest, EllipseMatchesLCEllipsoid) {
+    std::uniform_real_distribution<double> position(-5.0, 45.0);
+    std::uniform_real_distribution<double> radius(0.5, 15.0);
+    std::uniform_real_distribution<double> angle(-M_PI / 2, M_PI / 2);
+    int width(40), height(30);
+    for (int trial = 0; trial < 100; ++trial) {
+        // LCEllipsoid major axis is at angle theta from the x-axis
+        float cx(position(mt)), cy(position(mt)), r1(radius(mt)), r2(radius(mt)), theta(angle(mt));
+        float major(std::max(r1, r2)), minor(std::min(r1, r2));
+        auto mask = RegionMask::Ellipse(cx, cy, major, minor, theta, width, height);
+        std::vector<bool> casacore_mask(static_cast<size_t>(width) * height, false);
+        try {
+            casacore::LCEllipsoid ellipse(cx, cy, major, minor, theta, casacore::IPosition(2, width, height));
+            casacore_mask = ImageMask(ellipse, width, height);
+        } catch (const casacore::AipsError& err) {
+            // Ellipse outside the image
+        }
+        CompareMasks(ImageMask(mask, width, height), casacore_mask, width, height,
+            [&](double px, double py) { return InEllipse(cx, cy, major, minor, theta, px, py, CASACORE_BOUNDARY_TOLERANCE); });
+    }
+}
+
+TEST_F(RegionMaskTest, BoundaryPixelsIncluded) {
+    // Square with pixel centers on the edges
+    auto square = RegionMask::Polygon({1.0, 1.0, 4.0, 4.0}, {1.0, 4.0, 4.0, 1.0}, 10, 10);
+    ASSERT_TRUE(square);
+    EXPECT_EQ(square->BlcX(), 1);
+    EXPECT_EQ(square->BlcY(), 1);
+    EXPECT_EQ(square->Width(), 4);
+    EXPECT_EQ(square->Height(), 4);
+    EXPECT_EQ(square->NumPixels(), 16);
+    EXPECT_EQ(square->Runs().size(), 4);
+
+    // Bounding boxes as for rectangle (center 5,5 size 4x3) and ellipse (center 5,5 radii 3,4) LCRegions
+    auto rectangle = RegionMask::Polygon({3.0, 7.0, 7.0, 3.0}, {3.5, 3.5, 6.5, 6.5}, 10, 10);
+    ASSERT_TRUE(rectangle);
+    EXPECT_EQ(rectangle->Width(), 5);
+    EXPECT_EQ(rectangle->Height(), 3);
+    EXPECT_EQ(rectangle->NumPixels(), 15);
+
+    auto ellipse = RegionMask::Ellipse(5.0, 5.0, 3.0, 4.0, 0.0, 10, 10);
+    ASSERT_TRUE(ellipse);
+    EXPECT_EQ(ellipse->BlcX(), 2);
+    EXPECT_EQ(ellipse->BlcY(), 1);
+    EXPECT_EQ(ellipse->Width(), 7);
+    EXPECT_EQ(ellipse->Height(), 9);
+
+    // Triangle with a horizontal top edge through pixel centers
+    auto triangle = RegionMask::Polygon({0.0, 4.0, 2.0}, {2.0, 2.0, 0.0}, 10, 10);
+    ASSERT_TRUE(triangle);
+    EXPECT_EQ(triangle->NumPixels(), 9);
+}
+
+TEST_F(RegionMaskTest, LimitedToImage) {
+    EXPECT_FALSE(RegionMask::Polygon({-5.0, -1.0, -3.0}, {2.0, 2.0, 6.0}, 10, 10));
+    EXPECT_FALSE(RegionMask::Ellipse(20.0, 20.0, 3.0, 2.0, 0.5, 10, 10));
+    // No pixel center inside
+    EXPECT_FALSE(RegionMask::Polygon({2.2, 2.8, 2.5}, {2.2, 2.2, 2.8}, 10, 10));
+
+    auto mask = RegionMask::Polygon({-5.0, 14.0, 14.0, -5.0}, {-5.0, -5.0, 3.0, 3.0}, 10, 10);
+    ASSERT_TRUE(mask);
+    EXPECT_EQ(mask->BlcX(), 0);
+    EXPECT_EQ(mask->BlcY(), 0);
+    EXPECT_EQ(mask->Width(), 10);
+    EXPECT_EQ(mask->Height(), 4);
+    EXPECT_EQ(mask->NumPixels(), 40);
+
+    // Edges crossing rows far outside the image, beyond the range of int
+    auto wide = RegionMask::Polygon({-1.0e12, 1.0e12, 0.0}, {0.0, 0.0, 5.0}, 10, 10);
+    ASSERT_TRUE(wide);
+    EXPECT_EQ(wide->BlcX(), 0);
+    EXPECT_EQ(wide->Width(), 10);
+    EXPECT_EQ(wide->Height(), 6);
+    EXPECT_EQ(wide->NumPixels(), 51);
+}
+
+TEST_F(RegionMaskTest, ApplyToData) {
+    auto mask = RegionMask::Ellipse(10.3, 8.7, 6.2, 3.1, 0.4, 20, 20);
+    ASSERT_TRUE(mask);
+    size_t size = static_cast<size_t>(mask->Width()) * mask->Height();
+    std::vector<float> data(size, 1.0f);
+    mask->ApplyToData(data.data());
+
+    std::unique_ptr<bool[]> pixels(new bool[size]);
+    mask->FillMask(pixels.get());
+    for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(std::isnan(data[i]), !pixels[i]);
+    }
+}
+
+TEST_F(RegionMaskTest, FromMask) {
+    auto ellipse = RegionMask::Ellipse(10.3, 8.7, 6.2, 3.1, 0.4, 20, 20);
+    ASSERT_TRUE(ellipse);
+    size_t size = static_cast<size_t>(ellipse->Width()) * ellipse->Height();
+    std::unique_ptr<bool[]> pixels(new bool[size]);
+    ellipse->FillMask(pixels.get());
+
+    auto mask = RegionMask::FromMask(pixels.get(), ellipse->BlcX(), ellipse->BlcY(), ellipse->Width(), ellipse->Height());
+    ASSERT_TRUE(mask);
+    EXPECT_EQ(mask->NumPixels(), ellipse->NumPixels());
+    ASSERT_EQ(mask->Runs().size(), ellipse->Runs().size());
+    for (size_t i = 0; i < mask->Runs().size(); ++i) {
+        EXPECT_EQ(mask->Runs()[i].y, ellipse->Runs()[i].y);
+        EXPECT_EQ(mask->Runs()[i].x0, ellipse->Runs()[i].x0);
+        EXPECT_EQ(mask->Runs()[i].x1, ellipse->Runs()[i].x1);
+    }
+
+    std::fill(pixels.get(), pixels.get() + size, false);
+    EXPECT_FALSE(RegionMask::FromMask(pixels.get(), 0, 0, ellipse->Width(), ellipse->Height()));
+}
@@ -0,0 +1,354 @@
+/* This file is part of the CARTA Image Viewer: https://github.com/CARTAvis/carta-backend
+   Copyright 2018- Academia Sinica Institute of Astronomy and Astrophysics (ASIAA),
+   Associated Universities, Inc. (AUI) and the Inter-University Institute for Data Intensive Astronomy (IDIA)
+   SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DataStream/Compression.h"
+#include "DataStream/Smoothing.h"
+#include "DataStream/VectorField.h"
+#include "ImageData/PolarizationCalculator.h"
+#include "ImageStats/BasicStatsCalculator.h"
+#include "ImageStats/Histogram.h"
+#include "Util/Simd.h"
+#include "Util/Stokes.h"
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include "Logger/Logger.h"
+#include "Timer/Timer.h"
+#endif
+
+#define MAX_ABS_ERROR 1.0e-4f
+#define MAX_ANGLE_ERROR 1.0e-4f
+#define MAX_SUM_ERROR 1.0e-12
+#define MAX_RELATIVE_ERROR 1.0e-6
+#define BENCHMARK_ITERS 10
+
+using namespace carta;
+
+class SimdDispatchTest : public ::testing::Test {
+public:
+    std::mt19937 mt;
+    std::uniform_real_distribution<float> float_random;
+
+    SimdDispatchTest() : mt(42), float_random(-1.0f, 1.0f) {}
+
+    ~SimdDispatchTest() {
+        Simd::SetLevelLimit(SimdLevel::AVX512);
+    }
+
+    std::vector<float> RandomData(size_t size, float nan_fraction, float inf_fraction = 0) {
+        std::vector<float> data(size);
+        std::uniform_real_distribution<float> fraction_random(0, 1.0f);
+        for (auto& val : data) {
+            float fraction = fraction_random(mt);
+            val = fraction < nan_fraction ? NAN : (fraction < nan_fraction + inf_fraction ? INFINITY : float_random(mt));
+        }
+        return data;
+    }
+
+    // Runs the function with each instruction set supported by the host, from the SSE baseline upwards
+    static void ForEachSimdLevel(const std::function<void(SimdLevel)>& func) {
+        for (int level = 0; level <= static_cast<int>(Simd::HostLevel()); level++) {
+            Simd::SetLevelLimit(static_cast<SimdLevel>(level));
+            ASSERT_EQ(Simd::Level(), static_cast<SimdLevel>(level));
+            func(static_cast<SimdLevel>(level));
+        }
+        Simd::SetLevelLimit(SimdLevel::AVX512);
+    }
+};
+
+TEST_F(SimdDispatchTest, HostLevelIsLimited) {
+    Simd::SetLevelLimit(SimdLevel::SSE);
+    EXPECT_EQ(Simd::Level(), SimdLevel::SSE);
+    Simd::SetLevelLimit(SimdLevel::AVX512);
+    EXPECT_EQ(Simd::Level(), Simd::HostLevel());
+    EXPECT_FALSE(Simd::Name(Simd::Level()).empty());
+}
+
+TEST_F(SimdDispatchTest, BlockSmoothMatchesScalar) {
+    int64_t width(517), height(389);
+    auto image = RandomData(width * height, 0.1f, 0.05f);
+    for (int smoothing_factor : {4, 8, 16, 32, 48}) {
+        int64_t dest_width = (width + smoothing_factor - 1) / smoothing_factor;
+        int64_t dest_height = (height + smoothing_factor - 1) / smoothing_factor;
+        std::vector<float> expected(dest_width * dest_height);
+        BlockSmoothScalar(image.data(), expected.data(), width, height, dest_width, dest_height, 0, 0, smoothing_factor);
+
+        ForEachSimdLevel([&](SimdLevel level) {
+            std::vector<float> smoothed(dest_width * dest_height);
+            BlockSmooth(image.data(), smoothed.data(), width, height, dest_width, dest_height, 0, 0, smoothing_factor);
+            for (int64_t i = 0; i < smoothed.size(); i++) {
+                ASSERT_EQ(std::isnan(smoothed[i]), std::isnan(expected[i])) << Simd::Name(level);
+                if (!std::isnan(expected[i])) {
+                    ASSERT_NEAR(smoothed[i], expected[i], MAX_ABS_ERROR) << Simd::Name(level);
+                }
+            }
+        });
+    }
+}
+
+TEST_F(SimdDispatchTest, GaussianSmoothMatchesBaseline) {
+    // Widths which are not multiples of the vector widths, for the scalar and masked right edges
+    int64_t width(531), height(277);
+    auto image = RandomData(width * height, 0.1f, 0.05f);
+    for (int smoothing_factor : {2, 3, 5, 9, 17}) {
+        int64_t apron = smoothing_factor - 1;
+        int64_t dest_width = width - 2 * apron;
+        int64_t dest_height = height - 2 * apron;
+        std::vector<float> expected;
+        ForEachSimdLevel([&](SimdLevel level) {
+            std::vector<float> smoothed(dest_width * dest_height);
+            ASSERT_TRUE(GaussianSmoothSeparable(image.data(), smoothed.data(), width, height, dest_width, dest_height, smoothing_factor));
+            if (level == SimdLevel::SSE) {
+                expected = smoothed;
+                return;
+            }
+            for (int64_t i = 0; i < smoothed.size(); i++) {
+                ASSERT_EQ(std::isnan(smoothed[i]), std::isnan(expected[i])) << Simd::Name(level);
+                if (!std::isnan(expected[i])) {
+                    ASSERT_NEAR(smoothed[i], expected[i], MAX_ABS_ERROR) << Simd::Name(level);
+                }
+            }
+        });
+    }
+}
+
+TEST_F(SimdDispatchTest, NearestNeighborMatchesScalar) {
+    int64_t width(1000), height(300);
+    auto image = RandomData(width * height, 0.1f);
+    for (int smoothing_factor : {1, 2, 3, 7, 16}) {
+        int64_t x_offset(5), y_offset(3);
+        int64_t dest_width = (width - x_offset) / smoothing_factor;
+        int64_t dest_height = (height - y_offset) / smoothing_factor;
+        ForEachSimdLevel([&](SimdLevel level) {
+            std::vector<float> dest(dest_width * dest_height);
+            NearestNeighbor(image.data(), dest.data(), width, dest_width, dest_height, x_offset, y_offset, smoothing_factor);
+            for (int64_t j = 0; j < dest_height; j++) {
+                for (int64_t i = 0; i < dest_width; i++) {
+                    float expected = image[(y_offset + j * smoothing_factor) * width + x_offset + i * smoothing_factor];
+                    float val = dest[j * dest_width + i];
+                    ASSERT_TRUE(val == expected || (std::isnan(val) && std::isnan(expected))) << Simd::Name(level);
+                }
+            }
+        });
+    }
+}
+
+TEST_F(SimdDispatchTest, HistogramMatchesScalar) {
+    auto data = RandomData(100003, 0.1f, 0.01f);
+    // Values on the bounds and bin edges
+    data[0] = -0.5f;
+    data[1] = 0.5f;
+    data[2] = 0.0f;
+    data[3] = -0.0f;
+
+    std::vector<int> expected;
+    ForEachSimdLevel([&](SimdLevel level) {
+        Histogram hist(100, HistogramBounds(-0.5, 0.5), data.data(), data.size());
+        if (expected.empty()) {
+            expected = hist.GetHistogramBins();
+        } else {
+            EXPECT_EQ(hist.GetHistogramBins(), expected) << Simd::Name(level);
+        }
+    });
+
+    int64_t num_in_range(0);
+    for (auto val : data) {
+        num_in_range += (val >= -0.5f && val <= 0.5f);
+    }
+    EXPECT_EQ(std::accumulate(expected.begin(), expected.end(), (int64_t)0), num_in_range);
+}
+
+TEST_F(SimdDispatchTest, BasicStatsMatchScalar) {
+    for (size_t size : {3, 100, 123457}) {
+        auto data = RandomData(size, 0.1f, 0.01f);
+        BasicStats<double> expected;
+        std::vector<double> data_double(data.begin(), data.end());
+        BasicStatsCalculator<double> calculator(data_double.data(), data_double.size());
+        calculator.reduce();
+        expected = calculator.GetStats();
+
+        ForEachSimdLevel([&](SimdLevel level) {
+            BasicStatsCalculator<float> float_calculator(data.data(), data.size());
+            float_calculator.reduce();
+            auto stats = float_calculator.GetStats();
+            EXPECT_EQ(stats.num_pixels, expected.num_pixels) << Simd::Name(level);
+            EXPECT_EQ(stats.min_val, expected.min_val) << Simd::Name(level);
+            EXPECT_EQ(stats.max_val, expected.max_val) << Simd::Name(level);
+            // Sums are accumulated in a different order; values are at most 1
+            EXPECT_NEAR(stats.sum, expected.sum, MAX_SUM_ERROR * size) << Simd::Name(level);
+            EXPECT_NEAR(stats.sumSq, expected.sumSq, MAX_SUM_ERROR * size) << Simd::Name(level);
+        });
+    }
+}
+
+TEST_F(SimdDispatchTest, NanEncodingsMatchBaseline) {
+    for (float nan_fraction : {0.0f, 0.05f, 0.5f, 1.0f}) {
+        int w(253), h(130);
+        auto data = RandomData(w * h, nan_fraction);
+        std::vector<int32_t> expected_encodings;
+        std::vector<float> expected_data;
+        ForEachSimdLevel([&](SimdLevel level) {
+            auto filled_data = data;
+            auto encodings = GetNanEncodingsBlock(filled_data, 0, w, h);
+            if (level == SimdLevel::SSE) {
+                expected_encodings = encodings;
+                expected_data = filled_data;
+            } else {
+                EXPECT_EQ(encodings, expected_encodings) << Simd::Name(level);
+                EXPECT_EQ(memcmp(filled_data.data(), expected_data.data(), sizeof(float) * data.size()), 0) << Simd::Name(level);
+            }
+        });
+    }
+}
+
+TEST_F(SimdDispatchTest, PolarizationMatchesScalar) {
+    size_t size(10007);
+    auto q = RandomData(size, 0.05f);
+    auto u = RandomData(size, 0.05f);
+    // Axes and signed zeros
+    std::vector<std::pair<float, float>> special_values = {{0.0f, 0.0f}, {-0.0f, 0.0f}, {0.0f, -0.0f}, {-0.0f, -0.0f}, {1.0f, 0.0f},
+        {-1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, -1.0f}, {-1.0f, -0.0f}, {1.0f, 1.0f}, {-1.0f, -1.0f}, {1e-30f, 1e30f}};
+    for (size_t i = 0; i < special_values.size(); i++) {
+        q[i] = special_values[i].first;
+        u[i] = special_values[i].second;
+    }
+    double q_error(0.01), u_error(0.02);
+
+    ForEachSimdLevel([&](SimdLevel level) {
+        std::vector<float> pi(size), pa(size);
+        CalculatePolarizedIntensity(q.data(), u.data(), pi.data(), size, q_error, u_error);
+        CalculatePolarizationAngle(q.data(), u.data(), pa.data(), size);
+        for (size_t i = 0; i < size; i++) {
+            float expected_pi = VectorField::CalcPi(q_error, u_error)(q[i], u[i]);
+            float expected_pa = VectorField::CalcPa()(q[i], u[i]);
+            ASSERT_EQ(std::isnan(pi[i]), std::isnan(expected_pi)) << Simd::Name(level) << " q=" << q[i] << " u=" << u[i];
+            ASSERT_EQ(std::isnan(pa[i]), std::isnan(expected_pa)) << Simd::Name(level) << " q=" << q[i] << " u=" << u[i];
+            if (!std::isnan(expected_pi)) {
+                ASSERT_FLOAT_EQ(pi[i], expected_pi) << Simd::Name(level);
+            }
+            if (!std::isnan(expected_pa)) {
+                ASSERT_NEAR(pa[i], expected_pa, MAX_ANGLE_ERROR) << Simd::Name(level) << " q=" << q[i] << " u=" << u[i];
+            }
+        }
+    });
+}
+
+TEST_F(SimdDispatchTest, ComputedStokesMatchScalar) {
+    size_t size(10007);
+    auto i = RandomData(size, 0.05f);
+    auto q = RandomData(size, 0.05f);
+    auto u = RandomData(size, 0.05f);
+    auto v = RandomData(size, 0.05f);
+
+    EXPECT_FALSE(ComputeStokesData(1, i.data(), q.data(), u.data(), v.data(), i.data(), size));
+    EXPECT_FALSE(ComputeStokesData(COMPUTE_STOKES_PTOTAL, i.data(), q.data(), u.data(), nullptr, i.data(), size));
+    EXPECT_FALSE(ComputeStokesData(COMPUTE_STOKES_PFLINEAR, nullptr, q.data(), u.data(), v.data(), i.data(), size));
+
+    for (int stokes : {COMPUTE_STOKES_PTOTAL, COMPUTE_STOKES_PLINEAR, COMPUTE_STOKES_PFTOTAL, COMPUTE_STOKES_PFLINEAR, COMPUTE_STOKES_PANGLE}) {
+        bool total = (stokes == COMPUTE_STOKES_PTOTAL || stokes == COMPUTE_STOKES_PFTOTAL);
+        bool fractional = (stokes == COMPUTE_STOKES_PFTOTAL || stokes == COMPUTE_STOKES_PFLINEAR);
+        ForEachSimdLevel([&](SimdLevel level) {
+            std::vector<float> result(size);
+            ASSERT_TRUE(ComputeStokesData(stokes, i.data(), q.data(), u.data(), v.data(), result.data(), size));
+            for (size_t k = 0; k < size; k++) {
+                // Same expressions as the polarization calculator
+                double expected;
+                if (stokes == COMPUTE_STOKES_PANGLE) {
+                    expected = 90.0 / casacore::C::pi * std::atan2(u[k], q[k]);
+                } else {
+                    double sum = (double)q[k] * q[k] + (double)u[k] * u[k] + (total ? (double)v[k] * v[k] : 0.0);
+                    expected = fractional ? 100.0 * std::sqrt(sum) / i[k] : std::sqrt(sum);
+                }
+                ASSERT_EQ(std::isnan(result[k]), std::isnan(expected)) << Simd::Name(level) << " stokes " << stokes;
+                if (std::isnan(expected)) {
+                    continue;
+                }
+                if (stokes == COMPUTE_STOKES_PANGLE) {
+                    ASSERT_NEAR(result[k], expected, MAX_ANGLE_ERROR) << Simd::Name(level);
+                } else {
+                    ASSERT_NEAR(result[k], expected, MAX_RELATIVE_ERROR * std::abs(expected))
+                        << Simd::Name(level) << " stokes " << stokes;
+                }
+            }
+        });
+    }
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST_F(SimdDispatchTest, BenchmarkMatrix) {
+    int64_t width(4096), height(4096);
+    auto image = RandomData(width * height, 0.01f);
+    auto q = RandomData(width * height, 0.01f);
+    std::vector<float> dest(width * height);
+    std::vector<float> dest2(width * height);
+
+    std::vector<std::pair<std::string, std::function<void()>>> kernels = {
+        {"BlockSmooth x16",
+            [&]() {
+                BlockSmooth(image.data(), dest.data(), width, height, width / 16, height / 16, 0, 0, 16);
+            }},
+        {"GaussianSmooth x16",
+            [&]() {
+                GaussianSmoothSeparable(image.data(), dest.data(), width, height, width - 30, height - 30, 16);
+            }},
+        {"NearestNeighbor x4",
+            [&]() {
+                NearestNeighbor(image.data(), dest.data(), width, width / 4, height / 4, 0, 0, 4);
+            }},
+        {"Histogram",
+            [&]() {
+                Histogram(1024, HistogramBounds(-1.0, 1.0), image.data(), image.size());
+            }},
+        {"BasicStats",
+            [&]() {
+                BasicStatsCalculator<float> calculator(image.data(), image.size());
+                calculator.reduce();
+            }},
+        {"NaN encodings",
+            [&]() {
+                // The encodings of the first call replace the NaNs
+                std::copy(image.begin(), image.begin() + 512 * 512, dest.begin());
+                GetNanEncodingsBlock(dest, 0, 512, 512);
+            }},
+        {"Polarized intensity",
+            [&]() {
+                CalculatePolarizedIntensity(q.data(), image.data(), dest.data(), image.size(), 0.01, 0.01);
+            }},
+        {"Polarization angle",
+            [&]() {
+                CalculatePolarizationAngle(q.data(), image.data(), dest2.data(), image.size());
+            }},
+        {"PFtotal",
+            [&]() {
+                ComputeStokesData(COMPUTE_STOKES_PFTOTAL, image.data(), q.data(), dest2.data(), q.data(), dest.data(), image.size());
+            }},
+    };
+
+    spdlog::info("Host instruction set: {}", Simd::Name(Simd::HostLevel()));
+    for (auto& [name, kernel] : kernels) {
+        double baseline_time(0);
+        ForEachSimdLevel([&](SimdLevel level) {
+            kernel();
+            Timer t;
+            for (int i = 0; i < BENCHMARK_ITERS; i++) {
+                kernel();
+            }
+            double time = t.Elapsed().ms() / BENCHMARK_ITERS;
+            if (level == SimdLevel::SSE) {
+                baseline_time = time;
+            }
+            spdlog::info("{:<20} {:<8} {:9.3f} ms {:6.2f}x", name, Simd::Name(level), time, baseline_time / time);
+        });
+    }
+}
+#endif
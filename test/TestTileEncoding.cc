@@ -5,14 +5,127 @@
 */
 
 #include <chrono>
+#include <cstring>
 #include <random>
 
 #include <gtest/gtest.h>
 
+#include "DataStream/Compression.h"
 #include "DataStream/Tile.h"
 
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include "Logger/Logger.h"
+#endif
+
 using namespace carta;
 
+// Previous element-by-element implementations of the NaN encodings, for comparison
+static std::vector<int32_t> NanEncodingsSimpleReference(std::vector<float>& array, int offset, int length) {
+    int32_t prev_index = offset;
+    bool prev = false;
+    std::vector<int32_t> encoded_array;
+    float prev_valid_num = 0;
+    for (auto i = offset; i < offset + length; i++) {
+        if (!std::isnan(array[i])) {
+            prev_valid_num = array[i];
+            break;
+        }
+    }
+    for (auto i = offset; i < offset + length; i++) {
+        bool current = std::isnan(array[i]);
+        if (current != prev) {
+            encoded_array.push_back(i - prev_index);
+            prev_index = i;
+            prev = current;
+        }
+        if (current) {
+            array[i] = prev_valid_num;
+        } else {
+            prev_valid_num = array[i];
+        }
+    }
+    encoded_array.push_back(offset + length - prev_index);
+    return encoded_array;
+}
+
+static std::vector<int32_t> NanEncodingsBlockReference(std::vector<float>& array, int offset, int w, int h) {
+    int length = w * h;
+    int32_t prev_index = offset;
+    bool prev = false;
+    std::vector<int32_t> encoded_array;
+    for (auto i = offset; i < offset + length; i++) {
+        bool current = std::isnan(array[i]);
+        if (current != prev) {
+            encoded_array.push_back(i - prev_index);
+            prev_index = i;
+            prev = current;
+        }
+    }
+    encoded_array.push_back(offset + length - prev_index);
+
+    if (encoded_array.size() > 1) {
+        for (auto i = 0; i < w; i += 4) {
+            for (auto j = 0; j < h; j += 4) {
+                int block_start = offset + j * w + i;
+                int valid_count = 0;
+                float sum = 0;
+                int block_width = std::min(4, w - i);
+                int block_height = std::min(4, h - j);
+                for (int x = 0; x < block_width; x++) {
+                    for (int y = 0; y < block_height; y++) {
+                        float v = array[block_start + (y * w) + x];
+                        if (!std::isnan(v)) {
+                            valid_count++;
+                            sum += v;
+                        }
+                    }
+                }
+                if (valid_count && valid_count != block_width * block_height) {
+                    float average = sum / valid_count;
+                    for (int x = 0; x < block_width; x++) {
+                        for (int y = 0; y < block_height; y++) {
+                            float v = array[block_start + (y * w) + x];
+                            if (std::isnan(v)) {
+                                array[block_start + (y * w) + x] = average;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return encoded_array;
+}
+
+// Tiles with random NaNs, and with a NaN border around an elliptical valid region, as in interferometric mosaics
+static std::vector<std::vector<float>> NanTestTiles(int w, int h, int offset) {
+    std::mt19937 mt(42);
+    std::uniform_real_distribution<float> float_random(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> fraction_random(0, 1.0f);
+    std::vector<std::vector<float>> tiles;
+    for (float nan_fraction : {0.0f, 0.01f, 0.3f, 0.9f, 1.0f}) {
+        std::vector<float> tile(offset + w * h, 7.0f);
+        for (int i = offset; i < tile.size(); i++) {
+            tile[i] = fraction_random(mt) < nan_fraction ? NAN : float_random(mt);
+        }
+        tiles.push_back(tile);
+    }
+    std::vector<float> mosaic(offset + w * h);
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            float x = (i - w * 0.6f) / (w * 0.5f);
+            float y = (j - h * 0.4f) / (h * 0.45f);
+            mosaic[offset + j * w + i] = x * x + y * y < 1 ? float_random(mt) : NAN;
+        }
+    }
+    tiles.push_back(mosaic);
+    return tiles;
+}
+
+static bool IdenticalData(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), sizeof(float) * a.size()) == 0;
+}
+
 TEST(TileEncodingTest, InvalidInput) {
     // Layer can be from 0 to 12
     ASSERT_EQ(Tile::Encode(0, 0, -1), -1);
@@ -51,8 +164,56 @@ TEST(TileEncodingTest, RoundTrip) {
     }
 }
 
+TEST(TileEncodingTest, NanEncodingsSimpleMatchReference) {
+    for (auto [w, h, offset] : std::vector<std::tuple<int, int, int>>{{256, 256, 0}, {253, 130, 0}, {61, 3, 17}, {1, 1, 0}}) {
+        for (auto& tile : NanTestTiles(w, h, offset)) {
+            auto expected_data = tile;
+            auto expected_encodings = NanEncodingsSimpleReference(expected_data, offset, w * h);
+            auto encodings = GetNanEncodingsSimple(tile, offset, w * h);
+            EXPECT_EQ(encodings, expected_encodings);
+            EXPECT_TRUE(IdenticalData(tile, expected_data));
+        }
+    }
+}
+
+TEST(TileEncodingTest, NanEncodingsBlockMatchReference) {
+    for (auto [w, h, offset] : std::vector<std::tuple<int, int, int>>{{256, 256, 0}, {253, 130, 0}, {61, 3, 17}, {1, 1, 0}}) {
+        for (auto& tile : NanTestTiles(w, h, offset)) {
+            auto expected_data = tile;
+            auto expected_encodings = NanEncodingsBlockReference(expected_data, offset, w, h);
+            auto encodings = GetNanEncodingsBlock(tile, offset, w, h);
+            EXPECT_EQ(encodings, expected_encodings);
+            EXPECT_TRUE(IdenticalData(tile, expected_data));
+        }
+    }
+}
+
 #ifdef COMPILE_PERFORMANCE_TESTS
 
+TEST(TileEncoding, PerformanceTestNanEncodings) {
+    int w(256), h(256), num_iters(200);
+    auto tiles = NanTestTiles(w, h, 0);
+    for (int t = 0; t < tiles.size(); t++) {
+        std::vector<float> data;
+        auto t_start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < num_iters; i++) {
+            data = tiles[t];
+            NanEncodingsBlockReference(data, 0, w, h);
+        }
+        auto t_reference = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < num_iters; i++) {
+            data = tiles[t];
+            GetNanEncodingsBlock(data, 0, w, h);
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+        float reference_us = std::chrono::duration_cast<std::chrono::microseconds>(t_reference - t_start).count();
+        float dt_us = std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_reference).count();
+        spdlog::info("NaN encodings of tile {}: reference {:.1f} MPix/s, vectorized {:.1f} MPix/s", t, num_iters * w * h / reference_us,
+            num_iters * w * h / dt_us);
+        EXPECT_LT(dt_us, reference_us);
+    }
+}
+
 TEST(TileEncoding, PerformanceTestEncoding) {
     int32_t layer = 12;
     int64_t encoded_val = 0;
@@ -8,10 +8,39 @@
 
 #include "Util/Casacore.h"
 #include "Util/File.h"
+#include "Util/Message.h"
 #include "Util/String.h"
 
 #include "CommonTestUtilities.h"
 
+#ifdef COMPILE_PERFORMANCE_TESTS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Logger/Logger.h"
+#include "Timer/Timer.h"
+
+// Counts heap allocations in the test binary, to compare building messages on the heap and on an arena
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+    std::free(ptr);
+}
+#endif
+
 class UtilTest : public ::testing::Test {
 public:
     void SetUp() {
@@ -110,3 +139,74 @@ TEST(UtilTest, HasSuffixCaseInsensitive) {
     EXPECT_TRUE(HasSuffix("test.fits.gz", ".fits.gz"));
     EXPECT_FALSE(HasSuffix("test.fits.gz", ".fits"));
 }
+
+TEST(UtilTest, ArenaMessageMatchesHeapMessage) {
+    std::vector<float> profile = {1.0, 2.0, std::numeric_limits<float>::quiet_NaN(), 4.0};
+    auto heap_message = Message::SpectralProfileData(1, 0.5);
+    heap_message.add_profiles()->set_raw_values_fp32(profile.data(), profile.size() * sizeof(float));
+
+    carta::MessageArena arena;
+    for (int i = 0; i < 3; ++i) {
+        auto* arena_message = Message::SpectralProfileData(arena.Get(), 1, 0.5);
+        arena_message->add_profiles()->set_raw_values_fp32(profile.data(), profile.size() * sizeof(float));
+        EXPECT_EQ(arena_message->GetArena(), arena.Get());
+        EXPECT_EQ(arena_message->SerializeAsString(), heap_message.SerializeAsString());
+        arena.Reset();
+    }
+}
+
+TEST(UtilTest, ArenaMessageReusesInitialBlock) {
+    carta::MessageArena arena;
+    for (int i = 0; i < 10; ++i) {
+        auto* tile_data = Message::RasterTileData(arena.Get(), 0, i, 0);
+        tile_data->add_tiles()->set_layer(i);
+        EXPECT_EQ(tile_data->sync_id(), i);
+        arena.Reset();
+        // Only the initial block is in use after a reset
+        EXPECT_LE(arena.Get()->SpaceAllocated(), MESSAGE_ARENA_BLOCK_SIZE);
+    }
+}
+
+#ifdef COMPILE_PERFORMANCE_TESTS
+TEST(UtilTest, ArenaMessageAllocations) {
+    // Raster tile messages as sent for a 2x2 tile request, built and serialized in a loop on the heap and on a reused arena
+    int num_messages(10000), num_tiles(4);
+    std::string image_data(16 * 1024, 'x');
+    std::string serialized;
+    auto add_tiles = [&](CARTA::RasterTileData* tile_data) {
+        for (int i = 0; i < num_tiles; ++i) {
+            auto* tile = tile_data->add_tiles();
+            tile->set_x(i);
+            tile->set_y(i);
+            tile->set_layer(0);
+            tile->set_width(256);
+            tile->set_height(256);
+            tile->set_image_data(image_data);
+        }
+        tile_data->SerializeToString(&serialized);
+    };
+
+    size_t start_count = allocation_count;
+    Timer t;
+    for (int i = 0; i < num_messages; ++i) {
+        auto tile_data = Message::RasterTileData(0, i, 0);
+        add_tiles(&tile_data);
+    }
+    auto heap_time = t.Elapsed();
+    size_t heap_allocations = allocation_count - start_count;
+
+    carta::MessageArena arena;
+    start_count = allocation_count;
+    t = Timer();
+    for (int i = 0; i < num_messages; ++i) {
+        add_tiles(Message::RasterTileData(arena.Get(), 0, i, 0));
+        arena.Reset();
+    }
+    auto arena_time = t.Elapsed();
+    size_t arena_allocations = allocation_count - start_count;
+
+    spdlog::info("{} raster tile messages: heap {} allocations {:.3f} ms, arena {} allocations {:.3f} ms", num_messages, heap_allocations,
+        heap_time.ms(), arena_allocations, arena_time.ms());
+    EXPECT_LT(arena_allocations, heap_allocations);
+}
+#endif